@@ -238,7 +238,7 @@ void QuickTimeAudioDecoder::QuickTimeAudioTrack::queueAudio(const Timestamp &len
 
 			// If we have reached the end of this edit (or have no more media to read),
 			// we move on to the next edit
-			if (trackPosition >= nextEditTime || _curChunk >= _parentTrack->chunkCount) {
+			if (trackPosition >= nextEditTime || _curChunk >= _parentTrack->chunkOffsets.size()) {
 				chunkLength = nextEditTime.convertToFramerate(getRate()) - getCurrentTrackTime();
 				stream = makeLimitingAudioStream(stream, chunkLength);
 				_curEdit++;
@@ -359,8 +359,7 @@ AudioStream *QuickTimeAudioDecoder::QuickTimeAudioTrack::readAudioChunk(uint chu
 
 		// Find our starting sample
 		uint32 startSample = 0;
-		for (uint32 i = 0; i < chunk; i++)
-			startSample += getAudioChunkSampleCount(i);
+		_parentTrack->getChunkSampleCount(chunk, startSample);
 
 		for (uint32 i = 0; i < sampleCount; i++) {
 			uint32 size = (_parentTrack->sampleSize != 0) ? _parentTrack->sampleSize : _parentTrack->sampleSizes[i + startSample];
@@ -473,7 +472,7 @@ void QuickTimeAudioDecoder::QuickTimeAudioTrack::enterNewEdit(const Timestamp &p
 	// Now to track down what chunk it's in
 	uint32 totalSamples = 0;
 	_curChunk = 0;
-	for (uint32 i = 0; i < _parentTrack->chunkCount; i++, _curChunk++) {
+	for (uint32 i = 0; i < _parentTrack->chunkOffsets.size(); i++, _curChunk++) {
 		uint32 chunkSampleCount = getAudioChunkSampleCount(i);
 
 		if (seekSample < totalSamples + chunkSampleCount)
@@ -502,13 +501,8 @@ void QuickTimeAudioDecoder::QuickTimeAudioTrack::queueStream(AudioStream *stream
 }
 
 uint32 QuickTimeAudioDecoder::QuickTimeAudioTrack::getAudioChunkSampleCount(uint chunk) const {
-	uint32 sampleCount = 0;
-
-	for (uint32 i = 0; i < _parentTrack->sampleToChunkCount; i++)
-		if (chunk >= _parentTrack->sampleToChunk[i].first)
-			sampleCount = _parentTrack->sampleToChunk[i].count;
-
-	return sampleCount;
+	uint32 firstSample;
+	return _parentTrack->getChunkSampleCount(chunk, firstSample);
 }
 
 Timestamp QuickTimeAudioDecoder::QuickTimeAudioTrack::getChunkLength(uint chunk, bool skipAACPrimer) const {
@@ -482,7 +482,7 @@ byte *MidiParser_QT::readWholeTrack(Common::QuickTimeParser::Track *track, uint3
 	MIDISampleDesc *entry = (MIDISampleDesc *)track->sampleDescs[0];
 	output.write(entry->_requestData, entry->_requestSize);
 
-	for (uint i = 0; i < track->chunkCount; i++) {
+	for (uint i = 0; i < track->chunkOffsets.size(); i++) {
 		_fd->seek(track->chunkOffsets[i]);
 
 		uint32 sampleCount = 0;
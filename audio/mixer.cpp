@@ -21,6 +21,8 @@
 
 #include "gui/EventRecorder.h"
 
+#include "common/config-manager.h"
+#include "common/profiler.h"
 #include "common/util.h"
 #include "common/textconsole.h"
 
@@ -39,10 +41,14 @@ namespace Audio {
 
 /**
  * Channel used by the default Mixer implementation.
+ *
+ * All methods are called by the mixer callback, or by the control side with
+ * the mixer mutex held; the engine visible settings (volume, balance, id,
+ * ...) are tracked by MixerImpl itself.
  */
 class Channel {
 public:
-	Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream, DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent);
+	Channel(Mixer *mixer, AudioStream *stream, DisposeAfterUse::Flag autofreeStream, bool reverseStereo, RateConverterQuality quality);
 	~Channel();
 
 	/**
@@ -61,25 +67,14 @@ public:
 	 */
 	bool isFinished() const { return _stream->endOfStream() && !_converter->needsDraining(); }
 
-	/**
-	 * Queries whether the channel is a permanent channel.
-	 * A permanent channel is not affected by a Mixer::stopAll
-	 * call.
-	 */
-	bool isPermanent() const { return _permanent; }
-
-	/**
-	 * Returns the id of the channel.
-	 */
-	int getId() const { return _id; }
-
 	/**
 	 * Pauses or unpaused the channel in a recursive fashion.
 	 *
 	 * @param paused true, when the channel should be paused.
 	 *               false when it should be unpaused.
+	 * @param time   time of the request, as returned by OSystem::getMillis(true).
 	 */
-	void pause(bool paused);
+	void pause(bool paused, uint32 time);
 
 	/**
 	 * Queries whether the channel is currently paused.
@@ -87,39 +82,18 @@ public:
 	bool isPaused() const { return (_pauseLevel != 0); }
 
 	/**
-	 * Sets the channel's own volume.
-	 *
-	 * @param volume new volume
+	 * Sets the effective volume of the left and right output channel.
 	 */
-	void setVolume(const byte volume);
-
-	/**
-	 * Gets the channel's own volume.
-	 *
-	 * @return volume
-	 */
-	byte getVolume();
-
-	/**
-	 * Sets the channel's balance setting.
-	 *
-	 * @param balance new balance
-	 */
-	void setBalance(const int8 balance);
-
-	/**
-	 * Gets the channel's balance setting.
-	 *
-	 * @return balance
-	 */
-	int8 getBalance();
+	void setOutputVolumes(st_volume_t volL, st_volume_t volR) { _volL = volL; _volR = volR; }
 
 	/**
 	 * Set the channel's sample rate.
 	 * 
-	 * @param rate	The new sample rate. Must be less than 131072
+	 * @param rate		The new sample rate. Must be less than 131072
+	 * @param filter	The filter makeRateFilter() built for the change, or nullptr.
+	 * @return The filter the channel no longer uses, which the caller must delete.
 	*/
-	void setRate(uint32 rate);
+	RateFilter *setRate(uint32 rate, RateFilter *filter);
 
 	/**
 	 * Get the channel's sample rate.
@@ -129,16 +103,9 @@ public:
 	uint32 getRate();
 
 	/**
-	 * Reset the sample rate of the channel back to its
-	 * AudioStream's native rate.
-	*/
-	void resetRate();
-
-	/**
-	 * Notifies the channel that the global sound type
-	 * volume settings changed.
+	 * Get the quality of the channel's rate converter.
 	 */
-	void notifyGlobalVolChange() { updateChannelVolumes(); }
+	RateConverterQuality getRateConverterQuality() const { return _quality; }
 
 	/**
 	 * Queries how long the channel has been playing.
@@ -150,11 +117,6 @@ public:
 	 */
 	void loop();
 
-	/**
-	 * Queries the channel's sound type.
-	 */
-	Mixer::SoundType getType() const { return _type; }
-
 	/**
 	 * Sets the channel's sound handle.
 	 *
@@ -168,16 +130,9 @@ public:
 	SoundHandle getHandle() const { return _handle; }
 
 private:
-	const Mixer::SoundType _type;
 	SoundHandle _handle;
-	bool _permanent;
 	int _pauseLevel;
-	int _id;
-
-	byte _volume;
-	int8 _balance;
 
-	void updateChannelVolumes();
 	st_volume_t _volL, _volR;
 
 	Mixer *_mixer;
@@ -188,6 +143,7 @@ private:
 	uint32 _pauseStartTime;
 	uint32 _pauseTime;
 
+	RateConverterQuality _quality;
 	RateConverter *_converter;
 	Common::DisposablePtr<AudioStream> _stream;
 };
@@ -197,15 +153,39 @@ private:
 #pragma mark -
 
 MixerImpl::MixerImpl(uint sampleRate, bool stereo, uint outBufSize)
-	: _mutex(), _sampleRate(sampleRate), _stereo(stereo), _outBufSize(outBufSize), _mixerReady(false), _handleSeed(0), _soundTypeSettings() {
+	: _mutex(), _controlMutex(), _sampleRate(sampleRate), _stereo(stereo), _outBufSize(outBufSize), _mixerReady(false), _handleSeed(0), _rateConverterQuality(kRateConverterLinear), _soundTypeSettings(),
+	  _commandsHead(0), _commandsTail(0), _commandsReclaimed(0) {
 
 	assert(sampleRate > 0);
 
-	for (int i = 0; i != NUM_CHANNELS; i++)
+	for (int i = 0; i != COMMAND_QUEUE_SIZE; i++) {
+		_commands[i].channel = nullptr;
+		_commands[i].filter = nullptr;
+	}
+
+	for (int i = 0; i != NUM_CHANNELS; i++) {
 		_channels[i] = nullptr;
+		_finishedHandles[i].store(0xffffffff);
+	}
+
+	if (ConfMan.hasKey("resampler_quality")) {
+		const Common::String quality = ConfMan.get("resampler_quality");
+		if (quality == "fast")
+			_rateConverterQuality = kRateConverterFast;
+		else if (quality == "medium")
+			_rateConverterQuality = kRateConverterMedium;
+		else if (quality == "best")
+			_rateConverterQuality = kRateConverterBest;
+		else if (quality != "linear")
+			warning("Unknown resampler quality '%s'", quality.c_str());
+	}
 }
 
 MixerImpl::~MixerImpl() {
+	// Apply pending insertions, so that their channels get freed as well
+	processCommands();
+	reclaimCommands();
+
 	for (int i = 0; i != NUM_CHANNELS; i++)
 		delete _channels[i];
 }
@@ -228,13 +208,257 @@ uint MixerImpl::getOutputBufSize() const {
 	return _outBufSize;
 }
 
-void MixerImpl::insertChannel(SoundHandle *handle, Channel *chan) {
-	int index = -1;
+void MixerImpl::setRateConverterQuality(RateConverterQuality quality) {
+	Common::StackLock lock(_controlMutex);
+
+	_rateConverterQuality = quality;
+}
+
+#pragma mark -
+#pragma mark --- Command queue ---
+#pragma mark -
+
+bool MixerImpl::pushCommand(const Command &cmd) {
+	// Producer side, called with _controlMutex held
+	reclaimCommands();
+
+	const uint tail = _commandsTail.load();
+	const uint next = (tail + 1) % COMMAND_QUEUE_SIZE;
+	if (next == _commandsHead.load())
+		return false;
+
+	_commands[tail] = cmd;
+	_commandsTail.store(next);
+	return true;
+}
+
+void MixerImpl::reclaimCommands() {
+	// Producer side: the callback handed back the filters and channels which
+	// are no longer used in the slots it is done with, since it must not free
+	// memory itself
+	const uint head = _commandsHead.load();
+
+	while (_commandsReclaimed != head) {
+		Command &cmd = _commands[_commandsReclaimed];
+		if (cmd.type == Command::kStop)
+			_channelStates[cmd.index].retiring = false;
+
+		delete cmd.channel;
+		cmd.channel = nullptr;
+		delete cmd.filter;
+		cmd.filter = nullptr;
+		_commandsReclaimed = (_commandsReclaimed + 1) % COMMAND_QUEUE_SIZE;
+	}
+}
+
+void MixerImpl::drainCommands() {
+	// Called with _controlMutex held once, if the callback fell far behind or
+	// does not run at all. Keep the lock order of the callback, whose streams
+	// may call back into the mixer: _mutex first, then _controlMutex.
+	_controlMutex.unlock();
+	Common::StackLock lock(_mutex);
+	_controlMutex.lock();
+
+	processCommands();
+	reclaimCommands();
+}
+
+void MixerImpl::postCommand(Command::Type type, int index, Channel *channel, uint32 arg1, uint32 arg2, RateFilter *filter) {
+	Command cmd;
+	cmd.type = type;
+	cmd.index = index;
+	cmd.handle = _channelStates[index].handle;
+	cmd.channel = channel;
+	cmd.arg1 = arg1;
+	cmd.arg2 = arg2;
+	cmd.filter = filter;
+
+	while (!pushCommand(cmd))
+		drainCommands();
+}
+
+void MixerImpl::postRateCommand(int index, uint32 oldRate, uint32 newRate) {
+	// Build the new filter bank here rather than in the mixer callback
+	RateFilter *filter = makeRateFilter(oldRate, newRate, _sampleRate, _channelStates[index].quality);
+	postCommand(Command::kRate, index, nullptr, newRate, 0, filter);
+}
+
+void MixerImpl::executeCommand(Command &cmd) {
+	if (cmd.type == Command::kInsert) {
+		assert(!_channels[cmd.index]);
+		_channels[cmd.index] = cmd.channel;
+		cmd.channel = nullptr;
+		return;
+	}
+
+	Channel *chan = _channels[cmd.index];
+	if (!chan || chan->getHandle()._val != cmd.handle)
+		return;
+
+	if (cmd.type == Command::kStop) {
+		// Hand the channel back to the control side
+		_channels[cmd.index] = nullptr;
+		cmd.channel = chan;
+		return;
+	}
+
+	// The channel may have finished or been stopped since the command was
+	// posted
+	if (_finishedHandles[cmd.index].load() == cmd.handle || !enterChannel(cmd.index))
+		return;
+
+	switch (cmd.type) {
+	case Command::kVolume:
+		chan->setOutputVolumes(cmd.arg1, cmd.arg2);
+		break;
+	case Command::kPause:
+		chan->pause(cmd.arg1 != 0, cmd.arg2);
+		break;
+	case Command::kRate:
+		cmd.filter = chan->setRate(cmd.arg1, cmd.filter);
+		break;
+	case Command::kLoop:
+		chan->loop();
+		break;
+	default:
+		break;
+	}
+
+	leaveChannel(cmd.index);
+}
+
+void MixerImpl::processCommands() {
+	// Consumer side, called with _mutex held
+	uint head = _commandsHead.load();
+	const uint tail = _commandsTail.load();
+
+	while (head != tail) {
+		executeCommand(_commands[head]);
+		head = (head + 1) % COMMAND_QUEUE_SIZE;
+	}
+
+	_commandsHead.store(head);
+}
+
+#pragma mark -
+#pragma mark --- Channel control ---
+#pragma mark -
+
+bool MixerImpl::isChannelActive(int index) {
+	ChannelState &state = _channelStates[index];
+	if (state.active && _finishedHandles[index].load() == state.handle)
+		retireChannel(index);
+
+	return state.active;
+}
+
+MixerImpl::ChannelState *MixerImpl::findChannel(SoundHandle handle) {
+	const int index = handle._val % NUM_CHANNELS;
+	if (!isChannelActive(index) || _channelStates[index].handle != handle._val)
+		return nullptr;
+
+	return &_channelStates[index];
+}
+
+void MixerImpl::retireChannel(int index) {
+	// The slot is reused once the callback carried out the kStop, which also
+	// keeps the following kInsert behind it
+	ChannelState &state = _channelStates[index];
+	state.active = false;
+	state.retiring = true;
+	postCommand(Command::kStop, index);
+}
+
+uint32 MixerImpl::stopChannel(int index) {
+	// The callback checks the flag before it touches the channel, so it only
+	// has to be waited for if it is busy with this very channel right now
+	const uint32 flags = _channelFlags[index].fetchAdd(kChannelStopped);
+	retireChannel(index);
+
+	return (flags & kChannelMixing) ? 1u << index : 0;
+}
+
+void MixerImpl::waitForChannels(uint32 slots) {
+	// Called without _controlMutex held, since the stream which is being
+	// mixed may call back into the mixer. The slots are not reused before
+	// the callback is done with them, so their flags stay put.
 	for (int i = 0; i != NUM_CHANNELS; i++) {
-		if (_channels[i] == nullptr) {
-			index = i;
-			break;
+		if (!(slots & (1u << i)))
+			continue;
+
+		while (_channelFlags[i].load() & kChannelMixing)
+			g_system->delayMillis(1);
+	}
+}
+
+bool MixerImpl::enterChannel(int index) {
+	// Consumer side, before touching a channel or its stream
+	if (_channelFlags[index].fetchAdd(kChannelMixing) & kChannelStopped) {
+		leaveChannel(index);
+		return false;
+	}
+
+	return true;
+}
+
+void MixerImpl::leaveChannel(int index) {
+	_channelFlags[index].fetchAdd((uint32)-kChannelMixing);
+}
+
+void MixerImpl::pauseChannel(int index, bool paused) {
+	postCommand(Command::kPause, index, nullptr, paused ? 1 : 0, g_system->getMillis(true));
+}
+
+void MixerImpl::computeChannelVolumes(const ChannelState &state, uint16 &volL, uint16 &volR) const {
+	// From the channel balance/volume and the global volume, we compute
+	// the effective volume for the left and right channel. Note the
+	// slightly odd divisor: the 255 reflects the fact that the maximal
+	// value for _volume is 255, while the 127 is there because the
+	// balance value ranges from -127 to 127.  The mixer (music/sound)
+	// volume is in the range 0 - kMaxMixerVolume.
+	// Hence, the vol_l/vol_r values will be in that range, too
+
+	if (!_soundTypeSettings[state.type].mute) {
+		int vol = _soundTypeSettings[state.type].volume * state.volume;
+
+		if (state.balance == 0) {
+			volL = vol / Mixer::kMaxChannelVolume;
+			volR = vol / Mixer::kMaxChannelVolume;
+		} else if (state.balance < 0) {
+			volL = vol / Mixer::kMaxChannelVolume;
+			volR = ((127 + state.balance) * vol) / (Mixer::kMaxChannelVolume * 127);
+		} else {
+			volL = ((127 - state.balance) * vol) / (Mixer::kMaxChannelVolume * 127);
+			volR = vol / Mixer::kMaxChannelVolume;
 		}
+	} else {
+		volL = volR = 0;
+	}
+}
+
+void MixerImpl::updateChannelVolumes(int index) {
+	uint16 volL, volR;
+	computeChannelVolumes(_channelStates[index], volL, volR);
+	postCommand(Command::kVolume, index, nullptr, volL, volR);
+}
+
+int MixerImpl::findFreeSlot() {
+	reclaimCommands();
+
+	for (int i = 0; i != NUM_CHANNELS; i++) {
+		if (!isChannelActive(i) && !_channelStates[i].retiring)
+			return i;
+	}
+
+	return -1;
+}
+
+void MixerImpl::insertChannel(SoundHandle *handle, Channel *chan, SoundType type, int id, byte volume, int8 balance, bool permanent) {
+	int index = findFreeSlot();
+	if (index == -1) {
+		// Stopped channels keep their slots until the callback removed them
+		drainCommands();
+		index = findFreeSlot();
 	}
 	if (index == -1) {
 		warning("MixerImpl::out of mixer slots");
@@ -242,12 +466,29 @@ void MixerImpl::insertChannel(SoundHandle *handle, Channel *chan) {
 		return;
 	}
 
-	_channels[index] = chan;
-
 	SoundHandle chanHandle;
 	chanHandle._val = index + (_handleSeed * NUM_CHANNELS);
 
+	ChannelState &state = _channelStates[index];
+	state.active = true;
+	state.handle = chanHandle._val;
+	state.id = id;
+	state.type = type;
+	state.permanent = permanent;
+	state.volume = volume;
+	state.balance = balance;
+	state.rate = state.streamRate = chan->getRate();
+	state.quality = chan->getRateConverterQuality();
+
+	uint16 volL, volR;
+	computeChannelVolumes(state, volL, volR);
+	chan->setOutputVolumes(volL, volR);
 	chan->setHandle(chanHandle);
+
+	// The callback is done with the previous channel of the slot
+	_channelFlags[index].store(0);
+	postCommand(Command::kInsert, index, chan);
+
 	_handleSeed++;
 	if (handle)
 		*handle = chanHandle;
@@ -261,7 +502,7 @@ void MixerImpl::playStream(
 			DisposeAfterUse::Flag autofreeStream,
 			bool permanent,
 			bool reverseStereo) {
-	Common::StackLock lock(_mutex);
+	Common::StackLock lock(_controlMutex);
 
 	if (stream == nullptr) {
 		warning("stream is 0");
@@ -274,7 +515,7 @@ void MixerImpl::playStream(
 	// Prevent duplicate sounds
 	if (id != -1) {
 		for (int i = 0; i != NUM_CHANNELS; i++)
-			if (_channels[i] != nullptr && _channels[i]->getId() == id) {
+			if (isChannelActive(i) && _channelStates[i].id == id) {
 				// Delete the stream if were asked to auto-dispose it.
 				// Note: This could cause trouble if the client code does not
 				// yet expect the stream to be gone. The primary example to
@@ -292,15 +533,15 @@ void MixerImpl::playStream(
 #endif
 
 	// Create the channel
-	Channel *chan = new Channel(this, type, stream, autofreeStream, reverseStereo, id, permanent);
-	chan->setVolume(volume);
-	chan->setBalance(balance);
-	insertChannel(handle, chan);
+	Channel *chan = new Channel(this, stream, autofreeStream, reverseStereo, _rateConverterQuality);
+	insertChannel(handle, chan, type, id, volume, balance, permanent);
 }
 
 int MixerImpl::mixCallback(byte *samples, uint len) {
 	assert(samples);
 
+	PROFILE_ZONE_TRACK("Mixer::mixCallback", Common::Profiler::kTrackAudio);
+
 	Common::StackLock lock(_mutex);
 
 	int16 *buf = (int16 *)samples;
@@ -308,6 +549,9 @@ int MixerImpl::mixCallback(byte *samples, uint len) {
 	// Since the mixer callback has been called, the mixer must be ready...
 	_mixerReady = true;
 
+	// Apply everything the engine requested since the last callback
+	processCommands();
+
 	//  zero the buf
 	memset(buf, 0, len);
 
@@ -322,61 +566,79 @@ int MixerImpl::mixCallback(byte *samples, uint len) {
 
 	// mix all channels
 	int res = 0, tmp;
-	for (int i = 0; i != NUM_CHANNELS; i++)
-		if (_channels[i]) {
-			if (_channels[i]->isFinished()) {
-				delete _channels[i];
-				_channels[i] = nullptr;
-			} else if (!_channels[i]->isPaused()) {
-				tmp = _channels[i]->mix(buf, len);
-
-				if (tmp > res)
-					res = tmp;
-			}
+	for (int i = 0; i != NUM_CHANNELS; i++) {
+		Channel *chan = _channels[i];
+		if (!chan || _finishedHandles[i].load() == chan->getHandle()._val || !enterChannel(i))
+			continue;
+
+		// Finished channels stay in place until the control side noticed
+		if (chan->isFinished()) {
+			_finishedHandles[i].store(chan->getHandle()._val);
+		} else if (!chan->isPaused()) {
+			tmp = chan->mix(buf, len);
+
+			if (tmp > res)
+				res = tmp;
 		}
 
+		leaveChannel(i);
+	}
+
 	return res;
 }
 
 void MixerImpl::stopAll() {
-	Common::StackLock lock(_mutex);
-	for (int i = 0; i != NUM_CHANNELS; i++) {
-		if (_channels[i] != nullptr && !_channels[i]->isPermanent()) {
-			delete _channels[i];
-			_channels[i] = nullptr;
+	uint32 busy = 0;
+	{
+		Common::StackLock lock(_controlMutex);
+		for (int i = 0; i != NUM_CHANNELS; i++) {
+			if (isChannelActive(i) && !_channelStates[i].permanent)
+				busy |= stopChannel(i);
 		}
 	}
+
+	// The streams must not be touched any more when we return, since the
+	// caller may free the data they play
+	waitForChannels(busy);
 }
 
 void MixerImpl::stopID(int id) {
-	Common::StackLock lock(_mutex);
-	for (int i = 0; i != NUM_CHANNELS; i++) {
-		if (_channels[i] != nullptr && _channels[i]->getId() == id) {
-			delete _channels[i];
-			_channels[i] = nullptr;
+	uint32 busy = 0;
+	{
+		Common::StackLock lock(_controlMutex);
+		for (int i = 0; i != NUM_CHANNELS; i++) {
+			if (isChannelActive(i) && _channelStates[i].id == id)
+				busy |= stopChannel(i);
 		}
 	}
+
+	waitForChannels(busy);
 }
 
 void MixerImpl::stopHandle(SoundHandle handle) {
-	Common::StackLock lock(_mutex);
+	uint32 busy;
+	{
+		Common::StackLock lock(_controlMutex);
 
-	// Simply ignore stop requests for handles of sounds that already terminated
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
-		return;
+		// Simply ignore stop requests for handles of sounds that already terminated
+		if (!findChannel(handle))
+			return;
 
-	delete _channels[index];
-	_channels[index] = nullptr;
+		busy = stopChannel(handle._val % NUM_CHANNELS);
+	}
+
+	waitForChannels(busy);
 }
 
 void MixerImpl::muteSoundType(SoundType type, bool mute) {
 	assert(0 <= (int)type && (int)type < ARRAYSIZE(_soundTypeSettings));
+
+	Common::StackLock lock(_controlMutex);
 	_soundTypeSettings[type].mute = mute;
 
 	for (int i = 0; i != NUM_CHANNELS; ++i) {
-		if (_channels[i] && _channels[i]->getType() == type)
-			_channels[i]->notifyGlobalVolChange();
+		if (isChannelActive(i) && _channelStates[i].type == type)
+			updateChannelVolumes(i);
 	}
 }
 
@@ -386,67 +648,77 @@ bool MixerImpl::isSoundTypeMuted(SoundType type) const {
 }
 
 void MixerImpl::setChannelVolume(SoundHandle handle, byte volume) {
-	Common::StackLock lock(_mutex);
+	Common::StackLock lock(_controlMutex);
 
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	ChannelState *state = findChannel(handle);
+	if (!state)
 		return;
 
-	_channels[index]->setVolume(volume);
+	state->volume = volume;
+	updateChannelVolumes(handle._val % NUM_CHANNELS);
 }
 
 byte MixerImpl::getChannelVolume(SoundHandle handle) {
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	Common::StackLock lock(_controlMutex);
+
+	const ChannelState *state = findChannel(handle);
+	if (!state)
 		return 0;
 
-	return _channels[index]->getVolume();
+	return state->volume;
 }
 
 void MixerImpl::setChannelBalance(SoundHandle handle, int8 balance) {
-	Common::StackLock lock(_mutex);
+	Common::StackLock lock(_controlMutex);
 
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	ChannelState *state = findChannel(handle);
+	if (!state)
 		return;
 
-	_channels[index]->setBalance(balance);
+	state->balance = balance;
+	updateChannelVolumes(handle._val % NUM_CHANNELS);
 }
 
 int8 MixerImpl::getChannelBalance(SoundHandle handle) {
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	Common::StackLock lock(_controlMutex);
+
+	const ChannelState *state = findChannel(handle);
+	if (!state)
 		return 0;
 
-	return _channels[index]->getBalance();
+	return state->balance;
 }
 
 void MixerImpl::setChannelRate(SoundHandle handle, uint32 rate) {
-	Common::StackLock lock(_mutex);
+	Common::StackLock lock(_controlMutex);
 
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	ChannelState *state = findChannel(handle);
+	if (!state)
 		return;
 
-	_channels[index]->setRate(rate);
+	postRateCommand(handle._val % NUM_CHANNELS, state->rate, rate);
+	state->rate = rate;
 }
 
 uint32 MixerImpl::getChannelRate(SoundHandle handle) {
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	Common::StackLock lock(_controlMutex);
+
+	const ChannelState *state = findChannel(handle);
+	if (!state)
 		return 0;
-	
-	return _channels[index]->getRate();
+
+	return state->rate;
 }
 
 void MixerImpl::resetChannelRate(SoundHandle handle) {
-	Common::StackLock lock(_mutex);
+	Common::StackLock lock(_controlMutex);
 
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	ChannelState *state = findChannel(handle);
+	if (!state)
 		return;
-	
-	_channels[index]->resetRate();
+
+	postRateCommand(handle._val % NUM_CHANNELS, state->rate, state->streamRate);
+	state->rate = state->streamRate;
 }
 
 uint32 MixerImpl::getSoundElapsedTime(SoundHandle handle) {
@@ -456,89 +728,90 @@ uint32 MixerImpl::getSoundElapsedTime(SoundHandle handle) {
 Timestamp MixerImpl::getElapsedTime(SoundHandle handle) {
 	Common::StackLock lock(_mutex);
 
+	// Make sure a pause or unpause request is accounted for
+	processCommands();
+
 	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val || _finishedHandles[index].load() == handle._val)
 		return Timestamp(0, _sampleRate);
 
 	return _channels[index]->getElapsedTime();
 }
 
 void MixerImpl::loopChannel(SoundHandle handle) {
-	Common::StackLock lock(_mutex);
+	Common::StackLock lock(_controlMutex);
 
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	if (!findChannel(handle))
 		return;
 
-	_channels[index]->loop();
+	postCommand(Command::kLoop, handle._val % NUM_CHANNELS);
 }
 
 void MixerImpl::pauseAll(bool paused) {
-	Common::StackLock lock(_mutex);
+	Common::StackLock lock(_controlMutex);
 	for (int i = 0; i != NUM_CHANNELS; i++) {
-		if (_channels[i] != nullptr) {
-			_channels[i]->pause(paused);
+		if (isChannelActive(i)) {
+			pauseChannel(i, paused);
 		}
 	}
 }
 
 void MixerImpl::pauseID(int id, bool paused) {
-	Common::StackLock lock(_mutex);
+	Common::StackLock lock(_controlMutex);
 	for (int i = 0; i != NUM_CHANNELS; i++) {
-		if (_channels[i] != nullptr && _channels[i]->getId() == id) {
-			_channels[i]->pause(paused);
+		if (isChannelActive(i) && _channelStates[i].id == id) {
+			pauseChannel(i, paused);
 			return;
 		}
 	}
 }
 
 void MixerImpl::pauseHandle(SoundHandle handle, bool paused) {
-	Common::StackLock lock(_mutex);
+	Common::StackLock lock(_controlMutex);
 
 	// Simply ignore (un)pause requests for sounds that already terminated
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	if (!findChannel(handle))
 		return;
 
-	_channels[index]->pause(paused);
+	pauseChannel(handle._val % NUM_CHANNELS, paused);
 }
 
 bool MixerImpl::isSoundIDActive(int id) {
-	Common::StackLock lock(_mutex);
+	Common::StackLock lock(_controlMutex);
 
 #ifdef ENABLE_EVENTRECORDER
 	g_eventRec.updateSubsystems();
 #endif
 
 	for (int i = 0; i != NUM_CHANNELS; i++)
-		if (_channels[i] && _channels[i]->getId() == id)
+		if (isChannelActive(i) && _channelStates[i].id == id)
 			return true;
 	return false;
 }
 
 int MixerImpl::getSoundID(SoundHandle handle) {
-	Common::StackLock lock(_mutex);
-	const int index = handle._val % NUM_CHANNELS;
-	if (_channels[index] && _channels[index]->getHandle()._val == handle._val)
-		return _channels[index]->getId();
+	Common::StackLock lock(_controlMutex);
+
+	const ChannelState *state = findChannel(handle);
+	if (state)
+		return state->id;
 	return 0;
 }
 
 bool MixerImpl::isSoundHandleActive(SoundHandle handle) {
-	Common::StackLock lock(_mutex);
+	Common::StackLock lock(_controlMutex);
 
 #ifdef ENABLE_EVENTRECORDER
 	g_eventRec.updateSubsystems();
 #endif
 
-	const int index = handle._val % NUM_CHANNELS;
-	return _channels[index] && _channels[index]->getHandle()._val == handle._val;
+	return findChannel(handle) != nullptr;
 }
 
 bool MixerImpl::hasActiveChannelOfType(SoundType type) {
-	Common::StackLock lock(_mutex);
+	Common::StackLock lock(_controlMutex);
 	for (int i = 0; i != NUM_CHANNELS; i++)
-		if (_channels[i] && _channels[i]->getType() == type)
+		if (isChannelActive(i) && _channelStates[i].type == type)
 			return true;
 	return false;
 }
@@ -552,12 +825,12 @@ void MixerImpl::setVolumeForSoundType(SoundType type, int volume) {
 	// TODO: Maybe we should do logarithmic (not linear) volume
 	// scaling? See also Player_V2::setMasterVolume
 
-	Common::StackLock lock(_mutex);
+	Common::StackLock lock(_controlMutex);
 	_soundTypeSettings[type].volume = volume;
 
 	for (int i = 0; i != NUM_CHANNELS; ++i) {
-		if (_channels[i] && _channels[i]->getType() == type)
-			_channels[i]->notifyGlobalVolChange();
+		if (isChannelActive(i) && _channelStates[i].type == type)
+			updateChannelVolumes(i);
 	}
 }
 
@@ -572,44 +845,27 @@ int MixerImpl::getVolumeForSoundType(SoundType type) const {
 #pragma mark --- Channel implementations ---
 #pragma mark -
 
-Channel::Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream,
-				 DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent)
-	: _type(type), _mixer(mixer), _id(id), _permanent(permanent), _volume(Mixer::kMaxChannelVolume),
-	  _balance(0), _pauseLevel(0), _samplesConsumed(0), _samplesDecoded(0), _mixerTimeStamp(0),
-	  _pauseStartTime(0), _pauseTime(0), _converter(nullptr), _volL(0), _volR(0),
+Channel::Channel(Mixer *mixer, AudioStream *stream,
+				 DisposeAfterUse::Flag autofreeStream, bool reverseStereo, RateConverterQuality quality)
+	: _pauseLevel(0), _volL(0), _volR(0), _mixer(mixer), _samplesConsumed(0), _samplesDecoded(0),
+	  _mixerTimeStamp(0), _pauseStartTime(0), _pauseTime(0), _quality(quality), _converter(nullptr),
 	  _stream(stream, autofreeStream) {
 	assert(mixer);
 	assert(stream);
 
 	// Get a rate converter instance
-	_converter = makeRateConverter(_stream->getRate(), mixer->getOutputRate(), _stream->isStereo(), mixer->getOutputStereo(), reverseStereo);
+	_converter = makeRateConverter(_stream->getRate(), mixer->getOutputRate(), _stream->isStereo(), mixer->getOutputStereo(), reverseStereo, quality);
 }
 
 Channel::~Channel() {
 	delete _converter;
 }
 
-void Channel::setVolume(const byte volume) {
-	_volume = volume;
-	updateChannelVolumes();
-}
-
-byte Channel::getVolume() {
-	return _volume;
-}
-
-void Channel::setBalance(const int8 balance) {
-	_balance = balance;
-	updateChannelVolumes();
-}
-
-int8 Channel::getBalance() {
-	return _balance;
-}
-
-void Channel::setRate(uint32 rate) {
+RateFilter *Channel::setRate(uint32 rate, RateFilter *filter) {
 	if (_converter)
-		_converter->setInputRate(rate);
+		return _converter->setInputRateWithFilter(rate, filter);
+
+	return filter;
 }
 
 uint32 Channel::getRate() {
@@ -619,52 +875,19 @@ uint32 Channel::getRate() {
 	return 0;
 }
 
-void Channel::resetRate() {
-	if (_converter && _stream) {
-		_converter->setInputRate(_stream->getRate());
-	}
-}
-
-void Channel::updateChannelVolumes() {
-	// From the channel balance/volume and the global volume, we compute
-	// the effective volume for the left and right channel. Note the
-	// slightly odd divisor: the 255 reflects the fact that the maximal
-	// value for _volume is 255, while the 127 is there because the
-	// balance value ranges from -127 to 127.  The mixer (music/sound)
-	// volume is in the range 0 - kMaxMixerVolume.
-	// Hence, the vol_l/vol_r values will be in that range, too
-
-	if (!_mixer->isSoundTypeMuted(_type)) {
-		int vol = _mixer->getVolumeForSoundType(_type) * _volume;
-
-		if (_balance == 0) {
-			_volL = vol / Mixer::kMaxChannelVolume;
-			_volR = vol / Mixer::kMaxChannelVolume;
-		} else if (_balance < 0) {
-			_volL = vol / Mixer::kMaxChannelVolume;
-			_volR = ((127 + _balance) * vol) / (Mixer::kMaxChannelVolume * 127);
-		} else {
-			_volL = ((127 - _balance) * vol) / (Mixer::kMaxChannelVolume * 127);
-			_volR = vol / Mixer::kMaxChannelVolume;
-		}
-	} else {
-		_volL = _volR = 0;
-	}
-}
-
-void Channel::pause(bool paused) {
+void Channel::pause(bool paused, uint32 time) {
 	//assert((paused && _pauseLevel >= 0) || (!paused && _pauseLevel));
 
 	if (paused) {
 		_pauseLevel++;
 
 		if (_pauseLevel == 1)
-			_pauseStartTime = g_system->getMillis(true);
+			_pauseStartTime = time;
 	} else if (_pauseLevel > 0) {
 		_pauseLevel--;
 
 		if (!_pauseLevel) {
-			_pauseTime = (g_system->getMillis(true) - _pauseStartTime);
+			_pauseTime = (time - _pauseStartTime);
 			_pauseStartTime = 0;
 		}
 	}
@@ -23,8 +23,12 @@
 #define AUDIO_MIXER_INTERN_H
 
 #include "common/scummsys.h"
+#include "common/atomic.h"
 #include "common/mutex.h"
 #include "audio/mixer.h"
+#include "audio/rate.h"
+
+class MixerTestSuite;
 
 namespace Audio {
 
@@ -49,6 +53,30 @@ namespace Audio {
  * 4) Change the mixer into ready mode via setReady(true).
  * 5) Start audio processing (e.g. by resuming the audio thread, if applicable).
  *
+ * Channel control requests (playStream(), stop*(), setChannelVolume() and
+ * friends) do not wait for the mixer callback: they update a shadow copy of
+ * the channel state and post a command to a single producer, single consumer
+ * queue which the callback drains before mixing. Stopped and finished
+ * channels are handed back through the queue as well, and deleted by the
+ * control side, so the callback never frees memory.
+ *
+ * A stream must not be touched any more once stop*() returned, since the
+ * caller may free the data it plays. Each slot therefore has a flag word in
+ * which the callback marks the channel it is working on, and stop*() marks
+ * the channel as stopped. The callback skips stopped channels, and stop*()
+ * only waits (without any lock held) if it caught the callback in the middle
+ * of that one channel.
+ * As a consequence, a stream must not stop its own channel from within
+ * readBuffer().
+ *
+ * The callback still holds mutex() while mixing, for the engines which use it
+ * to guard their streams, and getElapsedTime() takes it. The control side
+ * only takes it if the queue or the slots ran full because the callback did
+ * not run, and then drains the queue itself. On targets without atomic
+ * builtins or Interlocked intrinsics, the atomics fall back to a
+ * Common::Mutex each (see Common::Atomic), which are held only for a single
+ * operation.
+ *
  * In the future, we might make it possible for backends to provide
  * (partial) alternative implementations of the mixer, e.g. to make
  * better use of native sound mixing support on low-end devices.
@@ -56,18 +84,84 @@ namespace Audio {
  * @see OSystem::getMixer()
  */
 class MixerImpl : public Mixer {
+	friend class ::MixerTestSuite;
+
 private:
 	enum {
-		NUM_CHANNELS = 32
+		NUM_CHANNELS = 32,
+		COMMAND_QUEUE_SIZE = 256
+	};
+
+	/** Bits of _channelFlags */
+	enum {
+		kChannelMixing = 1 << 0,
+		kChannelStopped = 1 << 1
+	};
+
+	/**
+	 * A channel control request, queued by the control side and carried
+	 * out by the mixer callback, or by the control side itself with _mutex
+	 * held (see drainCommands()).
+	 */
+	struct Command {
+		enum Type {
+			kInsert,
+			kStop,
+			kVolume,
+			kPause,
+			kRate,
+			kLoop
+		};
+
+		Type type;
+		int index;
+		uint32 handle;
+		/**
+		 * For kInsert, the new channel. Once a kStop was carried out, the
+		 * channel it removed, which the control side deletes.
+		 */
+		Channel *channel;
+		uint32 arg1, arg2;
+		/**
+		 * For kRate, the filter built for the new rate. Once the command was
+		 * carried out, the filter the channel no longer uses, which the
+		 * control side deletes (see reclaimCommands()).
+		 */
+		RateFilter *filter;
+	};
+
+	/**
+	 * The control side view of a channel, owned by _controlMutex.
+	 */
+	struct ChannelState {
+		ChannelState() : active(false), retiring(false), handle(0), id(-1), type(kPlainSoundType), permanent(false),
+			volume(kMaxChannelVolume), balance(0), rate(0), streamRate(0), quality(kRateConverterLinear) {}
+
+		bool active;
+		/** The slot is not reusable until the callback removed the channel */
+		bool retiring;
+		uint32 handle;
+		int id;
+		SoundType type;
+		bool permanent;
+		byte volume;
+		int8 balance;
+		uint32 rate;
+		uint32 streamRate;
+		RateConverterQuality quality;
 	};
 
+	/** Serializes the mixer callback and mutex() users. */
 	Common::Mutex _mutex;
+	/** Serializes the control side; never taken by the mixer callback. */
+	Common::Mutex _controlMutex;
 
 	const uint _sampleRate;
 	const bool _stereo;
 	const uint _outBufSize;
 	bool _mixerReady;
 	uint32 _handleSeed;
+	RateConverterQuality _rateConverterQuality;
 
 	struct SoundTypeSettings {
 		SoundTypeSettings() : mute(false), volume(kMaxMixerVolume) {}
@@ -78,7 +172,18 @@ private:
 
 	SoundTypeSettings _soundTypeSettings[4];
 	Channel *_channels[NUM_CHANNELS];
+	ChannelState _channelStates[NUM_CHANNELS];
+
+	/** Handle of the last channel which finished playing in each slot. */
+	Common::Atomic<uint32> _finishedHandles[NUM_CHANNELS];
+	/** kChannelMixing and kChannelStopped, for the channel in each slot */
+	Common::Atomic<uint32> _channelFlags[NUM_CHANNELS];
 
+	Command _commands[COMMAND_QUEUE_SIZE];
+	Common::Atomic<uint> _commandsHead;
+	Common::Atomic<uint> _commandsTail;
+	/** First queue slot which the control side did not reclaim yet */
+	uint _commandsReclaimed;
 
 public:
 
@@ -136,8 +241,37 @@ public:
 	virtual bool getOutputStereo() const;
 	virtual uint getOutputBufSize() const;
 
+	/**
+	 * Set the resampling quality used for streams started from now on.
+	 * The initial value is taken from the "resampler_quality" config key.
+	 */
+	void setRateConverterQuality(RateConverterQuality quality);
+	RateConverterQuality getRateConverterQuality() const { return _rateConverterQuality; }
+
 protected:
-	void insertChannel(SoundHandle *handle, Channel *chan);
+	int findFreeSlot();
+	void insertChannel(SoundHandle *handle, Channel *chan, SoundType type, int id, byte volume, int8 balance, bool permanent);
+
+private:
+	ChannelState *findChannel(SoundHandle handle);
+	bool isChannelActive(int index);
+	void retireChannel(int index);
+	/** Returns the bit of the slot if the callback has to be waited for. */
+	uint32 stopChannel(int index);
+	void waitForChannels(uint32 slots);
+	bool enterChannel(int index);
+	void leaveChannel(int index);
+	void pauseChannel(int index, bool paused);
+	void computeChannelVolumes(const ChannelState &state, uint16 &volL, uint16 &volR) const;
+	void updateChannelVolumes(int index);
+
+	void postCommand(Command::Type type, int index, Channel *channel = nullptr, uint32 arg1 = 0, uint32 arg2 = 0, RateFilter *filter = nullptr);
+	void postRateCommand(int index, uint32 oldRate, uint32 newRate);
+	bool pushCommand(const Command &cmd);
+	void reclaimCommands();
+	void drainCommands();
+	void executeCommand(Command &cmd);
+	void processCommands();
 
 public:
 	/**
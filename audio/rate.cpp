@@ -29,11 +29,49 @@
 
 #include "audio/audiostream.h"
 #include "audio/rate.h"
+#include "audio/rate_intern.h"
 #include "audio/mixer.h"
 #include "common/util.h"
 
 namespace Audio {
 
+void clampedAddBuffer(st_sample_t *dst, const st_sample_t *src, st_size_t numSamples) {
+	st_size_t i = 0;
+
+#if defined(AUDIO_RATE_SSE2)
+#ifdef OUTPUT_UNSIGNED_AUDIO
+	const __m128i bias = _mm_set1_epi16((int16)0x8000);
+#endif
+	for (; i + 8 <= numSamples; i += 8) {
+		__m128i a = _mm_loadu_si128((const __m128i *)(dst + i));
+		const __m128i b = _mm_loadu_si128((const __m128i *)(src + i));
+#ifdef OUTPUT_UNSIGNED_AUDIO
+		a = _mm_xor_si128(_mm_adds_epi16(_mm_xor_si128(a, bias), b), bias);
+#else
+		a = _mm_adds_epi16(a, b);
+#endif
+		_mm_storeu_si128((__m128i *)(dst + i), a);
+	}
+#elif defined(AUDIO_RATE_NEON)
+#ifdef OUTPUT_UNSIGNED_AUDIO
+	const int16x8_t bias = vdupq_n_s16((int16)0x8000);
+#endif
+	for (; i + 8 <= numSamples; i += 8) {
+		int16x8_t a = vld1q_s16(dst + i);
+		const int16x8_t b = vld1q_s16(src + i);
+#ifdef OUTPUT_UNSIGNED_AUDIO
+		a = veorq_s16(vqaddq_s16(veorq_s16(a, bias), b), bias);
+#else
+		a = vqaddq_s16(a, b);
+#endif
+		vst1q_s16(dst + i, a);
+	}
+#endif
+
+	for (; i < numSamples; i++)
+		clampedAdd(dst[i], src[i]);
+}
+
 /**
  * The default fractional type in frac.h (with 16 fractional bits) limits
  * the rate conversion code to 65536Hz audio: we need to able to handle
@@ -112,7 +150,7 @@ int RateConverter_Impl<inStereo, outStereo, reverseStereo>::copyConvert(AudioStr
 				return (outBuffer - outStart) / (outStereo ? 2 : 1);
 		}
 
-		// Mix the data into the output buffer
+		// Store the data in the output buffer
 		st_sample_t inL, inR;
 		inL = *_bufferPos++;
 		inR = (inStereo ? *_bufferPos++ : inL);
@@ -124,15 +162,15 @@ int RateConverter_Impl<inStereo, outStereo, reverseStereo>::copyConvert(AudioStr
 
 		if (outStereo) {
 			// Output left channel
-			clampedAdd(outBuffer[reverseStereo    ], outL);
+			outBuffer[reverseStereo    ] = outL;
 
 			// Output right channel
-			clampedAdd(outBuffer[reverseStereo ^ 1], outR);
+			outBuffer[reverseStereo ^ 1] = outR;
 
 			outBuffer += 2;
 		} else {
 			// Output mono channel
-			clampedAdd(outBuffer[0], (outL + outR) / 2);
+			outBuffer[0] = (outL + outR) / 2;
 
 			outBuffer += 1;
 		}
@@ -184,15 +222,15 @@ int RateConverter_Impl<inStereo, outStereo, reverseStereo>::simpleConvert(AudioS
 
 		if (outStereo) {
 			// output left channel
-			clampedAdd(outBuffer[reverseStereo    ], outL);
+			outBuffer[reverseStereo    ] = outL;
 
 			// output right channel
-			clampedAdd(outBuffer[reverseStereo ^ 1], outR);
+			outBuffer[reverseStereo ^ 1] = outR;
 
 			outBuffer += 2;
 		} else {
 			// output mono channel
-			clampedAdd(outBuffer[0], (outL + outR) / 2);
+			outBuffer[0] = (outL + outR) / 2;
 
 			outBuffer += 1;
 		}
@@ -249,15 +287,15 @@ int RateConverter_Impl<inStereo, outStereo, reverseStereo>::interpolateConvert(A
 
 			if (outStereo) {
 				// Output left channel
-				clampedAdd(outBuffer[reverseStereo    ], outL);
+				outBuffer[reverseStereo    ] = outL;
 
 				// Output right channel
-				clampedAdd(outBuffer[reverseStereo ^ 1], outR);
+				outBuffer[reverseStereo ^ 1] = outR;
 
 				outBuffer += 2;
 			} else {
 				// Output mono channel
-				clampedAdd(outBuffer[0], (outL + outR) / 2);
+				outBuffer[0] = (outL + outR) / 2;
 
 				outBuffer += 1;
 			}
@@ -286,18 +324,42 @@ template<bool inStereo, bool outStereo, bool reverseStereo>
 int RateConverter_Impl<inStereo, outStereo, reverseStereo>::convert(AudioStream &input, st_sample_t *outBuffer, st_size_t numSamples, st_volume_t volL, st_volume_t volR) {
 	assert(input.isStereo() == inStereo);
 
-	if (_inRate == _outRate) {
-		return copyConvert(input, outBuffer, numSamples, volL, volR);
-	} else {
-		if ((_inRate % _outRate) == 0 && (_inRate < 65536)) {
-			return simpleConvert(input, outBuffer, numSamples, volL, volR);
+	// The conversion routines overwrite their output, so work in chunks
+	// and mix each of them into outBuffer in one go
+	st_sample_t mixBuffer[512];
+	const st_size_t maxChunk = ARRAYSIZE(mixBuffer) / (outStereo ? 2 : 1);
+
+	int written = 0;
+	while (numSamples > 0) {
+		const st_size_t chunk = MIN<st_size_t>(numSamples, maxChunk);
+		int converted;
+
+		if (_inRate == _outRate) {
+			converted = copyConvert(input, mixBuffer, chunk, volL, volR);
 		} else {
-			return interpolateConvert(input, outBuffer, numSamples, volL, volR);
+			if ((_inRate % _outRate) == 0 && (_inRate < 65536)) {
+				converted = simpleConvert(input, mixBuffer, chunk, volL, volR);
+			} else {
+				converted = interpolateConvert(input, mixBuffer, chunk, volL, volR);
+			}
 		}
+
+		clampedAddBuffer(outBuffer, mixBuffer, converted * (outStereo ? 2 : 1));
+		outBuffer += converted * (outStereo ? 2 : 1);
+		written += converted;
+		numSamples -= converted;
+
+		if ((st_size_t)converted < chunk)
+			break;
 	}
+
+	return written;
 }
 
-RateConverter *makeRateConverter(st_rate_t inRate, st_rate_t outRate, bool inStereo, bool outStereo, bool reverseStereo) {
+RateConverter *makeRateConverter(st_rate_t inRate, st_rate_t outRate, bool inStereo, bool outStereo, bool reverseStereo, RateConverterQuality quality) {
+	if (quality != kRateConverterLinear)
+		return makeSincRateConverter(inRate, outRate, inStereo, outStereo, reverseStereo, quality);
+
 	if (inStereo) {
 		if (outStereo) {
 			if (reverseStereo)
@@ -314,4 +376,11 @@ RateConverter *makeRateConverter(st_rate_t inRate, st_rate_t outRate, bool inSte
 	}
 }
 
+RateFilter *makeRateFilter(st_rate_t oldInRate, st_rate_t newInRate, st_rate_t outRate, RateConverterQuality quality) {
+	if (quality != kRateConverterLinear)
+		return makeSincRateFilter(oldInRate, newInRate, outRate, quality);
+
+	return nullptr;
+}
+
 } // End of namespace Audio
@@ -40,6 +40,14 @@ typedef uint16 st_volume_t;
 typedef uint32 st_size_t;
 typedef uint32 st_rate_t;
 
+/** Resampling quality presets, see makeRateConverter(). */
+enum RateConverterQuality {
+	kRateConverterLinear, /*!< Linear interpolation, the cheapest option. */
+	kRateConverterFast,   /*!< Windowed sinc filter with 8 taps. */
+	kRateConverterMedium, /*!< Windowed sinc filter with 16 taps. */
+	kRateConverterBest    /*!< Windowed sinc filter with 32 taps. */
+};
+
 /* Minimum and maximum values a sample can hold. */
 enum {
 	ST_SAMPLE_MAX = 0x7fffL,
@@ -66,6 +74,27 @@ static inline void clampedAdd(int16& a, int b) {
 #endif
 }
 
+/**
+ * Add the samples in @p src to the ones in @p dst, clamping the results in
+ * the same way as clampedAdd() does. Uses SSE2 or NEON when the target
+ * guarantees them.
+ *
+ * @param dst			Buffer to mix into.
+ * @param src			Samples to add.
+ * @param numSamples	Number of samples (not sample pairs) in both buffers.
+ */
+void clampedAddBuffer(st_sample_t *dst, const st_sample_t *src, st_size_t numSamples);
+
+/**
+ * Coefficients a RateConverter needs for a particular pair of rates.
+ *
+ * @see makeRateFilter()
+ */
+class RateFilter {
+public:
+	virtual ~RateFilter() {}
+};
+
 /**
  * Helper class that handles resampling an AudioStream between an input and output
  * sample rate. Its regular use case is upsampling from the native stream rate
@@ -93,6 +122,22 @@ public:
 	virtual void setInputRate(st_rate_t inputRate) = 0;
 	virtual void setOutputRate(st_rate_t outputRate) = 0;
 
+	/**
+	 * Change the input rate like setInputRate(), but switch to a filter
+	 * which was built in advance with makeRateFilter(). This neither
+	 * allocates memory nor computes coefficients, so it may be called from
+	 * the audio callback.
+	 *
+	 * @param inputRate	The new input rate.
+	 * @param filter	The filter returned by makeRateFilter() for the change
+	 *					to @p inputRate, which the converter takes over.
+	 *					nullptr keeps the current filter.
+	 *
+	 * @return The filter which is no longer used and has to be deleted by
+	 *         the caller, or nullptr.
+	 */
+	virtual RateFilter *setInputRateWithFilter(st_rate_t inputRate, RateFilter *filter) { setInputRate(inputRate); return filter; }
+
 	virtual st_rate_t getInputRate() const = 0;
 	virtual st_rate_t getOutputRate() const = 0;
 
@@ -104,7 +149,28 @@ public:
 	virtual bool needsDraining() const = 0;
 };
 
-RateConverter *makeRateConverter(st_rate_t inRate, st_rate_t outRate, bool inStereo, bool outStereo, bool reverseStereo);
+/**
+ * Create a RateConverter for the given input and output formats.
+ *
+ * The windowed sinc presets filter the input with a polyphase filter bank.
+ * They produce a much cleaner output than linear interpolation, which aliases
+ * audibly when upsampling low rate sound effects to 48 or 96 kHz, at a higher
+ * CPU cost. The number of taps grows with the ratio when downsampling.
+ */
+RateConverter *makeRateConverter(st_rate_t inRate, st_rate_t outRate, bool inStereo, bool outStereo, bool reverseStereo, RateConverterQuality quality = kRateConverterLinear);
+
+/**
+ * Build the filter a converter of the given quality needs when its input
+ * rate changes from @p oldInRate to @p newInRate, for passing to
+ * RateConverter::setInputRateWithFilter().
+ *
+ * Computing a filter bank is expensive, so this is meant to be called on the
+ * thread requesting the change rather than in the audio callback.
+ *
+ * @return The new filter, or nullptr if the converter can keep its current
+ *         one (always the case for kRateConverterLinear).
+ */
+RateFilter *makeRateFilter(st_rate_t oldInRate, st_rate_t newInRate, st_rate_t outRate, RateConverterQuality quality);
 
 /** @} */
 } // End of namespace Audio
@@ -0,0 +1,44 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef AUDIO_RATE_INTERN_H
+#define AUDIO_RATE_INTERN_H
+
+#include "audio/rate.h"
+
+// SSE2 and NEON are part of the x86-64 and AArch64 base instruction sets, so
+// the resampling and mixing code can use them without a runtime check
+#if defined(SCUMMVM_SSE2) && (defined(__x86_64__) || defined(_M_X64))
+#define AUDIO_RATE_SSE2
+#include <emmintrin.h>
+#elif defined(SCUMMVM_NEON) && (defined(__aarch64__) || defined(_M_ARM64))
+#define AUDIO_RATE_NEON
+#include <arm_neon.h>
+#endif
+
+namespace Audio {
+
+RateConverter *makeSincRateConverter(st_rate_t inRate, st_rate_t outRate, bool inStereo, bool outStereo, bool reverseStereo, RateConverterQuality quality);
+RateFilter *makeSincRateFilter(st_rate_t oldInRate, st_rate_t newInRate, st_rate_t outRate, RateConverterQuality quality);
+
+} // End of namespace Audio
+
+#endif
@@ -0,0 +1,491 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "audio/audiostream.h"
+#include "audio/mixer.h"
+#include "audio/rate_intern.h"
+#include "common/array.h"
+#include "common/util.h"
+
+#include <math.h>
+
+namespace Audio {
+
+namespace {
+
+struct SincPreset {
+	int taps;        /*!< Taps per phase when upsampling, a multiple of 8. */
+	int phases;      /*!< Number of fractional positions in the filter bank. */
+	double passband; /*!< Cutoff frequency, relative to the lower Nyquist frequency. */
+	double beta;     /*!< Kaiser window shape. */
+};
+
+const SincPreset sincPresets[] = {
+	{  8,  64, 0.80, 5.0 }, // kRateConverterFast
+	{ 16, 128, 0.88, 7.0 }, // kRateConverterMedium
+	{ 32, 256, 0.94, 9.0 }  // kRateConverterBest
+};
+
+enum {
+	kMaxTaps = 128
+};
+
+const SincPreset &getPreset(RateConverterQuality quality) {
+	return sincPresets[CLIP<int>(quality - kRateConverterFast, 0, ARRAYSIZE(sincPresets) - 1)];
+}
+
+/** Zeroth order modified Bessel function of the first kind. */
+double besselI0(double x) {
+	const double q = x * x / 4.0;
+	double sum = 1.0, term = 1.0;
+
+	for (int k = 1; k < 64 && term > sum * 1e-12; k++) {
+		term *= q / ((double)k * k);
+		sum += term;
+	}
+
+	return sum;
+}
+
+/** Sum of samples[i] * coefs[i], for a multiple of 8 taps. */
+inline int32 dotProduct(const int16 *samples, const int16 *coefs, int taps) {
+#if defined(AUDIO_RATE_SSE2)
+	__m128i acc = _mm_setzero_si128();
+	for (int i = 0; i < taps; i += 8) {
+		const __m128i s = _mm_loadu_si128((const __m128i *)(samples + i));
+		const __m128i c = _mm_loadu_si128((const __m128i *)(coefs + i));
+		acc = _mm_add_epi32(acc, _mm_madd_epi16(s, c));
+	}
+	acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+	acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtsi128_si32(acc);
+#elif defined(AUDIO_RATE_NEON)
+	int32x4_t acc = vdupq_n_s32(0);
+	for (int i = 0; i < taps; i += 8) {
+		const int16x8_t s = vld1q_s16(samples + i);
+		const int16x8_t c = vld1q_s16(coefs + i);
+		acc = vmlal_s16(acc, vget_low_s16(s), vget_low_s16(c));
+		acc = vmlal_s16(acc, vget_high_s16(s), vget_high_s16(c));
+	}
+	int32x2_t sum = vadd_s32(vget_low_s32(acc), vget_high_s32(acc));
+	sum = vpadd_s32(sum, sum);
+	return vget_lane_s32(sum, 0);
+#else
+	int32 acc = 0;
+	for (int i = 0; i < taps; i++)
+		acc += samples[i] * coefs[i];
+	return acc;
+#endif
+}
+
+inline st_sample_t filterResult(int32 acc) {
+	return (st_sample_t)CLIP<int32>((acc + (1 << 14)) >> 15, ST_SAMPLE_MIN, ST_SAMPLE_MAX);
+}
+
+/** A polyphase filter bank for one ratio of input and output rate. */
+class SincFilter : public RateFilter {
+public:
+	SincFilter(const SincPreset &preset, int taps_, double cutoff_);
+
+	/**
+	 * Compute the size and cutoff of the filter for the given rates. When
+	 * downsampling, the filter is widened so that it still reaches into the
+	 * stop band.
+	 */
+	static void getShape(const SincPreset &preset, st_rate_t inRate, st_rate_t outRate, int &taps, double &cutoff);
+
+	/**
+	 * Build the filter for the new rates, or return nullptr if it would be
+	 * identical to the one for the old rates. The cutoff only changes when
+	 * downsampling, so pitch changes of upsampled sounds do not build a new
+	 * bank.
+	 */
+	static SincFilter *makeForChange(const SincPreset &preset, st_rate_t oldInRate, st_rate_t oldOutRate, st_rate_t newInRate, st_rate_t newOutRate);
+
+	const int taps;
+	const double cutoff;
+	/** phases rows of taps coefficients, in 1.15 fixed point */
+	Common::Array<int16> coefs;
+};
+
+SincFilter::SincFilter(const SincPreset &preset, int taps_, double cutoff_) : taps(taps_), cutoff(cutoff_) {
+	const int phases = preset.phases;
+	const int center = taps / 2 - 1;
+	const double halfWidth = taps / 2.0;
+	const double windowScale = 1.0 / besselI0(preset.beta);
+
+	coefs.resize(phases * taps);
+	Common::Array<double> row(taps);
+
+	for (int p = 0; p < phases; p++) {
+		double sum = 0.0;
+		for (int k = 0; k < taps; k++) {
+			const double x = k - center - (double)p / phases;
+			const double t = x / halfWidth;
+			const double window = (t * t < 1.0) ? besselI0(preset.beta * sqrt(1.0 - t * t)) * windowScale : 0.0;
+			const double arg = M_PI * cutoff * x;
+			const double sinc = (x == 0.0) ? 1.0 : sin(arg) / arg;
+			row[k] = cutoff * sinc * window;
+			sum += row[k];
+		}
+
+		// Normalize every phase to unity gain, putting the rounding error
+		// on the largest tap, so that there is no ripple on constant input
+		int16 *phase = &coefs[p * taps];
+		int total = 0, largest = 0;
+		for (int k = 0; k < taps; k++) {
+			phase[k] = (int16)CLIP<int>((int)floor(row[k] / sum * 32768.0 + 0.5), -32767, 32767);
+			total += phase[k];
+			if (ABS(phase[k]) > ABS(phase[largest]))
+				largest = k;
+		}
+		phase[largest] = (int16)CLIP<int>(phase[largest] + 32768 - total, -32767, 32767);
+	}
+}
+
+void SincFilter::getShape(const SincPreset &preset, st_rate_t inRate, st_rate_t outRate, int &taps, double &cutoff) {
+	const int ratio = (inRate + outRate - 1) / outRate;
+	taps = MIN<int>(preset.taps * MAX(ratio, 1), kMaxTaps);
+	cutoff = preset.passband * MIN<double>(1.0, (double)outRate / inRate);
+}
+
+SincFilter *SincFilter::makeForChange(const SincPreset &preset, st_rate_t oldInRate, st_rate_t oldOutRate, st_rate_t newInRate, st_rate_t newOutRate) {
+	int oldTaps, newTaps;
+	double oldCutoff, newCutoff;
+	getShape(preset, oldInRate, oldOutRate, oldTaps, oldCutoff);
+	getShape(preset, newInRate, newOutRate, newTaps, newCutoff);
+
+	if (oldTaps == newTaps && oldCutoff == newCutoff)
+		return nullptr;
+	return new SincFilter(preset, newTaps, newCutoff);
+}
+
+} // End of anonymous namespace
+
+/**
+ * Polyphase windowed sinc resampler.
+ *
+ * Input is kept in one history buffer per channel. Every output frame is the
+ * dot product of the input around its position with the filter bank phase at
+ * or just before its fractional position. The output position is tracked as
+ * an exact fraction of the output rate, so there is no drift over time.
+ *
+ * setInputRate() and setOutputRate() build a new filter bank right away if
+ * the ratio requires one; setInputRateWithFilter() takes over one which was
+ * built by makeRateFilter() in advance.
+ */
+template<bool inStereo, bool outStereo, bool reverseStereo>
+class SincRateConverter : public RateConverter {
+public:
+	SincRateConverter(st_rate_t inputRate, st_rate_t outputRate, RateConverterQuality quality);
+	~SincRateConverter();
+
+	int convert(AudioStream &input, st_sample_t *outBuffer, st_size_t numSamples, st_volume_t volL, st_volume_t volR) override;
+
+	void setInputRate(st_rate_t inputRate) override;
+	void setOutputRate(st_rate_t outputRate) override;
+	RateFilter *setInputRateWithFilter(st_rate_t inputRate, RateFilter *filter) override;
+
+	st_rate_t getInputRate() const override { return _inRate; }
+	st_rate_t getOutputRate() const override { return _outRate; }
+
+	bool needsDraining() const override { return _pos + _filter->taps / 2 - 1 < _dataEnd; }
+
+private:
+	enum {
+		kBlockFrames = 256,
+		kHistoryFrames = kBlockFrames + kMaxTaps,
+		kChannels = inStereo ? 2 : 1
+	};
+
+	void updateStep();
+	SincFilter *switchFilter(SincFilter *filter);
+	bool fill(AudioStream &input);
+	int resample(AudioStream &input, st_sample_t *outBuffer, int numFrames, st_volume_t volL, st_volume_t volR);
+
+	const SincPreset &_preset;
+	st_rate_t _inRate, _outRate;
+	st_rate_t _stepInt, _stepFrac;
+
+	SincFilter *_filter;
+
+	/**
+	 * fill() keeps up to kHistoryFrames frames in here. The extra space is
+	 * for the silence switchFilter() may insert in front of them.
+	 */
+	int16 _history[kChannels][kHistoryFrames + kMaxTaps / 2];
+	/** Number of frames in _history */
+	int _historyFrames;
+	/** First history frame used for the next output frame */
+	int _pos;
+	/** Output position between _pos and _pos + 1, in 1 / _outRate units */
+	st_rate_t _frac;
+	/** End of the stream data in _history; anything after it is padding */
+	int _dataEnd;
+	/** Whether the stream ended and the filter was flushed with silence */
+	bool _padded;
+
+	st_sample_t _readBuffer[kBlockFrames * kChannels];
+};
+
+template<bool inStereo, bool outStereo, bool reverseStereo>
+SincRateConverter<inStereo, outStereo, reverseStereo>::SincRateConverter(st_rate_t inputRate, st_rate_t outputRate, RateConverterQuality quality) :
+	_preset(getPreset(quality)),
+	_inRate(inputRate),
+	_outRate(outputRate),
+	_stepInt(0),
+	_stepFrac(0),
+	_frac(0),
+	_padded(false) {
+
+	int taps;
+	double cutoff;
+	SincFilter::getShape(_preset, inputRate, outputRate, taps, cutoff);
+	_filter = new SincFilter(_preset, taps, cutoff);
+
+	// The filter for the first output is centered on frame 0
+	_pos = 0;
+	_historyFrames = _dataEnd = taps / 2 - 1;
+	for (int c = 0; c < kChannels; c++)
+		memset(_history[c], 0, _historyFrames * sizeof(int16));
+
+	updateStep();
+}
+
+template<bool inStereo, bool outStereo, bool reverseStereo>
+SincRateConverter<inStereo, outStereo, reverseStereo>::~SincRateConverter() {
+	delete _filter;
+}
+
+template<bool inStereo, bool outStereo, bool reverseStereo>
+void SincRateConverter<inStereo, outStereo, reverseStereo>::setInputRate(st_rate_t inputRate) {
+	delete setInputRateWithFilter(inputRate, SincFilter::makeForChange(_preset, _inRate, _outRate, inputRate, _outRate));
+}
+
+template<bool inStereo, bool outStereo, bool reverseStereo>
+void SincRateConverter<inStereo, outStereo, reverseStereo>::setOutputRate(st_rate_t outputRate) {
+	SincFilter *filter = SincFilter::makeForChange(_preset, _inRate, _outRate, _inRate, outputRate);
+
+	_frac = (st_rate_t)(((uint64)_frac * outputRate) / _outRate);
+	_outRate = outputRate;
+	updateStep();
+
+	if (filter)
+		delete switchFilter(filter);
+}
+
+template<bool inStereo, bool outStereo, bool reverseStereo>
+RateFilter *SincRateConverter<inStereo, outStereo, reverseStereo>::setInputRateWithFilter(st_rate_t inputRate, RateFilter *filter) {
+	_inRate = inputRate;
+	updateStep();
+
+	if (!filter)
+		return nullptr;
+	return switchFilter(static_cast<SincFilter *>(filter));
+}
+
+template<bool inStereo, bool outStereo, bool reverseStereo>
+void SincRateConverter<inStereo, outStereo, reverseStereo>::updateStep() {
+	_stepInt = _inRate / _outRate;
+	_stepFrac = _inRate % _outRate;
+}
+
+template<bool inStereo, bool outStereo, bool reverseStereo>
+SincFilter *SincRateConverter<inStereo, outStereo, reverseStereo>::switchFilter(SincFilter *filter) {
+	SincFilter *oldFilter = _filter;
+	_filter = filter;
+
+	// Keep the next output frame centered on the same input frame
+	_pos += oldFilter->taps / 2 - filter->taps / 2;
+	if (_pos < 0) {
+		// The wider filter reaches back further than the history, whose
+		// frames were dropped already: pad it with silence in front
+		const int padding = -_pos;
+		for (int c = 0; c < kChannels; c++) {
+			memmove(_history[c] + padding, _history[c], _historyFrames * sizeof(int16));
+			memset(_history[c], 0, padding * sizeof(int16));
+		}
+		_historyFrames += padding;
+		_dataEnd += padding;
+		_pos = 0;
+	}
+
+	return oldFilter;
+}
+
+template<bool inStereo, bool outStereo, bool reverseStereo>
+bool SincRateConverter<inStereo, outStereo, reverseStereo>::fill(AudioStream &input) {
+	// Drop the frames the filter has moved past. When downsampling, _pos
+	// may be beyond the end of the history, in which case it keeps pointing
+	// past the frames which are read next.
+	const int drop = MIN(_pos, _historyFrames);
+	for (int c = 0; c < kChannels; c++)
+		memmove(_history[c], _history[c] + drop, (_historyFrames - drop) * sizeof(int16));
+	_historyFrames -= drop;
+	_dataEnd -= drop;
+	_pos -= drop;
+
+	if (!_padded) {
+		const int frames = MIN<int>(kHistoryFrames - _historyFrames, kBlockFrames);
+		const int read = input.readBuffer(_readBuffer, frames * kChannels) / kChannels;
+
+		if (read > 0) {
+			const st_sample_t *src = _readBuffer;
+			int16 *left = _history[0] + _historyFrames;
+			if (inStereo) {
+				int16 *right = _history[kChannels - 1] + _historyFrames;
+				for (int i = 0; i < read; i++) {
+					left[i] = *src++;
+					right[i] = *src++;
+				}
+			} else {
+				memcpy(left, src, read * sizeof(int16));
+			}
+
+			_historyFrames += read;
+			_dataEnd = _historyFrames;
+			return true;
+		}
+
+		// Streams which temporarily ran out of data are resumed later on
+		if (!input.endOfStream())
+			return false;
+
+		_padded = true;
+	}
+
+	// Flush the filter with silence. The filter may have been switched to
+	// a wider one since the stream ended, which needs more of it.
+	const int padding = MIN<int>(kHistoryFrames - _historyFrames, _dataEnd + _filter->taps - _historyFrames);
+	if (padding <= 0)
+		return false;
+
+	for (int c = 0; c < kChannels; c++)
+		memset(_history[c] + _historyFrames, 0, padding * sizeof(int16));
+	_historyFrames += padding;
+	return true;
+}
+
+template<bool inStereo, bool outStereo, bool reverseStereo>
+int SincRateConverter<inStereo, outStereo, reverseStereo>::resample(AudioStream &input, st_sample_t *outBuffer, int numFrames, st_volume_t volL, st_volume_t volR) {
+	const int taps = _filter->taps;
+	const int center = taps / 2 - 1;
+	const bool sameRate = (_inRate == _outRate);
+	int produced = 0;
+
+	while (produced < numFrames) {
+		if (_pos + taps > _historyFrames) {
+			if (!fill(input))
+				break;
+			continue;
+		}
+
+		if (_padded && _pos + center >= _dataEnd)
+			break;
+
+		// Produce as many frames as the history allows in one go
+		while (produced < numFrames && _pos + taps <= _historyFrames) {
+			st_sample_t inL, inR;
+
+			if (sameRate) {
+				inL = _history[0][_pos + center];
+				inR = inStereo ? _history[kChannels - 1][_pos + center] : inL;
+			} else {
+				const int16 *coefs = &_filter->coefs[(_frac * _preset.phases / _outRate) * taps];
+				inL = filterResult(dotProduct(_history[0] + _pos, coefs, taps));
+				inR = inStereo ? filterResult(dotProduct(_history[kChannels - 1] + _pos, coefs, taps)) : inL;
+			}
+
+			st_sample_t outL, outR;
+			outL = (inL * (int)volL) / Audio::Mixer::kMaxMixerVolume;
+			outR = (inR * (int)volR) / Audio::Mixer::kMaxMixerVolume;
+
+			if (outStereo) {
+				outBuffer[reverseStereo    ] = outL;
+				outBuffer[reverseStereo ^ 1] = outR;
+				outBuffer += 2;
+			} else {
+				outBuffer[0] = (outL + outR) / 2;
+				outBuffer += 1;
+			}
+			produced++;
+
+			_frac += _stepFrac;
+			if (_frac >= _outRate) {
+				_frac -= _outRate;
+				_pos++;
+			}
+			_pos += _stepInt;
+
+			if (_padded && _pos + center >= _dataEnd)
+				break;
+		}
+	}
+
+	return produced;
+}
+
+template<bool inStereo, bool outStereo, bool reverseStereo>
+int SincRateConverter<inStereo, outStereo, reverseStereo>::convert(AudioStream &input, st_sample_t *outBuffer, st_size_t numSamples, st_volume_t volL, st_volume_t volR) {
+	assert(input.isStereo() == inStereo);
+
+	st_sample_t mixBuffer[512];
+	const st_size_t maxChunk = ARRAYSIZE(mixBuffer) / (outStereo ? 2 : 1);
+
+	int written = 0;
+	while (numSamples > 0) {
+		const st_size_t chunk = MIN<st_size_t>(numSamples, maxChunk);
+		const int converted = resample(input, mixBuffer, chunk, volL, volR);
+
+		clampedAddBuffer(outBuffer, mixBuffer, converted * (outStereo ? 2 : 1));
+		outBuffer += converted * (outStereo ? 2 : 1);
+		written += converted;
+		numSamples -= converted;
+
+		if ((st_size_t)converted < chunk)
+			break;
+	}
+
+	return written;
+}
+
+RateConverter *makeSincRateConverter(st_rate_t inRate, st_rate_t outRate, bool inStereo, bool outStereo, bool reverseStereo, RateConverterQuality quality) {
+	if (inStereo) {
+		if (outStereo) {
+			if (reverseStereo)
+				return new SincRateConverter<true, true, true>(inRate, outRate, quality);
+			else
+				return new SincRateConverter<true, true, false>(inRate, outRate, quality);
+		} else
+			return new SincRateConverter<true, false, false>(inRate, outRate, quality);
+	} else {
+		if (outStereo) {
+			return new SincRateConverter<false, true, false>(inRate, outRate, quality);
+		} else
+			return new SincRateConverter<false, false, false>(inRate, outRate, quality);
+	}
+}
+
+RateFilter *makeSincRateFilter(st_rate_t oldInRate, st_rate_t newInRate, st_rate_t outRate, RateConverterQuality quality) {
+	return SincFilter::makeForChange(getPreset(quality), oldInRate, outRate, newInRate, outRate);
+}
+
+} // End of namespace Audio
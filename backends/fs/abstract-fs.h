@@ -172,6 +172,22 @@ public:
 	 */
 	virtual bool isWritable() const = 0;
 
+	/**
+	 * Retrieves the size and the last modification time of the file referred
+	 * by this node, without opening it. The time is only meant to be compared
+	 * against earlier values for the same file.
+	 *
+	 * @param size             the size of the file in bytes
+	 * @param modificationTime opaque modification timestamp
+	 *
+	 * @return true if the information is available, false otherwise.
+	 *
+	 * The default implementation provides nothing, so callers must treat
+	 * files as possibly modified (e.g. the detection MD5 cache then hashes
+	 * them again on every run).
+	 */
+	virtual bool getFileStats(int64 &size, int64 &modificationTime) const { return false; }
+
 
 	/**
 	 * Creates a SeekableReadStream instance corresponding to the file
@@ -182,6 +198,20 @@ public:
 	 */
 	virtual Common::SeekableReadStream *createReadStream() = 0;
 
+	/**
+	 * Like createReadStream(), but the stream may map the file into memory,
+	 * in which case getRangePointer() gives direct access to its data.
+	 *
+	 * Only meant for read-only game data which is read at random a lot. Read
+	 * errors on mapped files cannot be reported as such, so backends only map
+	 * files on fixed local disks. Backends may also leave small files to
+	 * createReadStream(). The default implementation just calls
+	 * createReadStream().
+	 *
+	 * @return pointer to the stream object, 0 in case of a failure
+	 */
+	virtual Common::SeekableReadStream *createMappedReadStream();
+
 	/**
 	 * Creates a SeekableReadStream instance corresponding to an alternate
 	 * stream of the file referred by this node. This assumes that the node
@@ -0,0 +1,168 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "backends/fs/posix/posix-mmapstream.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Mappings are only used where we can tell which filesystem a file is on
+#if defined(_POSIX_MAPPED_FILES) && _POSIX_MAPPED_FILES > 0
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/vfs.h>
+#define POSIX_MMAPSTREAM_AVAILABLE
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__) || defined(__DragonFly__)
+#include <sys/mman.h>
+#include <sys/param.h>
+#include <sys/mount.h>
+#define POSIX_MMAPSTREAM_AVAILABLE
+#endif
+#endif
+
+#ifdef POSIX_MMAPSTREAM_AVAILABLE
+/**
+ * Check whether the file is on a fixed local disk. Errors reading a mapped
+ * file are only reported through SIGBUS, so files on network shares and on
+ * media which may be pulled out (or be scratched) are never mapped.
+ */
+static bool isOnFixedLocalDisk(int fd) {
+	struct statfs fs;
+	if (fstatfs(fd, &fs) == -1)
+		return false;
+
+#if defined(__linux__)
+	switch ((uint32)fs.f_type) {
+	case 0x00006969: // NFS
+	case 0x0000517b: // SMB
+	case 0xff534d42: // CIFS
+	case 0xfe534d42: // SMB2
+	case 0x65735546: // FUSE, which covers sshfs and most removable NTFS drives
+	case 0x01021997: // 9P
+	case 0x73757245: // Coda
+	case 0x5346414f: // AFS
+	case 0x00c36400: // Ceph
+	case 0x00004d44: // FAT
+	case 0x2011bab0: // exFAT
+	case 0x00009660: // ISO 9660
+	case 0x15013346: // UDF
+		return false;
+	default:
+		return true;
+	}
+#else
+	if (!(fs.f_flags & MNT_LOCAL))
+		return false;
+#ifdef MNT_REMOVABLE
+	if (fs.f_flags & MNT_REMOVABLE)
+		return false;
+#endif
+
+	const char *const removableTypes[] = { "msdos", "msdosfs", "exfat", "cd9660", "udf" };
+	for (int i = 0; i < ARRAYSIZE(removableTypes); i++) {
+		if (!strcmp(fs.f_fstypename, removableTypes[i]))
+			return false;
+	}
+	return true;
+#endif
+}
+#endif
+
+PosixMmapStream *PosixMmapStream::makeFromPath(const Common::String &path, int64 minSize) {
+#ifdef POSIX_MMAPSTREAM_AVAILABLE
+	// Keep clear of exhausting the address space of 32-bit systems
+	const int64 maxSize = (sizeof(void *) > 4) ? ((int64)1 << 32) : (64 << 20);
+
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd == -1)
+		return nullptr;
+
+	// Only regular files can be mapped, and empty ones need no mapping
+	struct stat st;
+	if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode) || st.st_size == 0 || st.st_size < minSize || st.st_size > maxSize || !isOnFixedLocalDisk(fd)) {
+		close(fd);
+		return nullptr;
+	}
+
+	void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	// The mapping keeps its own reference to the file
+	close(fd);
+	if (data == MAP_FAILED)
+		return nullptr;
+
+	return new PosixMmapStream((const byte *)data, st.st_size);
+#else
+	return nullptr;
+#endif
+}
+
+PosixMmapStream::PosixMmapStream(const byte *data, int64 size) :
+		_data(data), _size(size), _pos(0), _eos(false) {
+}
+
+PosixMmapStream::~PosixMmapStream() {
+#ifdef POSIX_MMAPSTREAM_AVAILABLE
+	munmap(const_cast<byte *>(_data), _size);
+#endif
+}
+
+bool PosixMmapStream::seek(int64 offs, int whence) {
+	switch (whence) {
+	case SEEK_END:
+		offs += _size;
+		break;
+	case SEEK_CUR:
+		offs += _pos;
+		break;
+	case SEEK_SET:
+	default:
+		break;
+	}
+
+	// Like fseek(), seeking past the end is allowed, reads then fail
+	if (offs < 0)
+		return false;
+
+	_pos = offs;
+	_eos = false;
+	return true;
+}
+
+uint32 PosixMmapStream::read(void *dataPtr, uint32 dataSize) {
+	int64 available = MAX<int64>(_size - _pos, 0);
+	if (dataSize > available) {
+		dataSize = available;
+		_eos = true;
+	}
+
+	memcpy(dataPtr, _data + _pos, dataSize);
+	_pos += dataSize;
+	return dataSize;
+}
+
+const byte *PosixMmapStream::getRangePointer(int64 offset, uint32 size) const {
+	if (offset < 0 || offset > _size || size > _size - offset)
+		return nullptr;
+	return _data + offset;
+}
@@ -0,0 +1,77 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef BACKENDS_FS_POSIX_POSIXMMAPSTREAM_H
+#define BACKENDS_FS_POSIX_POSIXMMAPSTREAM_H
+
+#include "common/noncopyable.h"
+#include "common/stream.h"
+#include "common/str.h"
+
+/**
+ * A read-only file stream backed by a memory mapping of the whole file.
+ *
+ * Seeking is free and reads are plain memory copies, which pays off for
+ * engines doing lots of small random accesses into large data files. The
+ * data can also be accessed without any copy through getRangePointer().
+ *
+ * A read error on the underlying file, or the file being truncated while it
+ * is mapped, raises SIGBUS instead of failing a read, and err() never
+ * reports anything. This is why these streams are only created on request,
+ * through AbstractFSNode::createMappedReadStream(), and only for files on
+ * fixed local disks.
+ */
+class PosixMmapStream final : public Common::SeekableReadStream, public Common::NonCopyable {
+public:
+	/**
+	 * Map the file at @p path into memory.
+	 *
+	 * @param path    The file to map.
+	 * @param minSize Files smaller than this are not mapped.
+	 * @return The new stream, or nullptr if the file could not be mapped, is
+	 *         too small or is not on a fixed local disk, in which case the
+	 *         caller should fall back to a regular stream.
+	 */
+	static PosixMmapStream *makeFromPath(const Common::String &path, int64 minSize = 1);
+
+	~PosixMmapStream() override;
+
+	bool err() const override { return false; }
+	void clearErr() override { _eos = false; }
+	bool eos() const override { return _eos; }
+
+	int64 pos() const override { return _pos; }
+	int64 size() const override { return _size; }
+	bool seek(int64 offs, int whence = SEEK_SET) override;
+	uint32 read(void *dataPtr, uint32 dataSize) override;
+
+	const byte *getRangePointer(int64 offset, uint32 size) const override;
+
+private:
+	PosixMmapStream(const byte *data, int64 size);
+
+	const byte *_data;
+	int64 _size;
+	int64 _pos;
+	bool _eos;
+};
+
+#endif
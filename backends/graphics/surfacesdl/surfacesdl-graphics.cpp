@@ -1313,6 +1313,17 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 		_isInOverlayPalette = _overlayVisible;
 	}
 
+	_numDirtyRects = 0;
+	for (Graphics::DirtyRegion::const_iterator i = _dirtyRegion.begin(); i != _dirtyRegion.end(); ++i) {
+		SDL_Rect *r = &_dirtyRectList[_numDirtyRects++];
+
+		r->x = i->left;
+		r->y = i->top;
+		r->w = i->width();
+		r->h = i->height();
+	}
+	_dirtyRegion.clear();
+
 	// In case of double buferring partially good version may be on another page,
 	// so we need to fully redraw
 	if (_isDoubleBuf && _numDirtyRects)
@@ -1751,7 +1762,7 @@ void SurfaceSdlGraphicsManager::addDirtyRect(int x, int y, int w, int h, bool in
 	if (_forceRedraw)
 		return;
 
-	if (_numDirtyRects == NUM_DIRTY_RECT) {
+	if (_dirtyRegion.size() == NUM_DIRTY_RECT) {
 		_forceRedraw = true;
 		return;
 	}
@@ -1806,14 +1817,8 @@ void SurfaceSdlGraphicsManager::addDirtyRect(int x, int y, int w, int h, bool in
 		return;
 	}
 
-	if (w > 0 && h > 0) {
-		SDL_Rect *r = &_dirtyRectList[_numDirtyRects++];
-
-		r->x = x;
-		r->y = y;
-		r->w = w;
-		r->h = h;
-	}
+	if (w > 0 && h > 0)
+		_dirtyRegion.addRect(Common::Rect(x, y, x + w, y + h));
 }
 
 int16 SurfaceSdlGraphicsManager::getHeight() const {
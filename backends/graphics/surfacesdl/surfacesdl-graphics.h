@@ -24,6 +24,7 @@
 
 #include "backends/graphics/graphics.h"
 #include "backends/graphics/sdl/sdl-graphics.h"
+#include "graphics/dirtyregion.h"
 #include "graphics/pixelformat.h"
 #include "graphics/scaler.h"
 #include "graphics/scalerplugin.h"
@@ -353,9 +354,11 @@ protected:
 	};
 
 	// Dirty rect management
-	// When double-buffering we need to redraw both updates from
+	// Updates are collected in the region and copied to the list when
+	// drawing. When double-buffering we need to redraw both updates from
 	// current frame and previous frame. For convenience we copy
 	// them here before traversing the list.
+	Graphics::DirtyRegion _dirtyRegion;
 	SDL_Rect _dirtyRectList[2 * NUM_DIRTY_RECT];
 	int _numDirtyRects;
 
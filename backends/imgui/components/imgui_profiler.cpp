@@ -0,0 +1,289 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/algorithm.h"
+#include "common/file.h"
+
+#include "backends/imgui/components/imgui_profiler.h"
+
+namespace ImGuiEx {
+
+static const float kFrameGraphHeight = 60.0f;
+static const float kTimelineRowHeight = 18.0f;
+static const char *const kTraceFileName = "scummvm-profile.json";
+
+struct ZoneTotal {
+	const char *name;
+	uint64 total;
+	uint calls;
+};
+
+static bool zoneTotalGreater(const ZoneTotal &a, const ZoneTotal &b) {
+	return a.total > b.total;
+}
+
+static ImU32 getZoneColor(const char *name) {
+	// Stable color per zone name, so zones are easy to follow between frames
+	uint32 hash = 5381;
+	for (const char *c = name; *c; c++)
+		hash = hash * 33 + (byte)*c;
+	float r, g, b;
+	ImGui::ColorConvertHSVtoRGB((hash % 360) / 360.0f, 0.5f, 0.8f, r, g, b);
+	return ImGui::GetColorU32(ImVec4(r, g, b, 1.0f));
+}
+
+static ImU32 getFrameColor(uint64 duration) {
+	if (duration <= 16667)
+		return IM_COL32(80, 200, 80, 255);
+	if (duration <= 33333)
+		return IM_COL32(220, 200, 60, 255);
+	return IM_COL32(220, 70, 60, 255);
+}
+
+ImGuiProfiler::ImGuiProfiler() : _selectedFrame(kLatestFrame), _paused(false) {
+}
+
+void ImGuiProfiler::draw(const char *title, bool *p_open) {
+	if (!*p_open)
+		return;
+
+	ImGui::SetNextWindowSize(ImVec2(720, 560), ImGuiCond_FirstUseEver);
+	if (!ImGui::Begin(title, p_open)) {
+		ImGui::End();
+		return;
+	}
+
+	bool enabled = Common::Profiler::isEnabled();
+	if (ImGui::Checkbox("Record", &enabled)) {
+		ProfilerMan.setEnabled(enabled);
+		_selectedFrame = kLatestFrame;
+	}
+	ImGui::SameLine();
+	ImGui::Checkbox("Pause", &_paused);
+	ImGui::SameLine();
+	if (ImGui::Button("Export Chrome trace"))
+		exportTrace();
+	if (!_status.empty()) {
+		ImGui::SameLine();
+		ImGui::TextUnformatted(_status.c_str());
+	}
+
+	if (!_paused && enabled) {
+		ProfilerMan.getFrames(_frames);
+		ProfilerMan.getCounterNames(_counterNames);
+	}
+
+	if (_frames.empty()) {
+		ImGui::TextUnformatted(enabled ? "Waiting for the first frame..." : "Enable recording to capture frames.");
+		ImGui::End();
+		return;
+	}
+
+	drawFrameGraph();
+
+	const Common::Profiler::Frame *frame = &_frames.back();
+	for (uint i = 0; i < _frames.size(); i++) {
+		if (_frames[i].number == _selectedFrame)
+			frame = &_frames[i];
+	}
+
+	if (!_paused || _zones.empty() || _selectedFrame != kLatestFrame)
+		ProfilerMan.getZones(*frame, _zones);
+
+	ImGui::Text("Frame %u: %.3f ms", frame->number, (frame->end - frame->start) / 1000.0);
+	if (_selectedFrame != kLatestFrame) {
+		ImGui::SameLine();
+		if (ImGui::SmallButton("Follow latest"))
+			_selectedFrame = kLatestFrame;
+	}
+
+	drawTimeline(*frame);
+
+	if (ImGui::CollapsingHeader("Zones", ImGuiTreeNodeFlags_DefaultOpen))
+		drawZoneTable();
+	if (ImGui::CollapsingHeader("Counters", ImGuiTreeNodeFlags_DefaultOpen))
+		drawCounterTable(*frame);
+
+	ImGui::End();
+}
+
+void ImGuiProfiler::drawFrameGraph() {
+	ImDrawList *drawList = ImGui::GetWindowDrawList();
+	ImVec2 origin = ImGui::GetCursorScreenPos();
+	float width = ImGui::GetContentRegionAvail().x;
+
+	// Scale to the slowest frame, but never below 33 ms so that the 60 and
+	// 30 fps guides stay visible
+	uint64 maxDuration = 33333;
+	for (uint i = 0; i < _frames.size(); i++)
+		maxDuration = MAX(maxDuration, _frames[i].end - _frames[i].start);
+
+	ImGui::InvisibleButton("##frames", ImVec2(width, kFrameGraphHeight));
+	bool hovered = ImGui::IsItemHovered();
+	drawList->AddRectFilled(origin, origin + ImVec2(width, kFrameGraphHeight), IM_COL32(30, 30, 30, 255));
+
+	float barWidth = width / Common::Profiler::kFrameHistory;
+	for (uint i = 0; i < _frames.size(); i++) {
+		const Common::Profiler::Frame &frame = _frames[i];
+		uint64 duration = frame.end - frame.start;
+		float x = origin.x + i * barWidth;
+		float height = kFrameGraphHeight * duration / maxDuration;
+		ImVec2 min(x, origin.y + kFrameGraphHeight - height);
+		ImVec2 max(x + MAX(barWidth - 1.0f, 1.0f), origin.y + kFrameGraphHeight);
+
+		ImU32 color = getFrameColor(duration);
+		if (frame.number == _selectedFrame)
+			color = IM_COL32(255, 255, 255, 255);
+		drawList->AddRectFilled(min, max, color);
+
+		if (hovered && ImGui::GetIO().MousePos.x >= x && ImGui::GetIO().MousePos.x < x + barWidth) {
+			ImGui::SetTooltip("Frame %u: %.3f ms", frame.number, duration / 1000.0);
+			if (ImGui::IsMouseClicked(ImGuiMouseButton_Left)) {
+				_selectedFrame = frame.number;
+				_paused = true;
+			}
+		}
+	}
+
+	for (uint64 guide = 16667; guide < maxDuration; guide += 16667) {
+		float y = origin.y + kFrameGraphHeight - kFrameGraphHeight * guide / maxDuration;
+		drawList->AddLine(ImVec2(origin.x, y), ImVec2(origin.x + width, y), IM_COL32(255, 255, 255, 60));
+	}
+}
+
+void ImGuiProfiler::drawTimeline(const Common::Profiler::Frame &frame) {
+	uint maxDepth[Common::Profiler::kTrackCount] = { 0 };
+	for (uint i = 0; i < _zones.size(); i++)
+		maxDepth[_zones[i].track] = MAX<uint>(maxDepth[_zones[i].track], _zones[i].depth + 1);
+
+	static const char *const trackNames[] = { "Main", "Audio" };
+	ImDrawList *drawList = ImGui::GetWindowDrawList();
+	float labelWidth = ImGui::CalcTextSize("Audio ").x;
+	float width = ImGui::GetContentRegionAvail().x - labelWidth;
+	uint64 duration = MAX<uint64>(frame.end - frame.start, 1);
+
+	for (uint track = 0; track < Common::Profiler::kTrackCount; track++) {
+		uint rows = MAX<uint>(maxDepth[track], 1);
+		ImVec2 origin = ImGui::GetCursorScreenPos();
+		ImGui::PushID(track);
+		ImGui::InvisibleButton("##track", ImVec2(labelWidth + width, rows * kTimelineRowHeight));
+		bool hovered = ImGui::IsItemHovered();
+		ImGui::PopID();
+
+		drawList->AddText(origin, ImGui::GetColorU32(ImGuiCol_Text), trackNames[track]);
+		origin.x += labelWidth;
+		drawList->AddRectFilled(origin, origin + ImVec2(width, rows * kTimelineRowHeight), IM_COL32(30, 30, 30, 255));
+
+		for (uint i = 0; i < _zones.size(); i++) {
+			const Common::Profiler::Zone &zone = _zones[i];
+			if (zone.track != track)
+				continue;
+
+			// Zones which began in an earlier frame are clipped to this one
+			uint64 start = CLIP(zone.start, frame.start, frame.end) - frame.start;
+			uint64 end = CLIP(zone.end, frame.start, frame.end) - frame.start;
+			ImVec2 min(origin.x + width * start / duration, origin.y + zone.depth * kTimelineRowHeight);
+			ImVec2 max(origin.x + width * end / duration, min.y + kTimelineRowHeight - 1.0f);
+			max.x = MAX(max.x, min.x + 1.0f);
+
+			drawList->AddRectFilled(min, max, getZoneColor(zone.name));
+			if (ImGui::CalcTextSize(zone.name).x < max.x - min.x - 4.0f)
+				drawList->AddText(min + ImVec2(2.0f, 2.0f), IM_COL32(0, 0, 0, 255), zone.name);
+
+			if (hovered && ImGui::IsMouseHoveringRect(min, max))
+				ImGui::SetTooltip("%s\n%.3f ms", zone.name, (zone.end - zone.start) / 1000.0);
+		}
+	}
+}
+
+void ImGuiProfiler::drawZoneTable() {
+	Common::Array<ZoneTotal> totals;
+	for (uint i = 0; i < _zones.size(); i++) {
+		const Common::Profiler::Zone &zone = _zones[i];
+		uint j;
+		for (j = 0; j < totals.size(); j++) {
+			if (totals[j].name == zone.name)
+				break;
+		}
+		if (j == totals.size()) {
+			ZoneTotal total = { zone.name, 0, 0 };
+			totals.push_back(total);
+		}
+		totals[j].total += zone.end - zone.start;
+		totals[j].calls++;
+	}
+	Common::sort(totals.begin(), totals.end(), zoneTotalGreater);
+
+	if (ImGui::BeginTable("Zones", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp)) {
+		ImGui::TableSetupColumn("Zone");
+		ImGui::TableSetupColumn("Total (ms)");
+		ImGui::TableSetupColumn("Calls");
+		ImGui::TableHeadersRow();
+		for (uint i = 0; i < totals.size(); i++) {
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::TextUnformatted(totals[i].name);
+			ImGui::TableNextColumn();
+			ImGui::Text("%.3f", totals[i].total / 1000.0);
+			ImGui::TableNextColumn();
+			ImGui::Text("%u", totals[i].calls);
+		}
+		ImGui::EndTable();
+	}
+}
+
+void ImGuiProfiler::drawCounterTable(const Common::Profiler::Frame &frame) {
+	if (ImGui::BeginTable("Counters", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp)) {
+		ImGui::TableSetupColumn("Counter");
+		ImGui::TableSetupColumn("Frame");
+		ImGui::TableSetupColumn("Average");
+		ImGui::TableHeadersRow();
+		for (uint i = 0; i < _counterNames.size(); i++) {
+			int64 sum = 0;
+			for (uint j = 0; j < _frames.size(); j++)
+				sum += _frames[j].counters[i];
+
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::TextUnformatted(_counterNames[i]);
+			ImGui::TableNextColumn();
+			ImGui::Text("%lld", (long long)frame.counters[i]);
+			ImGui::TableNextColumn();
+			ImGui::Text("%.1f", (double)sum / _frames.size());
+		}
+		ImGui::EndTable();
+	}
+}
+
+void ImGuiProfiler::exportTrace() {
+	Common::DumpFile file;
+	if (!file.open(Common::Path(kTraceFileName))) {
+		_status = Common::String::format("Could not open %s", kTraceFileName);
+		return;
+	}
+
+	ProfilerMan.exportChromeTrace(file);
+	file.finalize();
+	_status = file.err() ? Common::String::format("Could not write %s", kTraceFileName) : Common::String::format("Saved %s", kTraceFileName);
+	file.close();
+}
+
+} // namespace ImGuiEx
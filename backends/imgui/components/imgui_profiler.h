@@ -0,0 +1,64 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef BACKENDS_IMGUI_COMPONENTS_IMGUI_PROFILER_H
+#define BACKENDS_IMGUI_COMPONENTS_IMGUI_PROFILER_H
+
+#ifndef IMGUI_DEFINE_MATH_OPERATORS
+#define IMGUI_DEFINE_MATH_OPERATORS
+#endif
+
+#include "backends/imgui/imgui.h"
+#include "common/profiler.h"
+
+namespace ImGuiEx {
+
+/**
+ * Window showing the data recorded by Common::Profiler: a graph of the
+ * recent frame times, a timeline of the zones of the selected frame, the
+ * time spent per zone and the per-frame counters.
+ */
+class ImGuiProfiler {
+	enum {
+		kLatestFrame = 0xFFFFFFFF
+	};
+
+	Common::Array<Common::Profiler::Frame> _frames;
+	Common::Array<Common::Profiler::Zone> _zones;
+	Common::Array<const char *> _counterNames;
+	uint32 _selectedFrame; // Frame number, or kLatestFrame to follow the newest one
+	bool _paused;
+	Common::String _status;
+
+	void drawFrameGraph();
+	void drawTimeline(const Common::Profiler::Frame &frame);
+	void drawZoneTable();
+	void drawCounterTable(const Common::Profiler::Frame &frame);
+	void exportTrace();
+
+public:
+	ImGuiProfiler();
+	void draw(const char *title, bool *p_open);
+};
+
+} // namespace ImGuiEx
+
+#endif
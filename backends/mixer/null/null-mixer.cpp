@@ -25,6 +25,7 @@
 NullMixerManager::NullMixerManager() : MixerManager() {
 	_outputRate = 22050;
 	_callsCounter = 0;
+	_pendingFrames = 0;
 	_samples = 8192;
 	while (_samples * 16 > _outputRate * 2)
 		_samples >>= 1;
@@ -67,3 +68,18 @@ void NullMixerManager::update(uint8 callbackPeriod) {
 		_mixer->mixCallback(_samplesBuf, _samples);
 	}
 }
+
+void NullMixerManager::updateElapsed(uint32 millis) {
+	if (_audioSuspended) {
+		return;
+	}
+	// Each callback fills _samples bytes of 16-bit stereo output. Frames
+	// are counted in thousandths to stay exact at any output rate.
+	const uint64 callbackFrames = (uint64)(_samples / 4) * 1000;
+	_pendingFrames += (uint64)millis * _outputRate;
+	while (_pendingFrames >= callbackFrames) {
+		assert(_mixer);
+		_mixer->mixCallback(_samplesBuf, _samples);
+		_pendingFrames -= callbackFrames;
+	}
+}
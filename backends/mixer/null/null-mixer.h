@@ -41,6 +41,13 @@ public:
 	void init() override;
 	void update(uint8 callbackPeriod = 10);
 
+	/**
+	 * Pull as many buffers from the mixer as the output rate consumes in
+	 * the given amount of time. Used to drive the mixer at a fixed rate
+	 * from a virtual clock.
+	 */
+	void updateElapsed(uint32 millis);
+
 	void suspendAudio() override;
 	int resumeAudio() override;
 
@@ -51,6 +58,7 @@ private:
 	uint32 _callsCounter;
 	uint32 _samples;
 	uint8 *_samplesBuf;
+	uint64 _pendingFrames;
 };
 
 #endif
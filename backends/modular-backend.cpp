@@ -26,6 +26,7 @@
 #include "backends/mixer/mixer.h"
 #include "gui/EventRecorder.h"
 
+#include "common/profiler.h"
 #include "common/timer.h"
 #include "graphics/pixelformat.h"
 
@@ -190,17 +191,25 @@ void ModularGraphicsBackend::fillScreen(const Common::Rect &r, uint32 col) {
 }
 
 void ModularGraphicsBackend::updateScreen() {
+	{
+		PROFILE_ZONE("updateScreen");
+
 #ifdef ENABLE_EVENTRECORDER
-	g_system->getMillis();		// force event recorder to update the tick count
-	g_eventRec.processScreenUpdate();
-	g_eventRec.preDrawOverlayGui();
+		g_system->getMillis();		// force event recorder to update the tick count
+		g_eventRec.processScreenUpdate();
+		g_eventRec.preDrawOverlayGui();
 #endif
 
-	_graphicsManager->updateScreen();
+		_graphicsManager->updateScreen();
 
 #ifdef ENABLE_EVENTRECORDER
-	g_eventRec.postDrawOverlayGui();
+		g_eventRec.postDrawOverlayGui();
 #endif
+	}
+
+	// Every screen update ends a frame of the engine's main loop
+	if (Common::Profiler::isEnabled())
+		ProfilerMan.frameMark();
 }
 
 void ModularGraphicsBackend::setShakePos(int shakeXOffset, int shakeYOffset) {
@@ -22,6 +22,7 @@
 #include <time.h>
 #ifdef POSIX
 #include <sys/time.h>
+#include <sys/resource.h>
 #include <unistd.h>
 #include <signal.h>
 // sighandler_t is a GNU extension exposed when _GNU_SOURCE is defined
@@ -45,19 +46,34 @@ typedef void (*sighandler_t)(int);
 #define FORBIDDEN_SYMBOL_EXCEPTION_time_h
 
 #include "common/scummsys.h"
+#include "common/profiler.h"
 
 #if defined(USE_NULL_DRIVER)
 #include "backends/modular-backend.h"
 #include "backends/mutex/null/null-mutex.h"
+#include "backends/graphics/null/null-graphics.h"
 #include "base/main.h"
 
+// Tests use real threads, so that code running on worker threads is
+// actually exercised
+#if defined(NULL_DRIVER_USE_FOR_TEST) && defined(POSIX)
+#define NULL_DRIVER_USE_THREADS
+#include "backends/mutex/pthread/pthread-mutex.h"
+#include "backends/threads/pthread/pthread-threads.h"
+#endif
+
 #ifndef NULL_DRIVER_USE_FOR_TEST
 #include "backends/saves/default/default-saves.h"
 #include "backends/timer/default/default-timer.h"
 #include "backends/events/default/default-events.h"
 #include "backends/mixer/null/null-mixer.h"
-#include "backends/graphics/null/null-graphics.h"
+#include "common/config-manager.h"
 #include "gui/debugger.h"
+#include "gui/EventRecorder.h"
+
+#ifdef ENABLE_EVENTRECORDER
+#define NULL_DRIVER_USE_EVENTRECORDER
+#endif
 #endif
 
 /*
@@ -75,6 +91,103 @@ typedef void (*sighandler_t)(int);
 	#include "backends/fs/windows/windows-fs-factory.h"
 #endif
 
+static uint64 getRealMicros() {
+#ifdef POSIX
+	timeval curTime;
+	gettimeofday(&curTime, 0);
+	return (uint64)curTime.tv_sec * 1000000 + curTime.tv_usec;
+#elif defined(WIN32)
+	return (uint64)GetTickCount() * 1000;
+#else
+	return 0;
+#endif
+}
+
+#ifdef NULL_DRIVER_USE_EVENTRECORDER
+/**
+ * Graphics manager used by benchmark runs. Like the null graphics manager
+ * it draws nothing, but it records the wall clock time between screen
+ * updates so the cost of every frame can be reported at exit.
+ *
+ * Frame times go into a fixed histogram rather than a growing array, so
+ * that long runs do not inflate the peak memory use being measured.
+ */
+class BenchmarkGraphicsManager : public NullGraphicsManager {
+public:
+	BenchmarkGraphicsManager();
+
+	void updateScreen() override;
+
+	Common::String getReport() const;
+
+private:
+	enum {
+		kBucketMicros = 10,
+		kNumBuckets = 10000 // Frames longer than 100 ms share the last bucket
+	};
+
+	double getPercentile(uint percent) const;
+
+	uint64 _startTime;
+	uint64 _lastFrameTime;
+	uint32 _frames;
+	uint32 _maxFrameTime;
+	uint32 _histogram[kNumBuckets];
+};
+
+BenchmarkGraphicsManager::BenchmarkGraphicsManager() :
+	_startTime(getRealMicros()), _frames(0), _maxFrameTime(0) {
+	_lastFrameTime = _startTime;
+	memset(_histogram, 0, sizeof(_histogram));
+}
+
+void BenchmarkGraphicsManager::updateScreen() {
+	uint64 now = getRealMicros();
+	uint32 frameTime = (uint32)(now - _lastFrameTime);
+	_lastFrameTime = now;
+
+	_histogram[MIN<uint32>(frameTime / kBucketMicros, kNumBuckets - 1)]++;
+	_maxFrameTime = MAX(_maxFrameTime, frameTime);
+	_frames++;
+}
+
+double BenchmarkGraphicsManager::getPercentile(uint percent) const {
+	// Nearest rank, reported as the upper edge of the matching bucket
+	uint64 rank = ((uint64)_frames * percent + 99) / 100;
+	uint64 seen = 0;
+	for (uint i = 0; i < kNumBuckets - 1; ++i) {
+		seen += _histogram[i];
+		if (seen >= rank && seen > 0)
+			return MIN<uint32>((i + 1) * kBucketMicros, _maxFrameTime) / 1000.0;
+	}
+	return _maxFrameTime / 1000.0;
+}
+
+Common::String BenchmarkGraphicsManager::getReport() const {
+	uint64 elapsed = getRealMicros() - _startTime;
+
+	Common::String report = Common::String::format(
+		"Benchmark: %u frames in %.3f s (%.2f fps)\n"
+		"Benchmark: frame time p50 %.3f ms, p90 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+		_frames, elapsed / 1000000.0, elapsed ? _frames * 1000000.0 / elapsed : 0.0,
+		getPercentile(50), getPercentile(90), getPercentile(99), _maxFrameTime / 1000.0);
+
+#ifdef POSIX
+	rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+		// Darwin reports the maximum resident set size in bytes
+		long peakKB = usage.ru_maxrss / 1024;
+#else
+		long peakKB = usage.ru_maxrss;
+#endif
+		report += Common::String::format("Benchmark: peak RSS %ld KiB\n", peakKB);
+	}
+#endif
+	return report;
+}
+#endif
+
 class OSystem_NULL : public ModularMixerBackend, public ModularGraphicsBackend, Common::EventSource {
 public:
 	OSystem_NULL(bool silenceLogs);
@@ -85,7 +198,17 @@ public:
 	virtual bool pollEvent(Common::Event &event);
 
 	virtual Common::MutexInternal *createMutex();
+#ifdef NULL_DRIVER_USE_THREADS
+	virtual Common::ThreadInternal *createThread(Common::ThreadProc proc, void *param);
+	virtual Common::SemaphoreInternal *createSemaphore(uint initialCount);
+	virtual uint getCPUCount();
+
+	// Tests choose how many workers the job system gets, independently
+	// of the machine they run on
+	void setCPUCount(uint cpuCount) { _cpuCount = cpuCount; }
+#endif
 	virtual uint32 getMillis(bool skipRecord = false);
+	virtual uint64 getMicros();
 	virtual void delayMillis(uint msecs);
 	virtual void getTimeAndDate(TimeDate &td, bool skipRecord = false) const;
 
@@ -95,16 +218,41 @@ public:
 
 	virtual void addSysArchivesToSearchSet(Common::SearchSet &s, int priority);
 
+#ifdef NULL_DRIVER_USE_EVENTRECORDER
+	virtual MixerManager *getMixerManager();
+	virtual Common::TimerManager *getTimerManager();
+	virtual Common::SaveFileManager *getSavefileManager();
+#endif
+
 private:
+#ifdef NULL_DRIVER_USE_EVENTRECORDER
+	void printBenchmarkReport();
+
+	// Benchmark runs never sleep. Time only moves forward when the engine
+	// asks for a delay, or when the event recorder replays a timer event.
+	bool _benchmark;
+	uint32 _virtualMillis;
+	uint32 _lastMixMillis;
+#endif
+
 #ifdef POSIX
 	timeval _startTime;
 #elif defined(WIN32)
 	DWORD _startTime;
+#endif
+#ifdef NULL_DRIVER_USE_THREADS
+	uint _cpuCount;
 #endif
 	bool _silenceLogs;
 };
 
 OSystem_NULL::OSystem_NULL(bool silenceLogs) :
+#ifdef NULL_DRIVER_USE_EVENTRECORDER
+	_benchmark(false), _virtualMillis(0), _lastMixMillis(0),
+#endif
+#ifdef NULL_DRIVER_USE_THREADS
+	_cpuCount(1),
+#endif
 	_silenceLogs(silenceLogs) {
 	#if defined(__amigaos4__)
 		_fsFactory = new AmigaOSFilesystemFactory();
@@ -119,9 +267,21 @@ OSystem_NULL::OSystem_NULL(bool silenceLogs) :
 	#else
 		#error Unknown and unsupported FS backend
 	#endif
+
+#ifdef NULL_DRIVER_USE_FOR_TEST
+	// Tests don't call initBackend(), but video decoders still query the
+	// screen format
+	_graphicsManager = new NullGraphicsManager();
+#endif
 }
 
 OSystem_NULL::~OSystem_NULL() {
+#ifdef NULL_DRIVER_USE_EVENTRECORDER
+	printBenchmarkReport();
+
+	// The event recorder owns the timer manager, see initBackend()
+	delete g_eventRec.getTimerManager();
+#endif
 }
 
 #if defined(POSIX) && !defined(NULL_DRIVER_USE_FOR_TEST)
@@ -147,13 +307,25 @@ void OSystem_NULL::initBackend() {
 	last_handler = signal(SIGINT, intHandler);
 #endif
 
-	_timerManager = new DefaultTimerManager();
 	_eventManager = new DefaultEventManager(this);
 	_savefileManager = new DefaultSaveFileManager();
-	_graphicsManager = new NullGraphicsManager();
+#ifdef NULL_DRIVER_USE_EVENTRECORDER
+	_benchmark = ConfMan.getBool("benchmark");
+	if (_benchmark)
+		_graphicsManager = new BenchmarkGraphicsManager();
+	else
+#endif
+		_graphicsManager = new NullGraphicsManager();
 	_mixerManager = new NullMixerManager();
 	// Setup and start mixer
 	_mixerManager->init();
+
+#ifdef NULL_DRIVER_USE_EVENTRECORDER
+	g_eventRec.registerMixerManager(_mixerManager);
+	g_eventRec.registerTimerManager(new DefaultTimerManager());
+#else
+	_timerManager = new DefaultTimerManager();
+#endif
 #endif
 
 	BaseBackend::initBackend();
@@ -161,8 +333,22 @@ void OSystem_NULL::initBackend() {
 
 bool OSystem_NULL::pollEvent(Common::Event &event) {
 #ifndef NULL_DRIVER_USE_FOR_TEST
+#ifdef NULL_DRIVER_USE_EVENTRECORDER
+	// While recording or replaying, the event recorder fires the timers
+	// itself in step with the recorded clock
+	if (g_eventRec.getRecordMode() == GUI::EventRecorder::kPassthrough)
+		((DefaultTimerManager *)getTimerManager())->checkTimers();
+
+	if (_benchmark) {
+		// Pull the mixer at its output rate against the virtual clock
+		((NullMixerManager *)_mixerManager)->updateElapsed(_virtualMillis - _lastMixMillis);
+		_lastMixMillis = _virtualMillis;
+	} else
+		((NullMixerManager *)_mixerManager)->update(1);
+#else
 	((DefaultTimerManager *)getTimerManager())->checkTimers();
 	((NullMixerManager *)_mixerManager)->update(1);
+#endif
 
 #ifdef POSIX
 	if (intReceived) {
@@ -187,25 +373,70 @@ bool OSystem_NULL::pollEvent(Common::Event &event) {
 }
 
 Common::MutexInternal *OSystem_NULL::createMutex() {
+#ifdef NULL_DRIVER_USE_THREADS
+	return createPthreadMutexInternal();
+#else
 	return new NullMutexInternal();
+#endif
 }
 
+#ifdef NULL_DRIVER_USE_THREADS
+Common::ThreadInternal *OSystem_NULL::createThread(Common::ThreadProc proc, void *param) {
+	return createPthreadThreadInternal(proc, param);
+}
+
+Common::SemaphoreInternal *OSystem_NULL::createSemaphore(uint initialCount) {
+	return createPthreadSemaphoreInternal(initialCount);
+}
+
+uint OSystem_NULL::getCPUCount() {
+	return _cpuCount;
+}
+#endif
+
 uint32 OSystem_NULL::getMillis(bool skipRecord) {
+	uint32 millis = 0;
+#ifdef NULL_DRIVER_USE_EVENTRECORDER
+	if (_benchmark)
+		millis = _virtualMillis;
+	else
+#endif
+	{
 #ifdef POSIX
-	timeval curTime;
+		timeval curTime;
 
-	gettimeofday(&curTime, 0);
+		gettimeofday(&curTime, 0);
 
-	return (uint32)(((curTime.tv_sec - _startTime.tv_sec) * 1000) +
-			((curTime.tv_usec - _startTime.tv_usec) / 1000));
+		millis = (uint32)(((curTime.tv_sec - _startTime.tv_sec) * 1000) +
+				((curTime.tv_usec - _startTime.tv_usec) / 1000));
 #elif defined(WIN32)
-	return GetTickCount() - _startTime;
-#else
-	return 0;
+		millis = GetTickCount() - _startTime;
 #endif
+	}
+
+#ifdef NULL_DRIVER_USE_EVENTRECORDER
+	g_eventRec.processMillis(millis, skipRecord);
+#endif
+
+	return millis;
+}
+
+uint64 OSystem_NULL::getMicros() {
+	return getRealMicros();
 }
 
 void OSystem_NULL::delayMillis(uint msecs) {
+	PROFILE_ZONE("delayMillis");
+
+#ifdef NULL_DRIVER_USE_EVENTRECORDER
+	if (_benchmark) {
+		_virtualMillis += msecs;
+		return;
+	}
+	if (g_eventRec.processDelayMillis())
+		return;
+#endif
+
 #ifdef POSIX
 	usleep(msecs * 1000);
 #elif defined(WIN32)
@@ -223,10 +454,40 @@ void OSystem_NULL::getTimeAndDate(TimeDate &td, bool skipRecord) const {
 	td.tm_mon = t.tm_mon;
 	td.tm_year = t.tm_year;
 	td.tm_wday = t.tm_wday;
+
+#ifdef NULL_DRIVER_USE_EVENTRECORDER
+	g_eventRec.processTimeAndDate(td, skipRecord);
+#endif
+}
+
+#ifdef NULL_DRIVER_USE_EVENTRECORDER
+MixerManager *OSystem_NULL::getMixerManager() {
+	return g_eventRec.getMixerManager();
+}
+
+Common::TimerManager *OSystem_NULL::getTimerManager() {
+	return g_eventRec.getTimerManager();
+}
+
+Common::SaveFileManager *OSystem_NULL::getSavefileManager() {
+	return g_eventRec.getSaveManager(_savefileManager);
 }
 
+void OSystem_NULL::printBenchmarkReport() {
+	if (!_benchmark)
+		return;
+	_benchmark = false;
+
+	logMessage(LogMessageType::kInfo, ((BenchmarkGraphicsManager *)_graphicsManager)->getReport().c_str());
+}
+#endif
+
 #ifndef NULL_DRIVER_USE_FOR_TEST
 void OSystem_NULL::quit() {
+#ifdef NULL_DRIVER_USE_EVENTRECORDER
+	// The event recorder quits once the recording has been replayed
+	printBenchmarkReport();
+#endif
 	exit(0);
 }
 #endif
@@ -36,6 +36,7 @@
 #include "common/fs.h"
 #include "common/archive.h"
 #include "common/config-manager.h"
+#include "common/memstream.h"
 #include "common/compression/deflate.h"
 
 #include <errno.h>	// for removeSavefile()
@@ -44,13 +45,81 @@
 const char *const DefaultSaveFileManager::TIMESTAMPS_FILENAME = "timestamps";
 #endif
 
-DefaultSaveFileManager::DefaultSaveFileManager() {
+/**
+ * Collects the data of a save file in memory, and hands it to the save file
+ * manager to be written when the stream is finalized.
+ */
+class DefaultSaveWriteStream : public Common::MemoryWriteStreamDynamic {
+public:
+	DefaultSaveWriteStream(DefaultSaveFileManager *manager, const Common::String &filename, Common::SeekableWriteStream *file, bool compress) :
+		Common::MemoryWriteStreamDynamic(DisposeAfterUse::YES), _manager(manager), _filename(filename), _file(file), _compress(compress), _err(false) {}
+
+	~DefaultSaveWriteStream() override {
+		finalize();
+	}
+
+	bool err() const override { return _err; }
+	void clearErr() override { _err = false; }
+
+	void finalize() override {
+		if (!_file)
+			return;
+
+		DefaultSaveFileManager::PendingSave *save = new DefaultSaveFileManager::PendingSave();
+		save->filename = _filename;
+		save->file = _file;
+		save->compress = _compress;
+		save->error = Common::kNoError;
+
+		// The save takes over the buffer
+		save->data = _data;
+		save->size = _size;
+		_data = _ptr = nullptr;
+		_capacity = _size = _pos = 0;
+		_file = nullptr;
+
+		if (!_manager->queueSave(save))
+			_err = true;
+	}
+
+private:
+	DefaultSaveFileManager *_manager;
+	Common::String _filename;
+	Common::SeekableWriteStream *_file;
+	bool _compress;
+	bool _err;
+};
+
+DefaultSaveFileManager::DefaultSaveFileManager() :
+		_writerThread(nullptr), _savesQueued(nullptr), _savesDone(nullptr), _waitingForSaves(false), _quitWriter(false) {
 }
 
-DefaultSaveFileManager::DefaultSaveFileManager(const Common::Path &defaultSavepath) {
+DefaultSaveFileManager::DefaultSaveFileManager(const Common::Path &defaultSavepath) :
+		_writerThread(nullptr), _savesQueued(nullptr), _savesDone(nullptr), _waitingForSaves(false), _quitWriter(false) {
 	ConfMan.registerDefault("savepath", defaultSavepath);
 }
 
+DefaultSaveFileManager::~DefaultSaveFileManager() {
+	if (_writerThread) {
+		waitForSaves();
+
+		_savesMutex.lock();
+		_quitWriter = true;
+		_savesMutex.unlock();
+		_savesQueued->post();
+
+		_writerThread->join();
+		delete _writerThread;
+	}
+
+	delete _savesQueued;
+	delete _savesDone;
+
+	// Nobody is left to be informed about these
+	for (Common::List<PendingSave *>::iterator i = _finishedSaves.begin(); i != _finishedSaves.end(); ++i)
+		delete *i;
+}
+
 
 void DefaultSaveFileManager::checkPath(const Common::FSNode &dir) {
 	clearError();
@@ -97,6 +166,8 @@ Common::InSaveFile *DefaultSaveFileManager::openRawFile(const Common::String &fi
 	if (getError().getCode() != Common::kNoError)
 		return nullptr;
 
+	waitForSave(filename);
+
 	SaveFileCache::const_iterator file = _saveFileCache.find(filename);
 	if (file == _saveFileCache.end()) {
 		return nullptr;
@@ -119,6 +190,8 @@ Common::InSaveFile *DefaultSaveFileManager::openForLoading(const Common::String
 		}
 	}
 
+	waitForSave(filename);
+
 	SaveFileCache::const_iterator file = _saveFileCache.find(filename);
 	if (file == _saveFileCache.end()) {
 		return nullptr;
@@ -142,6 +215,9 @@ Common::OutSaveFile *DefaultSaveFileManager::openForSaving(const Common::String
 		}
 	}
 
+	// Don't truncate the file while an older version is still being written
+	waitForSave(filename);
+
 #if defined(USE_CLOUD) && defined(USE_LIBCURL)
 	// Update file's timestamp
 	Common::HashMap<Common::String, uint32> timestamps = loadTimestamps();
@@ -165,7 +241,7 @@ Common::OutSaveFile *DefaultSaveFileManager::openForSaving(const Common::String
 	Common::SeekableWriteStream *const sf = fileNode.createWriteStream();
 	if (!sf)
 		return nullptr;
-	Common::OutSaveFile *const result = new Common::OutSaveFile(compress ? Common::wrapCompressedWriteStream(sf) : sf);
+	Common::OutSaveFile *const result = new Common::OutSaveFile(new DefaultSaveWriteStream(this, filename, sf, compress));
 
 	// Add file to cache now that it exists.
 	_saveFileCache[filename] = Common::FSNode(fileNode.getPath());
@@ -179,6 +255,8 @@ bool DefaultSaveFileManager::removeSavefile(const Common::String &filename) {
 	if (getError().getCode() != Common::kNoError)
 		return false;
 
+	waitForSave(filename);
+
 #if defined(USE_CLOUD) && defined(USE_LIBCURL)
 	// Update file's timestamp
 	Common::HashMap<Common::String, uint32> timestamps = loadTimestamps();
@@ -233,6 +311,131 @@ bool DefaultSaveFileManager::exists(const Common::String &filename) {
 	return _saveFileCache.contains(filename);
 }
 
+void DefaultSaveFileManager::processPendingSaves(bool wait) {
+	if (wait)
+		waitForSaves();
+
+	_savesMutex.lock();
+	Common::List<PendingSave *> finished;
+	SWAP(finished, _finishedSaves);
+	_savesMutex.unlock();
+
+	for (Common::List<PendingSave *>::iterator i = finished.begin(); i != finished.end(); ++i) {
+		PendingSave *save = *i;
+		if (_saveCallback)
+			_saveCallback(_saveCallbackParam, save->filename, save->error);
+		else if (save->error.getCode() != Common::kNoError)
+			warning("Failed to write savefile '%s'", save->filename.c_str());
+		delete save;
+	}
+}
+
+bool DefaultSaveFileManager::queueSave(PendingSave *save) {
+	// Start the writer on first use
+	if (!_savesQueued) {
+		_savesQueued = g_system->createSemaphore(0);
+		if (_savesQueued) {
+			_savesDone = g_system->createSemaphore(0);
+			if (_savesDone)
+				_writerThread = g_system->createThread(writerProc, this);
+		}
+	}
+
+	if (!_writerThread) {
+		writeSave(save);
+		bool success = save->error.getCode() == Common::kNoError;
+		delete save;
+		return success;
+	}
+
+	_savesMutex.lock();
+	_pendingSaves.push_back(save);
+	_savesMutex.unlock();
+	_savesQueued->post();
+	return true;
+}
+
+void DefaultSaveFileManager::waitForSave(const Common::String &filename) {
+	_savesMutex.lock();
+	bool pending = false;
+	for (Common::List<PendingSave *>::const_iterator i = _pendingSaves.begin(); i != _pendingSaves.end(); ++i) {
+		if ((*i)->filename.equalsIgnoreCase(filename)) {
+			pending = true;
+			break;
+		}
+	}
+	_savesMutex.unlock();
+
+	if (pending)
+		waitForSaves();
+}
+
+void DefaultSaveFileManager::waitForSaves() {
+	_savesMutex.lock();
+	if (_pendingSaves.empty()) {
+		_savesMutex.unlock();
+		return;
+	}
+	_waitingForSaves = true;
+	_savesMutex.unlock();
+
+	_savesDone->wait();
+}
+
+void DefaultSaveFileManager::writeSave(PendingSave *save) {
+	Common::WriteStream *stream = save->file;
+	if (save->compress)
+		stream = Common::wrapCompressedWriteStream(stream);
+
+	stream->write(save->data, save->size);
+	// This does not fsync() the file, just like the save files written on
+	// the engine thread never were. Write streams from FSNode have no way
+	// to do so on most backends, and a save file reported as written has
+	// been handed to the OS either way.
+	stream->finalize();
+	if (stream->err())
+		save->error = Common::Error(Common::kWritingFailed, save->filename);
+
+	delete stream;
+	save->file = nullptr;
+	free(save->data);
+	save->data = nullptr;
+}
+
+void DefaultSaveFileManager::writerProc(void *param) {
+	((DefaultSaveFileManager *)param)->writerLoop();
+}
+
+void DefaultSaveFileManager::writerLoop() {
+	for (;;) {
+		_savesQueued->wait();
+
+		_savesMutex.lock();
+		if (_pendingSaves.empty()) {
+			bool quit = _quitWriter;
+			_savesMutex.unlock();
+			if (quit)
+				break;
+			continue;
+		}
+		// The save stays in the list while it is written, so that it is
+		// still waited for
+		PendingSave *save = _pendingSaves.front();
+		_savesMutex.unlock();
+
+		writeSave(save);
+
+		_savesMutex.lock();
+		_pendingSaves.pop_front();
+		_finishedSaves.push_back(save);
+		if (_pendingSaves.empty() && _waitingForSaves) {
+			_waitingForSaves = false;
+			_savesDone->post();
+		}
+		_savesMutex.unlock();
+	}
+}
+
 Common::Path DefaultSaveFileManager::getSavePath() const {
 
 	Common::Path dir;
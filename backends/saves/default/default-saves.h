@@ -27,14 +27,26 @@
 #include "common/str.h"
 #include "common/fs.h"
 #include "common/hash-str.h"
+#include "common/list.h"
+#include "common/mutex.h"
+
+class DefaultSaveFileManagerTestSuite;
 
 /**
  * Provides a default savefile manager implementation for common platforms.
+ *
+ * Save files are collected in memory, and compressed and written on a
+ * background thread once they have been finalized. Without thread support,
+ * they are written right away.
  */
 class DefaultSaveFileManager : public Common::SaveFileManager {
+	friend class DefaultSaveWriteStream;
+	friend class ::DefaultSaveFileManagerTestSuite;
+
 public:
 	DefaultSaveFileManager();
 	DefaultSaveFileManager(const Common::Path &defaultSavepath);
+	~DefaultSaveFileManager() override;
 
 	void updateSavefilesList(Common::StringArray &lockedFiles) override;
 	Common::StringArray listSavefiles(const Common::String &pattern) override;
@@ -43,6 +55,7 @@ public:
 	Common::OutSaveFile *openForSaving(const Common::String &filename, bool compress = true) override;
 	bool removeSavefile(const Common::String &filename) override;
 	bool exists(const Common::String &filename) override;
+	void processPendingSaves(bool wait = false) override;
 
 #ifdef USE_LIBCURL
 
@@ -100,10 +113,55 @@ protected:
 	Common::StringArray _lockedFiles;
 
 private:
+	/**
+	 * A finalized save file waiting to be written.
+	 */
+	struct PendingSave {
+		Common::String filename;
+		Common::SeekableWriteStream *file;
+		byte *data;
+		uint32 size;
+		bool compress;
+		Common::Error error;
+	};
+
+	/**
+	 * Write a finalized save file in the background, or right away when
+	 * there is no writer thread. Takes ownership of the save.
+	 *
+	 * @return False if the save file was written right away and failed.
+	 */
+	bool queueSave(PendingSave *save);
+
+	/**
+	 * Wait until the given save file has been written, if it is pending.
+	 */
+	void waitForSave(const Common::String &filename);
+
+	/**
+	 * Wait until all pending save files have been written.
+	 */
+	void waitForSaves();
+
+	static void writeSave(PendingSave *save);
+	static void writerProc(void *param);
+	void writerLoop();
+
 	/**
 	 * The currently cached directory.
 	 */
 	Common::Path _cachedDirectory;
+
+	Common::Mutex _savesMutex;
+	/** Save files waiting to be written. The first one is being written. */
+	Common::List<PendingSave *> _pendingSaves;
+	/** Save files which have been written, to be reported to the callback. */
+	Common::List<PendingSave *> _finishedSaves;
+	Common::ThreadInternal *_writerThread;
+	Common::SemaphoreInternal *_savesQueued;
+	Common::SemaphoreInternal *_savesDone;
+	bool _waitingForSaves;
+	bool _quitWriter;
 };
 
 #endif
@@ -201,6 +201,10 @@ static const char HELP_STRING4[] =
 	"  --screenshot-period=NUM  When recording, trigger a screenshot every NUM milliseconds\n"
 	"                           (default: 60000)\n"
 	"  --list-records           Display a list of recordings for the target specified\n"
+#ifdef USE_NULL_DRIVER
+	"  --benchmark              Replay the recording without delays on the null backend\n"
+	"                           and report frame rate, frame times and peak memory use\n"
+#endif
 #endif
 	"\n"
 #if defined(ENABLE_SKY) || defined(ENABLE_QUEEN)
@@ -373,6 +377,7 @@ void registerDefaults() {
 	ConfMan.registerDefault("disable_display", false);
 	ConfMan.registerDefault("record_mode", "none");
 	ConfMan.registerDefault("record_file_name", "record.bin");
+	ConfMan.registerDefault("benchmark", false);
 
 	ConfMan.registerDefault("gui_saveload_chooser", "grid");
 	ConfMan.registerDefault("gui_saveload_last_pos", "0");
@@ -805,6 +810,11 @@ Common::String parseCommandLine(Common::StringMap &settings, int argc, const cha
 
 			DO_LONG_OPTION_INT("screenshot-period")
 			END_OPTION
+
+#ifdef USE_NULL_DRIVER
+			DO_LONG_OPTION_BOOL("benchmark")
+			END_OPTION
+#endif
 #endif
 
 			DO_LONG_OPTION("opl-driver")
@@ -32,6 +32,7 @@
 
 #include "engines/engine.h"
 #include "engines/metaengine.h"
+#include "engines/advancedDetector.h"
 #include "base/commandLine.h"
 #include "base/plugins.h"
 #include "base/version.h"
@@ -43,6 +44,7 @@
 #include "common/events.h"
 #include "gui/EventRecorder.h"
 #include "common/fs.h"
+#include "common/jobs.h"
 #ifdef ENABLE_EVENTRECORDER
 #include "common/recorderfile.h"
 #endif
@@ -63,6 +65,9 @@
 #include "graphics/cursorman.h"
 #include "graphics/fontman.h"
 #include "graphics/yuv_to_rgb.h"
+#include "graphics/blit/blit-fast.h"
+#include "graphics/fonts/glyphatlas.h"
+#include "image/codecs/codec.h"
 #ifdef USE_FREETYPE2
 #include "graphics/fonts/ttf.h"
 #endif
@@ -553,6 +558,9 @@ extern "C" int scummvm_main(int argc, const char * const argv[]) {
 	// the command line params) was read.
 	system.initBackend();
 
+	// Select the SIMD blit kernels while only this thread exists
+	Graphics::FastBlit::selectFuncs();
+
 	// If we received an invalid graphics mode parameter via command line
 	// we check this here. We can't do it until after the backend is inited,
 	// or there won't be a graphics manager to ask for the supported modes.
@@ -890,6 +898,7 @@ extern "C" int scummvm_main(int argc, const char * const argv[]) {
 	Cloud::CloudManager::destroy();
 #endif
 #endif
+	AdvancedDetectorCacheManager::destroy();
 	PluginManager::destroy();
 	GUI::GuiManager::destroy();
 	Common::ConfigManager::destroy();
@@ -908,8 +917,11 @@ extern "C" int scummvm_main(int argc, const char * const argv[]) {
 #ifdef USE_FREETYPE2
 	Graphics::shutdownTTF();
 #endif
+	Graphics::GlyphAtlas::destroy();
 	EngineManager::destroy();
 	Graphics::YUVToRGBManager::destroy();
+	Image::DitherTableCache::destroy();
+	Common::JobSystem::destroy();
 
 	return 0;
 }
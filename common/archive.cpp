@@ -22,6 +22,7 @@
 #include "common/archive.h"
 #include "common/file.h"
 #include "common/fs.h"
+#include "common/mutex.h"
 #include "common/system.h"
 #include "common/textconsole.h"
 #include "common/memstream.h"
@@ -328,6 +329,16 @@ SearchSet::ArchiveNodeList::const_iterator SearchSet::find(const String &name) c
 	return it;
 }
 
+SearchSet::SearchSet() : _indexMutex(nullptr), _ignoreClashes(false) {
+	if (g_system && g_system->backendInitialized())
+		_indexMutex = new Mutex();
+}
+
+SearchSet::~SearchSet() {
+	clear();
+	delete _indexMutex;
+}
+
 /*
 	Keep the nodes sorted according to descending priorities.
 	In case two or node nodes have the same priority, insertion
@@ -340,6 +351,7 @@ void SearchSet::insert(const Node &node) {
 			break;
 	}
 	_list.insert(it, node);
+	clearIndex();
 }
 
 void SearchSet::add(const String &name, Archive *archive, int priority, bool autoFree) {
@@ -430,6 +442,7 @@ void SearchSet::remove(const String &name) {
 		if (it->_autoFree)
 			delete it->_arc;
 		_list.erase(it);
+		clearIndex();
 	}
 }
 
@@ -453,6 +466,7 @@ void SearchSet::clear() {
 	}
 
 	_list.clear();
+	clearIndex(true);
 }
 
 void SearchSet::setPriority(const String &name, int priority) {
@@ -471,17 +485,95 @@ void SearchSet::setPriority(const String &name, int priority) {
 	insert(node);
 }
 
-bool SearchSet::hasFile(const Path &path) const {
-	if (path.empty())
+bool SearchSet::lockIndex() const {
+	// Like the String memory pool, the mutex can only be created once the
+	// backend is initialized. There should be no other threads before, and
+	// a SearchSet created that early (i.e. SearchMan) is first used by the
+	// main thread after.
+	if (!g_system || !g_system->backendInitialized())
 		return false;
+	if (!_indexMutex)
+		_indexMutex = new Mutex();
+	_indexMutex->lock();
+	return true;
+}
 
-	ArchiveNodeList::const_iterator it = _list.begin();
-	for (; it != _list.end(); ++it) {
+void SearchSet::unlockIndex() const {
+	_indexMutex->unlock();
+}
+
+void SearchSet::clearIndex(bool shrinkArray) {
+	const bool locked = lockIndex();
+	_index.clear(shrinkArray);
+	if (locked)
+		unlockIndex();
+}
+
+int SearchSet::findFixedMember(const Path &path) const {
+	// Only the index is locked. The archives are asked without holding the
+	// lock, as FSDirectory::hasFile() checks on disk.
+	bool indexed = false;
+	int fixedPos = -1;
+	bool locked = lockIndex();
+	MemberIndex::const_iterator entry = _index.find(path);
+	if (entry != _index.end()) {
+		indexed = true;
+		fixedPos = entry->_value;
+	}
+	if (locked)
+		unlockIndex();
+
+	if (indexed) {
+		if (fixedPos < 0)
+			return -1;
+
+		// The archive may have lost the member since, e.g. an FSDirectory
+		// whose file was deleted. The entry is then replaced below.
+		ArchiveNodeList::const_iterator it = _list.begin();
+		for (int pos = 0; pos < fixedPos; ++pos)
+			++it;
 		if (it->_arc->hasFile(path))
-			return true;
+			return fixedPos;
 	}
 
-	return false;
+	fixedPos = -1;
+	int pos = 0;
+	for (ArchiveNodeList::const_iterator it = _list.begin(); it != _list.end(); ++it, ++pos) {
+		if (it->_fixedMembers && it->_arc->hasFile(path)) {
+			fixedPos = pos;
+			break;
+		}
+	}
+
+	locked = lockIndex();
+	if (_index.size() >= kMaxIndexSize)
+		_index.clear();
+	_index[path] = fixedPos;
+	if (locked)
+		unlockIndex();
+	return fixedPos;
+}
+
+SearchSet::ArchiveNodeList::const_iterator SearchSet::findMember(const Path &path) const {
+	// Only the archives whose members may change have to be asked every time
+	const int fixedPos = findFixedMember(path);
+
+	int pos = 0;
+	for (ArchiveNodeList::const_iterator it = _list.begin(); it != _list.end(); ++it, ++pos) {
+		if (pos == fixedPos)
+			return it;
+		if (!it->_fixedMembers && it->_arc->hasFile(path))
+			return it;
+	}
+
+	return _list.end();
+}
+
+bool SearchSet::hasFile(const Path &path) const {
+	if (path.empty())
+		return false;
+
+	return findMember(path) != _list.end();
 }
 
 bool SearchSet::isPathDirectory(const Path &path) const {
@@ -560,17 +652,14 @@ const ArchiveMemberPtr SearchSet::getMember(const Path &path, Archive **containe
 	if (path.empty())
 		return ArchiveMemberPtr();
 
-	ArchiveNodeList::const_iterator it = _list.begin();
-	for (; it != _list.end(); ++it) {
-		if (it->_arc->hasFile(path)) {
-			if (container) {
-				*container = it->_arc;
-			}
-			return it->_arc->getMember(path);
-		}
-	}
+	ArchiveNodeList::const_iterator it = findMember(path);
+	if (it == _list.end())
+		return ArchiveMemberPtr();
 
-	return ArchiveMemberPtr();
+	if (container) {
+		*container = it->_arc;
+	}
+	return it->_arc->getMember(path);
 }
 
 const ArchiveMemberPtr SearchSet::getMember(const Path &path) const {
@@ -581,8 +670,16 @@ SeekableReadStream *SearchSet::createReadStreamForMember(const Path &path) const
 	if (path.empty())
 		return nullptr;
 
+	// Archives with fixed members before the first one holding the member
+	// can't open it
+	const int fixedPos = findFixedMember(path);
+
+	int pos = 0;
 	ArchiveNodeList::const_iterator it = _list.begin();
-	for (; it != _list.end(); ++it) {
+	for (; it != _list.end(); ++it, ++pos) {
+		if (it->_fixedMembers && (fixedPos < 0 || pos < fixedPos))
+			continue;
+
 		SeekableReadStream *stream = it->_arc->createReadStreamForMember(path);
 		if (stream)
 			return stream;
@@ -23,9 +23,11 @@
 #define COMMON_ARCHIVE_H
 
 #include "common/error.h"
+#include "common/flathashmap.h"
 #include "common/hashmap.h"
 #include "common/hash-str.h"
 #include "common/list.h"
+#include "common/noncopyable.h"
 #include "common/path.h"
 #include "common/ptr.h"
 #include "common/singleton.h"
@@ -45,6 +47,7 @@ namespace Common {
 
 class ArchiveMember;
 class FSNode;
+class Mutex;
 class SeekableReadStream;
 
 enum class AltStreamType {
@@ -222,6 +225,15 @@ public:
 
 	virtual bool getChildren(const Common::Path &path, Common::Array<Common::String> &list, ListMode mode = kListDirectoriesOnly, bool hidden = true) const;
 
+	/**
+	 * Return true if the archive never gains members once it has been opened,
+	 * and hasFile() returns true for every member which can be opened.
+	 * SearchSet only remembers which archive holds a member for such archives.
+	 * It still asks that archive with hasFile() on every lookup, in case the
+	 * member was removed.
+	 */
+	virtual bool hasFixedMembers() const { return false; }
+
 private:
 	void prepareMaps() const;
 
@@ -239,11 +251,17 @@ class MemcachingCaseInsensitiveArchive;
 // WeakPtr and thus may expire. Also strong reference is held by
 // Returned memory stream. Hence once no memory streams and no
 // strong referenceas are remaining, the block is freed.
+// The contents may also be a view into a larger shared block, e.g.
+// an archive stream addressable in memory (see getSharedRangePointer),
+// in which case no copy of the data is made at all.
 class SharedArchiveContents {
 public:
 	SharedArchiveContents(byte *contents, uint32 contentSize) :
 		_strongRef(contents, ArrayDeleter<byte>()), _weakRef(_strongRef),
 		_contentSize(contentSize), _missingFile(false), _bypass(nullptr) {}
+	SharedArchiveContents(const SharedPtr<byte> &contents, uint32 contentSize) :
+		_strongRef(contents), _weakRef(_strongRef),
+		_contentSize(contentSize), _missingFile(false), _bypass(nullptr) {}
 	SharedArchiveContents() : _strongRef(nullptr), _weakRef(nullptr), _contentSize(0), _missingFile(true), _bypass(nullptr) {}
 	static SharedArchiveContents bypass(SeekableReadStream *stream) {
 		return SharedArchiveContents(stream);
@@ -327,15 +345,21 @@ private:
  * contained Archives, hence the simplistic policy of always looking for the first
  * match. SearchSet does guarantee that searches are performed in DESCENDING
  * priority order. In case of conflicting priorities, insertion order prevails.
+ *
+ * Several threads may look up members at the same time, provided the archives
+ * themselves allow it. The list of archives is not locked though: adding,
+ * removing or reprioritizing archives must not happen while other threads
+ * use the SearchSet.
  */
-class SearchSet : public Archive {
+class SearchSet : public Archive, NonCopyable {
 	struct Node {
 		int		_priority;
 		String	_name;
 		Archive	*_arc;
 		bool	_autoFree;
+		bool	_fixedMembers;
 		Node(int priority, const String &name, Archive *arc, bool autoFree)
-			: _priority(priority), _name(name), _arc(arc), _autoFree(autoFree) {
+			: _priority(priority), _name(name), _arc(arc), _autoFree(autoFree), _fixedMembers(arc->hasFixedMembers()) {
 		}
 	};
 	typedef List<Node> ArchiveNodeList;
@@ -346,11 +370,45 @@ class SearchSet : public Archive {
 
 	void insert(const Node& node); //!< Add an archive while keeping the list sorted by descending priority.
 
+	/**
+	 * Return the position in the list of the first archive with fixed
+	 * members which has a member @p path, or -1 if there is none.
+	 */
+	int findFixedMember(const Path &path) const;
+
+	/**
+	 * Return the first archive in the list which has a member @p path.
+	 */
+	ArchiveNodeList::const_iterator findMember(const Path &path) const;
+
+	enum {
+		kMaxIndexSize = 16384
+	};
+
+	/**
+	 * Position in the list of the first archive with fixed members holding a
+	 * path, or -1 if none does. The paths are compared exactly, so that each
+	 * archive can still decide which paths are equal.
+	 */
+	typedef FlatHashMap<Path, int, Path::Hash, Path::EqualTo> MemberIndex;
+	mutable MemberIndex _index;
+
+	/**
+	 * Guards _index, which lookups update, against lookups from other
+	 * threads. Only held while the index itself is accessed. Created once
+	 * the backend is initialized, see lockIndex().
+	 */
+	mutable Mutex *_indexMutex;
+
+	bool lockIndex() const;
+	void unlockIndex() const;
+	void clearIndex(bool shrinkArray = false);
+
 	bool _ignoreClashes;
 
 public:
-	SearchSet() : _ignoreClashes(false) { }
-	virtual ~SearchSet() { clear(); }
+	SearchSet();
+	virtual ~SearchSet();
 
 	char getPathSeparator() const override { return '/'; }
 
@@ -0,0 +1,184 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/arena.h"
+#include "common/util.h"
+
+namespace Common {
+
+Arena::Arena(size_t blockSize) : _block(0), _offset(0), _blockSize(blockSize),
+	_allocations(0), _bytesAllocated(0), _heapAllocations(0) {
+	assert(blockSize > 0);
+}
+
+Arena::~Arena() {
+	for (uint i = 0; i < _blocks.size(); i++)
+		::free(_blocks[i].data);
+}
+
+void *Arena::allocateSlow(size_t size, size_t alignment) {
+	const size_t needed = size + alignment - 1;
+
+	// Move on to the next kept block if the allocation fits into it,
+	// otherwise insert a new block before it
+	uint next = _blocks.empty() ? 0 : _block + 1;
+	if (next >= _blocks.size() || _blocks[next].size < needed) {
+		Block block;
+		block.size = MAX(needed, _blockSize);
+		block.data = (byte *)::malloc(block.size);
+		if (!block.data)
+			::error("Common::Arena: failure to allocate %u bytes", (uint)block.size);
+		_blocks.insert_at(next, block);
+		_heapAllocations++;
+	}
+
+	_block = next;
+	const size_t offset = (size_t)(-(uintptr)_blocks[next].data) & (alignment - 1);
+	_offset = offset + size;
+	return _blocks[next].data + offset;
+}
+
+char *Arena::copyString(const char *str) {
+	const size_t len = strlen(str) + 1;
+	char *copy = (char *)allocate(len, 1);
+	memcpy(copy, str, len);
+	return copy;
+}
+
+void Arena::reset() {
+	_block = 0;
+	_offset = 0;
+}
+
+void Arena::freeUnusedBlocks() {
+	const uint used = _offset ? _block + 1 : _block;
+	for (uint i = used; i < _blocks.size(); i++)
+		::free(_blocks[i].data);
+	_blocks.resize(used);
+}
+
+size_t Arena::getMemoryUsage() const {
+	size_t size = 0;
+	for (uint i = 0; i < _blocks.size(); i++)
+		size += _blocks[i].size;
+	return size;
+}
+
+void Arena::resetStatistics() {
+	_allocations = 0;
+	_bytesAllocated = 0;
+	_heapAllocations = 0;
+}
+
+
+ArenaString::ArenaString(Arena &arena, const char *str) : _arena(&arena), _str(const_cast<char *>("")), _size(0), _capacity(0) {
+	append(str, strlen(str));
+}
+
+ArenaString::ArenaString(Arena &arena, const char *str, uint32 len) : _arena(&arena), _str(const_cast<char *>("")), _size(0), _capacity(0) {
+	append(str, len);
+}
+
+ArenaString::ArenaString(Arena &arena, const String &str) : _arena(&arena), _str(const_cast<char *>("")), _size(0), _capacity(0) {
+	append(str.c_str(), str.size());
+}
+
+ArenaString::ArenaString(const ArenaString &str) : _arena(str._arena), _str(const_cast<char *>("")), _size(0), _capacity(0) {
+	// Copies can't share the storage, since both may append to it
+	append(str._str, str._size);
+}
+
+ArenaString &ArenaString::operator=(const ArenaString &str) {
+	if (this != &str) {
+		clear();
+		append(str._str, str._size);
+	}
+	return *this;
+}
+
+ArenaString ArenaString::format(Arena &arena, const char *fmt, ...) {
+	va_list va;
+	va_start(va, fmt);
+	const int len = vsnprintf(nullptr, 0, fmt, va);
+	va_end(va);
+
+	ArenaString output(arena);
+	if (len <= 0)
+		return output;
+
+	output.ensureCapacity(len);
+	va_start(va, fmt);
+	vsnprintf(output._str, len + 1, fmt, va);
+	va_end(va);
+	output._size = len;
+	return output;
+}
+
+ArenaString &ArenaString::operator+=(const char *str) {
+	append(str, strlen(str));
+	return *this;
+}
+
+ArenaString &ArenaString::operator+=(const String &str) {
+	append(str.c_str(), str.size());
+	return *this;
+}
+
+ArenaString &ArenaString::operator+=(const ArenaString &str) {
+	append(str._str, str._size);
+	return *this;
+}
+
+ArenaString &ArenaString::operator+=(char c) {
+	append(&c, 1);
+	return *this;
+}
+
+void ArenaString::append(const char *str, uint32 len) {
+	if (!len)
+		return;
+
+	ensureCapacity(_size + len);
+	// The source may be part of this string, which stays in place
+	memmove(_str + _size, str, len);
+	_size += len;
+	_str[_size] = 0;
+}
+
+void ArenaString::clear() {
+	_size = 0;
+	if (_capacity)
+		_str[0] = 0;
+}
+
+void ArenaString::ensureCapacity(uint32 newSize) {
+	if (newSize <= _capacity)
+		return;
+
+	// The old storage stays valid until the arena is rewound
+	const uint32 newCapacity = MAX<uint32>(newSize, MAX<uint32>(_capacity * 2, 15));
+	char *newStr = (char *)_arena->allocate(newCapacity + 1, 1);
+	memcpy(newStr, _str, _size + 1);
+	_str = newStr;
+	_capacity = newCapacity;
+}
+
+} // End of namespace Common
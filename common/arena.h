@@ -0,0 +1,359 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef COMMON_ARENA_H
+#define COMMON_ARENA_H
+
+#include "common/scummsys.h"
+#include "common/array.h"
+#include "common/memory.h"
+#include "common/noncopyable.h"
+#include "common/str.h"
+
+namespace Common {
+
+/**
+ * @defgroup common_arena Arena
+ * @ingroup common_memory
+ *
+ * @brief API for allocating short-lived memory from an arena.
+ * @{
+ */
+
+/**
+ * An arena hands out memory by advancing a pointer through large blocks,
+ * which makes allocating nearly free. Single allocations are never freed,
+ * instead the arena is rewound to an earlier mark, which releases everything
+ * allocated since at once. The blocks are kept for the next allocations, so
+ * e.g. an arena rewound every frame stops using the heap once it has grown
+ * to the size a frame needs.
+ *
+ * The arena never runs destructors. Use ArenaArray and ArenaString, which
+ * do, or only store objects which need none.
+ */
+class Arena : NonCopyable {
+public:
+	/** A position in the arena to rewind to. */
+	struct Marker {
+		uint block;
+		size_t offset;
+	};
+
+	enum {
+		kDefaultBlockSize = 64 * 1024,
+		kDefaultAlignment = 16
+	};
+
+	/**
+	 * Create an arena. The memory is allocated in blocks of @p blockSize
+	 * bytes, or larger ones for larger allocations.
+	 */
+	explicit Arena(size_t blockSize = kDefaultBlockSize);
+	~Arena();
+
+	/**
+	 * Allocate @p size bytes aligned to @p alignment, which must be a power
+	 * of two. The memory stays valid until the arena is rewound past it.
+	 */
+	void *allocate(size_t size, size_t alignment = kDefaultAlignment) {
+		_allocations++;
+		_bytesAllocated += size;
+		if (_block < _blocks.size()) {
+			byte *data = _blocks[_block].data;
+			const size_t offset = _offset + ((size_t)(-(uintptr)(data + _offset)) & (alignment - 1));
+			if (offset + size <= _blocks[_block].size) {
+				_offset = offset + size;
+				return data + offset;
+			}
+		}
+		return allocateSlow(size, alignment);
+	}
+
+	/** Allocate uninitialized memory for @p count objects of type @p T. */
+	template<class T>
+	T *allocateArray(size_t count) {
+		return (T *)allocate(sizeof(T) * count, alignof(T));
+	}
+
+	/** Copy a zero terminated string into the arena. */
+	char *copyString(const char *str);
+
+	/** Return the current position, to pass to rewind() later. */
+	Marker mark() const {
+		Marker marker = { _block, _offset };
+		return marker;
+	}
+
+	/**
+	 * Release all memory allocated since @p marker was taken. Markers taken
+	 * after it become invalid.
+	 */
+	void rewind(const Marker &marker) {
+		assert(marker.block < _block || (marker.block == _block && marker.offset <= _offset));
+		_block = marker.block;
+		_offset = marker.offset;
+	}
+
+	/** Release all memory allocated from the arena, but keep the blocks. */
+	void reset();
+
+	/** Free the blocks which are not in use. */
+	void freeUnusedBlocks();
+
+	/** Return the number of allocations since the last resetStatistics(). */
+	uint getAllocationCount() const { return _allocations; }
+
+	/** Return the number of bytes allocated since the last resetStatistics(). */
+	size_t getBytesAllocated() const { return _bytesAllocated; }
+
+	/** Return how often the arena had to allocate a block since the last resetStatistics(). */
+	uint getHeapAllocationCount() const { return _heapAllocations; }
+
+	/** Return the number of bytes used by the blocks of the arena. */
+	size_t getMemoryUsage() const;
+
+	void resetStatistics();
+
+private:
+	struct Block {
+		byte *data;
+		size_t size;
+	};
+
+	void *allocateSlow(size_t size, size_t alignment);
+
+	Array<Block> _blocks;
+	uint _block;      ///< Block the next allocation is tried in
+	size_t _offset;   ///< Offset of the free space in that block
+	size_t _blockSize;
+
+	uint _allocations;
+	size_t _bytesAllocated;
+	uint _heapAllocations;
+};
+
+/**
+ * Rewinds an arena to the position it had when the scope was entered, once
+ * the scope is left.
+ */
+class ArenaScope : NonCopyable {
+public:
+	explicit ArenaScope(Arena &arena) : _arena(arena), _marker(arena.mark()) {}
+	~ArenaScope() { _arena.rewind(_marker); }
+
+private:
+	Arena &_arena;
+	Arena::Marker _marker;
+};
+
+/**
+ * A dynamically sized array with its elements stored in an arena. It offers
+ * the most common parts of the Array interface.
+ *
+ * When the array grows, the old storage is only released when the arena is
+ * rewound, so reserve() the expected size where it is known. The array must
+ * be destroyed before the arena is rewound past its storage.
+ */
+template<class T>
+class ArenaArray : NonCopyable {
+public:
+	typedef T *iterator;
+	typedef const T *const_iterator;
+
+	typedef T value_type;
+
+	typedef uint size_type;
+
+	explicit ArenaArray(Arena &arena) : _arena(&arena), _storage(nullptr), _size(0), _capacity(0) {}
+
+	ArenaArray(ArenaArray &&old) : _arena(old._arena), _storage(old._storage), _size(old._size), _capacity(old._capacity) {
+		old._storage = nullptr;
+		old._size = 0;
+		old._capacity = 0;
+	}
+
+	~ArenaArray() {
+		clear();
+	}
+
+	/** Construct an element to the end of the array. */
+	template<class... TArgs>
+	void emplace_back(TArgs &&...args) {
+		if (_size != _capacity) {
+			new ((void *)&_storage[_size]) T(Common::forward<TArgs>(args)...);
+		} else {
+			// Construct the new element first, since it may copy-construct from
+			// the original storage
+			const size_type newCapacity = _capacity ? _capacity * 2 : 8;
+			T *newStorage = _arena->allocateArray<T>(newCapacity);
+			new ((void *)&newStorage[_size]) T(Common::forward<TArgs>(args)...);
+			moveStorage(newStorage, newCapacity);
+		}
+		_size++;
+	}
+
+	/** Append an element to the end of the array. */
+	void push_back(const T &element) {
+		emplace_back(element);
+	}
+
+	/** Append an element to the end of the array. */
+	void push_back(T &&element) {
+		emplace_back(Common::move(element));
+	}
+
+	/** Remove the last element of the array. */
+	void pop_back() {
+		assert(_size > 0);
+		_size--;
+		_storage[_size].~T();
+	}
+
+	T &operator[](size_type idx) {
+		assert(idx < _size);
+		return _storage[idx];
+	}
+
+	const T &operator[](size_type idx) const {
+		assert(idx < _size);
+		return _storage[idx];
+	}
+
+	T &front() { assert(_size > 0); return _storage[0]; }
+	const T &front() const { assert(_size > 0); return _storage[0]; }
+	T &back() { assert(_size > 0); return _storage[_size - 1]; }
+	const T &back() const { assert(_size > 0); return _storage[_size - 1]; }
+
+	T *data() { return _storage; }
+	const T *data() const { return _storage; }
+
+	size_type size() const { return _size; }
+	bool empty() const { return _size == 0; }
+
+	iterator begin() { return _storage; }
+	iterator end() { return _storage + _size; }
+	const_iterator begin() const { return _storage; }
+	const_iterator end() const { return _storage + _size; }
+
+	/** Remove all elements. The storage is kept for new elements. */
+	void clear() {
+		for (size_type i = 0; i < _size; i++)
+			_storage[i].~T();
+		_size = 0;
+	}
+
+	/** Make room for at least @p newCapacity elements. */
+	void reserve(size_type newCapacity) {
+		if (newCapacity <= _capacity)
+			return;
+
+		moveStorage(_arena->allocateArray<T>(newCapacity), newCapacity);
+	}
+
+	/** Change the size of the array. */
+	void resize(size_type newSize) {
+		reserve(newSize);
+		for (size_type i = newSize; i < _size; i++)
+			_storage[i].~T();
+		for (size_type i = _size; i < newSize; i++)
+			new ((void *)&_storage[i]) T();
+		_size = newSize;
+	}
+
+	/** Copy the elements into an Array, e.g. to keep them after the arena is rewound. */
+	Array<T> toArray() const {
+		return Array<T>(_storage, _size);
+	}
+
+private:
+	void moveStorage(T *newStorage, size_type newCapacity) {
+		uninitialized_move(_storage, _storage + _size, newStorage);
+		for (size_type i = 0; i < _size; i++)
+			_storage[i].~T();
+		_storage = newStorage;
+		_capacity = newCapacity;
+	}
+
+	Arena *_arena;
+	T *_storage;
+	size_type _size;
+	size_type _capacity;
+};
+
+/**
+ * A string stored in an arena, for building temporary strings without using
+ * the heap. It offers the most common parts of the String interface, and
+ * toString() converts it to a String which outlives the arena.
+ */
+class ArenaString {
+public:
+	explicit ArenaString(Arena &arena) : _arena(&arena), _str(const_cast<char *>("")), _size(0), _capacity(0) {}
+	ArenaString(Arena &arena, const char *str);
+	ArenaString(Arena &arena, const char *str, uint32 len);
+	ArenaString(Arena &arena, const String &str);
+	ArenaString(const ArenaString &str);
+
+	ArenaString &operator=(const ArenaString &str);
+
+	/** Format a string like String::format. */
+	static ArenaString format(Arena &arena, MSVC_PRINTF const char *fmt, ...) GCC_PRINTF(2, 3);
+
+	const char *c_str() const { return _str; }
+	uint32 size() const { return _size; }
+	bool empty() const { return _size == 0; }
+
+	char operator[](int idx) const {
+		assert(_str && idx >= 0 && idx < (int)_size);
+		return _str[idx];
+	}
+
+	ArenaString &operator+=(const char *str);
+	ArenaString &operator+=(const String &str);
+	ArenaString &operator+=(const ArenaString &str);
+	ArenaString &operator+=(char c);
+
+	/** Append @p len characters from @p str. */
+	void append(const char *str, uint32 len);
+
+	bool equals(const char *x) const { return strcmp(_str, x) == 0; }
+	bool equalsIgnoreCase(const char *x) const { return scumm_stricmp(_str, x) == 0; }
+
+	bool operator==(const char *x) const { return equals(x); }
+	bool operator!=(const char *x) const { return !equals(x); }
+
+	void clear();
+
+	String toString() const { return String(_str, _size); }
+
+private:
+	void ensureCapacity(uint32 newSize);
+
+	Arena *_arena;
+	char *_str;
+	uint32 _size;
+	uint32 _capacity; ///< Space for characters at _str, not counting the terminator
+};
+
+/** @} */
+
+} // End of namespace Common
+
+#endif
@@ -0,0 +1,105 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef COMMON_ATOMIC_H
+#define COMMON_ATOMIC_H
+
+#include "common/scummsys.h"
+#include "common/noncopyable.h"
+
+#if defined(HAVE_ATOMIC_BUILTINS)
+// Nothing to include, the compiler provides the __atomic builtins
+#elif defined(_MSC_VER)
+#include "common/intrinsics.h"
+#else
+#include "common/mutex.h"
+#endif
+
+#if defined(HAVE_ATOMIC_BUILTINS) || defined(_MSC_VER)
+/**
+ * Defined if Common::Atomic does not need a mutex, which also makes it usable
+ * for variables which are constructed before g_system is set up.
+ */
+#define COMMON_ATOMIC_LOCK_FREE
+#endif
+
+namespace Common {
+
+/**
+ * @defgroup common_atomic Atomic
+ * @ingroup common
+ *
+ * @brief A minimal atomic variable for sharing state between threads.
+ * @{
+ */
+
+/**
+ * A variable which may be read and written by several threads at once.
+ *
+ * Loads have acquire and stores have release semantics, so everything a
+ * thread wrote before a store() is visible to a thread which load()s the
+ * stored value.
+ *
+ * T must be an integral type (or bool) no wider than 32 bits.
+ *
+ * Uses the compiler's __atomic builtins when configure found them, the
+ * Interlocked intrinsics on MSVC and a Common::Mutex everywhere else. The
+ * mutex fallback needs g_system to be set up at construction time, just like
+ * any other Common::Mutex.
+ */
+template<typename T>
+class Atomic : NonCopyable {
+public:
+	explicit Atomic(T value = T()) : _value(value) {}
+
+#if defined(HAVE_ATOMIC_BUILTINS)
+	T load() const { return __atomic_load_n(&_value, __ATOMIC_ACQUIRE); }
+	void store(T value) { __atomic_store_n(&_value, value, __ATOMIC_RELEASE); }
+	/** Add @p value and return the previous value. */
+	T fetchAdd(T value) { return __atomic_fetch_add(&_value, value, __ATOMIC_ACQ_REL); }
+
+private:
+	T _value;
+#elif defined(_MSC_VER)
+	T load() const { return (T)_InterlockedCompareExchange(&_value, 0, 0); }
+	void store(T value) { _InterlockedExchange(&_value, (long)value); }
+	/** Add @p value and return the previous value. */
+	T fetchAdd(T value) { return (T)_InterlockedExchangeAdd(&_value, (long)value); }
+
+private:
+	mutable volatile long _value;
+#else
+	T load() const { StackLock lock(_mutex); return _value; }
+	void store(T value) { StackLock lock(_mutex); _value = value; }
+	/** Add @p value and return the previous value. */
+	T fetchAdd(T value) { StackLock lock(_mutex); T old = _value; _value += value; return old; }
+
+private:
+	Mutex _mutex;
+	T _value;
+#endif
+};
+
+/** @} */
+
+} // End of namespace Common
+
+#endif
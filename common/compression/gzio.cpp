@@ -34,6 +34,7 @@
    comments to that effect with your name and the date.  Thank you.
  */
 
+#include "common/array.h"
 #include "common/debug.h"
 #include "common/endian.h"
 #include "common/stream.h"
@@ -232,6 +233,8 @@ public:
 		}
 	}
 
+	~GzioReadStream() override;
+
 	uint32 read(void *dataPtr, uint32 dataSize) override;
 
 	bool eos() const override { return _eos; }
@@ -257,6 +260,28 @@ private:
 	static const int WSIZE = 0x8000;
 	static const int INBUFSIZ = 0x2000;
 
+	/*
+	 *  Distance between checkpoints in the uncompressed data.  Each one keeps
+	 *  a copy of the window, so this trades memory for the cost of a seek.
+	 */
+	static const int CHECKPOINT_INTERVAL = 0x100000;
+
+	/*
+	 *  The state at the start of a block, from where decompression can be
+	 *  resumed after a seek instead of starting over.
+	 */
+	struct Checkpoint {
+		/* The offset in the uncompressed data.  */
+		int64 offset;
+		/* The offset of the next unread byte in the underlying file.  */
+		int64 inputOffset;
+		/* The bit buffer and the bits in it.  */
+		unsigned long bb;
+		unsigned bk;
+		/* A copy of the sliding window.  */
+		uint8 *slide;
+	};
+
 	/* If input is in memory following fields are used instead of file.  */
 	Common::DisposablePtr<Common::SeekableReadStream> _input;
 	/* The offset at which the data starts in the underlying file.  */
@@ -302,7 +327,14 @@ private:
 	uint64 _streamPos;
 	bool _eos;
 
+	/* The checkpoints found so far, ordered by offset.  */
+	Common::Array<Checkpoint> _checkpoints;
+
 	void inflate_window();
+	void fill_window();
+	void add_checkpoint(int64 offset);
+	const Checkpoint *find_checkpoint(int64 offset) const;
+	void restore_checkpoint(const Checkpoint &checkpoint);
 	void get_new_block();
 	byte parentGetByte();
 	void parentSeek(int64 off);
@@ -1023,6 +1055,15 @@ GzioReadStream::inflate_window ()
   /* initialize window */
   _wp = 0;
 
+  fill_window ();
+}
+
+
+void
+GzioReadStream::fill_window ()
+{
+  unsigned start = _wp;
+
   /*
    *  Main decompression loop.
    */
@@ -1041,6 +1082,7 @@ GzioReadStream::inflate_window ()
 	      break;
 	    }
 
+	  add_checkpoint (_savedOffset + _wp - start);
 	  get_new_block ();
 	}
 
@@ -1085,7 +1127,74 @@ GzioReadStream::inflate_window ()
 	}
     }
 
-  _savedOffset += _wp;
+  _savedOffset += _wp - start;
+}
+
+
+void
+GzioReadStream::add_checkpoint (int64 offset)
+{
+  Checkpoint checkpoint;
+
+  /* Only extend the list, a later pass finds the same block boundaries.  */
+  if (offset < (_checkpoints.empty () ? 0 : _checkpoints.back ().offset)
+	       + CHECKPOINT_INTERVAL)
+    return;
+
+  checkpoint.offset = offset;
+  checkpoint.inputOffset = _input->pos () - (_inbufSize - _inbufD);
+  checkpoint.bb = _bb;
+  checkpoint.bk = _bk;
+  checkpoint.slide = new uint8[WSIZE];
+  memcpy (checkpoint.slide, _slide, WSIZE);
+
+  _checkpoints.push_back (checkpoint);
+}
+
+
+const GzioReadStream::Checkpoint *
+GzioReadStream::find_checkpoint (int64 offset) const
+{
+  uint lo = 0, hi = _checkpoints.size ();
+
+  /* Find the last checkpoint at or before offset.  */
+  while (lo < hi)
+    {
+      uint mid = (lo + hi) / 2;
+      if (_checkpoints[mid].offset <= offset)
+	lo = mid + 1;
+      else
+	hi = mid;
+    }
+
+  return lo ? &_checkpoints[lo - 1] : NULL;
+}
+
+
+void
+GzioReadStream::restore_checkpoint (const Checkpoint &checkpoint)
+{
+  parentSeek (checkpoint.inputOffset);
+  _bb = checkpoint.bb;
+  _bk = checkpoint.bk;
+
+  /* Checkpoints are taken between blocks.  */
+  _lastBlock = 0;
+  _blockLen = 0;
+  huft_free (_tl);
+  huft_free (_td);
+  _tl = NULL;
+  _td = NULL;
+
+  /*
+   *  The window is circular, so it holds the same data as it did when the
+   *  checkpoint was taken.  Fill the rest of the current part of it.
+   */
+  memcpy (_slide, checkpoint.slide, WSIZE);
+  _wp = checkpoint.offset & (WSIZE - 1);
+  _savedOffset = checkpoint.offset;
+
+  fill_window ();
 }
 
 
@@ -1241,9 +1350,21 @@ GzioReadStream::readAtOffset (int64 offset, byte *buf, uint32 len)
 {
   int32 ret = 0;
 
-  /* Do we reset decompression to the beginning of the file?  */
+  const Checkpoint *checkpoint = find_checkpoint (offset);
+
+  /*
+   *  Do we resume decompression from a checkpoint, or reset it to the
+   *  beginning of the file?  A checkpoint is also used to skip ahead.
+   */
   if (_savedOffset > offset + WSIZE)
-    initialize_tables();
+    {
+      if (checkpoint)
+	restore_checkpoint (*checkpoint);
+      else
+	initialize_tables ();
+    }
+  else if (checkpoint && checkpoint->offset > _savedOffset)
+    restore_checkpoint (*checkpoint);
 
   /*
    *  This loop operates upon uncompressed data only.  The only
@@ -1285,6 +1406,14 @@ GzioReadStream::readAtOffset (int64 offset, byte *buf, uint32 len)
   return ret;
 }
 
+GzioReadStream::~GzioReadStream() {
+	huft_free(_tl);
+	huft_free(_td);
+
+	for (uint i = 0; i < _checkpoints.size(); i++)
+		delete[] _checkpoints[i].slide;
+}
+
 uint32 GzioReadStream::read(void *dataPtr, uint32 dataSize) {
 	int32 actualRead = readAtOffset(_streamPos, (byte *)dataPtr, dataSize);
 	if (actualRead < 0) {
@@ -80,7 +80,7 @@ private:
 		bool isInMacArchive() const override;
 	};
 
-	Common::SeekableReadStream *_stream;
+	Common::SharedPtr<Common::SeekableReadStream> _stream;
 
 	typedef Common::HashMap<Common::Path, FileEntry, Common::Path::IgnoreCase_Hash, Common::Path::IgnoreCase_EqualTo> FileMap;
 	FileMap _map;
@@ -102,7 +102,6 @@ private:
 };
 
 StuffItArchive::StuffItArchive() : Common::MemcachingCaseInsensitiveArchive(), _flattenTree(false) {
-	_stream = nullptr;
 }
 
 StuffItArchive::~StuffItArchive() {
@@ -125,7 +124,7 @@ bool StuffItArchive::open(const Common::Path &filename, bool flattenTree) {
 bool StuffItArchive::open(Common::SeekableReadStream *stream, bool flattenTree) {
 	close();
 
-	_stream = stream;
+	_stream.reset(stream);
 	_flattenTree = flattenTree;
 
 	if (!_stream)
@@ -275,8 +274,7 @@ bool StuffItArchive::open(Common::SeekableReadStream *stream, bool flattenTree)
 }
 
 void StuffItArchive::close() {
-	delete _stream;
-	_stream = nullptr;
+	_stream.reset();
 	_map.clear();
 }
 
@@ -335,34 +333,43 @@ Common::SharedArchiveContents StuffItArchive::readContentsForPathFork(const Comm
 	if (entryFork.compression & 0xF0)
 		error("Unhandled StuffIt encryption");
 
-	Common::SeekableSubReadStream subStream(_stream, entryFork.offset, entryFork.offset + entryFork.compressedSize);
-
-	byte *uncompressedBlock = new byte[entryFork.uncompressedSize];
-
-	// We currently only support type 14 compression
-	switch (entryFork.compression) {
-	case 0: // Uncompressed
-		subStream.read(uncompressedBlock, entryFork.uncompressedSize);
-		break;
-	case 13: // TableHuff
-		if (!decompress13(&subStream, uncompressedBlock, entryFork.uncompressedSize))
-			error("SIT-13 decompression failed");
-		break;
-	case 14: // Installer
-		decompress14(&subStream, uncompressedBlock, entryFork.uncompressedSize);
-		break;
-	default:
-		error("Unhandled StuffIt compression %d", entryFork.compression);
-		return Common::SharedArchiveContents();
+	// Uncompressed forks are handed out as views of the archive if it is
+	// addressable in memory
+	Common::SharedPtr<byte> contents;
+	if (entryFork.compression == 0)
+		contents = Common::getSharedRangePointer(_stream, entryFork.offset, entryFork.uncompressedSize);
+
+	if (!contents) {
+		Common::SeekableSubReadStream subStream(_stream.get(), entryFork.offset, entryFork.offset + entryFork.compressedSize);
+
+		byte *uncompressedBlock = new byte[entryFork.uncompressedSize];
+		contents = Common::SharedPtr<byte>(uncompressedBlock, Common::ArrayDeleter<byte>());
+
+		// We currently only support type 14 compression
+		switch (entryFork.compression) {
+		case 0: // Uncompressed
+			subStream.read(uncompressedBlock, entryFork.uncompressedSize);
+			break;
+		case 13: // TableHuff
+			if (!decompress13(&subStream, uncompressedBlock, entryFork.uncompressedSize))
+				error("SIT-13 decompression failed");
+			break;
+		case 14: // Installer
+			decompress14(&subStream, uncompressedBlock, entryFork.uncompressedSize);
+			break;
+		default:
+			error("Unhandled StuffIt compression %d", entryFork.compression);
+			return Common::SharedArchiveContents();
+		}
 	}
 
-	uint16 actualCRC = Common::CRC16().crcFast(uncompressedBlock, entryFork.uncompressedSize);
+	uint16 actualCRC = Common::CRC16().crcFast(contents.get(), entryFork.uncompressedSize);
 
 	if (actualCRC != entryFork.crc) {
 		error("StuffItArchive::readContentsForPath(): CRC mismatch: %04x vs %04x for file %s %s fork", actualCRC, entryFork.crc, path.toString().c_str(), (isResFork ? "res" : "data"));
 	}
 
-	return Common::SharedArchiveContents(uncompressedBlock, entryFork.uncompressedSize);
+	return Common::SharedArchiveContents(contents, entryFork.uncompressedSize);
 }
 
 Common::Path StuffItArchive::translatePath(const Common::Path &path) const {
@@ -710,6 +710,7 @@ public:
 
 	// Archive implementation
 	bool hasFile(const Path &path) const override;
+	bool hasFixedMembers() const override { return true; }
 	int listMembers(ArchiveMemberList &list) const override;
 	const ArchiveMemberPtr getMember(const Path &path) const override;
 	Common::SharedArchiveContents readContentsForPath(const Common::Path &translated) const override;
@@ -325,6 +325,7 @@ typedef Common::HashMap<Common::Path, cached_file_in_zip, Common::Path::IgnoreCa
 */
 typedef struct {
 	Common::SeekableReadStream *_stream;				/* io structore of the zipfile */
+	Common::SharedPtr<Common::SeekableReadStream> _streamRef;	/* owns _stream, shared by views of stored files */
 	unz_global_info gi;				/* public global information */
 	uLong byte_before_the_zipfile;	/* byte before the zipfile, (>0 for sfx)*/
 	uLong num_file;					/* number of the current file in the zipfile*/
@@ -459,6 +460,7 @@ unzFile unzOpen(Common::SeekableReadStream *stream, bool flattenTree) {
 	int err = UNZ_OK;
 
 	us->_stream = stream;
+	us->_streamRef.reset(stream);
 
 	central_pos = unzlocal_SearchCentralDir(*us->_stream);
 	if (central_pos == 0)
@@ -489,7 +491,6 @@ unzFile unzOpen(Common::SeekableReadStream *stream, bool flattenTree) {
 		err = UNZ_ERRNO;
 
 	if (err != UNZ_OK) {
-		delete us->_stream;
 		delete us;
 		return nullptr;
 	}
@@ -516,7 +517,6 @@ unzFile unzOpen(Common::SeekableReadStream *stream, bool flattenTree) {
 		err = UNZ_BADZIPFILE;
 
 	if (err != UNZ_OK) {
-		delete us->_stream;
 		delete us;
 		return nullptr;
 	}
@@ -606,7 +606,6 @@ int unzClose(unzFile file) {
 		return UNZ_PARAMERROR;
 	s = (unz_s *)file;
 
-	delete s->_stream;
 	delete s;
 	return UNZ_OK;
 }
@@ -988,40 +987,50 @@ Common::SharedArchiveContents unzOpenCurrentFile (unzFile file
 	}
 
 	uint32 crc32_wait = s->cur_file_info.crc;
+	uLong dataOffset = s->cur_file_info_internal.offset_curfile + SIZEZIPLOCALHEADER + iSizeVar;
+
+	// Stored files are handed out as views of the zipfile if it is
+	// addressable in memory
+	Common::SharedPtr<byte> contents;
+	if (s->cur_file_info.compression_method == 0)
+		contents = Common::getSharedRangePointer(s->_streamRef, dataOffset, s->cur_file_info.uncompressed_size);
+
+	if (!contents) {
+		byte *compressedBuffer = new byte[s->cur_file_info.compressed_size];
+		s->_stream->seek(dataOffset);
+		s->_stream->read(compressedBuffer, s->cur_file_info.compressed_size);
+		byte *uncompressedBuffer = nullptr;
+
+		switch (s->cur_file_info.compression_method) {
+		case 0: // Store
+			uncompressedBuffer = compressedBuffer;
+			break;
+		case Z_DEFLATED:
+			uncompressedBuffer = new byte[s->cur_file_info.uncompressed_size];
+			assert(s->cur_file_info.uncompressed_size == 0 || uncompressedBuffer != nullptr);
+			Common::inflateZlibHeaderless(uncompressedBuffer, s->cur_file_info.uncompressed_size, compressedBuffer, s->cur_file_info.compressed_size);
+			delete[] compressedBuffer;
+			compressedBuffer = nullptr;
+			break;
+		default:
+			warning("Unknown compression algoritthm %d", (int)s->cur_file_info.compression_method);
+			delete[] compressedBuffer;
+			return Common::SharedArchiveContents();
+		}
 
-	byte *compressedBuffer = new byte[s->cur_file_info.compressed_size];
-	s->_stream->seek(s->cur_file_info_internal.offset_curfile + SIZEZIPLOCALHEADER + iSizeVar);
-	s->_stream->read(compressedBuffer, s->cur_file_info.compressed_size);
-	byte *uncompressedBuffer = nullptr;
-
-	switch (s->cur_file_info.compression_method) {
-	case 0: // Store
-		uncompressedBuffer = compressedBuffer;
-		break;
-	case Z_DEFLATED:
-		uncompressedBuffer = new byte[s->cur_file_info.uncompressed_size];
-		assert(s->cur_file_info.uncompressed_size == 0 || uncompressedBuffer != nullptr);
-		Common::inflateZlibHeaderless(uncompressedBuffer, s->cur_file_info.uncompressed_size, compressedBuffer, s->cur_file_info.compressed_size);
-		delete[] compressedBuffer;
-		compressedBuffer = nullptr;
-		break;
-	default:
-		warning("Unknown compression algoritthm %d", (int)s->cur_file_info.compression_method);
-		delete[] compressedBuffer;
-		return Common::SharedArchiveContents();
+		contents = Common::SharedPtr<byte>(uncompressedBuffer, Common::ArrayDeleter<byte>());
 	}
 #ifndef USE_ZLIB
-	uint32 crc32_data = crc.crcFast(uncompressedBuffer, s->cur_file_info.uncompressed_size);
+	uint32 crc32_data = crc.crcFast(contents.get(), s->cur_file_info.uncompressed_size);
 #else
-	uint32 crc32_data = crc32(0, uncompressedBuffer, s->cur_file_info.uncompressed_size);
+	uint32 crc32_data = crc32(0, contents.get(), s->cur_file_info.uncompressed_size);
 #endif
 	if (crc32_data != crc32_wait) {
-		delete[] uncompressedBuffer;
 		warning("CRC32 mismatch: %08x, %08x", crc32_data, crc32_wait);
 		return Common::SharedArchiveContents();
 	}
 
-	return Common::SharedArchiveContents(uncompressedBuffer, s->cur_file_info.uncompressed_size);
+	return Common::SharedArchiveContents(contents, s->cur_file_info.uncompressed_size);
 }
 
 
@@ -1043,6 +1052,7 @@ public:
 
 	bool hasFile(const Path &path) const override;
 	bool isPathDirectory(const Path &path) const override;
+	bool hasFixedMembers() const override { return true; }
 	int listMembers(ArchiveMemberList &list) const override;
 	const ArchiveMemberPtr getMember(const Path &path) const override;
 	Common::SharedArchiveContents readContentsForPath(const Common::Path &translated) const override;
@@ -23,6 +23,7 @@
 #include "common/debug.h"
 #include "common/file.h"
 #include "common/fs.h"
+#include "common/profiler.h"
 #include "common/textconsole.h"
 #include "common/system.h"
 #include "backends/fs/fs-factory.h"
@@ -45,6 +46,9 @@ bool File::open(const Path &filename, Archive &archive) {
 	assert(!filename.empty());
 	assert(!_handle);
 
+	PROFILE_ZONE("File::open");
+	PROFILE_COUNT("Opened files", 1);
+
 	SeekableReadStream *stream = nullptr;
 
 	if ((stream = archive.createReadStreamForMember(filename))) {
@@ -69,6 +73,9 @@ bool File::open(const FSNode &node) {
 		return false;
 	}
 
+	PROFILE_ZONE("File::open");
+	PROFILE_COUNT("Opened files", 1);
+
 	SeekableReadStream *stream = node.createReadStream();
 	return open(stream, node.getPath().toString(Common::Path::kNativeSeparator));
 }
@@ -137,6 +144,11 @@ bool File::seek(int64 offs, int whence) {
 	return _handle->seek(offs, whence);
 }
 
+const byte *File::getRangePointer(int64 offset, uint32 size) const {
+	assert(_handle);
+	return _handle->getRangePointer(offset, size);
+}
+
 uint32 File::read(void *ptr, uint32 len) {
 	assert(_handle);
 	return _handle->read(ptr, len);
@@ -0,0 +1,612 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+// The hash table in this file uses open addressing with a separate array of
+// control bytes, in the style of the "Swiss tables" of Abseil: every slot
+// has a control byte holding 7 bits of the hash of its key, and lookups
+// compare a whole group of control bytes at once before looking at any key.
+
+#ifndef COMMON_FLATHASHMAP_H
+#define COMMON_FLATHASHMAP_H
+
+#include "common/func.h"
+#include "common/hashmap.h"
+#include "common/util.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FLATHASHMAP_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace Common {
+
+/**
+ * @defgroup common_flathashmap Flat hash table (FlatHashMap)
+ * @ingroup common
+ *
+ * @brief API for operations on an open addressing hash table.
+ *
+ * @{
+ */
+
+namespace FlatHash {
+
+/** Control byte values. Full slots store the 7 bit H2 hash instead. */
+enum : int8 {
+	kEmpty = -128,
+	kDeleted = -2
+};
+
+enum {
+	kGroupWidth = 16,
+	kMinCapacity = 16
+};
+
+/** Return the index of the lowest set bit in @p mask, which must not be 0. */
+inline uint lowestBit(uint32 mask) {
+#if defined(__GNUC__)
+	return __builtin_ctz(mask);
+#elif defined(_MSC_VER)
+	unsigned long result;
+	_BitScanForward(&result, mask);
+	return result;
+#else
+	uint bit = 0;
+	while (!(mask & 1)) {
+		mask >>= 1;
+		bit++;
+	}
+	return bit;
+#endif
+}
+
+/**
+ * A group of kGroupWidth control bytes. The match functions return a bit mask
+ * with bit i set if control byte i matches.
+ */
+class Group {
+public:
+#ifdef FLATHASHMAP_SSE2
+	explicit Group(const int8 *ctrl) : _ctrl(_mm_loadu_si128((const __m128i *)ctrl)) {}
+
+	uint32 match(int8 h2) const {
+		return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), _ctrl));
+	}
+
+	uint32 matchEmpty() const {
+		return match(kEmpty);
+	}
+
+	uint32 matchEmptyOrDeleted() const {
+		// Both are negative and below -1, full slots are not negative
+		return _mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), _ctrl));
+	}
+
+private:
+	__m128i _ctrl;
+#else
+	explicit Group(const int8 *ctrl) : _ctrl(ctrl) {}
+
+	uint32 match(int8 h2) const {
+		uint32 mask = 0;
+		for (uint i = 0; i < kGroupWidth; i++)
+			mask |= (uint32)(_ctrl[i] == h2) << i;
+		return mask;
+	}
+
+	uint32 matchEmpty() const {
+		return match(kEmpty);
+	}
+
+	uint32 matchEmptyOrDeleted() const {
+		uint32 mask = 0;
+		for (uint i = 0; i < kGroupWidth; i++)
+			mask |= (uint32)(_ctrl[i] < -1) << i;
+		return mask;
+	}
+
+private:
+	const int8 *_ctrl;
+#endif
+};
+
+/**
+ * The table shared by FlatHashMap and FlatHashSet. Node must have a _key
+ * member and a constructor taking the key.
+ */
+template<class Node, class Key, class HashFunc, class EqualFunc>
+class Table {
+public:
+	typedef uint size_type;
+
+	static const size_type npos = (size_type)-1;
+
+	Table() : _ctrl(nullptr), _slots(nullptr), _capacity(0), _size(0), _deleted(0) {}
+
+	Table(const Table &table) : _ctrl(nullptr), _slots(nullptr), _capacity(0), _size(0), _deleted(0), _hash(table._hash), _equal(table._equal) {
+		assign(table);
+	}
+
+	~Table() {
+		destroy();
+	}
+
+	Table &operator=(const Table &table) {
+		if (this != &table) {
+			destroy();
+			_hash = table._hash;
+			_equal = table._equal;
+			assign(table);
+		}
+		return *this;
+	}
+
+	size_type size() const { return _size; }
+	size_type capacity() const { return _capacity; }
+
+	Node &node(size_type idx) { return _slots[idx]; }
+	const Node &node(size_type idx) const { return _slots[idx]; }
+	Node *nodePtr(size_type idx) { return &_slots[idx]; }
+
+	/** Return the first full slot at or after @p idx, or npos. */
+	size_type next(size_type idx) const {
+		for (; idx < _capacity; idx++) {
+			if (_ctrl[idx] >= 0)
+				return idx;
+		}
+		return npos;
+	}
+
+	/** Return the slot holding @p key, or npos. */
+	template<class K>
+	size_type lookup(const K &key) const {
+		if (!_size)
+			return npos;
+
+		const uint hash = mix(_hash(key));
+		const int8 h2 = hash >> 25;
+		const size_type mask = _capacity - 1;
+		size_type pos = hash & mask;
+
+		for (size_type step = kGroupWidth; ; step += kGroupWidth) {
+			const Group group(_ctrl + pos);
+			for (uint32 match = group.match(h2); match; match &= match - 1) {
+				const size_type idx = (pos + lowestBit(match)) & mask;
+				if (_equal(_slots[idx]._key, key))
+					return idx;
+			}
+			// An empty slot ends every probe sequence for a key not in the table
+			if (group.matchEmpty())
+				return npos;
+			pos = (pos + step) & mask;
+		}
+	}
+
+	/** Return the slot holding @p key, creating it if necessary. */
+	size_type lookupAndCreateIfMissing(const Key &key, bool &created) {
+		size_type idx = lookup(key);
+		created = (idx == npos);
+		if (!created)
+			return idx;
+
+		if ((_size + _deleted + 1) * 8 > _capacity * 7) {
+			// Reclaim the deleted slots if that frees enough space, grow otherwise
+			if (_size * 16 < _capacity * 7)
+				rehash(_capacity);
+			else
+				rehash(_capacity ? _capacity * 2 : (size_type)kMinCapacity);
+		}
+
+		const uint hash = mix(_hash(key));
+		idx = findFreeSlot(hash);
+		if (_ctrl[idx] == kDeleted)
+			_deleted--;
+		setCtrl(idx, hash >> 25);
+		new (&_slots[idx]) Node(key);
+		_size++;
+		return idx;
+	}
+
+	/** Remove the node in slot @p idx. This never moves other nodes. */
+	void erase(size_type idx) {
+		assert(idx < _capacity && _ctrl[idx] >= 0);
+		_slots[idx].~Node();
+		setCtrl(idx, kDeleted);
+		_size--;
+		_deleted++;
+	}
+
+	void clear(bool shrinkArray) {
+		if (shrinkArray) {
+			destroy();
+			return;
+		}
+
+		destroyNodes();
+		if (_capacity)
+			memset(_ctrl, kEmpty, _capacity + kGroupWidth);
+		_size = 0;
+		_deleted = 0;
+	}
+
+private:
+	int8 *_ctrl;        ///< Control bytes; the first kGroupWidth - 1 are mirrored after the last one
+	Node *_slots;       ///< Uninitialized storage for _capacity nodes
+	size_type _capacity;
+	size_type _size;
+	size_type _deleted; ///< Number of kDeleted control bytes
+
+	HashFunc _hash;
+	EqualFunc _equal;
+
+	/**
+	 * Spread the bits of the hash, many hash functions in use vary mostly in
+	 * the lowest bits. The top 7 bits are the H2 hash stored in the control
+	 * bytes, the low bits pick the first group to probe.
+	 */
+	static uint mix(uint hash) {
+		return (uint)((uint32)hash * 0x9E3779B1u);
+	}
+
+	void setCtrl(size_type idx, int8 value) {
+		_ctrl[idx] = value;
+		if (idx < kGroupWidth - 1)
+			_ctrl[_capacity + idx] = value;
+	}
+
+	size_type findFreeSlot(uint hash) const {
+		const size_type mask = _capacity - 1;
+		size_type pos = hash & mask;
+
+		for (size_type step = kGroupWidth; ; step += kGroupWidth) {
+			const uint32 match = Group(_ctrl + pos).matchEmptyOrDeleted();
+			if (match)
+				return (pos + lowestBit(match)) & mask;
+			pos = (pos + step) & mask;
+		}
+	}
+
+	void allocate(size_type capacity) {
+		_capacity = capacity;
+		_ctrl = (int8 *)malloc(capacity + kGroupWidth);
+		_slots = (Node *)malloc(capacity * sizeof(Node));
+		assert(_ctrl != nullptr && _slots != nullptr);
+		memset(_ctrl, kEmpty, capacity + kGroupWidth);
+		_size = 0;
+		_deleted = 0;
+	}
+
+	void rehash(size_type newCapacity) {
+		int8 *oldCtrl = _ctrl;
+		Node *oldSlots = _slots;
+		const size_type oldCapacity = _capacity;
+
+		allocate(newCapacity);
+
+		for (size_type i = 0; i < oldCapacity; i++) {
+			if (oldCtrl[i] < 0)
+				continue;
+
+			// The keys are known to be unique, so there is no need to compare them
+			const uint hash = mix(_hash(oldSlots[i]._key));
+			const size_type idx = findFreeSlot(hash);
+			setCtrl(idx, hash >> 25);
+			new (&_slots[idx]) Node(Common::move(oldSlots[i]));
+			oldSlots[i].~Node();
+			_size++;
+		}
+
+		free(oldCtrl);
+		free(oldSlots);
+	}
+
+	void assign(const Table &table) {
+		if (!table._size)
+			return;
+
+		allocate(table._capacity);
+		memcpy(_ctrl, table._ctrl, _capacity + kGroupWidth);
+		for (size_type i = 0; i < _capacity; i++) {
+			if (_ctrl[i] >= 0)
+				new (&_slots[i]) Node(table._slots[i]);
+		}
+		_size = table._size;
+		_deleted = table._deleted;
+	}
+
+	void destroyNodes() {
+		for (size_type i = 0; i < _capacity; i++) {
+			if (_ctrl[i] >= 0)
+				_slots[i].~Node();
+		}
+	}
+
+	void destroy() {
+		destroyNodes();
+		free(_ctrl);
+		free(_slots);
+		_ctrl = nullptr;
+		_slots = nullptr;
+		_capacity = 0;
+		_size = 0;
+		_deleted = 0;
+	}
+};
+
+/** Iterator policy yielding the whole node, for maps. */
+struct SelectNode {
+	template<class V, class N>
+	static V *get(N *node) { return node; }
+};
+
+/** Iterator policy yielding only the key, for sets. */
+struct SelectKey {
+	template<class V, class N>
+	static V *get(N *node) { return &node->_key; }
+};
+
+/**
+ * Iterator over the full slots of a table. Erasing the node an iterator
+ * points to does not invalidate the iterator, inserting does.
+ */
+template<class Table, class ValueType, class Select>
+class IteratorImpl {
+	template<class T, class V, class S> friend class IteratorImpl;
+
+public:
+	typedef typename Table::size_type size_type;
+
+	IteratorImpl() : _idx(0), _table(nullptr) {}
+	IteratorImpl(size_type idx, const Table *table) : _idx(idx), _table(table) {}
+	template<class V>
+	IteratorImpl(const IteratorImpl<Table, V, Select> &c) : _idx(c._idx), _table(c._table) {}
+
+	ValueType &operator*() const { return *deref(); }
+	ValueType *operator->() const { return deref(); }
+
+	bool operator==(const IteratorImpl &iter) const { return _idx == iter._idx && _table == iter._table; }
+	bool operator!=(const IteratorImpl &iter) const { return !(*this == iter); }
+
+	IteratorImpl &operator++() {
+		assert(_table);
+		_idx = _table->next(_idx + 1);
+		return *this;
+	}
+
+	IteratorImpl operator++(int) {
+		IteratorImpl old = *this;
+		operator ++();
+		return old;
+	}
+
+	/** Return the slot the iterator points to. */
+	size_type index() const { return _idx; }
+
+private:
+	size_type _idx;
+	const Table *_table;
+
+	ValueType *deref() const {
+		assert(_table != nullptr);
+		assert(_idx < _table->capacity());
+		return Select::template get<ValueType>(const_cast<Table *>(_table)->nodePtr(_idx));
+	}
+};
+
+} // End of namespace FlatHash
+
+/**
+ * FlatHashMap<Key,Val> maps objects of type Key to objects of type Val, just
+ * like HashMap, and has the same interface, so the two can be swapped for one
+ * another.
+ *
+ * The nodes are stored inline in a single array rather than allocated one by
+ * one, and lookups first compare a group of 16 one byte hash fragments, with
+ * SSE2 where available. This makes lookups and iteration considerably
+ * cheaper, in particular for misses, at the cost of moving nodes around when
+ * the table grows: unlike with HashMap, pointers to keys and values are
+ * invalidated whenever a key is added.
+ *
+ * The lookup functions also accept keys of other types, as long as the hash
+ * and equality functors do: e.g. a FlatHashMap keyed by String with the
+ * IgnoreCase functors can be searched with a const char * without creating
+ * a temporary String.
+ */
+template<class Key, class Val, class HashFunc = Hash<Key>, class EqualFunc = EqualTo<Key> >
+class FlatHashMap {
+public:
+	struct Node {
+		Val _value;
+		const Key _key;
+		explicit Node(const Key &key) : _value(), _key(key) {}
+		Node(const Node &node) : _value(node._value), _key(node._key) {}
+		Node(Node &&node) : _value(Common::move(node._value)), _key(node._key) {}
+	};
+
+private:
+	typedef FlatHash::Table<Node, Key, HashFunc, EqualFunc> Table;
+
+	Table _table;
+
+	Val _defaultVal;
+
+public:
+	typedef typename Table::size_type size_type;
+
+	typedef FlatHash::IteratorImpl<Table, Node, FlatHash::SelectNode> iterator;
+	typedef FlatHash::IteratorImpl<Table, const Node, FlatHash::SelectNode> const_iterator;
+
+	FlatHashMap() : _defaultVal() {}
+
+	template<class K>
+	bool contains(const K &key) const { return _table.lookup(key) != Table::npos; }
+
+	Val &operator[](const Key &key) { return getOrCreateVal(key); }
+	const Val &operator[](const Key &key) const { return getVal(key); }
+
+	Val &getOrCreateVal(const Key &key) {
+		bool created;
+		return _table.node(_table.lookupAndCreateIfMissing(key, created))._value;
+	}
+
+	Val &getVal(const Key &key) {
+		const size_type idx = _table.lookup(key);
+		if (idx != Table::npos)
+			return _table.node(idx)._value;
+#ifdef RELEASE_BUILD
+		return _defaultVal;
+#else
+		unknownKeyError(key);
+#endif
+	}
+
+	const Val &getVal(const Key &key) const {
+		const size_type idx = _table.lookup(key);
+		if (idx != Table::npos)
+			return _table.node(idx)._value;
+#ifdef RELEASE_BUILD
+		return _defaultVal;
+#else
+		unknownKeyError(key);
+#endif
+	}
+
+	template<class K>
+	const Val &getValOrDefault(const K &key) const { return getValOrDefault(key, _defaultVal); }
+
+	template<class K>
+	const Val &getValOrDefault(const K &key, const Val &defaultVal) const {
+		const size_type idx = _table.lookup(key);
+		return idx != Table::npos ? _table.node(idx)._value : defaultVal;
+	}
+
+	template<class K>
+	bool tryGetVal(const K &key, Val &out) const {
+		const size_type idx = _table.lookup(key);
+		if (idx == Table::npos)
+			return false;
+		out = _table.node(idx)._value;
+		return true;
+	}
+
+	void setVal(const Key &key, const Val &val) { getOrCreateVal(key) = val; }
+
+	void clear(bool shrinkArray = 0) { _table.clear(shrinkArray); }
+
+	void erase(iterator entry) {
+		_table.erase(entry.index());
+	}
+
+	template<class K>
+	void erase(const K &key) {
+		const size_type idx = _table.lookup(key);
+		if (idx != Table::npos)
+			_table.erase(idx);
+	}
+
+	size_type size() const { return _table.size(); }
+
+	/** Return true if hashmap is empty. */
+	bool empty() const { return _table.size() == 0; }
+
+	iterator begin() { return iterator(_table.next(0), &_table); }
+	iterator end() { return iterator(Table::npos, &_table); }
+
+	const_iterator begin() const { return const_iterator(_table.next(0), &_table); }
+	const_iterator end() const { return const_iterator(Table::npos, &_table); }
+
+	template<class K>
+	iterator find(const K &key) { return iterator(_table.lookup(key), &_table); }
+
+	template<class K>
+	const_iterator find(const K &key) const { return const_iterator(_table.lookup(key), &_table); }
+};
+
+/**
+ * FlatHashSet<Key> is a set of objects of type Key, stored the same way as
+ * the keys of a FlatHashMap. Iterating over it yields the keys.
+ */
+template<class Key, class HashFunc = Hash<Key>, class EqualFunc = EqualTo<Key> >
+class FlatHashSet {
+public:
+	struct Node {
+		const Key _key;
+		explicit Node(const Key &key) : _key(key) {}
+	};
+
+private:
+	typedef FlatHash::Table<Node, Key, HashFunc, EqualFunc> Table;
+
+	Table _table;
+
+public:
+	typedef typename Table::size_type size_type;
+
+	typedef FlatHash::IteratorImpl<Table, const Key, FlatHash::SelectKey> iterator;
+	typedef iterator const_iterator;
+
+	template<class K>
+	bool contains(const K &key) const { return _table.lookup(key) != Table::npos; }
+
+	/** Add @p key to the set. Return true if it was not in the set yet. */
+	bool insert(const Key &key) {
+		bool created;
+		_table.lookupAndCreateIfMissing(key, created);
+		return created;
+	}
+
+	void clear(bool shrinkArray = 0) { _table.clear(shrinkArray); }
+
+	void erase(iterator entry) {
+		_table.erase(entry.index());
+	}
+
+	/** Remove @p key from the set. Return true if it was in the set. */
+	template<class K>
+	bool erase(const K &key) {
+		const size_type idx = _table.lookup(key);
+		if (idx == Table::npos)
+			return false;
+		_table.erase(idx);
+		return true;
+	}
+
+	size_type size() const { return _table.size(); }
+
+	/** Return true if the set is empty. */
+	bool empty() const { return _table.size() == 0; }
+
+	iterator begin() const { return iterator(_table.next(0), &_table); }
+	iterator end() const { return iterator(Table::npos, &_table); }
+
+	template<class K>
+	iterator find(const K &key) const { return iterator(_table.lookup(key), &_table); }
+};
+
+/** @} */
+
+} // End of namespace Common
+
+#endif
@@ -54,6 +54,7 @@ QuickTimeParser::QuickTimeParser() {
 	_winX = 0;
 	_winY = 0;
 	_panoTrack = nullptr;
+	_lazySampleTables = false;
 
 	initParseTable();
 }
@@ -80,6 +81,8 @@ bool QuickTimeParser::parseFile(const Path &filename) {
 			_fd = _resFork->getResource(MKTAG('m', 'o', 'o', 'v'), idArray[0]);
 
 		if (_fd) {
+			// The resource is freed below, so read the sample tables now
+			_lazySampleTables = false;
 			atom.size = _fd->size();
 			if (readDefault(atom) < 0 || !_foundMOOV)
 				return false;
@@ -92,6 +95,7 @@ bool QuickTimeParser::parseFile(const Path &filename) {
 	if (!_fd)
 		return false;
 	atom.size = _fd->size();
+	_lazySampleTables = true;
 
 	if (readDefault(atom) < 0 || !_foundMOOV)
 		return false;
@@ -109,6 +113,7 @@ bool QuickTimeParser::parseStream(SeekableReadStream *stream, DisposeAfterUse::F
 	_fd = stream;
 	_foundMOOV = false;
 	_disposeFileHandle = disposeFileHandle;
+	_lazySampleTables = true;
 
 	Atom atom = { 0, 0, 0xffffffff };
 
@@ -149,7 +154,7 @@ bool QuickTimeParser::parsePanoramaAtoms() {
 			sizes[i] = _panoTrack->sampleSizes[i];
 	}
 
-	for (uint32 i = 0; i < sizes.size() && i < _panoTrack->chunkCount; i++) {
+	for (uint32 i = 0; i < sizes.size() && i < _panoTrack->chunkOffsets.size(); i++) {
 		_panoTrack->panoSamples.resize(_panoTrack->panoSamples.size() + 1);
 		Atom atom = { 0, _panoTrack->chunkOffsets[i], sizes[i] };
 		_fd->seek(_panoTrack->chunkOffsets[i], SEEK_SET);
@@ -363,7 +368,9 @@ int QuickTimeParser::readCMOV(Atom atom) {
 
 	// Load data into a new MemoryReadStream and assign _fd to be that
 	SeekableReadStream *oldStream = _fd;
+	bool oldLazySampleTables = _lazySampleTables;
 	_fd = new MemoryReadStream(uncompressedData, uncompressedSize, DisposeAfterUse::YES);
+	_lazySampleTables = false;
 
 	// Read the contents of the uncompressed data
 	Atom a = { MKTAG('m', 'o', 'o', 'v'), 0, uncompressedSize };
@@ -373,6 +380,7 @@ int QuickTimeParser::readCMOV(Atom atom) {
 	free(compressedData);
 	delete _fd;
 	_fd = oldStream;
+	_lazySampleTables = oldLazySampleTables;
 
 	return err;
 }
@@ -653,6 +661,14 @@ int QuickTimeParser::readSTSC(Atom atom) {
 		track->sampleToChunk[i].count = _fd->readUint32BE();
 		track->sampleToChunk[i].id = _fd->readUint32BE();
 		//warning("Sample to Chunk[%d]: First = %d, Count = %d", i, track->sampleToChunk[i].first, track->sampleToChunk[i].count);
+
+		// Index the entries by their first sample, so that finding the
+		// chunk of a sample does not need to walk through all the chunks
+		if (i == 0)
+			track->sampleToChunk[i].firstSample = 0;
+		else
+			track->sampleToChunk[i].firstSample = track->sampleToChunk[i - 1].firstSample +
+				(track->sampleToChunk[i].first - track->sampleToChunk[i - 1].first) * track->sampleToChunk[i - 1].count;
 	}
 
 	return 0;
@@ -664,20 +680,14 @@ int QuickTimeParser::readSTSS(Atom atom) {
 	_fd->readByte(); // version
 	_fd->readByte(); _fd->readByte(); _fd->readByte(); // flags
 
-	track->keyframeCount = _fd->readUint32BE();
-
-	debug(0, "keyframeCount = %d", track->keyframeCount);
+	uint32 keyframeCount = _fd->readUint32BE();
 
-	track->keyframes = new uint32[track->keyframeCount];
+	debug(0, "keyframeCount = %d", keyframeCount);
 
-	if (!track->keyframes)
+	if (keyframeCount > (uint32)(_fd->size() - _fd->pos()) / 4)
 		return -1;
 
-	for (uint32 i = 0; i < track->keyframeCount; i++) {
-		track->keyframes[i] = _fd->readUint32BE() - 1; // Adjust here, the frames are based on 1
-		debug(6, "keyframes[%d] = %d", i, track->keyframes[i]);
-
-	}
+	track->keyframes.load(_fd, keyframeCount, 1, _lazySampleTables); // Adjust here, the frames are based on 1
 	return 0;
 }
 
@@ -695,16 +705,10 @@ int QuickTimeParser::readSTSZ(Atom atom) {
 	if (track->sampleSize)
 		return 0; // there isn't any table following
 
-	track->sampleSizes = new uint32[track->sampleCount];
-
-	if (!track->sampleSizes)
+	if (track->sampleCount > (uint32)(_fd->size() - _fd->pos()) / 4)
 		return -1;
 
-	for(uint32 i = 0; i < track->sampleCount; i++) {
-		track->sampleSizes[i] = _fd->readUint32BE();
-		debug(6, "sampleSizes[%d] = %d", i, track->sampleSizes[i]);
-	}
-
+	track->sampleSizes.load(_fd, track->sampleCount, 0, _lazySampleTables);
 	return 0;
 }
 
@@ -749,19 +753,15 @@ int QuickTimeParser::readSTCO(Atom atom) {
 	_fd->readByte(); // version
 	_fd->readByte(); _fd->readByte(); _fd->readByte(); // flags
 
-	track->chunkCount = _fd->readUint32BE();
-	track->chunkOffsets = new uint32[track->chunkCount];
+	uint32 chunkCount = _fd->readUint32BE();
 
-	if (!track->chunkOffsets)
+	if (chunkCount > (uint32)(_fd->size() - _fd->pos()) / 4)
 		return -1;
 
-	for (uint32 i = 0; i < track->chunkCount; i++) {
-		// WORKAROUND/HACK: The offsets in Riven videos (ones inside the Mohawk archives themselves)
-		// have offsets relative to the archive and not the video. This is quite nasty. We subtract
-		// the initial offset of the stream to get the correct value inside of the stream.
-		track->chunkOffsets[i] = _fd->readUint32BE() - _beginOffset;
-	}
-
+	// WORKAROUND/HACK: The offsets in Riven videos (ones inside the Mohawk archives themselves)
+	// have offsets relative to the archive and not the video. This is quite nasty. We subtract
+	// the initial offset of the stream to get the correct value inside of the stream.
+	track->chunkOffsets.load(_fd, chunkCount, _beginOffset, _lazySampleTables);
 	return 0;
 }
 
@@ -1273,17 +1273,12 @@ QuickTimeParser::SampleDesc::~SampleDesc() {
 }
 
 QuickTimeParser::Track::Track() {
-	chunkCount = 0;
-	chunkOffsets = nullptr;
 	timeToSampleCount = 0;
 	timeToSample = nullptr;
 	sampleToChunkCount = 0;
 	sampleToChunk = nullptr;
 	sampleSize = 0;
 	sampleCount = 0;
-	sampleSizes = nullptr;
-	keyframeCount = 0;
-	keyframes = nullptr;
 	timeScale = 0;
 	width = 0;
 	height = 0;
@@ -1312,14 +1307,149 @@ String QuickTimeParser::PanoStringTable::getString(int32 offset) const {
 }
 
 QuickTimeParser::Track::~Track() {
-	delete[] chunkOffsets;
 	delete[] timeToSample;
 	delete[] sampleToChunk;
-	delete[] sampleSizes;
-	delete[] keyframes;
 
 	for (uint32 i = 0; i < sampleDescs.size(); i++)
 		delete sampleDescs[i];
 }
 
+bool QuickTimeParser::Track::findSampleChunk(uint32 sample, uint32 &chunk, uint32 &firstSampleInChunk, uint32 &descId) const {
+	if (sampleToChunkCount == 0)
+		return false;
+
+	// Find the last entry starting at or before the sample
+	uint32 lo = 0, hi = sampleToChunkCount;
+	while (hi - lo > 1) {
+		uint32 mid = (lo + hi) / 2;
+		if (sampleToChunk[mid].firstSample <= sample)
+			lo = mid;
+		else
+			hi = mid;
+	}
+
+	const SampleToChunkEntry &entry = sampleToChunk[lo];
+	if (entry.count == 0 || sample < entry.firstSample)
+		return false;
+
+	uint32 chunkInEntry = (sample - entry.firstSample) / entry.count;
+	chunk = entry.first + chunkInEntry;
+	if (chunk >= chunkOffsets.size())
+		return false;
+
+	firstSampleInChunk = entry.firstSample + chunkInEntry * entry.count;
+	descId = entry.id;
+	return true;
+}
+
+uint32 QuickTimeParser::Track::getChunkSampleCount(uint32 chunk, uint32 &firstSample) const {
+	// Find the last entry starting at or before the chunk
+	uint32 lo = 0, hi = sampleToChunkCount;
+	while (lo < hi) {
+		uint32 mid = (lo + hi) / 2;
+		if (sampleToChunk[mid].first <= chunk)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (lo == 0) {
+		firstSample = 0;
+		return 0;
+	}
+
+	const SampleToChunkEntry &entry = sampleToChunk[lo - 1];
+	firstSample = entry.firstSample + (chunk - entry.first) * entry.count;
+	return entry.count;
+}
+
+uint32 QuickTimeParser::Track::findKeyframe(uint32 sample) const {
+	// The keyframes are sorted, so search for the last one not after the sample
+	uint32 lo = 0, hi = keyframes.size();
+	while (lo < hi) {
+		uint32 mid = (lo + hi) / 2;
+		if (keyframes[mid] <= sample)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	// If none found, we'll assume the requested sample is a key frame
+	return lo > 0 ? keyframes[lo - 1] : sample;
+}
+
+QuickTimeParser::SampleTable::SampleTable() : _stream(nullptr), _offset(0), _count(0), _bias(0) {
+}
+
+QuickTimeParser::SampleTable::~SampleTable() {
+	clear();
+}
+
+void QuickTimeParser::SampleTable::clear() {
+	for (uint32 i = 0; i < _pages.size(); i++)
+		delete[] _pages[i];
+
+	_pages.clear();
+	_stream = nullptr;
+	_count = 0;
+}
+
+void QuickTimeParser::SampleTable::load(SeekableReadStream *stream, uint32 count, uint32 bias, bool lazy) {
+	clear();
+
+	_stream = stream;
+	_offset = stream->pos();
+	_count = count;
+	_bias = bias;
+	_pages.resize((count + kPageSize - 1) / kPageSize);
+
+	for (uint32 i = 0; i < _pages.size(); i++)
+		_pages[i] = nullptr;
+
+	if (!lazy) {
+		for (uint32 i = 0; i < _pages.size(); i++)
+			loadPage(i);
+
+		_stream = nullptr;
+	}
+
+	stream->seek(_offset + (int64)count * 4);
+}
+
+const uint32 *QuickTimeParser::SampleTable::loadPage(uint32 page) const {
+	assert(_stream && !_pages[page]);
+
+	uint32 first = page * kPageSize;
+	uint32 count = MIN(kPageSize, _count - first);
+	uint32 *entries = new uint32[count];
+
+	// The table is read while data is streamed from the same file, so
+	// leave the stream where it was
+	int64 pos = _stream->pos();
+	_stream->seek(_offset + (int64)first * 4);
+	uint32 bytesRead = _stream->read(entries, count * 4);
+	_stream->seek(pos);
+
+	if (bytesRead != count * 4) {
+		warning("QuickTimeParser::SampleTable: Failed to read entries %d to %d", first, first + count - 1);
+		memset((byte *)entries + bytesRead, 0, count * 4 - bytesRead);
+	}
+
+	for (uint32 i = 0; i < count; i++)
+		entries[i] = FROM_BE_32(entries[i]) - _bias;
+
+	_pages[page] = entries;
+	return entries;
+}
+
+uint32 QuickTimeParser::SampleTable::getLoadedCount() const {
+	uint32 loaded = 0;
+
+	for (uint32 i = 0; i < _pages.size(); i++)
+		if (_pages[i])
+			loaded += MIN(kPageSize, _count - i * kPageSize);
+
+	return loaded;
+}
+
 } // End of namespace Video
@@ -31,6 +31,7 @@
 #define COMMON_QUICKTIME_H
 
 #include "common/array.h"
+#include "common/noncopyable.h"
 #include "common/scummsys.h"
 #include "common/path.h"
 #include "common/stream.h"
@@ -118,6 +119,56 @@ protected:
 		uint32 first;
 		uint32 count;
 		uint32 id;
+		uint32 firstSample; // computed from the preceding entries
+	};
+
+	/**
+	 * A table of 32-bit entries from a sample table atom (stco, stsz, stss).
+	 *
+	 * When the atom can be read again later, only its position is recorded
+	 * while parsing and the entries are read in pages of kPageSize the first
+	 * time one of them is needed. Long movies thus open quickly and only
+	 * keep the parts of the tables which are actually used in memory.
+	 */
+	class SampleTable : NonCopyable {
+	public:
+		SampleTable();
+		~SampleTable();
+
+		uint32 size() const { return _count; }
+		bool empty() const { return _count == 0; }
+
+		uint32 operator[](uint32 idx) const {
+			assert(idx < _count);
+			const uint32 *page = _pages[idx / kPageSize];
+			if (!page)
+				page = loadPage(idx / kPageSize);
+			return page[idx % kPageSize];
+		}
+
+		/**
+		 * Set up the table for @p count entries stored at the current
+		 * position of @p stream. @p bias is subtracted from every entry.
+		 *
+		 * If @p lazy is set, the stream must stay valid as long as the table.
+		 * Otherwise all the entries are read immediately.
+		 */
+		void load(SeekableReadStream *stream, uint32 count, uint32 bias, bool lazy);
+
+		/** Return the number of entries currently held in memory. */
+		uint32 getLoadedCount() const;
+
+	private:
+		static const uint32 kPageSize = 1024;
+
+		const uint32 *loadPage(uint32 page) const;
+		void clear();
+
+		SeekableReadStream *_stream;
+		int64 _offset;
+		uint32 _count;
+		uint32 _bias;
+		mutable Array<uint32 *> _pages;
 	};
 
 	struct EditListEntry {
@@ -280,17 +331,30 @@ protected:
 		Track();
 		~Track();
 
-		uint32 chunkCount;
-		uint32 *chunkOffsets;
+		/**
+		 * Find the chunk holding @p sample, and the first sample in that
+		 * chunk. Return false if the sample is not in any chunk.
+		 */
+		bool findSampleChunk(uint32 sample, uint32 &chunk, uint32 &firstSampleInChunk, uint32 &descId) const;
+
+		/**
+		 * Return the number of samples in @p chunk, and set @p firstSample
+		 * to the index of the first of them.
+		 */
+		uint32 getChunkSampleCount(uint32 chunk, uint32 &firstSample) const;
+
+		/** Return the last keyframe at or before @p sample, or @p sample if there is none. */
+		uint32 findKeyframe(uint32 sample) const;
+
+		SampleTable chunkOffsets;
 		int timeToSampleCount;
 		TimeToSampleEntry *timeToSample;
 		uint32 sampleToChunkCount;
 		SampleToChunkEntry *sampleToChunk;
 		uint32 sampleSize;
 		uint32 sampleCount;
-		uint32 *sampleSizes;
-		uint32 keyframeCount;
-		uint32 *keyframes;
+		SampleTable sampleSizes;
+		SampleTable keyframes;
 		int32 timeScale; // media time
 
 		uint16 width;
@@ -384,6 +448,7 @@ private:
 	uint32 _beginOffset;
 	MacResManager *_resFork;
 	bool _foundMOOV;
+	bool _lazySampleTables; // whether _fd stays open after parsing
 
 	void initParseTable();
 
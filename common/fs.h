@@ -252,6 +252,15 @@ public:
 	 */
 	bool isWritable() const;
 
+	/**
+	 * Retrieve the size and the last modification time of the file referred
+	 * by this node without opening it. The modification time is an opaque
+	 * value only meant to detect changes to the file.
+	 *
+	 * @return True if the backend provided the information, false otherwise.
+	 */
+	bool getFileStats(int64 &size, int64 &modificationTime) const;
+
 	/**
 	 * Create a SeekableReadStream instance corresponding to the file
 	 * referred by this node. This assumes that the node actually refers
@@ -261,6 +270,17 @@ public:
 	 */
 	SeekableReadStream *createReadStream() const override;
 
+	/**
+	 * Create a SeekableReadStream instance like createReadStream() does,
+	 * which may map the file into memory so that getRangePointer() works on
+	 * it. Meant for read-only game data files; the backend decides whether
+	 * mapping the file is safe and worth it, and falls back to a regular
+	 * stream otherwise. FSDirectory opens its members this way.
+	 *
+	 * @return Pointer to the stream object, nullptr in case of a failure.
+	 */
+	SeekableReadStream *createMappedReadStream() const;
+
 	/**
 	 * Create a SeekableReadStream instance corresponding to an alternate stream
 	 * of the file referred by this node. This assumes that the node actually
@@ -423,6 +443,12 @@ public:
 	 */
 	bool isPathDirectory(const Path &path) const override;
 
+	/**
+	 * The directory is scanned only once, so files created later are never
+	 * found. hasFile() still notices files which were removed.
+	 */
+	bool hasFixedMembers() const override { return true; }
+
 	/**
 	 * Return a list of matching file names. Pattern can use GLOB wildcards.
 	 */
@@ -33,21 +33,28 @@ inline uint hashit_lower(const String &str) { return hashit_lower(str.c_str());
 
 // FIXME: The following functors obviously are not consistently named
 
+// The const char * overloads let FlatHashMap look up String keys without
+// creating a temporary String.
+
 struct CaseSensitiveString_EqualTo {
 	bool operator()(const String& x, const String& y) const { return x.equals(y); }
+	bool operator()(const String& x, const char *y) const { return x.equals(y); }
 };
 
 struct CaseSensitiveString_Hash {
 	uint operator()(const String& x) const { return x.hash(); }
+	uint operator()(const char *x) const { return hashit(x); }
 };
 
 
 struct IgnoreCase_EqualTo {
 	bool operator()(const String& x, const String& y) const { return x.equalsIgnoreCase(y); }
+	bool operator()(const String& x, const char *y) const { return x.equalsIgnoreCase(y); }
 };
 
 struct IgnoreCase_Hash {
 	uint operator()(const String& x) const { return hashit_lower(x.c_str()); }
+	uint operator()(const char *x) const { return hashit_lower(x); }
 };
 
 // Specalization of the Hash functor for String objects.
@@ -61,6 +68,9 @@ struct Hash<String> {
 	uint operator()(const String& s) const {
 		return s.hash();
 	}
+	uint operator()(const char *s) const {
+		return hashit(s);
+	}
 };
 
 template<>
@@ -0,0 +1,206 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/jobs.h"
+#include "common/system.h"
+#include "common/textconsole.h"
+
+namespace Common {
+
+DECLARE_SINGLETON(JobSystem);
+
+JobGroup::JobGroup() : _pending(0), _waiting(false), _done(nullptr) {
+}
+
+JobGroup::~JobGroup() {
+	assert(_pending == 0);
+	delete _done;
+}
+
+JobSystem::JobSystem() : _jobsAvailable(nullptr), _quit(false) {
+	uint cpuCount = g_system->getCPUCount();
+	if (cpuCount <= 1)
+		return;
+
+	_jobsAvailable = g_system->createSemaphore(0);
+	if (!_jobsAvailable)
+		return;
+
+	// The thread calling wait() helps out, so one worker less than the
+	// number of cores keeps every core busy.
+	uint workerCount = MIN<uint>(cpuCount - 1, kMaxWorkers);
+	for (uint i = 0; i < workerCount; i++) {
+		ThreadInternal *thread = g_system->createThread(workerProc, this);
+		if (!thread)
+			break;
+		_workers.push_back(thread);
+	}
+
+	if (_workers.empty()) {
+		delete _jobsAvailable;
+		_jobsAvailable = nullptr;
+	}
+}
+
+JobSystem::~JobSystem() {
+	_mutex.lock();
+	assert(_queue.empty());
+	_quit = true;
+	_mutex.unlock();
+
+	for (uint i = 0; i < _workers.size(); i++)
+		_jobsAvailable->post();
+
+	for (uint i = 0; i < _workers.size(); i++) {
+		_workers[i]->join();
+		delete _workers[i];
+	}
+
+	delete _jobsAvailable;
+}
+
+void JobSystem::addJob(JobGroup &group, JobProc proc, void *param) {
+	if (_workers.empty()) {
+		proc(param);
+		return;
+	}
+
+	Job job;
+	job.proc = proc;
+	job.param = param;
+	job.group = &group;
+
+	_mutex.lock();
+	group._pending++;
+	_queue.push_back(job);
+	_mutex.unlock();
+
+	_jobsAvailable->post();
+}
+
+void JobSystem::wait(JobGroup &group) {
+	if (_workers.empty())
+		return;
+
+	// Run our own jobs rather than sleeping while they sit in the queue.
+	while (runQueuedJob(&group)) {
+	}
+
+	_mutex.lock();
+	if (group._pending == 0) {
+		_mutex.unlock();
+		return;
+	}
+
+	// The remaining jobs are running on workers: sleep until the last one
+	// signals the group.
+	if (!group._done)
+		group._done = g_system->createSemaphore(0);
+	group._waiting = true;
+	_mutex.unlock();
+
+	group._done->wait();
+}
+
+void JobSystem::parallelFor(uint count, RangeProc proc, void *param, uint minSlice) {
+	if (count == 0)
+		return;
+
+	uint sliceCount = MIN<uint>(getConcurrency(), (count + minSlice - 1) / MAX<uint>(minSlice, 1));
+	if (sliceCount <= 1) {
+		proc(param, 0, count);
+		return;
+	}
+
+	struct Slice {
+		RangeProc proc;
+		void *param;
+		uint begin, end;
+
+		static void run(void *slice) {
+			Slice *s = (Slice *)slice;
+			s->proc(s->param, s->begin, s->end);
+		}
+	};
+
+	Slice slices[kMaxWorkers + 1];
+	JobGroup group;
+	for (uint i = 0; i < sliceCount; i++) {
+		slices[i].proc = proc;
+		slices[i].param = param;
+		slices[i].begin = count * i / sliceCount;
+		slices[i].end = count * (i + 1) / sliceCount;
+		addJob(group, Slice::run, &slices[i]);
+	}
+	wait(group);
+}
+
+void JobSystem::workerProc(void *param) {
+	((JobSystem *)param)->workerLoop();
+}
+
+void JobSystem::workerLoop() {
+	for (;;) {
+		_jobsAvailable->wait();
+
+		_mutex.lock();
+		bool quit = _quit && _queue.empty();
+		_mutex.unlock();
+		if (quit)
+			break;
+
+		// The queue may already have been drained by a waiting thread,
+		// in which case this wake-up is simply a no-op.
+		runQueuedJob(nullptr);
+	}
+}
+
+bool JobSystem::runQueuedJob(JobGroup *group) {
+	_mutex.lock();
+	List<Job>::iterator it = _queue.begin();
+	if (group) {
+		while (it != _queue.end() && it->group != group)
+			++it;
+	}
+	if (it == _queue.end()) {
+		_mutex.unlock();
+		return false;
+	}
+	Job job = *it;
+	_queue.erase(it);
+	_mutex.unlock();
+
+	job.proc(job.param);
+	finishJob(job.group);
+	return true;
+}
+
+void JobSystem::finishJob(JobGroup *group) {
+	_mutex.lock();
+	assert(group->_pending > 0);
+	if (--group->_pending == 0 && group->_waiting) {
+		group->_waiting = false;
+		group->_done->post();
+	}
+	_mutex.unlock();
+}
+
+} // End of namespace Common
@@ -0,0 +1,150 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef COMMON_JOBS_H
+#define COMMON_JOBS_H
+
+#include "common/array.h"
+#include "common/list.h"
+#include "common/mutex.h"
+#include "common/singleton.h"
+
+namespace Common {
+
+/**
+ * @defgroup common_jobs Job system
+ * @ingroup common
+ *
+ * @brief API for running independent jobs on a pool of worker threads.
+ * @{
+ */
+
+class JobSystem;
+
+/**
+ * A set of jobs which can be waited on as a whole.
+ *
+ * A group must outlive all jobs added to it; the usual pattern is to put it
+ * on the stack, add jobs, and call JobSystem::wait() before it goes out of
+ * scope.
+ */
+class JobGroup : NonCopyable {
+	friend class JobSystem;
+
+	uint _pending;
+	bool _waiting;
+	SemaphoreInternal *_done;
+
+public:
+	JobGroup();
+	~JobGroup();
+};
+
+/**
+ * Fixed-size pool of worker threads executing jobs.
+ *
+ * The pool is sized after OSystem::getCPUCount() the first time it is used.
+ * On backends without thread support (see OSystem::createThread()) there are
+ * no workers and every job is run on the calling thread as soon as it is
+ * added, so callers never need a separate serial code path.
+ *
+ * Jobs must not touch the OSystem graphics, events or mixer APIs, and must
+ * not share unsynchronized state with each other.
+ */
+class JobSystem : public Singleton<JobSystem> {
+public:
+	typedef void (*JobProc)(void *param);                       /*!< Type definition of a job. */
+	typedef void (*RangeProc)(void *param, uint begin, uint end); /*!< Type definition of a parallelFor() slice. */
+
+	enum {
+		kMaxWorkers = 32
+	};
+
+	JobSystem();
+	~JobSystem();
+
+	/**
+	 * Return the number of worker threads, 0 if jobs are run serially.
+	 */
+	uint getWorkerCount() const { return _workers.size(); }
+
+	/**
+	 * Return the number of threads which can run jobs at the same time,
+	 * including the thread waiting on a group.
+	 */
+	uint getConcurrency() const { return _workers.size() + 1; }
+
+	/**
+	 * Queue a job for execution as part of @p group.
+	 *
+	 * @param group	Group the job belongs to.
+	 * @param proc	Job procedure.
+	 * @param param	Arbitrary pointer passed to the job procedure.
+	 */
+	void addJob(JobGroup &group, JobProc proc, void *param);
+
+	/**
+	 * Block until all jobs of @p group have finished.
+	 *
+	 * While waiting, the calling thread runs queued jobs of the same group
+	 * itself, so waiting from inside a job does not deadlock the pool.
+	 */
+	void wait(JobGroup &group);
+
+	/**
+	 * Split [0, count) into contiguous slices and run @p proc on each of
+	 * them in parallel. Returns when all slices are done.
+	 *
+	 * @param count		Number of items.
+	 * @param proc		Slice procedure, called with a half-open item range.
+	 * @param param		Arbitrary pointer passed to the slice procedure.
+	 * @param minSlice	Minimum number of items per slice, to keep the
+	 *					scheduling overhead low for cheap items.
+	 */
+	void parallelFor(uint count, RangeProc proc, void *param, uint minSlice = 1);
+
+private:
+	struct Job {
+		JobProc proc;
+		void *param;
+		JobGroup *group;
+	};
+
+	static void workerProc(void *param);
+	void workerLoop();
+	bool runQueuedJob(JobGroup *group);
+	void finishJob(JobGroup *group);
+
+	Mutex _mutex;
+	List<Job> _queue;
+	Array<ThreadInternal *> _workers;
+	SemaphoreInternal *_jobsAvailable;
+	bool _quit;
+};
+
+/** @} */
+
+} // End of namespace Common
+
+/** Shortcut for accessing the job system. */
+#define JobSys		Common::JobSystem::instance()
+
+#endif
@@ -27,6 +27,7 @@
 #include "common/fs.h"
 #include "common/macresman.h"
 #include "common/md5.h"
+#include "common/memstream.h"
 #include "common/substream.h"
 #include "common/textconsole.h"
 #include "common/archive.h"
@@ -96,7 +97,6 @@ MacFinderExtendedInfoData MacFinderExtendedInfo::toData() const {
 #define MAXNAMELEN 63
 
 MacResManager::MacResManager() {
-	_stream = nullptr;
 	// _baseFileName cleared by String constructor
 
 	_mode = kResForkNone;
@@ -131,7 +131,7 @@ void MacResManager::close() {
 
 	delete[] _resLists; _resLists = nullptr;
 	delete[] _resTypes; _resTypes = nullptr;
-	delete _stream; _stream = nullptr;
+	_stream.reset();
 	_resMap.numTypes = 0;
 }
 
@@ -157,7 +157,7 @@ String MacResManager::computeResForkMD5AsString(uint32 length, bool tail) const
 	uint32 dataLength = _stream->readUint32BE();
 
 
-	SeekableSubReadStream resForkStream(_stream, dataOffset, dataOffset + dataLength);
+	SeekableSubReadStream resForkStream(_stream.get(), dataOffset, dataOffset + dataLength);
 	if (tail && dataLength > length)
 		resForkStream.seek(-(int64)length, SEEK_END);
 
@@ -243,7 +243,7 @@ bool MacResManager::open(const Path &fileName, Archive &archive) {
 		stream = archive.createReadStreamForMemberAltStream(fileName, AltStreamType::MacResourceFork);
 		if (stream && !loadFromRawFork(stream)) {
 			delete stream;
-			_stream = nullptr;
+			_stream.reset();
 		}
 
 		// If the archive member exists, then the file exists, but has no res fork, so we should return true
@@ -341,7 +341,7 @@ bool MacResManager::open(const Path &fileName, Archive &archive) {
 
 	if (fileExists) { // No non-empty resource fork found, but the file still exists
 		_baseFileName = fileName;
-		_stream = nullptr;
+		_stream.reset();
 		return true;
 	}
 
@@ -804,7 +804,7 @@ bool MacResManager::load(SeekableReadStream *stream) {
 		return false;
 
 	if (_resForkSize == 0) {
-		_stream = stream;
+		_stream.reset(stream);
 		return true;
 	}
 
@@ -826,7 +826,7 @@ bool MacResManager::load(SeekableReadStream *stream) {
 	debug(7, "got header: data %d [%d] map %d [%d]",
 		_dataOffset, _dataLength, _mapOffset, _mapLength);
 
-	_stream = stream;
+	_stream.reset(stream);
 
 	readMap();
 	return true;
@@ -915,6 +915,16 @@ SeekableReadStream *MacResManager::getResource(uint32 typeID, uint16 resID) {
 	if (!len)
 		return nullptr;
 
+	return readResourceData(len);
+}
+
+SeekableReadStream *MacResManager::readResourceData(uint32 len) const {
+	// Resource data is stored raw, so when the fork is addressable in memory
+	// the returned stream can be a view of it instead of a copy
+	SharedPtr<byte> data = getSharedRangePointer(_stream, _stream->pos(), len);
+	if (data)
+		return new MemoryReadStream(data, len);
+
 	return _stream->readStream(len);
 }
 
@@ -929,7 +939,7 @@ SeekableReadStream *MacResManager::getResource(const String &fileName) {
 				if (!len)
 					return nullptr;
 
-				return _stream->readStream(len);
+				return readResourceData(len);
 			}
 		}
 	}
@@ -951,7 +961,7 @@ SeekableReadStream *MacResManager::getResource(uint32 typeID, const String &file
 				if (!len)
 					return nullptr;
 
-				return _stream->readStream(len);
+				return readResourceData(len);
 			}
 		}
 	}
@@ -26,6 +26,7 @@
 
 #include "common/array.h"
 #include "common/fs.h"
+#include "common/ptr.h"
 #include "common/rect.h"
 #include "common/str.h"
 #include "common/str-array.h"
@@ -309,10 +310,11 @@ public:
 	static MacVers *parseVers(SeekableReadStream *vvers);
 
 private:
-	SeekableReadStream *_stream;
+	SharedPtr<SeekableReadStream> _stream;
 	Path _baseFileName;
 
 	bool load(SeekableReadStream *stream);
+	SeekableReadStream *readResourceData(uint32 len) const;
 
 	bool loadFromRawFork(SeekableReadStream *stream);
 	bool loadFromAppleDouble(SeekableReadStream *stream);
@@ -93,9 +93,32 @@ public:
 	int64 size() const { return _size; }
 
 	bool seek(int64 offs, int whence = SEEK_SET);
+
+	const byte *getRangePointer(int64 offset, uint32 size) const {
+		if (offset < 0 || offset > _size || size > _size - offset)
+			return nullptr;
+		return _ptrOrig.get() + offset;
+	}
 };
 
 
+/**
+ * Get a pointer to a range of the data of @p stream which keeps the stream
+ * alive, so that the range can be wrapped in a MemoryReadStream without
+ * copying it.
+ *
+ * @return The pointer, or a null pointer if the stream data is not
+ *         addressable in memory (see SeekableReadStream::getRangePointer).
+ */
+inline SharedPtr<byte> getSharedRangePointer(const SharedPtr<SeekableReadStream> &stream, int64 offset, uint32 size) {
+	const byte *data = stream ? stream->getRangePointer(offset, size) : nullptr;
+	if (!data)
+		return SharedPtr<byte>();
+
+	// Memory streams never write through the pointer
+	return SharedPtr<byte>(stream, const_cast<byte *>(data));
+}
+
 /**
  * This is a MemoryReadStream subclass which adds non-endian
  * read methods whose endianness is set on the stream creation.
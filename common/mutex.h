@@ -45,6 +45,27 @@ public:
 	virtual bool unlock() = 0;
 };
 
+/** Entry point of a thread created with OSystem::createThread(). */
+typedef void (*ThreadProc)(void *param);
+
+class ThreadInternal {
+public:
+	virtual ~ThreadInternal() {}
+
+	/** Block until the thread procedure has returned. */
+	virtual void join() = 0;
+};
+
+class SemaphoreInternal {
+public:
+	virtual ~SemaphoreInternal() {}
+
+	/** Decrement the semaphore, blocking while its count is zero. */
+	virtual void wait() = 0;
+	/** Increment the semaphore, waking up one waiting thread if any. */
+	virtual void post() = 0;
+};
+
 /**
  * Auxiliary class to (un)lock a mutex on the stack.
  */
@@ -1062,6 +1062,15 @@ uint Path::hashIgnoreCase() const {
 	return hashit_lower(_str);
 }
 
+uint Path::Hash::operator()(const char *x) const {
+	// Paths without characters to escape are stored as is
+	return needsEncoding(x, '/') ? Path(x).hash() : hashit(x);
+}
+
+uint Path::IgnoreCase_Hash::operator()(const char *x) const {
+	return needsEncoding(x, '/') ? Path(x).hashIgnoreCase() : hashit_lower(x);
+}
+
 // This hash algorithm is inspired by a Python proposal to hash for tuples
 // https://bugs.python.org/issue942952#msg20602
 // As we don't have the length, it's not added in but
@@ -219,18 +219,26 @@ public:
 	 */
 	struct IgnoreCase_EqualTo {
 		bool operator()(const Path &x, const Path &y) const { return x.equalsIgnoreCase(y); }
+		bool operator()(const Path &x, const char *y) const {
+			return needsEncoding(y, '/') ? x.equalsIgnoreCase(Path(y)) : x._str.equalsIgnoreCase(y);
+		}
 	};
 
 	struct IgnoreCase_Hash {
 		uint operator()(const Path &x) const { return x.hashIgnoreCase(); }
+		uint operator()(const char *x) const;
 	};
 
 	struct EqualTo {
 		bool operator()(const Path &x, const Path &y) const { return x.equals(y); }
+		bool operator()(const Path &x, const char *y) const {
+			return needsEncoding(y, '/') ? x.equals(Path(y)) : x._str.equals(y);
+		}
 	};
 
 	struct Hash {
 		uint operator()(const Path &x) const { return x.hash(); }
+		uint operator()(const char *x) const;
 	};
 
 	/** Construct a new empty path. */
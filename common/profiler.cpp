@@ -0,0 +1,266 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/profiler.h"
+#include "common/algorithm.h"
+#include "common/stream.h"
+#include "common/str.h"
+#include "common/system.h"
+
+namespace Common {
+
+DECLARE_SINGLETON(Profiler);
+
+#ifdef COMMON_ATOMIC_LOCK_FREE
+Atomic<bool> Profiler::_enabled(false);
+#else
+bool Profiler::_enabled = false;
+#endif
+
+#ifndef NO_CXX11_THREAD_LOCAL
+static thread_local bool ownsMainTrack = false;
+#endif
+
+static const char *const trackNames[] = { "Main", "Audio" };
+
+Profiler::Profiler() : _frameCount(0) {
+	for (uint track = 0; track < kTrackCount; track++)
+		_zones[track] = nullptr;
+	memset(&_currentFrame, 0, sizeof(_currentFrame));
+	memset(_depth, 0, sizeof(_depth));
+}
+
+Profiler::~Profiler() {
+	storeEnabled(false);
+	for (uint track = 0; track < kTrackCount; track++)
+		delete[] _zones[track];
+}
+
+void Profiler::setEnabled(bool enabled) {
+	StackLock lock(_mutex);
+
+	if (enabled && !isEnabled()) {
+		// The zone buffers are kept once allocated, zones which were opened
+		// before recording stopped may still be closed into them
+		for (uint track = 0; track < kTrackCount; track++) {
+			if (!_zones[track])
+				_zones[track] = new Zone[kMaxZones];
+		}
+		clear();
+	}
+
+#ifndef NO_CXX11_THREAD_LOCAL
+	if (enabled)
+		ownsMainTrack = true;
+#endif
+	storeEnabled(enabled);
+}
+
+void Profiler::storeEnabled(bool enabled) {
+#ifdef COMMON_ATOMIC_LOCK_FREE
+	_enabled.store(enabled);
+#else
+	_enabled = enabled;
+#endif
+}
+
+bool Profiler::isMainThread() {
+#ifdef NO_CXX11_THREAD_LOCAL
+	// The threads cannot be told apart, but none of the backends which
+	// implement OSystem::createThread() lack thread_local support
+	return true;
+#else
+	return ownsMainTrack;
+#endif
+}
+
+void Profiler::clear() {
+	_frameCount = 0;
+
+	// The zone counts are never reset, since the audio thread may be
+	// closing a zone right now
+	memset(&_currentFrame, 0, sizeof(_currentFrame));
+	_currentFrame.start = now();
+	for (uint track = 0; track < kTrackCount; track++)
+		_currentFrame.firstZone[track] = _zoneCount[track].load();
+}
+
+uint64 Profiler::now() const {
+	return g_system->getMicros();
+}
+
+void Profiler::endZone(const char *name, uint64 start, Track track, uint depth) {
+	uint64 end = now();
+
+	// This thread is the only one writing to the track, so the count cannot
+	// change under us; readers only look at zones once it was stored
+	const uint32 index = _zoneCount[track].load();
+	Zone &zone = _zones[track][index % kMaxZones];
+	zone.name = name;
+	zone.start = start;
+	zone.end = end;
+	zone.order = _zoneOrder.fetchAdd(1);
+	zone.track = track;
+	zone.depth = MIN<uint>(depth, kMaxDepth - 1);
+	_zoneCount[track].store(index + 1);
+}
+
+void Profiler::count(const char *name, int64 value) {
+	StackLock lock(_mutex);
+
+	uint index;
+	for (index = 0; index < _counterNames.size(); index++) {
+		if (_counterNames[index] == name || !strcmp(_counterNames[index], name))
+			break;
+	}
+
+	if (index == _counterNames.size()) {
+		if (index == kMaxCounters)
+			return;
+		_counterNames.push_back(name);
+	}
+
+	_currentFrame.counters[index] += value;
+}
+
+void Profiler::frameMark() {
+	if (!isEnabled())
+		return;
+
+	uint64 end = now();
+
+	StackLock lock(_mutex);
+	const Frame &frame = _frames[_frameCount % kFrameHistory];
+	_currentFrame.end = end;
+	for (uint track = 0; track < kTrackCount; track++)
+		_currentFrame.endZone[track] = _zoneCount[track].load();
+	_frames[_frameCount % kFrameHistory] = _currentFrame;
+	_frameCount++;
+
+	memset(&_currentFrame, 0, sizeof(_currentFrame));
+	_currentFrame.number = _frameCount;
+	_currentFrame.start = end;
+	for (uint track = 0; track < kTrackCount; track++)
+		_currentFrame.firstZone[track] = frame.endZone[track];
+}
+
+void Profiler::getCounterNames(Array<const char *> &names) const {
+	StackLock lock(_mutex);
+	names = _counterNames;
+}
+
+void Profiler::getFrames(Array<Frame> &frames) const {
+	StackLock lock(_mutex);
+
+	uint32 count = MIN<uint32>(_frameCount, kFrameHistory);
+	frames.clear();
+	frames.reserve(count);
+	for (uint32 i = _frameCount - count; i != _frameCount; i++)
+		frames.push_back(_frames[i % kFrameHistory]);
+}
+
+void Profiler::copyZones(Track track, uint32 first, uint32 end, Array<Zone> &zones) const {
+	// Skip the zones which have already been overwritten
+	uint32 count = _zoneCount[track].load();
+	first = MAX(first, count - MIN<uint32>(count, kMaxZones));
+	if (first >= end)
+		return;
+
+	const uint size = zones.size();
+	for (uint32 i = first; i != end; i++)
+		zones.push_back(_zones[track][i % kMaxZones]);
+
+	// The track's thread may have wrapped around and overwritten some of the
+	// copied zones meanwhile, including the one it is writing right now
+	count = _zoneCount[track].load();
+	if (count - first >= kMaxZones) {
+		const uint32 stale = MIN<uint32>(count - first - kMaxZones + 1, end - first);
+		zones.erase(zones.begin() + size, zones.begin() + size + stale);
+	}
+}
+
+static bool closedBefore(const Profiler::Zone &a, const Profiler::Zone &b) {
+	return (int32)(a.order - b.order) < 0;
+}
+
+void Profiler::getZones(const Frame &frame, Array<Zone> &zones) const {
+	StackLock lock(_mutex);
+
+	zones.clear();
+	if (!_zones[0])
+		return;
+
+	for (uint track = 0; track < kTrackCount; track++)
+		copyZones((Track)track, frame.firstZone[track], frame.endZone[track], zones);
+
+	// Each track is in closing order already, interleave them
+	sort(zones.begin(), zones.end(), closedBefore);
+}
+
+static String escapeJSON(const char *str) {
+	String result;
+	for (; *str; str++) {
+		if (*str == '"' || *str == '\\')
+			result += '\\';
+		result += *str;
+	}
+	return result;
+}
+
+void Profiler::exportChromeTrace(WriteStream &stream) const {
+	Array<Frame> frames;
+	Array<const char *> counterNames;
+	getFrames(frames);
+	getCounterNames(counterNames);
+
+	stream.writeString("{\"traceEvents\":[\n");
+
+	// Name the threads after the tracks, frames get a track of their own
+	stream.writeString("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Frames\"}}");
+	for (uint track = 0; track < kTrackCount; track++)
+		stream.writeString(String::format(",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}", track + 1, trackNames[track]));
+
+	uint64 origin = frames.empty() ? 0 : frames[0].start;
+	Array<Zone> zones;
+	for (uint i = 0; i < frames.size(); i++) {
+		const Frame &frame = frames[i];
+		stream.writeString(String::format(",\n{\"name\":\"Frame %u\",\"ph\":\"X\",\"pid\":1,\"tid\":0,\"ts\":%llu,\"dur\":%llu}",
+			frame.number, (unsigned long long)(frame.start - origin), (unsigned long long)(frame.end - frame.start)));
+
+		for (uint c = 0; c < counterNames.size(); c++) {
+			stream.writeString(String::format(",\n{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"ts\":%llu,\"args\":{\"value\":%lld}}",
+				escapeJSON(counterNames[c]).c_str(), (unsigned long long)(frame.start - origin), (long long)frame.counters[c]));
+		}
+
+		getZones(frame, zones);
+		for (uint z = 0; z < zones.size(); z++) {
+			const Zone &zone = zones[z];
+			// Zones still open when the first frame began start before the origin
+			uint64 start = MAX(zone.start, origin);
+			stream.writeString(String::format(",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%llu,\"dur\":%llu}",
+				escapeJSON(zone.name).c_str(), zone.track + 1, (unsigned long long)(start - origin), (unsigned long long)(zone.end - start)));
+		}
+	}
+
+	stream.writeString("\n]}\n");
+}
+
+} // End of namespace Common
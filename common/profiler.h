@@ -0,0 +1,243 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef COMMON_PROFILER_H
+#define COMMON_PROFILER_H
+
+#include "common/array.h"
+#include "common/atomic.h"
+#include "common/mutex.h"
+#include "common/singleton.h"
+
+namespace Common {
+
+/**
+ * @defgroup common_profiler Profiler
+ * @ingroup common
+ *
+ * @brief Lightweight instrumentation of the per-frame hot paths.
+ * @{
+ */
+
+class WriteStream;
+
+/**
+ * Collects timed zones and counters, grouped by frame.
+ *
+ * Zones are opened and closed with the PROFILE_ZONE() macro, which records
+ * the time spent in the enclosing scope. Counters accumulate arbitrary
+ * per-frame values, such as the number of pixels blitted. A frame ends each
+ * time frameMark() is called, which the modular backends do on every
+ * updateScreen(). The last kFrameHistory frames are kept in a ring buffer.
+ *
+ * Recording is off by default, and costs a single test per zone until
+ * setEnabled() is called. Zones are attributed to a track, which names the
+ * thread they run on. The main thread and the audio thread each have their
+ * own track, so nesting depth is tracked separately for both. The main track
+ * belongs to the thread which enabled recording: PROFILE_ZONE() is a no-op
+ * on any other thread, such as the job system workers or the video
+ * decode-ahead thread, which run instrumented code like the blitters as well.
+ *
+ * Every track records its zones into a ring buffer of its own, which only
+ * the thread running the track writes to. Closing a zone therefore takes no
+ * lock and can be done from the mixer callback; the main thread merges the
+ * tracks when it reads them back. Counters, frame marks and the accessors
+ * do lock, so they should only be used on the main thread.
+ */
+class Profiler : public Singleton<Profiler> {
+public:
+	enum Track {
+		kTrackMain,  /*!< Engine, GUI and backend code on the main thread. */
+		kTrackAudio, /*!< Mixer callback. */
+		kTrackCount
+	};
+
+	enum {
+		kFrameHistory = 240,
+		kMaxZones = 32768,
+		kMaxCounters = 16,
+		kMaxDepth = 32
+	};
+
+	/** A completed zone. Times are in microseconds, see OSystem::getMicros(). */
+	struct Zone {
+		const char *name;
+		uint64 start;
+		uint64 end;
+		uint32 order; /*!< Position among the zones of all tracks, in the order they were closed. */
+		byte track;
+		byte depth;
+	};
+
+	/** A completed frame. */
+	struct Frame {
+		uint32 number;
+		uint64 start;
+		uint64 end;
+		uint32 firstZone[kTrackCount]; /*!< Per track sequence number of the first zone closed during the frame. */
+		uint32 endZone[kTrackCount];   /*!< Per track sequence number past the last zone closed during the frame. */
+		int64 counters[kMaxCounters];
+	};
+
+	Profiler();
+	~Profiler();
+
+	/**
+	 * Start or stop recording. Starting clears all previously recorded data.
+	 */
+	void setEnabled(bool enabled);
+
+	/**
+	 * Return whether recording is on. This does not instantiate the
+	 * profiler, so instrumented code stays usable before g_system is set.
+	 */
+#ifdef COMMON_ATOMIC_LOCK_FREE
+	static bool isEnabled() { return _enabled.load(); }
+#else
+	static bool isEnabled() { return _enabled; }
+#endif
+
+	/** Return whether the calling thread is the one the main track belongs to. */
+	static bool isMainThread();
+
+	/** Return the current time in microseconds. */
+	uint64 now() const;
+
+	/**
+	 * Record a zone which started at @p start and ends now. Must be called on
+	 * the thread @p track stands for; does not lock.
+	 */
+	void endZone(const char *name, uint64 start, Track track, uint depth);
+
+	/**
+	 * Add @p value to a per-frame counter. @p name must be a string literal,
+	 * or at least outlive the profiler.
+	 */
+	void count(const char *name, int64 value);
+
+	/** End the current frame and start a new one. */
+	void frameMark();
+
+	/** Copy the names of all counters registered so far, in counter order. */
+	void getCounterNames(Array<const char *> &names) const;
+
+	/** Copy the completed frames, oldest first. */
+	void getFrames(Array<Frame> &frames) const;
+
+	/**
+	 * Copy the zones of @p frame which are still in the ring buffers, in the
+	 * order they were closed.
+	 */
+	void getZones(const Frame &frame, Array<Zone> &zones) const;
+
+	/**
+	 * Write the recorded frames as JSON in the Chrome trace event format,
+	 * which can be loaded in chrome://tracing or Perfetto.
+	 */
+	void exportChromeTrace(WriteStream &stream) const;
+
+	/** @internal Used by ProfileZone to track nesting. */
+	uint enterZone(Track track) { return _depth[track]++; }
+	void leaveZone(Track track) { _depth[track]--; }
+
+private:
+	void clear();
+	void copyZones(Track track, uint32 first, uint32 end, Array<Zone> &zones) const;
+	static void storeEnabled(bool enabled);
+
+#ifdef COMMON_ATOMIC_LOCK_FREE
+	static Atomic<bool> _enabled;
+#else
+	// A Common::Atomic would need a mutex, which cannot exist before g_system
+	static bool _enabled;
+#endif
+	Mutex _mutex;
+
+	/** Per track ring buffers of kMaxZones zones, only written by the thread of the track */
+	Zone *_zones[kTrackCount];
+	/** Per track number of zones closed so far, stored after the zone was written */
+	Atomic<uint32> _zoneCount[kTrackCount];
+	/** Number of zones closed so far on all tracks */
+	Atomic<uint32> _zoneOrder;
+
+	Frame _frames[kFrameHistory];
+	uint32 _frameCount;
+	Frame _currentFrame;
+
+	Array<const char *> _counterNames;
+	uint _depth[kTrackCount];
+};
+
+/**
+ * Records the time spent between its construction and its destruction as a
+ * profiler zone. Use through PROFILE_ZONE() and PROFILE_ZONE_TRACK().
+ */
+class ProfileZone : NonCopyable {
+public:
+	ProfileZone(const char *name, Profiler::Track track = Profiler::kTrackMain) : _name(nullptr) {
+		if (Profiler::isEnabled() && (track != Profiler::kTrackMain || Profiler::isMainThread())) {
+			Profiler &profiler = Profiler::instance();
+			_name = name;
+			_track = track;
+			_depth = profiler.enterZone(track);
+			_start = profiler.now();
+		}
+	}
+
+	~ProfileZone() {
+		if (_name) {
+			Profiler &profiler = Profiler::instance();
+			profiler.leaveZone(_track);
+			profiler.endZone(_name, _start, _track, _depth);
+		}
+	}
+
+private:
+	const char *_name;
+	Profiler::Track _track;
+	uint _depth;
+	uint64 _start;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+/** Profile the rest of the enclosing scope as a zone called @p name. */
+#define PROFILE_ZONE(name) Common::ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+
+/** Profile the rest of the enclosing scope on a track other than the main thread. */
+#define PROFILE_ZONE_TRACK(name, track) Common::ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name, track)
+
+/** Add @p value to the per-frame counter @p name. */
+#define PROFILE_COUNT(name, value) \
+	do { \
+		if (Common::Profiler::isEnabled()) \
+			ProfilerMan.count(name, value); \
+	} while (false)
+
+/** @} */
+
+} // End of namespace Common
+
+/** Shortcut for accessing the profiler. */
+#define ProfilerMan		Common::Profiler::instance()
+
+#endif
@@ -197,6 +197,17 @@ public:
 			_tracker->incStrong();
 	}
 
+	/**
+	 * Creates a pointer to @p p which shares the ownership of @p r, e.g. to
+	 * refer to a member or a part of the object owned by @p r. The object
+	 * owned by @p r is kept alive as long as this pointer exists.
+	 */
+	template<class T2>
+	SharedPtr(const SharedPtr<T2> &r, T *p) : _pointer(p), _tracker(r._tracker) {
+		if (_tracker)
+			_tracker->incStrong();
+	}
+
 	template<class T2>
 	explicit SharedPtr(const WeakPtr<T2> &r) : _pointer(nullptr), _tracker(nullptr) {
 		if (r._tracker && r._tracker->isAlive()) {
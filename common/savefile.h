@@ -140,11 +140,24 @@ public:
  * SaveFileManager instances to be used.
  */
 class SaveFileManager : NonCopyable {
+public:
+	/**
+	 * Type of the callback informed when a save file, which was written in
+	 * the background, has been stored or could not be stored.
+	 *
+	 * @param param  The parameter passed to setSaveCallback().
+	 * @param name   Name of the save file.
+	 * @param error  kNoError if the save file was stored.
+	 */
+	typedef void (*SaveCallback)(void *param, const String &name, const Error &error);
 
 protected:
 	Error _error;      /*!< Error code. */
 	String _errorDesc; /*!< Description of an error. */
 
+	SaveCallback _saveCallback; /*!< Callback informed about save files written in the background. */
+	void *_saveCallbackParam;   /*!< Parameter passed to the callback. */
+
 	/**
 	 * Set some information about the last error that occurred.
 	 * @param error     Code identifying the last error.
@@ -153,6 +166,7 @@ protected:
 	virtual void setError(Error error, const String &errorDesc) { _error = error; _errorDesc = errorDesc; }
 
 public:
+	SaveFileManager() : _saveCallback(nullptr), _saveCallbackParam(nullptr) {}
 	virtual ~SaveFileManager() {}
 
 	/**
@@ -194,6 +208,13 @@ public:
 	 * exports from the Quest for Glory series. QfG5 is a 3D game and will not be
 	 * supported by ScummVM.
 	 *
+	 * Save file managers may write the file in the background after it has
+	 * been finalized. In that case, err() only reports the errors which
+	 * occurred before finalize() returned, and the errors which occur later
+	 * are reported to the callback set with setSaveCallback(). Callers which
+	 * must know whether the file was stored before going on can call
+	 * processPendingSaves(true).
+	 *
 	 * @param name      Name of the save file.
 	 * @param compress  Whether to compress the resulting save file (default) or not.
 	 *
@@ -201,6 +222,24 @@ public:
 	 */
 	virtual OutSaveFile *openForSaving(const String &name, bool compress = true) = 0;
 
+	/**
+	 * Set the callback informed about save files written in the background.
+	 * It is only ever called from processPendingSaves().
+	 *
+	 * @param callback  The callback, or nullptr to not be informed.
+	 * @param param     Arbitrary pointer passed to the callback.
+	 */
+	void setSaveCallback(SaveCallback callback, void *param) { _saveCallback = callback; _saveCallbackParam = param; }
+
+	/**
+	 * Inform the save callback about all save files which have been written
+	 * in the background since the last call.
+	 *
+	 * @param wait  Whether to wait for the save files which are still being
+	 *              written first.
+	 */
+	virtual void processPendingSaves(bool wait = false) {}
+
 	/**
 	 * Open the file with the specified @p name in the given directory for loading.
 	 *
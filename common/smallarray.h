@@ -0,0 +1,308 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef COMMON_SMALLARRAY_H
+#define COMMON_SMALLARRAY_H
+
+#include "common/array.h"
+
+namespace Common {
+
+/**
+ * @addtogroup common_array
+ * @{
+ */
+
+/**
+ * An array which stores up to N elements inside the object itself, and only
+ * allocates memory when it grows larger. It has the interface of Array.
+ *
+ * This suits the many small arrays of points, rectangles or children which
+ * objects keep: an Array allocates as soon as its first element is added.
+ * Unlike with Array, moving a SmallArray which uses the inline storage moves
+ * the elements one by one.
+ */
+template<class T, uint N>
+class SmallArray {
+	static_assert(N > 0, "SmallArray needs inline storage");
+
+public:
+	typedef T *iterator; /*!< Array iterator. */
+	typedef const T *const_iterator; /*!< Const-qualified array iterator. */
+
+	typedef T value_type; /*!< Value type of the array. */
+
+	typedef uint size_type; /*!< Size type of the array. */
+
+private:
+	size_type _capacity; /*!< Maximum number of elements the array can hold. */
+	size_type _size; /*!< How many elements the array holds. */
+	T *_storage; /*!< Memory used for element storage, either _inline or allocated. */
+	alignas(T) byte _inline[N * sizeof(T)];
+
+public:
+	SmallArray() : _capacity(N), _size(0), _storage(inlineStorage()) {}
+
+	/**
+	 * Construct an array as a copy of the given @p array.
+	 */
+	SmallArray(const SmallArray &array) : _capacity(N), _size(0), _storage(inlineStorage()) {
+		reserve(array._size);
+		uninitialized_copy(array.begin(), array.end(), _storage);
+		_size = array._size;
+	}
+
+	/**
+	 * Construct an array as a copy of the given array using the C++11 move semantic.
+	 */
+	SmallArray(SmallArray &&old) : _capacity(N), _size(0), _storage(inlineStorage()) {
+		takeFrom(old);
+	}
+
+	/**
+	 * Construct an array using list initialization.
+	 */
+	SmallArray(std::initializer_list<T> list) : _capacity(N), _size(0), _storage(inlineStorage()) {
+		reserve(list.size());
+		uninitialized_copy(list.begin(), list.end(), _storage);
+		_size = list.size();
+	}
+
+	/**
+	 * Construct an array by copying data from a regular array.
+	 */
+	template<class T2>
+	SmallArray(const T2 *array, size_type n) : _capacity(N), _size(0), _storage(inlineStorage()) {
+		reserve(n);
+		uninitialized_copy(array, array + n, _storage);
+		_size = n;
+	}
+
+	~SmallArray() {
+		clear();
+	}
+
+	SmallArray &operator=(const SmallArray &array) {
+		if (this == &array)
+			return *this;
+
+		clear();
+		reserve(array._size);
+		uninitialized_copy(array.begin(), array.end(), _storage);
+		_size = array._size;
+		return *this;
+	}
+
+	SmallArray &operator=(SmallArray &&old) {
+		if (this == &old)
+			return *this;
+
+		clear();
+		takeFrom(old);
+		return *this;
+	}
+
+	/** Construct an element to the end of the array. */
+	template<class... TArgs>
+	void emplace_back(TArgs &&...args) {
+		if (_size != _capacity) {
+			new ((void *)&_storage[_size]) T(Common::forward<TArgs>(args)...);
+		} else {
+			// Construct the new element first, since it may copy-construct from
+			// the original storage
+			const size_type newCapacity = _capacity * 2;
+			T *newStorage = allocStorage(newCapacity);
+			new ((void *)&newStorage[_size]) T(Common::forward<TArgs>(args)...);
+			moveStorage(newStorage, newCapacity);
+		}
+		_size++;
+	}
+
+	/** Append an element to the end of the array. */
+	void push_back(const T &element) {
+		emplace_back(element);
+	}
+
+	/** Append an element to the end of the array. */
+	void push_back(T &&element) {
+		emplace_back(Common::move(element));
+	}
+
+	/** Remove the last element of the array. */
+	void pop_back() {
+		assert(_size > 0);
+		_size--;
+		_storage[_size].~T();
+	}
+
+	/** Insert an element into the array at the given position. */
+	void insert_at(size_type idx, const T &element) {
+		assert(idx <= _size);
+		// Copy first, the element may be part of this array
+		T tmp(element);
+		if (idx == _size) {
+			emplace_back(Common::move(tmp));
+			return;
+		}
+
+		emplace_back(Common::move(back()));
+		move_backward(_storage + idx, _storage + _size - 2, _storage + _size - 1);
+		_storage[idx] = Common::move(tmp);
+	}
+
+	/** Remove an element at the given position from the array and return the value of that element. */
+	T remove_at(size_type idx) {
+		assert(idx < _size);
+		T tmp = Common::move(_storage[idx]);
+		move(_storage + idx + 1, _storage + _size, _storage + idx);
+		pop_back();
+		return tmp;
+	}
+
+	/** Erase the element at @p pos position and return an iterator pointing to the next element in the array. */
+	iterator erase(iterator pos) {
+		move(pos + 1, _storage + _size, pos);
+		pop_back();
+		return pos;
+	}
+
+	T &operator[](size_type idx) {
+		assert(idx < _size);
+		return _storage[idx];
+	}
+
+	const T &operator[](size_type idx) const {
+		assert(idx < _size);
+		return _storage[idx];
+	}
+
+	T &front() { assert(_size > 0); return _storage[0]; }
+	const T &front() const { assert(_size > 0); return _storage[0]; }
+	T &back() { assert(_size > 0); return _storage[_size - 1]; }
+	const T &back() const { assert(_size > 0); return _storage[_size - 1]; }
+
+	T *data() { return _storage; }
+	const T *data() const { return _storage; }
+
+	size_type size() const { return _size; }
+	bool empty() const { return _size == 0; }
+
+	iterator begin() { return _storage; }
+	iterator end() { return _storage + _size; }
+	const_iterator begin() const { return _storage; }
+	const_iterator end() const { return _storage + _size; }
+
+	/** Return true if the elements are stored inside the object. */
+	bool isInline() const { return _storage == inlineStorage(); }
+
+	/** Clear the array of all its elements, and go back to the inline storage. */
+	void clear() {
+		for (size_type i = 0; i < _size; ++i)
+			_storage[i].~T();
+		if (!isInline())
+			free(_storage);
+		_storage = inlineStorage();
+		_capacity = N;
+		_size = 0;
+	}
+
+	/** Reserve enough memory in the array so that it can store at least the given number of elements. */
+	void reserve(size_type newCapacity) {
+		if (newCapacity <= _capacity)
+			return;
+		moveStorage(allocStorage(newCapacity), newCapacity);
+	}
+
+	/** Change the size of the array. */
+	void resize(size_type newSize) {
+		reserve(newSize);
+		for (size_type i = newSize; i < _size; ++i)
+			_storage[i].~T();
+		for (size_type i = _size; i < newSize; ++i)
+			new ((void *)&_storage[i]) T();
+		_size = newSize;
+	}
+
+	/** Check whether two arrays are identical. */
+	bool operator==(const SmallArray &other) const {
+		if (_size != other._size)
+			return false;
+		for (size_type i = 0; i < _size; ++i) {
+			if (_storage[i] != other._storage[i])
+				return false;
+		}
+		return true;
+	}
+
+	/** Check if two arrays are different. */
+	bool operator!=(const SmallArray &other) const {
+		return !(*this == other);
+	}
+
+	/** Copy the elements into an Array. */
+	Array<T> toArray() const {
+		return Array<T>(_storage, _size);
+	}
+
+private:
+	T *inlineStorage() { return (T *)_inline; }
+	const T *inlineStorage() const { return (const T *)_inline; }
+
+	static T *allocStorage(size_type capacity) {
+		T *storage = (T *)malloc(sizeof(T) * capacity);
+		if (!storage)
+			::error("Common::SmallArray: failure to allocate %u bytes", capacity * (size_type)sizeof(T));
+		return storage;
+	}
+
+	/** Move the elements to new storage, which must be large enough. */
+	void moveStorage(T *newStorage, size_type newCapacity) {
+		uninitialized_move(_storage, _storage + _size, newStorage);
+		for (size_type i = 0; i < _size; ++i)
+			_storage[i].~T();
+		if (!isInline())
+			free(_storage);
+		_storage = newStorage;
+		_capacity = newCapacity;
+	}
+
+	/** Take over the elements of @p old. This array must be empty and inline. */
+	void takeFrom(SmallArray &old) {
+		if (old.isInline()) {
+			uninitialized_move(old.begin(), old.end(), _storage);
+			_size = old._size;
+			old.clear();
+		} else {
+			_storage = old._storage;
+			_capacity = old._capacity;
+			_size = old._size;
+			old._storage = old.inlineStorage();
+			old._capacity = N;
+			old._size = 0;
+		}
+	}
+};
+
+/** @} */
+
+} // End of namespace Common
+
+#endif
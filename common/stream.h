@@ -792,6 +792,24 @@ public:
 	 */
 	virtual bool skip(uint32 offset) { return seek(offset, SEEK_CUR); }
 
+	/**
+	 * Obtain direct read access to a range of the stream data, without
+	 * copying it.
+	 *
+	 * This is only possible for streams whose whole data is addressable in
+	 * memory, such as memory streams or memory-mapped files, so callers must
+	 * be prepared to fall back to read() if nullptr is returned. The stream
+	 * position indicator is not changed, and the returned pointer stays
+	 * valid as long as the stream exists.
+	 *
+	 * @param offset	Offset of the range from the start of the stream.
+	 * @param size		Size of the range in bytes.
+	 *
+	 * @return Pointer to the data, or nullptr if the stream does not support
+	 *         direct access or the range does not lie within the stream.
+	 */
+	virtual const byte *getRangePointer(int64 offset, uint32 size) const { return nullptr; }
+
 	/**
 	 * Read at most one less than the number of characters specified
 	 * by @p bufSize from the stream and store them in the string buffer.
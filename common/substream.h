@@ -86,6 +86,12 @@ public:
 	virtual int64 size() const { return _end - _begin; }
 
 	virtual bool seek(int64 offset, int whence = SEEK_SET);
+
+	virtual const byte *getRangePointer(int64 offset, uint32 size) const {
+		if (offset < 0 || offset > _end - _begin || size > _end - _begin - offset)
+			return nullptr;
+		return _parentStream->getRangePointer(_begin + offset, size);
+	}
 };
 
 /**
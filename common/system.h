@@ -55,6 +55,9 @@ class Store;
 namespace Common {
 class EventManager;
 class MutexInternal;
+class SemaphoreInternal;
+class ThreadInternal;
+typedef void (*ThreadProc)(void *param);
 struct Rect;
 class SaveFileManager;
 class SearchSet;
@@ -1531,6 +1534,16 @@ public:
 	 */
 	virtual uint32 getMillis(bool skipRecord = false) = 0;
 
+	/**
+	 * Get the number of microseconds since an arbitrary starting point, with
+	 * the best precision the backend can offer.
+	 *
+	 * Unlike getMillis(), this is never recorded or replayed by the event
+	 * recorder, so it is only meant for measuring time, for example by the
+	 * profiler. The default implementation is based on getMillis().
+	 */
+	virtual uint64 getMicros() { return (uint64)getMillis(true) * 1000; }
+
 	/** Delay/sleep for the specified amount of milliseconds. */
 	virtual void delayMillis(uint msecs) = 0;
 
@@ -1616,6 +1629,39 @@ public:
 	 */
 	virtual Common::MutexInternal *createMutex() = 0;
 
+	/**
+	 * Create a new worker thread which immediately starts running @p proc.
+	 *
+	 * This is not a general purpose threading API: it only exists so that
+	 * Common::JobSystem can spread independent work over several cores.
+	 * Engines should use Common::JobSystem instead of calling this directly.
+	 *
+	 * Backends which do not support threads do not need to override this.
+	 * Jobs are then run serially on the calling thread.
+	 *
+	 * @param proc	Thread procedure.
+	 * @param param	Arbitrary pointer passed to the thread procedure.
+	 *
+	 * @return The newly created thread, or 0 if threads are not supported.
+	 */
+	virtual Common::ThreadInternal *createThread(Common::ThreadProc proc, void *param) { return nullptr; }
+
+	/**
+	 * Create a new counting semaphore.
+	 *
+	 * Backends that override createThread() must also override this.
+	 *
+	 * @param initialCount	Initial value of the semaphore.
+	 *
+	 * @return The newly created semaphore, or 0 if threads are not supported.
+	 */
+	virtual Common::SemaphoreInternal *createSemaphore(uint initialCount) { return nullptr; }
+
+	/**
+	 * Return the number of logical CPU cores available to the process.
+	 */
+	virtual uint getCPUCount() { return 1; }
+
 	/** @} */
 
 
@@ -475,6 +475,11 @@ int main(int argc, char *argv[]) {
 		}
 	}
 
+	// GCC and Clang provide the __atomic builtins which configure checks for.
+	// MSVC uses the Interlocked intrinsics instead, see common/atomic.h.
+	if (projectType != kProjectMSVC)
+		setup.defines.push_back("HAVE_ATOMIC_BUILTINS");
+
 	setup.defines.push_back("SDL_BACKEND");
 	if (!setup.useSDL2) {
 		cout << "\nBuilding against SDL 1.2\n\n";
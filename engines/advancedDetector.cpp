@@ -24,10 +24,12 @@
 #include "common/debug.h"
 #include "common/util.h"
 #include "common/file.h"
+#include "common/jobs.h"
 #include "common/macresman.h"
 #include "common/md5.h"
 #include "common/config-manager.h"
 #include "common/punycode.h"
+#include "common/savefile.h"
 #include "common/system.h"
 #include "common/textconsole.h"
 #include "common/tokenizer.h"
@@ -468,6 +470,124 @@ namespace Common {
 	DECLARE_SINGLETON(AdvancedDetectorCacheManager);
 }
 
+static const char *const kPersistentMD5CacheName = "detection-md5.cache";
+
+void AdvancedDetectorCacheManager::loadPersistentMD5s() {
+	_persistentLoaded = true;
+
+	Common::SaveFileManager *saveFileMan = g_system->getSavefileManager();
+	if (!saveFileMan)
+		return;
+
+	Common::ScopedPtr<Common::InSaveFile> file(saveFileMan->openForLoading(kPersistentMD5CacheName));
+	if (!file)
+		return;
+
+	// Each line is the MD5, size, modification time and generation of last
+	// use, separated by spaces, followed by the key
+	uint32 lastGeneration = 0;
+	while (!file->eos() && !file->err()) {
+		Common::String line = file->readLine();
+		if (line.size() < 34 || line[32] != ' ')
+			continue;
+
+		PersistentMD5 entry;
+		long long size, modificationTime;
+		unsigned int lastUsed;
+		int keyStart;
+		if (sscanf(line.c_str() + 33, "%lld %lld %u %n", &size, &modificationTime, &lastUsed, &keyStart) != 3 || line[33 + keyStart] == '\0')
+			continue;
+
+		entry.md5 = Common::String(line.c_str(), 32);
+		entry.size = size;
+		entry.modificationTime = modificationTime;
+		entry.lastUsed = lastUsed;
+		_persistentMD5s.setVal(line.c_str() + 33 + keyStart, entry);
+		lastGeneration = MAX<uint32>(lastGeneration, lastUsed);
+	}
+
+	_persistentGeneration = lastGeneration + 1;
+}
+
+bool AdvancedDetectorCacheManager::getPersistentMD5(const Common::String &key, int64 size, int64 modificationTime, Common::String &md5) {
+	if (!_persistentLoaded)
+		loadPersistentMD5s();
+
+	PersistentMD5Map::iterator it = _persistentMD5s.find(key);
+	if (it == _persistentMD5s.end())
+		return false;
+
+	// The file was modified since it was hashed, the entry is replaced
+	// once the new MD5 is known
+	if (it->_value.size != size || it->_value.modificationTime != modificationTime)
+		return false;
+
+	if (it->_value.lastUsed != _persistentGeneration) {
+		it->_value.lastUsed = _persistentGeneration;
+		_persistentDirty = true;
+	}
+
+	md5 = it->_value.md5;
+	return true;
+}
+
+void AdvancedDetectorCacheManager::setPersistentMD5(const Common::String &key, int64 size, int64 modificationTime, const Common::String &md5) {
+	if (!_persistentLoaded)
+		loadPersistentMD5s();
+
+	if (md5.size() != 32)
+		return;
+
+	PersistentMD5 &entry = _persistentMD5s.getOrCreateVal(key);
+	entry.md5 = md5;
+	entry.size = size;
+	entry.modificationTime = modificationTime;
+	entry.lastUsed = _persistentGeneration;
+	_persistentDirty = true;
+}
+
+void AdvancedDetectorCacheManager::flushPersistentMD5s() {
+	if (!_persistentDirty || !g_system)
+		return;
+
+	Common::SaveFileManager *saveFileMan = g_system->getSavefileManager();
+	if (!saveFileMan)
+		return;
+
+	// Keep the cache from growing forever as files come and go: drop the
+	// entries which have not been used for the longest time
+	if (_persistentMD5s.size() > kMaxPersistentMD5s) {
+		Common::Array<uint32> generations;
+		generations.reserve(_persistentMD5s.size());
+		for (PersistentMD5Map::const_iterator it = _persistentMD5s.begin(); it != _persistentMD5s.end(); ++it)
+			generations.push_back(it->_value.lastUsed);
+		Common::sort(generations.begin(), generations.end(), Common::Greater<uint32>());
+		uint32 oldestKept = generations[kMaxPersistentMD5s - 1];
+
+		// Entries used in the same run are kept or dropped together
+		for (PersistentMD5Map::iterator it = _persistentMD5s.begin(); it != _persistentMD5s.end(); ++it) {
+			if (it->_value.lastUsed < oldestKept)
+				_persistentMD5s.erase(it);
+		}
+	}
+
+	Common::ScopedPtr<Common::OutSaveFile> file(saveFileMan->openForSaving(kPersistentMD5CacheName, false));
+	if (!file) {
+		warning("Could not write the MD5 cache '%s'", kPersistentMD5CacheName);
+		return;
+	}
+
+	for (PersistentMD5Map::const_iterator it = _persistentMD5s.begin(); it != _persistentMD5s.end(); ++it) {
+		file->writeString(it->_value.md5);
+		file->writeString(Common::String::format(" %lld %lld %u ", (long long)it->_value.size, (long long)it->_value.modificationTime, it->_value.lastUsed));
+		file->writeString(it->_key);
+		file->writeByte('\n');
+	}
+	file->finalize();
+
+	_persistentDirty = false;
+}
+
 
 static MD5Properties gameFileToMD5Props(const ADGameFileDescription *fileEntry, uint32 gameFlags) {
 	MD5Properties ret = kMD5Head;
@@ -532,12 +652,42 @@ Common::String md5PropToGameFile(MD5Properties flags) {
 
 static bool getFilePropertiesIntern(uint md5Bytes, const AdvancedMetaEngineBase::FileMap &allFiles, MD5Properties md5prop, const Common::Path &fname, FileProperties &fileProps);
 
-bool AdvancedMetaEngineDetectionBase::getFileProperties(const FileMap &allFiles, MD5Properties md5prop, const Common::Path &fname, FileProperties &fileProps) const {
+static Common::String md5CacheName(MD5Properties md5prop, const Common::Path &fname, uint md5Bytes) {
 	Common::String hashname = md5PropToCachePrefix(md5prop);
 		hashname += ':';
 		hashname += fname.toString('/');
 		hashname += ':';
-		hashname += Common::String::format("%d", _md5Bytes);
+		hashname += Common::String::format("%d", md5Bytes);
+	return hashname;
+}
+
+/**
+ * Build the key of a file in the persistent MD5 cache, and get the size and
+ * modification time its entry must match. Only plain files are cached there,
+ * so that rescanning an unchanged directory does not read any file.
+ *
+ * FSNode::getFileStats() is only implemented by the POSIX filesystem so far.
+ * On other filesystems this returns false, and files are hashed on every
+ * detection run as they were before the persistent cache existed.
+ */
+static bool persistentMD5Key(uint md5Bytes, const AdvancedMetaEngineBase::FileMap &allFiles, MD5Properties md5prop, const Common::Path &fname, int64 &size, int64 &modificationTime, Common::String &key) {
+	if (md5prop & (kMD5MacResFork | kMD5MacDataFork | kMD5Archive))
+		return false;
+
+	if (!allFiles.contains(fname))
+		return false;
+
+	const Common::FSNode &node = allFiles[fname];
+	if (!node.getFileStats(size, modificationTime))
+		return false;
+
+	key = Common::String::format("%s:%u:", md5PropToCachePrefix(md5prop).c_str(), md5Bytes);
+	key += node.getPath().toString(Common::Path::kNativeSeparator);
+	return true;
+}
+
+bool AdvancedMetaEngineDetectionBase::getFileProperties(const FileMap &allFiles, MD5Properties md5prop, const Common::Path &fname, FileProperties &fileProps) const {
+	Common::String hashname = md5CacheName(md5prop, fname, _md5Bytes);
 
 	if (ADCacheMan.containsMD5(hashname)) {
 		fileProps.md5 = ADCacheMan.getMD5(hashname);
@@ -545,16 +695,137 @@ bool AdvancedMetaEngineDetectionBase::getFileProperties(const FileMap &allFiles,
 		return true;
 	}
 
+	int64 size, modificationTime;
+	Common::String persistentKey;
+	bool persistent = persistentMD5Key(_md5Bytes, allFiles, md5prop, fname, size, modificationTime, persistentKey);
+	if (persistent && ADCacheMan.getPersistentMD5(persistentKey, size, modificationTime, fileProps.md5)) {
+		fileProps.size = size;
+		fileProps.md5prop = (MD5Properties)(md5prop & kMD5Tail);
+		ADCacheMan.setMD5(hashname, fileProps.md5);
+		ADCacheMan.setSize(hashname, fileProps.size);
+		return true;
+	}
+
 	bool res = getFilePropertiesIntern(_md5Bytes, allFiles, md5prop, fname, fileProps);
 
 	if (res) {
 		ADCacheMan.setMD5(hashname, fileProps.md5);
 		ADCacheMan.setSize(hashname, fileProps.size);
+		if (persistent)
+			ADCacheMan.setPersistentMD5(persistentKey, size, modificationTime, fileProps.md5);
 	}
 
 	return res;
 }
 
+namespace {
+
+struct MD5Job {
+	Common::SeekableReadStream *stream;
+	uint md5Bytes;
+	bool tail;
+	Common::String hashname;
+	Common::String persistentKey;
+	int64 size;
+	int64 modificationTime;
+	Common::String md5;
+
+	static void run(void *param) {
+		MD5Job *job = (MD5Job *)param;
+
+		if (job->tail && job->stream->size() > job->md5Bytes)
+			job->stream->seek(-(int64)job->md5Bytes, SEEK_END);
+
+		job->md5 = Common::computeStreamMD5AsString(*job->stream, job->md5Bytes);
+	}
+};
+
+} // End of anonymous namespace
+
+void AdvancedMetaEngineDetectionBase::precomputeFileProperties(const FileMap &allFiles) const {
+	// Streams are opened and closed on this thread, the workers only read
+	// from their own stream. Limit how many files are open at once.
+	const uint kMaxOpenFiles = 64;
+
+	Common::Array<MD5Job> jobs;
+	jobs.reserve(kMaxOpenFiles);
+	Common::HashMap<Common::String, bool, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> queued;
+
+	const byte *descPtr = _gameDescriptors;
+	const ADGameFileDescription *fileDesc = nullptr;
+
+	for (;;) {
+		// Collect the next batch of files which are neither in the
+		// in-memory nor in the persistent cache
+		while (jobs.size() < kMaxOpenFiles && ((const ADGameDescription *)descPtr)->gameId != nullptr) {
+			const ADGameDescription *g = (const ADGameDescription *)descPtr;
+
+			if (!fileDesc)
+				fileDesc = g->filesDescriptions;
+			if (!fileDesc->fileName) {
+				descPtr += _descItemSize;
+				fileDesc = nullptr;
+				continue;
+			}
+
+			MD5Properties md5prop = gameFileToMD5Props(fileDesc, g->flags);
+			Common::Path fname(fileDesc->fileName);
+			fileDesc++;
+
+			// A warm in-memory cache must not cost any filesystem access, so
+			// only stat the file after missing it
+			Common::String hashname = md5CacheName(md5prop, fname, _md5Bytes);
+			if (ADCacheMan.containsMD5(hashname))
+				continue;
+
+			// Many descriptions share files, only look at each of them once
+			if (queued.contains(hashname))
+				continue;
+			queued.setVal(hashname, true);
+
+			int64 size, modificationTime;
+			Common::String persistentKey;
+			if (!persistentMD5Key(_md5Bytes, allFiles, md5prop, fname, size, modificationTime, persistentKey))
+				continue;
+
+			Common::String md5;
+			if (ADCacheMan.getPersistentMD5(persistentKey, size, modificationTime, md5)) {
+				ADCacheMan.setMD5(hashname, md5);
+				ADCacheMan.setSize(hashname, size);
+				continue;
+			}
+
+			MD5Job job;
+			job.stream = allFiles[fname].createReadStream();
+			if (!job.stream)
+				continue;
+			job.md5Bytes = _md5Bytes;
+			job.tail = (md5prop & kMD5Tail) != 0;
+			job.hashname = hashname;
+			job.persistentKey = persistentKey;
+			job.size = size;
+			job.modificationTime = modificationTime;
+			jobs.push_back(job);
+		}
+
+		if (jobs.empty())
+			break;
+
+		Common::JobGroup group;
+		for (uint i = 0; i < jobs.size(); i++)
+			JobSys.addJob(group, MD5Job::run, &jobs[i]);
+		JobSys.wait(group);
+
+		for (uint i = 0; i < jobs.size(); i++) {
+			ADCacheMan.setMD5(jobs[i].hashname, jobs[i].md5);
+			ADCacheMan.setSize(jobs[i].hashname, jobs[i].stream->size());
+			ADCacheMan.setPersistentMD5(jobs[i].persistentKey, jobs[i].size, jobs[i].modificationTime, jobs[i].md5);
+			delete jobs[i].stream;
+		}
+		jobs.clear();
+	}
+}
+
 bool AdvancedMetaEngineBase::getFilePropertiesExtern(uint md5Bytes, const FileMap &allFiles, MD5Properties md5prop, const Common::Path &fname, FileProperties &fileProps) const {
 	return getFilePropertiesIntern(md5Bytes, allFiles, md5prop, fname, fileProps);
 }
@@ -732,6 +1003,10 @@ ADDetectedGames AdvancedMetaEngineDetectionBase::detectGame(const Common::FSNode
 
 	preprocessDescriptions();
 
+	// Hash the plain files up front, in parallel. The loop below then
+	// mostly hits the cache.
+	precomputeFileProperties(allFiles);
+
 	// Check which files are included in some ADGameDescription *and* whether
 	// they are present. Compute MD5s and file sizes for the available files.
 	for (descPtr = _gameDescriptors; ((const ADGameDescription *)descPtr)->gameId != nullptr; descPtr += _descItemSize) {
@@ -591,6 +591,12 @@ protected:
 	/** Get the properties (size and MD5) of this file. */
 	bool getFileProperties(const FileMap &allFiles, MD5Properties md5prop, const Common::Path &fname, FileProperties &fileProps) const;
 
+	/**
+	 * Compute the MD5s of all plain files used by the game descriptions
+	 * which are not cached yet, spreading the work over the job system.
+	 */
+	void precomputeFileProperties(const FileMap &allFiles) const;
+
 	/** Convert an AD game description into the shared game description format. */
 	virtual DetectedGame toDetectedGame(const ADDetectedGame &adGame, ADDetectedGameExtraInfo *extraInfo = nullptr) const;
 
@@ -771,10 +777,28 @@ public:
 		return archiveHashMap.getValOrDefault(node.getPath(), nullptr);
 	}
 
-	AdvancedDetectorCacheManager() {
+	/**
+	 * Look up an MD5 in the on-disk cache which persists across detection
+	 * runs and restarts. The key identifies the file by its full path, and
+	 * the entry is only used if the size and modification time still match.
+	 */
+	bool getPersistentMD5(const Common::String &key, int64 size, int64 modificationTime, Common::String &md5);
+
+	/** Add an MD5 to the on-disk cache, replacing any entry for the same file. */
+	void setPersistentMD5(const Common::String &key, int64 size, int64 modificationTime, const Common::String &md5);
+
+	/** Write the on-disk cache back if it was modified. */
+	void flushPersistentMD5s();
+
+	AdvancedDetectorCacheManager() : _persistentGeneration(0), _persistentLoaded(false), _persistentDirty(false) {
 		clear();
 	}
 
+	~AdvancedDetectorCacheManager() {
+		flushPersistentMD5s();
+		clearArchives();
+	}
+
 	void clearArchives() {
 		for (auto &entry : archiveHashMap) {
 			delete entry._value;
@@ -797,6 +821,29 @@ private:
 	FileHashMap md5HashMap;
 	SizeHashMap sizeHashMap;
 	ArchiveHashMap archiveHashMap;
+
+	void loadPersistentMD5s();
+
+	struct PersistentMD5 {
+		Common::String md5;
+		int64 size;
+		int64 modificationTime;
+		uint32 lastUsed; // generation in which the entry was last looked up or added
+	};
+
+	typedef Common::HashMap<Common::String, PersistentMD5> PersistentMD5Map;
+
+	/**
+	 * Maximum number of entries in the on-disk cache. Entries for files
+	 * which were removed are never looked up again, so the least recently
+	 * used ones are dropped when the cache is written.
+	 */
+	static const uint kMaxPersistentMD5s = 20000;
+
+	PersistentMD5Map _persistentMD5s;
+	uint32 _persistentGeneration; // incremented each time the cache is loaded
+	bool _persistentLoaded;
+	bool _persistentDirty;
 };
 
 /** Convenience shortcut for accessing the MD5CacheManager. */
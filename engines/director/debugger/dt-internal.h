@@ -31,6 +31,7 @@
 #include "backends/imgui/imgui.h"
 #include "backends/imgui/imgui_fonts.h"
 #include "backends/imgui/components/imgui_logger.h"
+#include "backends/imgui/components/imgui_profiler.h"
 
 #include "director/debugger/imgui_memory_editor.h"
 
@@ -93,6 +94,7 @@ typedef struct ImGuiWindows {
 	bool bpList = false;
 	bool settings = false;
 	bool logger = false;
+	bool profiler = false;
 	bool archive = false;
 	bool watchedVars = false;
 } ImGuiWindows;
@@ -178,6 +180,7 @@ typedef struct ImGuiState {
 	} _archive;
 
 	ImGuiEx::ImGuiLogger *_logger = nullptr;
+	ImGuiEx::ImGuiProfiler *_profiler = nullptr;
 } ImGuiState;
 
 // debugtools.cpp
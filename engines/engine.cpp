@@ -205,9 +205,16 @@ Engine::Engine(OSystem *syst)
 	}
 
 	_activeEnhancements = (int32)ConfMan.getInt("enhancements");
+
+	_saveFileMan->setSaveCallback(saveCallback, this);
 }
 
 Engine::~Engine() {
+	// The derived engine is gone already, and so is the screen to report
+	// errors on. Let the save file manager just log them.
+	_saveFileMan->setSaveCallback(nullptr, nullptr);
+	_saveFileMan->processPendingSaves(true);
+
 	_mixer->stopAll();
 
 	// Flush any pending remaining events
@@ -611,6 +618,8 @@ void Engine::warnMissingExtractedCDAudio() {
 }
 
 void Engine::handleAutoSave() {
+	_saveFileMan->processPendingSaves();
+
 #ifdef ENABLE_EVENTRECORDER
 	if (!g_eventRec.processAutosave())
 		return;
@@ -623,6 +632,22 @@ void Engine::handleAutoSave() {
 	}
 }
 
+void Engine::saveCallback(void *param, const Common::String &name, const Common::Error &error) {
+	Engine *engine = (Engine *)param;
+	if (error.getCode() == Common::kNoError)
+		return;
+
+	if (!engine->_autosaveFilename.empty() && name.equalsIgnoreCase(engine->_autosaveFilename)) {
+		g_system->displayMessageOnOSD(_("Error occurred making autosave"));
+
+		// Try again in 5 minutes, as if the autosave had failed right away
+		engine->_lastAutosaveTime = g_system->getMillis() + ((5 * 60 - engine->_autosaveInterval) * 1000);
+	} else {
+		g_system->displayMessageOnOSD(_("Failed to save game"));
+	}
+	warning("Failed to write savefile '%s': %s", name.c_str(), error.getDesc().c_str());
+}
+
 bool Engine::warnBeforeOverwritingAutosave() {
 	SaveStateDescriptor desc = getMetaEngine()->querySaveMetaInfos(
 		_targetName.c_str(), getAutosaveSlot());
@@ -675,6 +700,9 @@ void Engine::saveAutosaveIfEnabled() {
 	if (saveFlag)
 		saveFlag = warnBeforeOverwritingAutosave();
 
+	if (saveFlag)
+		_autosaveFilename = getSaveStateName(autoSaveSlot);
+
 	if (saveFlag && saveGameState(autoSaveSlot, autoSaveName, true).getCode() != Common::kNoError) {
 		// Couldn't autosave at the designated time
 		g_system->displayMessageOnOSD(_("Error occurred making autosave"));
@@ -925,7 +953,11 @@ Common::Error Engine::saveGameState(int slot, const Common::String &desc, bool i
 	if (result.getCode() == Common::kNoError) {
 		getMetaEngine()->appendExtendedSave(saveFile, getTotalPlayTime(), desc, isAutosave);
 
+		// Only covers the errors so far, the save file may still be written
+		// in the background. saveCallback() reports the errors from there.
 		saveFile->finalize();
+		if (saveFile->err())
+			result = Common::kWritingFailed;
 	}
 
 	delete saveFile;
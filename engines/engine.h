@@ -219,6 +219,12 @@ private:
 	 */
 	int _lastAutosaveTime;
 
+	/**
+	 * Name of the save file of the last autosave, to recognize it when it
+	 * could not be written in the background.
+	 */
+	Common::String _autosaveFilename;
+
 	/**
 	 * Save slot selected via the global main menu.
 	 *
@@ -671,6 +677,12 @@ protected:
 	 * Syncs the engine's mixer using the default volume syncing behavior.
 	 */
 	void defaultSyncSoundSettings();
+
+private:
+	/**
+	 * Report save files which could not be written in the background.
+	 */
+	static void saveCallback(void *param, const Common::String &name, const Common::Error &error);
 };
 
 
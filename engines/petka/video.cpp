@@ -51,13 +51,11 @@ void VideoSystem::update() {
 
 	interface->update(time - _time);
 
-	mergeDirtyRects();
-
 	_allowAddingRects = false;
 	interface->draw();
 	_allowAddingRects = true;
 
-	for (Common::Rect &r : _dirtyRects) {
+	for (const Common::Rect &r : _dirtyRects) {
 		const byte *srcP = (const byte *)getBasePtr(r.left, r.top);
 		g_system->copyRectToScreen(srcP, pitch, r.left, r.top, r.width(), r.height());
 	}
@@ -103,7 +101,7 @@ void VideoSystem::addDirtyMskRects(FlicDecoder &flc) {
 	addDirtyMskRects(Common::Point(0, 0), flc);
 }
 
-const Common::List<Common::Rect> &VideoSystem::rects() const {
+const Graphics::DirtyRegion &VideoSystem::rects() const {
 	return _dirtyRects;
 }
 
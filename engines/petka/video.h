@@ -46,7 +46,7 @@ public:
 
 	void setShake(bool shake);
 
-	const Common::List<Common::Rect> &rects() const;
+	const Graphics::DirtyRegion &rects() const;
 
 private:
 	PetkaEngine &_vm;
@@ -0,0 +1,267 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#include "graphics/blit/blit-fast.h"
+
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+namespace Graphics {
+
+class FastBlitImpl_AVX2 {
+	friend class FastBlit;
+
+struct Converter {
+	__m128i srcShift[4], expandLeft[4], expandRight[4];
+	__m128i dstLoss[4], dstShift[4];
+	__m256i srcMask[4];
+	__m256i alphaFill;
+	uint numComps;
+
+	Converter(const FastBlit::ConvertArgs &args) : numComps(args.numComps) {
+		for (uint i = 0; i < numComps; i++) {
+			srcShift[i] = _mm_cvtsi32_si128(args.comp[i].srcShift);
+			srcMask[i] = _mm256_set1_epi32(args.comp[i].srcMask);
+			expandLeft[i] = _mm_cvtsi32_si128(args.comp[i].expandLeft);
+			expandRight[i] = _mm_cvtsi32_si128(args.comp[i].expandRight);
+			dstLoss[i] = _mm_cvtsi32_si128(args.comp[i].dstLoss);
+			dstShift[i] = _mm_cvtsi32_si128(args.comp[i].dstShift);
+		}
+		alphaFill = _mm256_set1_epi32(args.alphaFill);
+	}
+
+	inline __m256i convert(__m256i px) const {
+		__m256i out = alphaFill;
+		for (uint i = 0; i < numComps; i++) {
+			__m256i v = _mm256_and_si256(_mm256_srl_epi32(px, srcShift[i]), srcMask[i]);
+			v = _mm256_or_si256(_mm256_sll_epi32(v, expandLeft[i]), _mm256_srl_epi32(v, expandRight[i]));
+			out = _mm256_or_si256(out, _mm256_sll_epi32(_mm256_srl_epi32(v, dstLoss[i]), dstShift[i]));
+		}
+		return out;
+	}
+};
+
+// Load 8 pixels, widened to 32 bits per pixel
+template<int Bpp>
+static inline __m256i load8(const byte *ptr) {
+	if (Bpp == 2)
+		return _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)ptr));
+	else
+		return _mm256_loadu_si256((const __m256i *)ptr);
+}
+
+// Store 8 pixels, truncating them to the pixel size
+template<int Bpp>
+static inline void store8(byte *ptr, __m256i px) {
+	if (Bpp == 2) {
+		px = _mm256_and_si256(px, _mm256_set1_epi32(0xFFFF));
+		px = _mm256_permute4x64_epi64(_mm256_packus_epi32(px, px), _MM_SHUFFLE(3, 1, 2, 0));
+		_mm_storeu_si128((__m128i *)ptr, _mm256_castsi256_si128(px));
+	} else {
+		_mm256_storeu_si256((__m256i *)ptr, px);
+	}
+}
+
+template<int SrcBpp, int DstBpp, bool hasKey>
+static void convert(const FastBlit::ConvertArgs &args) {
+	const Converter conv(args);
+	const __m256i key = _mm256_set1_epi32(args.key);
+	const byte *src = args.src;
+	byte *dst = args.dst;
+
+	for (uint y = 0; y < args.h; y++) {
+		const byte *in = src;
+		byte *out = dst;
+		uint x = 0;
+
+		for (; x + 8 <= args.w; x += 8) {
+			const __m256i px = load8<SrcBpp>(in);
+			__m256i res = conv.convert(px);
+			if (hasKey)
+				res = _mm256_blendv_epi8(res, load8<DstBpp>(out), _mm256_cmpeq_epi32(px, key));
+			store8<DstBpp>(out, res);
+			in += SrcBpp * 8;
+			out += DstBpp * 8;
+		}
+
+		for (; x < args.w; x++) {
+			const uint32 color = (SrcBpp == 2) ? *(const uint16 *)in : *(const uint32 *)in;
+			if (!hasKey || color != args.key) {
+				if (DstBpp == 2)
+					*(uint16 *)out = args.convert(color);
+				else
+					*(uint32 *)out = args.convert(color);
+			}
+			in += SrcBpp;
+			out += DstBpp;
+		}
+
+		src += args.srcPitch;
+		dst += args.dstPitch;
+	}
+}
+
+template<int SrcBpp, int DstBpp>
+static void convertKey(const FastBlit::ConvertArgs &args) {
+	if (args.hasKey)
+		convert<SrcBpp, DstBpp, true>(args);
+	else
+		convert<SrcBpp, DstBpp, false>(args);
+}
+
+template<int DstBpp, bool hasKey>
+static void map(const FastBlit::MapArgs &args) {
+	const __m256i key = _mm256_set1_epi32(args.key);
+	const byte *src = args.src;
+	byte *dst = args.dst;
+
+	for (uint y = 0; y < args.h; y++) {
+		const byte *in = src;
+		byte *out = dst;
+		uint x = 0;
+
+		for (; x + 8 <= args.w; x += 8) {
+			const __m256i idx = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)in));
+			__m256i res = _mm256_i32gather_epi32((const int *)args.map, idx, 4);
+			if (hasKey)
+				res = _mm256_blendv_epi8(res, load8<DstBpp>(out), _mm256_cmpeq_epi32(idx, key));
+			store8<DstBpp>(out, res);
+			in += 8;
+			out += DstBpp * 8;
+		}
+
+		for (; x < args.w; x++) {
+			if (!hasKey || *in != args.key) {
+				if (DstBpp == 2)
+					*(uint16 *)out = args.map[*in];
+				else
+					*(uint32 *)out = args.map[*in];
+			}
+			in++;
+			out += DstBpp;
+		}
+
+		src += args.srcPitch;
+		dst += args.dstPitch;
+	}
+}
+
+template<int DstBpp>
+static void mapKey(const FastBlit::MapArgs &args) {
+	if (args.hasKey)
+		map<DstBpp, true>(args);
+	else
+		map<DstBpp, false>(args);
+}
+
+template<typename Color>
+static void keyBlit(const FastBlit::KeyArgs &args) {
+	const uint pixelsPerVector = 32 / sizeof(Color);
+	__m256i key;
+	if (sizeof(Color) == 1)
+		key = _mm256_set1_epi8((char)args.key);
+	else if (sizeof(Color) == 2)
+		key = _mm256_set1_epi16((short)args.key);
+	else
+		key = _mm256_set1_epi32(args.key);
+
+	const byte *src = args.src;
+	byte *dst = args.dst;
+
+	for (uint y = 0; y < args.h; y++) {
+		const Color *in = (const Color *)src;
+		Color *out = (Color *)dst;
+		uint x = 0;
+
+		for (; x + pixelsPerVector <= args.w; x += pixelsPerVector) {
+			const __m256i s = _mm256_loadu_si256((const __m256i *)in);
+			const __m256i d = _mm256_loadu_si256((const __m256i *)out);
+			__m256i mask;
+			if (sizeof(Color) == 1)
+				mask = _mm256_cmpeq_epi8(s, key);
+			else if (sizeof(Color) == 2)
+				mask = _mm256_cmpeq_epi16(s, key);
+			else
+				mask = _mm256_cmpeq_epi32(s, key);
+			_mm256_storeu_si256((__m256i *)out, _mm256_blendv_epi8(s, d, mask));
+			in += pixelsPerVector;
+			out += pixelsPerVector;
+		}
+
+		for (; x < args.w; x++) {
+			if (*in != args.key)
+				*out = *in;
+			in++;
+			out++;
+		}
+
+		src += args.srcPitch;
+		dst += args.dstPitch;
+	}
+}
+
+}; // end of class FastBlitImpl_AVX2
+
+void FastBlit::convertAVX2(const ConvertArgs &args) {
+	if (args.srcBpp == 2) {
+		if (args.dstBpp == 2)
+			FastBlitImpl_AVX2::convertKey<2, 2>(args);
+		else
+			FastBlitImpl_AVX2::convertKey<2, 4>(args);
+	} else {
+		if (args.dstBpp == 2)
+			FastBlitImpl_AVX2::convertKey<4, 2>(args);
+		else
+			FastBlitImpl_AVX2::convertKey<4, 4>(args);
+	}
+}
+
+void FastBlit::mapAVX2(const MapArgs &args) {
+	if (args.dstBpp == 2)
+		FastBlitImpl_AVX2::mapKey<2>(args);
+	else
+		FastBlitImpl_AVX2::mapKey<4>(args);
+}
+
+void FastBlit::keyAVX2(const KeyArgs &args) {
+	if (args.bpp == 1)
+		FastBlitImpl_AVX2::keyBlit<uint8>(args);
+	else if (args.bpp == 2)
+		FastBlitImpl_AVX2::keyBlit<uint16>(args);
+	else
+		FastBlitImpl_AVX2::keyBlit<uint32>(args);
+}
+
+} // End of namespace Graphics
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
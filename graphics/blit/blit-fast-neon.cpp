@@ -0,0 +1,237 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#ifdef SCUMMVM_NEON
+
+#include "graphics/blit/blit-fast.h"
+
+#include <arm_neon.h>
+
+#if !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("neon"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("fpu=neon")
+#endif
+
+#endif // !defined(__aarch64__) && !defined(__ARM_NEON)
+
+namespace Graphics {
+
+class FastBlitImpl_NEON {
+	friend class FastBlit;
+
+struct Converter {
+	// Negative shift counts shift to the right
+	int32x4_t srcShift[4], expandLeft[4], expandRight[4];
+	int32x4_t dstLoss[4], dstShift[4];
+	uint32x4_t srcMask[4];
+	uint32x4_t alphaFill;
+	uint numComps;
+
+	Converter(const FastBlit::ConvertArgs &args) : numComps(args.numComps) {
+		for (uint i = 0; i < numComps; i++) {
+			srcShift[i] = vdupq_n_s32(-(int32)args.comp[i].srcShift);
+			srcMask[i] = vdupq_n_u32(args.comp[i].srcMask);
+			expandLeft[i] = vdupq_n_s32(args.comp[i].expandLeft);
+			expandRight[i] = vdupq_n_s32(-(int32)args.comp[i].expandRight);
+			dstLoss[i] = vdupq_n_s32(-(int32)args.comp[i].dstLoss);
+			dstShift[i] = vdupq_n_s32(args.comp[i].dstShift);
+		}
+		alphaFill = vdupq_n_u32(args.alphaFill);
+	}
+
+	inline uint32x4_t convert(uint32x4_t px) const {
+		uint32x4_t out = alphaFill;
+		for (uint i = 0; i < numComps; i++) {
+			uint32x4_t v = vandq_u32(vshlq_u32(px, srcShift[i]), srcMask[i]);
+			v = vorrq_u32(vshlq_u32(v, expandLeft[i]), vshlq_u32(v, expandRight[i]));
+			out = vorrq_u32(out, vshlq_u32(vshlq_u32(v, dstLoss[i]), dstShift[i]));
+		}
+		return out;
+	}
+};
+
+// Load 8 pixels, widened to 32 bits per pixel
+template<int Bpp>
+static inline void load8(const byte *ptr, uint32x4_t &lo, uint32x4_t &hi) {
+	if (Bpp == 2) {
+		const uint16x8_t px = vld1q_u16((const uint16 *)ptr);
+		lo = vmovl_u16(vget_low_u16(px));
+		hi = vmovl_u16(vget_high_u16(px));
+	} else {
+		lo = vld1q_u32((const uint32 *)ptr);
+		hi = vld1q_u32((const uint32 *)(ptr + 16));
+	}
+}
+
+// Store 8 pixels, truncating them to the pixel size
+template<int Bpp>
+static inline void store8(byte *ptr, uint32x4_t lo, uint32x4_t hi) {
+	if (Bpp == 2) {
+		vst1q_u16((uint16 *)ptr, vcombine_u16(vmovn_u32(lo), vmovn_u32(hi)));
+	} else {
+		vst1q_u32((uint32 *)ptr, lo);
+		vst1q_u32((uint32 *)(ptr + 16), hi);
+	}
+}
+
+template<int SrcBpp, int DstBpp, bool hasKey>
+static void convert(const FastBlit::ConvertArgs &args) {
+	const Converter conv(args);
+	const uint32x4_t key = vdupq_n_u32(args.key);
+	const byte *src = args.src;
+	byte *dst = args.dst;
+
+	for (uint y = 0; y < args.h; y++) {
+		const byte *in = src;
+		byte *out = dst;
+		uint x = 0;
+
+		for (; x + 8 <= args.w; x += 8) {
+			uint32x4_t lo, hi;
+			load8<SrcBpp>(in, lo, hi);
+			uint32x4_t resLo = conv.convert(lo);
+			uint32x4_t resHi = conv.convert(hi);
+			if (hasKey) {
+				uint32x4_t oldLo, oldHi;
+				load8<DstBpp>(out, oldLo, oldHi);
+				resLo = vbslq_u32(vceqq_u32(lo, key), oldLo, resLo);
+				resHi = vbslq_u32(vceqq_u32(hi, key), oldHi, resHi);
+			}
+			store8<DstBpp>(out, resLo, resHi);
+			in += SrcBpp * 8;
+			out += DstBpp * 8;
+		}
+
+		for (; x < args.w; x++) {
+			const uint32 color = (SrcBpp == 2) ? *(const uint16 *)in : *(const uint32 *)in;
+			if (!hasKey || color != args.key) {
+				if (DstBpp == 2)
+					*(uint16 *)out = args.convert(color);
+				else
+					*(uint32 *)out = args.convert(color);
+			}
+			in += SrcBpp;
+			out += DstBpp;
+		}
+
+		src += args.srcPitch;
+		dst += args.dstPitch;
+	}
+}
+
+template<int SrcBpp, int DstBpp>
+static void convertKey(const FastBlit::ConvertArgs &args) {
+	if (args.hasKey)
+		convert<SrcBpp, DstBpp, true>(args);
+	else
+		convert<SrcBpp, DstBpp, false>(args);
+}
+
+template<typename Color>
+static void keyBlit(const FastBlit::KeyArgs &args) {
+	const uint pixelsPerVector = 16 / sizeof(Color);
+	uint8x16_t key;
+	if (sizeof(Color) == 1)
+		key = vdupq_n_u8(args.key);
+	else if (sizeof(Color) == 2)
+		key = vreinterpretq_u8_u16(vdupq_n_u16(args.key));
+	else
+		key = vreinterpretq_u8_u32(vdupq_n_u32(args.key));
+
+	const byte *src = args.src;
+	byte *dst = args.dst;
+
+	for (uint y = 0; y < args.h; y++) {
+		const Color *in = (const Color *)src;
+		Color *out = (Color *)dst;
+		uint x = 0;
+
+		for (; x + pixelsPerVector <= args.w; x += pixelsPerVector) {
+			const uint8x16_t s = vld1q_u8((const uint8 *)in);
+			const uint8x16_t d = vld1q_u8((const uint8 *)out);
+			uint8x16_t mask;
+			if (sizeof(Color) == 1)
+				mask = vceqq_u8(s, key);
+			else if (sizeof(Color) == 2)
+				mask = vreinterpretq_u8_u16(vceqq_u16(vreinterpretq_u16_u8(s), vreinterpretq_u16_u8(key)));
+			else
+				mask = vreinterpretq_u8_u32(vceqq_u32(vreinterpretq_u32_u8(s), vreinterpretq_u32_u8(key)));
+			vst1q_u8((uint8 *)out, vbslq_u8(mask, d, s));
+			in += pixelsPerVector;
+			out += pixelsPerVector;
+		}
+
+		for (; x < args.w; x++) {
+			if (*in != args.key)
+				*out = *in;
+			in++;
+			out++;
+		}
+
+		src += args.srcPitch;
+		dst += args.dstPitch;
+	}
+}
+
+}; // end of class FastBlitImpl_NEON
+
+void FastBlit::convertNEON(const ConvertArgs &args) {
+	if (args.srcBpp == 2) {
+		if (args.dstBpp == 2)
+			FastBlitImpl_NEON::convertKey<2, 2>(args);
+		else
+			FastBlitImpl_NEON::convertKey<2, 4>(args);
+	} else {
+		if (args.dstBpp == 2)
+			FastBlitImpl_NEON::convertKey<4, 2>(args);
+		else
+			FastBlitImpl_NEON::convertKey<4, 4>(args);
+	}
+}
+
+void FastBlit::keyNEON(const KeyArgs &args) {
+	if (args.bpp == 1)
+		FastBlitImpl_NEON::keyBlit<uint8>(args);
+	else if (args.bpp == 2)
+		FastBlitImpl_NEON::keyBlit<uint16>(args);
+	else
+		FastBlitImpl_NEON::keyBlit<uint32>(args);
+}
+
+} // End of namespace Graphics
+
+#if !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#endif // SCUMMVM_NEON
@@ -0,0 +1,239 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#include "graphics/blit/blit-fast.h"
+
+#include <emmintrin.h>
+
+#if !defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("sse2"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#endif
+
+#endif // !defined(__x86_64__)
+
+namespace Graphics {
+
+class FastBlitImpl_SSE2 {
+	friend class FastBlit;
+
+struct Converter {
+	__m128i srcShift[4], srcMask[4];
+	__m128i expandLeft[4], expandRight[4];
+	__m128i dstLoss[4], dstShift[4];
+	__m128i alphaFill;
+	uint numComps;
+
+	Converter(const FastBlit::ConvertArgs &args) : numComps(args.numComps) {
+		for (uint i = 0; i < numComps; i++) {
+			srcShift[i] = _mm_cvtsi32_si128(args.comp[i].srcShift);
+			srcMask[i] = _mm_set1_epi32(args.comp[i].srcMask);
+			expandLeft[i] = _mm_cvtsi32_si128(args.comp[i].expandLeft);
+			expandRight[i] = _mm_cvtsi32_si128(args.comp[i].expandRight);
+			dstLoss[i] = _mm_cvtsi32_si128(args.comp[i].dstLoss);
+			dstShift[i] = _mm_cvtsi32_si128(args.comp[i].dstShift);
+		}
+		alphaFill = _mm_set1_epi32(args.alphaFill);
+	}
+
+	inline __m128i convert(__m128i px) const {
+		__m128i out = alphaFill;
+		for (uint i = 0; i < numComps; i++) {
+			__m128i v = _mm_and_si128(_mm_srl_epi32(px, srcShift[i]), srcMask[i]);
+			v = _mm_or_si128(_mm_sll_epi32(v, expandLeft[i]), _mm_srl_epi32(v, expandRight[i]));
+			out = _mm_or_si128(out, _mm_sll_epi32(_mm_srl_epi32(v, dstLoss[i]), dstShift[i]));
+		}
+		return out;
+	}
+};
+
+// Load 8 pixels, widened to 32 bits per pixel
+template<int Bpp>
+static inline void load8(const byte *ptr, __m128i &lo, __m128i &hi) {
+	if (Bpp == 2) {
+		const __m128i px = _mm_loadu_si128((const __m128i *)ptr);
+		lo = _mm_unpacklo_epi16(px, _mm_setzero_si128());
+		hi = _mm_unpackhi_epi16(px, _mm_setzero_si128());
+	} else {
+		lo = _mm_loadu_si128((const __m128i *)ptr);
+		hi = _mm_loadu_si128((const __m128i *)(ptr + 16));
+	}
+}
+
+// Store 8 pixels, truncating them to the pixel size
+template<int Bpp>
+static inline void store8(byte *ptr, __m128i lo, __m128i hi) {
+	if (Bpp == 2) {
+		// Sign extend the low 16 bits so that the saturating pack keeps them intact
+		lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+		hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+		_mm_storeu_si128((__m128i *)ptr, _mm_packs_epi32(lo, hi));
+	} else {
+		_mm_storeu_si128((__m128i *)ptr, lo);
+		_mm_storeu_si128((__m128i *)(ptr + 16), hi);
+	}
+}
+
+static inline __m128i select(__m128i mask, __m128i a, __m128i b) {
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+template<int SrcBpp, int DstBpp, bool hasKey>
+static void convert(const FastBlit::ConvertArgs &args) {
+	const Converter conv(args);
+	const __m128i key = _mm_set1_epi32(args.key);
+	const byte *src = args.src;
+	byte *dst = args.dst;
+
+	for (uint y = 0; y < args.h; y++) {
+		const byte *in = src;
+		byte *out = dst;
+		uint x = 0;
+
+		for (; x + 8 <= args.w; x += 8) {
+			__m128i lo, hi;
+			load8<SrcBpp>(in, lo, hi);
+			__m128i resLo = conv.convert(lo);
+			__m128i resHi = conv.convert(hi);
+			if (hasKey) {
+				__m128i oldLo, oldHi;
+				load8<DstBpp>(out, oldLo, oldHi);
+				resLo = select(_mm_cmpeq_epi32(lo, key), oldLo, resLo);
+				resHi = select(_mm_cmpeq_epi32(hi, key), oldHi, resHi);
+			}
+			store8<DstBpp>(out, resLo, resHi);
+			in += SrcBpp * 8;
+			out += DstBpp * 8;
+		}
+
+		for (; x < args.w; x++) {
+			const uint32 color = (SrcBpp == 2) ? *(const uint16 *)in : *(const uint32 *)in;
+			if (!hasKey || color != args.key) {
+				if (DstBpp == 2)
+					*(uint16 *)out = args.convert(color);
+				else
+					*(uint32 *)out = args.convert(color);
+			}
+			in += SrcBpp;
+			out += DstBpp;
+		}
+
+		src += args.srcPitch;
+		dst += args.dstPitch;
+	}
+}
+
+template<int SrcBpp, int DstBpp>
+static void convertKey(const FastBlit::ConvertArgs &args) {
+	if (args.hasKey)
+		convert<SrcBpp, DstBpp, true>(args);
+	else
+		convert<SrcBpp, DstBpp, false>(args);
+}
+
+template<typename Color>
+static void keyBlit(const FastBlit::KeyArgs &args) {
+	const uint pixelsPerVector = 16 / sizeof(Color);
+	__m128i key;
+	if (sizeof(Color) == 1)
+		key = _mm_set1_epi8((char)args.key);
+	else if (sizeof(Color) == 2)
+		key = _mm_set1_epi16((short)args.key);
+	else
+		key = _mm_set1_epi32(args.key);
+
+	const byte *src = args.src;
+	byte *dst = args.dst;
+
+	for (uint y = 0; y < args.h; y++) {
+		const Color *in = (const Color *)src;
+		Color *out = (Color *)dst;
+		uint x = 0;
+
+		for (; x + pixelsPerVector <= args.w; x += pixelsPerVector) {
+			const __m128i s = _mm_loadu_si128((const __m128i *)in);
+			const __m128i d = _mm_loadu_si128((const __m128i *)out);
+			__m128i mask;
+			if (sizeof(Color) == 1)
+				mask = _mm_cmpeq_epi8(s, key);
+			else if (sizeof(Color) == 2)
+				mask = _mm_cmpeq_epi16(s, key);
+			else
+				mask = _mm_cmpeq_epi32(s, key);
+			_mm_storeu_si128((__m128i *)out, select(mask, d, s));
+			in += pixelsPerVector;
+			out += pixelsPerVector;
+		}
+
+		for (; x < args.w; x++) {
+			if (*in != args.key)
+				*out = *in;
+			in++;
+			out++;
+		}
+
+		src += args.srcPitch;
+		dst += args.dstPitch;
+	}
+}
+
+}; // end of class FastBlitImpl_SSE2
+
+void FastBlit::convertSSE2(const ConvertArgs &args) {
+	if (args.srcBpp == 2) {
+		if (args.dstBpp == 2)
+			FastBlitImpl_SSE2::convertKey<2, 2>(args);
+		else
+			FastBlitImpl_SSE2::convertKey<2, 4>(args);
+	} else {
+		if (args.dstBpp == 2)
+			FastBlitImpl_SSE2::convertKey<4, 2>(args);
+		else
+			FastBlitImpl_SSE2::convertKey<4, 4>(args);
+	}
+}
+
+void FastBlit::keySSE2(const KeyArgs &args) {
+	if (args.bpp == 1)
+		FastBlitImpl_SSE2::keyBlit<uint8>(args);
+	else if (args.bpp == 2)
+		FastBlitImpl_SSE2::keyBlit<uint16>(args);
+	else
+		FastBlitImpl_SSE2::keyBlit<uint32>(args);
+}
+
+} // End of namespace Graphics
+
+#if !defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // !defined(__x86_64__)
@@ -0,0 +1,201 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "graphics/blit/blit-fast.h"
+#include "common/system.h"
+
+namespace Graphics {
+
+namespace {
+
+inline bool rangesOverlap(const byte *a, const uint aPitch, const uint aRow,
+						  const byte *b, const uint bPitch, const uint bRow, const uint h) {
+	const byte *aEnd = a + (h - 1) * aPitch + aRow;
+	const byte *bEnd = b + (h - 1) * bPitch + bRow;
+	return a < bEnd && b < aEnd;
+}
+
+// Components of this size expand to 8 bits with a single pair of shifts,
+// exactly matching what ColorComponent<>::expand() does.
+inline bool isSimpleComponent(const uint bits) {
+	return bits == 0 || (bits >= 4 && bits <= 8);
+}
+
+} // End of anonymous namespace
+
+FastBlit::ConvertFunc FastBlit::convertFunc = nullptr;
+FastBlit::MapFunc FastBlit::mapFunc = nullptr;
+FastBlit::KeyFunc FastBlit::keyFunc = nullptr;
+
+void FastBlit::selectFuncs() {
+	// Without a backend there is no way to query the CPU, so keep using
+	// the generic code
+	if (!g_system)
+		return;
+
+#ifdef SCUMMVM_NEON
+	if (g_system->hasFeature(OSystem::kFeatureCpuNEON)) {
+		convertFunc = convertNEON;
+		keyFunc = keyNEON;
+	}
+#endif
+#ifdef SCUMMVM_SSE2
+	if (g_system->hasFeature(OSystem::kFeatureCpuSSE2)) {
+		convertFunc = convertSSE2;
+		keyFunc = keySSE2;
+	}
+#endif
+#ifdef SCUMMVM_AVX2
+	if (g_system->hasFeature(OSystem::kFeatureCpuAVX2)) {
+		convertFunc = convertAVX2;
+		mapFunc = mapAVX2;
+		keyFunc = keyAVX2;
+	}
+#endif
+}
+
+bool FastBlit::crossBlit(byte *dst, const byte *src,
+						 const uint dstPitch, const uint srcPitch,
+						 const uint w, const uint h,
+						 const PixelFormat &dstFmt, const PixelFormat &srcFmt,
+						 const bool hasKey, const uint32 key) {
+	if (!convertFunc || !w || !h)
+		return false;
+
+	const uint srcBpp = srcFmt.bytesPerPixel;
+	const uint dstBpp = dstFmt.bytesPerPixel;
+	if ((srcBpp != 2 && srcBpp != 4) || (dstBpp != 2 && dstBpp != 4))
+		return false;
+	if (hasKey && srcBpp == 2 && key > 0xFFFF)
+		return false;
+
+	// The kernels work front to back, which is only safe for in-place
+	// conversions that do not change the pixel size.
+	if (dst == src) {
+		if (srcBpp != dstBpp || srcPitch != dstPitch)
+			return false;
+	} else if (rangesOverlap(dst, dstPitch, w * dstBpp, src, srcPitch, w * srcBpp, h)) {
+		return false;
+	}
+
+	const uint srcBits[4] = { srcFmt.aBits(), srcFmt.rBits(), srcFmt.gBits(), srcFmt.bBits() };
+	const uint srcShift[4] = { srcFmt.aShift, srcFmt.rShift, srcFmt.gShift, srcFmt.bShift };
+	const uint dstLoss[4] = { dstFmt.aLoss, dstFmt.rLoss, dstFmt.gLoss, dstFmt.bLoss };
+	const uint dstShift[4] = { dstFmt.aShift, dstFmt.rShift, dstFmt.gShift, dstFmt.bShift };
+
+	ConvertArgs args;
+	args.dst = dst;
+	args.src = src;
+	args.dstPitch = dstPitch;
+	args.srcPitch = srcPitch;
+	args.w = w;
+	args.h = h;
+	args.srcBpp = srcBpp;
+	args.dstBpp = dstBpp;
+	args.numComps = 0;
+	args.alphaFill = 0;
+	args.hasKey = hasKey;
+	args.key = key;
+
+	for (uint i = 0; i < 4; i++) {
+		if (!isSimpleComponent(srcBits[i]))
+			return false;
+		if (dstLoss[i] >= 8)
+			continue;
+
+		if (!srcBits[i]) {
+			// Missing source alpha is treated as fully opaque, missing
+			// color components as zero.
+			if (i == 0)
+				args.alphaFill = (0xFF >> dstLoss[i]) << dstShift[i];
+			continue;
+		}
+
+		ConvertArgs::Component &comp = args.comp[args.numComps++];
+		comp.srcShift = srcShift[i];
+		comp.srcMask = (1 << srcBits[i]) - 1;
+		comp.expandLeft = 8 - srcBits[i];
+		comp.expandRight = 2 * srcBits[i] - 8;
+		comp.dstLoss = dstLoss[i];
+		comp.dstShift = dstShift[i];
+	}
+
+	convertFunc(args);
+	return true;
+}
+
+bool FastBlit::crossBlitMap(byte *dst, const byte *src,
+							const uint dstPitch, const uint srcPitch,
+							const uint w, const uint h,
+							const uint bytesPerPixel, const uint32 *map,
+							const bool hasKey, const uint32 key) {
+	if (!mapFunc || !w || !h)
+		return false;
+	if (bytesPerPixel != 2 && bytesPerPixel != 4)
+		return false;
+	if (rangesOverlap(dst, dstPitch, w * bytesPerPixel, src, srcPitch, w, h))
+		return false;
+
+	MapArgs args;
+	args.dst = dst;
+	args.src = src;
+	args.dstPitch = dstPitch;
+	args.srcPitch = srcPitch;
+	args.w = w;
+	args.h = h;
+	args.dstBpp = bytesPerPixel;
+	args.map = map;
+	// A key outside of the CLUT8 range never matches anything
+	args.hasKey = hasKey && key <= 0xFF;
+	args.key = key;
+
+	mapFunc(args);
+	return true;
+}
+
+bool FastBlit::keyBlit(byte *dst, const byte *src,
+					   const uint dstPitch, const uint srcPitch,
+					   const uint w, const uint h,
+					   const uint bytesPerPixel, const uint32 key) {
+	if (!keyFunc || !w || !h)
+		return false;
+	if (bytesPerPixel != 1 && bytesPerPixel != 2 && bytesPerPixel != 4)
+		return false;
+	if ((bytesPerPixel == 1 && key > 0xFF) || (bytesPerPixel == 2 && key > 0xFFFF))
+		return false;
+	if (rangesOverlap(dst, dstPitch, w * bytesPerPixel, src, srcPitch, w * bytesPerPixel, h))
+		return false;
+
+	KeyArgs args;
+	args.dst = dst;
+	args.src = src;
+	args.dstPitch = dstPitch;
+	args.srcPitch = srcPitch;
+	args.w = w;
+	args.h = h;
+	args.bpp = bytesPerPixel;
+	args.key = key;
+
+	keyFunc(args);
+	return true;
+}
+
+} // End of namespace Graphics
@@ -0,0 +1,160 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef GRAPHICS_BLIT_FAST_H
+#define GRAPHICS_BLIT_FAST_H
+
+#include "graphics/pixelformat.h"
+
+class CrossBlitTestSuite;
+
+namespace Graphics {
+
+/**
+ * SIMD versions of the most common cases handled by crossBlit(),
+ * crossKeyBlit(), crossBlitMap(), crossKeyBlitMap() and keyBlit().
+ *
+ * Each entry point returns false if the request is not covered by a
+ * vectorized kernel on this CPU, in which case the caller falls back to the
+ * generic code in blit.cpp. The kernels produce bit-identical results to the
+ * generic code.
+ */
+class FastBlit {
+public:
+	/**
+	 * Pick the kernels for this CPU. Until this is called, every entry point
+	 * returns false.
+	 *
+	 * This must be called once the backend is initialized, since the CPU
+	 * features are queried through OSystem::hasFeature(), and before blits
+	 * may run on other threads: the selected kernels are not protected.
+	 */
+	static void selectFuncs();
+
+	/**
+	 * Convert between 16bpp and 32bpp formats whose components are either
+	 * absent or 4 to 8 bits wide. The source and destination must either not
+	 * overlap or be the same buffer with the same pitch and pixel size.
+	 */
+	static bool crossBlit(byte *dst, const byte *src,
+						  const uint dstPitch, const uint srcPitch,
+						  const uint w, const uint h,
+						  const PixelFormat &dstFmt, const PixelFormat &srcFmt,
+						  const bool hasKey, const uint32 key);
+
+	/** Palette lookup from CLUT8 to 16bpp or 32bpp, for non-overlapping buffers. */
+	static bool crossBlitMap(byte *dst, const byte *src,
+							 const uint dstPitch, const uint srcPitch,
+							 const uint w, const uint h,
+							 const uint bytesPerPixel, const uint32 *map,
+							 const bool hasKey, const uint32 key);
+
+	/** Color keyed copy of 8bpp, 16bpp or 32bpp pixels. */
+	static bool keyBlit(byte *dst, const byte *src,
+						const uint dstPitch, const uint srcPitch,
+						const uint w, const uint h,
+						const uint bytesPerPixel, const uint32 key);
+
+private:
+	struct ConvertArgs {
+		/** Describes how to move a single component from source to destination. */
+		struct Component {
+			uint32 srcShift, srcMask;
+			uint32 expandLeft, expandRight;
+			uint32 dstLoss, dstShift;
+		};
+
+		byte *dst;
+		const byte *src;
+		uint dstPitch, srcPitch;
+		uint w, h;
+		uint srcBpp, dstBpp;
+
+		Component comp[4];
+		uint numComps;
+		uint32 alphaFill;
+
+		bool hasKey;
+		uint32 key;
+
+		/** Scalar version of the conversion, used for the leftover pixels of each row. */
+		inline uint32 convert(uint32 color) const {
+			uint32 out = alphaFill;
+			for (uint i = 0; i < numComps; i++) {
+				const uint32 v = (color >> comp[i].srcShift) & comp[i].srcMask;
+				const uint32 e = (v << comp[i].expandLeft) | (v >> comp[i].expandRight);
+				out |= (e >> comp[i].dstLoss) << comp[i].dstShift;
+			}
+			return out;
+		}
+	};
+
+	struct MapArgs {
+		byte *dst;
+		const byte *src;
+		uint dstPitch, srcPitch;
+		uint w, h;
+		uint dstBpp;
+		const uint32 *map;
+		bool hasKey;
+		uint32 key;
+	};
+
+	struct KeyArgs {
+		byte *dst;
+		const byte *src;
+		uint dstPitch, srcPitch;
+		uint w, h;
+		uint bpp;
+		uint32 key;
+	};
+
+	typedef void (*ConvertFunc)(const ConvertArgs &args);
+	typedef void (*MapFunc)(const MapArgs &args);
+	typedef void (*KeyFunc)(const KeyArgs &args);
+
+#ifdef SCUMMVM_NEON
+	static void convertNEON(const ConvertArgs &args);
+	static void keyNEON(const KeyArgs &args);
+#endif
+#ifdef SCUMMVM_SSE2
+	static void convertSSE2(const ConvertArgs &args);
+	static void keySSE2(const KeyArgs &args);
+#endif
+#ifdef SCUMMVM_AVX2
+	static void convertAVX2(const ConvertArgs &args);
+	static void mapAVX2(const MapArgs &args);
+	static void keyAVX2(const KeyArgs &args);
+#endif
+
+	static ConvertFunc convertFunc;
+	static MapFunc mapFunc;
+	static KeyFunc keyFunc;
+
+	friend class ::CrossBlitTestSuite;
+	friend class FastBlitImpl_NEON;
+	friend class FastBlitImpl_SSE2;
+	friend class FastBlitImpl_AVX2;
+};
+
+} // End of namespace Graphics
+
+#endif // GRAPHICS_BLIT_FAST_H
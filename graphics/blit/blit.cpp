@@ -20,8 +20,10 @@
  */
 
 #include "graphics/blit.h"
+#include "graphics/blit/blit-fast.h"
 #include "graphics/pixelformat.h"
 #include "common/endian.h"
+#include "common/profiler.h"
 
 namespace Graphics {
 
@@ -35,6 +37,9 @@ void copyBlit(byte *dst, const byte *src,
 	if (dst == src)
 		return;
 
+	PROFILE_ZONE("copyBlit");
+	PROFILE_COUNT("Blitted pixels", w * h);
+
 	if (dstPitch == srcPitch && ((w * bytesPerPixel) == dstPitch)) {
 		memcpy(dst, src, dstPitch * h);
 	} else {
@@ -88,6 +93,12 @@ bool keyBlit(byte *dst, const byte *src,
 	if (dst == src)
 		return true;
 
+	PROFILE_ZONE("keyBlit");
+	PROFILE_COUNT("Blitted pixels", w * h);
+
+	if (FastBlit::keyBlit(dst, src, dstPitch, srcPitch, w, h, bytesPerPixel, key))
+		return true;
+
 	// Faster, but larger, to provide optimized handling for each case.
 	const uint srcDelta = (srcPitch - w * bytesPerPixel);
 	const uint dstDelta = (dstPitch - w * bytesPerPixel);
@@ -143,6 +154,9 @@ bool maskBlit(byte *dst, const byte *src, const byte *mask,
 	if (dst == src)
 		return true;
 
+	PROFILE_ZONE("maskBlit");
+	PROFILE_COUNT("Blitted pixels", w * h);
+
 	// Faster, but larger, to provide optimized handling for each case.
 	const uint srcDelta  = (srcPitch  - w * bytesPerPixel);
 	const uint dstDelta  = (dstPitch  - w * bytesPerPixel);
@@ -227,6 +241,12 @@ inline bool crossBlitHelper(byte *dst, const byte *src, const byte *mask, const
 						   const PixelFormat &srcFmt, const PixelFormat &dstFmt,
 						   const uint srcPitch, const uint dstPitch, const uint maskPitch,
 						   const uint32 key) {
+	PROFILE_ZONE("crossBlit");
+	PROFILE_COUNT("Blitted pixels", w * h);
+
+	if (!hasMask && FastBlit::crossBlit(dst, src, dstPitch, srcPitch, w, h, dstFmt, srcFmt, hasKey, key))
+		return true;
+
 	// Faster, but larger, to provide optimized handling for each case.
 	const uint srcDelta = (srcPitch - w * srcFmt.bytesPerPixel);
 	const uint dstDelta = (dstPitch - w * dstFmt.bytesPerPixel);
@@ -394,6 +414,12 @@ inline bool crossBlitMapHelperLogic(byte *dst, const byte *src, const byte *mask
 						   const uint bytesPerPixel, const uint32 *map,
 						   const uint srcPitch, const uint dstPitch, const uint maskPitch,
 						   const uint32 key) {
+	PROFILE_ZONE("crossBlitMap");
+	PROFILE_COUNT("Blitted pixels", w * h);
+
+	if (!hasMask && FastBlit::crossBlitMap(dst, src, dstPitch, srcPitch, w, h, bytesPerPixel, map, hasKey, key))
+		return true;
+
 	// Faster, but larger, to provide optimized handling for each case.
 	const uint srcDelta  = (srcPitch  - w);
 	const uint dstDelta  = (dstPitch  - w * bytesPerPixel);
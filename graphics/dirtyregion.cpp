@@ -0,0 +1,80 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "graphics/dirtyregion.h"
+
+namespace Graphics {
+
+static inline uint32 rectArea(const Common::Rect &r) {
+	return (uint32)r.width() * (uint32)r.height();
+}
+
+void DirtyRegion::addRect(const Common::Rect &r) {
+	if (r.isEmpty())
+		return;
+
+	Common::Rect rect = r;
+
+	// Each merge removes a rectangle from the list and the grown rectangle
+	// is checked again, as it may now reach rectangles it missed before.
+	for (;;) {
+		int best = -1;
+		uint32 bestCost = _mergeCost;
+
+		for (uint i = 0; i < _rects.size(); i++) {
+			const Common::Rect &other = _rects[i];
+
+			if (other.contains(rect))
+				return;
+
+			if (other.intersects(rect)) {
+				best = i;
+				break;
+			}
+
+			Common::Rect merged = other;
+			merged.extend(rect);
+			uint32 cost = rectArea(merged) - rectArea(other) - rectArea(rect);
+			if (cost <= bestCost) {
+				best = i;
+				bestCost = cost;
+			}
+		}
+
+		if (best < 0)
+			break;
+
+		rect.extend(_rects[best]);
+		_rects[best] = _rects.back();
+		_rects.pop_back();
+	}
+
+	_rects.push_back(rect);
+}
+
+uint32 DirtyRegion::getArea() const {
+	uint32 area = 0;
+	for (const_iterator i = begin(); i != end(); ++i)
+		area += rectArea(*i);
+	return area;
+}
+
+} // End of namespace Graphics
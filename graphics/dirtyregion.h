@@ -0,0 +1,98 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef GRAPHICS_DIRTYREGION_H
+#define GRAPHICS_DIRTYREGION_H
+
+#include "common/array.h"
+#include "common/rect.h"
+
+namespace Graphics {
+
+/**
+ * @defgroup graphics_dirtyregion Dirty region
+ * @ingroup graphics
+ *
+ * @brief DirtyRegion class for tracking modified areas of a surface.
+ *
+ * @{
+ */
+
+/**
+ * Tracks the modified areas of a surface as a short list of rectangles
+ * which never overlap each other.
+ *
+ * Rectangles are coalesced as they are added. Overlapping rectangles are
+ * always merged. Separate rectangles are merged when their bounding box
+ * covers at most mergeCost pixels that neither of them covers, i.e. when
+ * updating those pixels is cheaper than updating one more rectangle.
+ */
+class DirtyRegion {
+public:
+	typedef Common::Array<Common::Rect>::const_iterator const_iterator;
+
+	enum {
+		kDefaultMergeCost = 32 * 32
+	};
+
+	explicit DirtyRegion(uint mergeCost = kDefaultMergeCost) : _mergeCost(mergeCost) {}
+
+	/**
+	 * Adds an area to the region. Empty rectangles are ignored.
+	 *
+	 * This takes one pass over the current rectangles, plus one more for
+	 * every rectangle merged into the new one. Since each merge removes a
+	 * rectangle which had to be added first, adding n rectangles takes at
+	 * most 2n passes in total, but a single call may take more than one.
+	 */
+	void addRect(const Common::Rect &r);
+
+	/**
+	 * Removes all areas from the region.
+	 */
+	void clear() { _rects.clear(); }
+
+	bool empty() const { return _rects.empty(); }
+	uint size() const { return _rects.size(); }
+
+	const_iterator begin() const { return _rects.begin(); }
+	const_iterator end() const { return _rects.end(); }
+
+	/**
+	 * Returns the rectangles making up the region.
+	 */
+	const Common::Array<Common::Rect> &getRects() const { return _rects; }
+
+	/**
+	 * Returns the number of pixels in the region.
+	 */
+	uint32 getArea() const;
+
+private:
+	Common::Array<Common::Rect> _rects;
+	uint _mergeCost;
+};
+
+/** @} */
+
+} // End of namespace Graphics
+
+#endif
@@ -105,6 +105,42 @@ int getStringWidthImpl(const Font &font, const StringType &str) {
 	return space;
 }
 
+// Longer lines are drawn one character at a time
+enum {
+	kMaxRunLength = 256
+};
+
+template<class StringType>
+bool drawRunImpl(const Font &font, Surface *dst, const StringType &str, int x, int y, int leftX, int rightX, uint32 color,
+		const uint32 *transparentColor, Common::Rect &dirty) {
+	if (str.size() > kMaxRunLength)
+		return false;
+
+	uint32 run[kMaxRunLength];
+	uint len = 0;
+	for (typename StringType::const_iterator i = str.begin(), end = str.end(); i != end; ++i)
+		run[len++] = (typename StringType::unsigned_type)*i;
+
+	return font.drawRun(dst, run, len, x, y, leftX, rightX, color, transparentColor, dirty);
+}
+
+template<class StringType>
+bool drawRunImpl(const Font &font, Surface *dst, const StringType &str, int x, int y, int leftX, int rightX, uint32 color) {
+	Common::Rect dirty;
+	return drawRunImpl(font, dst, str, x, y, leftX, rightX, color, nullptr, dirty);
+}
+
+template<class StringType>
+bool drawRunImpl(const Font &font, ManagedSurface *dst, const StringType &str, int x, int y, int leftX, int rightX, uint32 color) {
+	const uint32 transColor = dst->getTransparentColor();
+	Common::Rect dirty;
+	if (!drawRunImpl(font, dst->surfacePtr(), str, x, y, leftX, rightX, color, dst->hasTransparentColor() ? &transColor : nullptr, dirty))
+		return false;
+
+	dst->addDirtyRect(dirty);
+	return true;
+}
+
 template<class SurfaceType, class StringType>
 void drawStringImpl(const Font &font, SurfaceType *dst, const StringType &str, int x, int y, int w, uint32 color, TextAlign align, int deltax) {
 	// The logic in getBoundingImpl is the same as we use here. In case we
@@ -120,6 +156,9 @@ void drawStringImpl(const Font &font, SurfaceType *dst, const StringType &str, i
 		x = x + w - width;
 	x += deltax;
 
+	if (drawRunImpl(font, dst, str, x, y, leftX, rightX, color))
+		return;
+
 	typename StringType::unsigned_type last = 0;
 	for (typename StringType::const_iterator i = str.begin(), end = str.end(); i != end; ++i) {
 		const typename StringType::unsigned_type cur = *i;
@@ -213,6 +213,31 @@ public:
 	virtual void drawChar(Surface *dst, uint32 chr, int x, int y, uint32 color) const = 0;
 	virtual void drawChar(ManagedSurface *dst, uint32 chr, int x, int y, uint32 color) const;
 
+	/**
+	 * Draw a line of text which drawString() has already aligned.
+	 *
+	 * The characters are drawn from pen position x. Characters which end left
+	 * of leftX are skipped, and drawing stops at the first character which
+	 * ends right of rightX.
+	 *
+	 * Fonts override this when they can draw a whole line faster than one
+	 * character at a time. The default implementation draws nothing and
+	 * returns false.
+	 *
+	 * @param dst              The surface to draw on.
+	 * @param str              The characters to draw.
+	 * @param len              The number of characters.
+	 * @param x                The x coordinate where to draw the first character.
+	 * @param y                The y coordinate where to draw the characters.
+	 * @param leftX            The left edge of the area to draw in.
+	 * @param rightX           The right edge of the area to draw in.
+	 * @param color            The color of the characters.
+	 * @param transparentColor The transparent color of the surface, or nullptr.
+	 * @param dirty            Set to the area which was drawn on.
+	 */
+	virtual bool drawRun(Surface *dst, const uint32 *str, uint len, int x, int y, int leftX, int rightX,
+	                     uint32 color, const uint32 *transparentColor, Common::Rect &dirty) const { return false; }
+
 	/** @overload */
 
 	/**
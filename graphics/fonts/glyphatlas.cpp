@@ -0,0 +1,195 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "graphics/fonts/glyphatlas.h"
+
+#include "common/util.h"
+
+namespace Common {
+DECLARE_SINGLETON(Graphics::GlyphAtlas);
+}
+
+namespace Graphics {
+
+GlyphAtlas::GlyphAtlas() : _nextFont(1), _clock(0), _budget(kDefaultBudget), _memoryUsage(0) {
+}
+
+GlyphAtlas::~GlyphAtlas() {
+	clear();
+}
+
+uint32 GlyphAtlas::registerFont() {
+	return _nextFont++;
+}
+
+void GlyphAtlas::unregisterFont(uint32 font) {
+	// The space stays in use until the page is dropped
+	for (EntryMap::iterator i = _entries.begin(); i != _entries.end(); ++i) {
+		if ((uint32)(i->_key >> 32) == font)
+			_entries.erase(i);
+	}
+}
+
+bool GlyphAtlas::getGlyph(uint32 font, uint32 glyph, Bitmap &bitmap) {
+	EntryMap::const_iterator i = _entries.find(makeKey(font, glyph));
+	if (i == _entries.end())
+		return false;
+
+	i->_value.page->lastUse = ++_clock;
+	bitmap = makeBitmap(i->_value);
+	return true;
+}
+
+GlyphAtlas::Bitmap GlyphAtlas::addGlyph(uint32 font, uint32 glyph, int w, int h) {
+	assert(w > 0 && h > 0);
+
+	const uint64 key = makeKey(font, glyph);
+	_entries.erase(key);
+
+	Entry entry;
+	Page *page = nullptr;
+
+	// Try the newest pages first, the older ones are likely to be full
+	for (uint i = _pages.size(); i-- > 0; ) {
+		if (allocate(_pages[i], w, h, entry)) {
+			page = _pages[i];
+			break;
+		}
+	}
+
+	if (!page) {
+		const int pageW = MAX<int>(w, kPageSize);
+		const int pageH = MAX<int>(h, kPageSize);
+
+		while (!_pages.empty() && _memoryUsage + pageW * pageH > _budget)
+			dropPage(findLeastRecentlyUsedPage());
+
+		page = createPage(pageW, pageH);
+		allocate(page, w, h, entry);
+	}
+
+	page->lastUse = ++_clock;
+	page->keys.push_back(key);
+	_entries[key] = entry;
+
+	return makeBitmap(entry);
+}
+
+void GlyphAtlas::removeGlyph(uint32 font, uint32 glyph) {
+	_entries.erase(makeKey(font, glyph));
+}
+
+void GlyphAtlas::setBudget(uint32 bytes) {
+	_budget = bytes;
+
+	while (!_pages.empty() && _memoryUsage > _budget)
+		dropPage(findLeastRecentlyUsedPage());
+}
+
+void GlyphAtlas::clear() {
+	while (!_pages.empty())
+		dropPage(_pages.size() - 1);
+}
+
+bool GlyphAtlas::allocate(Page *page, int w, int h, Entry &entry) {
+	if (w > page->w || h > page->h)
+		return false;
+
+	Shelf *shelf = nullptr;
+
+	// Don't waste tall shelves on small glyphs
+	for (uint i = 0; i < page->shelves.size(); i++) {
+		Shelf &s = page->shelves[i];
+		if (h <= s.h && h * 2 >= s.h && s.x + w <= page->w) {
+			shelf = &s;
+			break;
+		}
+	}
+
+	if (!shelf) {
+		if (page->shelvesHeight + h > page->h)
+			return false;
+
+		Shelf s;
+		s.y = page->shelvesHeight;
+		s.h = h;
+		s.x = 0;
+		page->shelves.push_back(s);
+		page->shelvesHeight += h;
+		shelf = &page->shelves.back();
+	}
+
+	entry.page = page;
+	entry.x = shelf->x;
+	entry.y = shelf->y;
+	entry.w = w;
+	entry.h = h;
+	shelf->x += w;
+	return true;
+}
+
+GlyphAtlas::Page *GlyphAtlas::createPage(int w, int h) {
+	Page *page = new Page();
+	page->pixels = new byte[w * h];
+	page->w = w;
+	page->h = h;
+	page->shelvesHeight = 0;
+	page->lastUse = _clock;
+
+	_pages.push_back(page);
+	_memoryUsage += w * h;
+	return page;
+}
+
+uint GlyphAtlas::findLeastRecentlyUsedPage() const {
+	uint oldest = 0;
+	for (uint i = 1; i < _pages.size(); i++) {
+		if (_pages[i]->lastUse < _pages[oldest]->lastUse)
+			oldest = i;
+	}
+	return oldest;
+}
+
+void GlyphAtlas::dropPage(uint index) {
+	Page *page = _pages[index];
+
+	for (uint i = 0; i < page->keys.size(); i++) {
+		EntryMap::iterator entry = _entries.find(page->keys[i]);
+		if (entry != _entries.end() && entry->_value.page == page)
+			_entries.erase(entry);
+	}
+
+	_memoryUsage -= page->w * page->h;
+	delete[] page->pixels;
+	delete page;
+	_pages.remove_at(index);
+}
+
+GlyphAtlas::Bitmap GlyphAtlas::makeBitmap(const Entry &entry) const {
+	Bitmap bitmap;
+	bitmap.pixels = entry.page->pixels + entry.y * entry.page->w + entry.x;
+	bitmap.pitch = entry.page->w;
+	bitmap.w = entry.w;
+	bitmap.h = entry.h;
+	return bitmap;
+}
+
+} // End of namespace Graphics
@@ -0,0 +1,156 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef GRAPHICS_FONTS_GLYPHATLAS_H
+#define GRAPHICS_FONTS_GLYPHATLAS_H
+
+#include "common/array.h"
+#include "common/hashmap.h"
+#include "common/singleton.h"
+
+namespace Graphics {
+
+/**
+ * @defgroup graphics_glyphatlas Glyph atlas
+ * @ingroup graphics
+ *
+ * @brief Cache of rendered glyphs shared by all fonts.
+ *
+ * @{
+ */
+
+/**
+ * Rendered glyphs of all fonts, stored as 8 bit coverage maps packed into
+ * pages.
+ *
+ * When the pages use up the memory budget, the least recently used page is
+ * dropped to make room, so fonts must be able to render a glyph again when
+ * getGlyph() no longer finds it.
+ */
+class GlyphAtlas : public Common::Singleton<GlyphAtlas> {
+public:
+	/**
+	 * A glyph coverage map. The pointers stay valid until the next call to
+	 * addGlyph().
+	 */
+	struct Bitmap {
+		byte *pixels;
+		int pitch;
+		int w, h;
+	};
+
+	enum {
+		kPageSize = 256,
+		kDefaultBudget = 4 * 1024 * 1024
+	};
+
+	GlyphAtlas();
+	~GlyphAtlas();
+
+	/**
+	 * Returns a key for a new font, which picks the font's glyphs together
+	 * with a glyph number chosen by the font.
+	 */
+	uint32 registerFont();
+
+	/**
+	 * Forget the glyphs of a font which is going away.
+	 */
+	void unregisterFont(uint32 font);
+
+	/**
+	 * Looks up a glyph and marks it as recently used.
+	 */
+	bool getGlyph(uint32 font, uint32 glyph, Bitmap &bitmap);
+
+	/**
+	 * Makes room for a glyph. The caller fills in the returned bitmap.
+	 */
+	Bitmap addGlyph(uint32 font, uint32 glyph, int w, int h);
+
+	/**
+	 * Forget a glyph, e.g. when it could not be rendered after all.
+	 */
+	void removeGlyph(uint32 font, uint32 glyph);
+
+	/**
+	 * Sets how many bytes the pages may use. The budget may be exceeded by
+	 * a single page when a glyph does not fit otherwise.
+	 */
+	void setBudget(uint32 bytes);
+
+	/**
+	 * Returns how many bytes the pages use.
+	 */
+	uint32 getMemoryUsage() const { return _memoryUsage; }
+
+	/**
+	 * Drops all glyphs.
+	 */
+	void clear();
+
+private:
+	struct Shelf {
+		int y, h;
+		int x;
+	};
+
+	struct Page {
+		byte *pixels;
+		int w, h;
+		Common::Array<Shelf> shelves;
+		int shelvesHeight;
+		uint32 lastUse;
+		Common::Array<uint64> keys;
+	};
+
+	struct Entry {
+		Page *page;
+		int16 x, y, w, h;
+	};
+
+	struct KeyHash {
+		uint operator()(uint64 key) const { return (uint)key ^ ((uint)(key >> 32) * 0x9E3779B1u); }
+	};
+
+	typedef Common::HashMap<uint64, Entry, KeyHash> EntryMap;
+
+	static uint64 makeKey(uint32 font, uint32 glyph) { return ((uint64)font << 32) | glyph; }
+
+	bool allocate(Page *page, int w, int h, Entry &entry);
+	Page *createPage(int w, int h);
+	uint findLeastRecentlyUsedPage() const;
+	void dropPage(uint index);
+	Bitmap makeBitmap(const Entry &entry) const;
+
+	Common::Array<Page *> _pages;
+	EntryMap _entries;
+	uint32 _nextFont;
+	uint32 _clock;
+	uint32 _budget;
+	uint32 _memoryUsage;
+};
+
+/** @} */
+
+} // End of namespace Graphics
+
+#endif
@@ -26,6 +26,7 @@
 #include "common/scummsys.h"
 #ifdef USE_FREETYPE2
 
+#include "graphics/fonts/glyphatlas.h"
 #include "graphics/fonts/ttf.h"
 #include "graphics/font.h"
 #include "graphics/surface.h"
@@ -180,6 +181,9 @@ public:
 	void drawChar(Surface *dst, uint32 chr, int x, int y, uint32 color) const override;
 	void drawChar(ManagedSurface *dst, uint32 chr, int x, int y, uint32 color) const override;
 
+	bool drawRun(Surface *dst, const uint32 *str, uint len, int x, int y, int leftX, int rightX,
+	             uint32 color, const uint32 *transparentColor, Common::Rect &dirty) const override;
+
 private:
 	bool _initialized;
 	FT_StreamRec_ _stream;
@@ -191,18 +195,24 @@ private:
 	int _width, _height;
 	int _ascent, _descent;
 
+	// The glyph images live in the GlyphAtlas, keyed by the same character
+	// code as the metrics here
 	struct Glyph {
-		Surface image;
 		int xOffset, yOffset;
+		int width, height;
 		int advance;
 		FT_UInt slot;
 	};
 
-	bool cacheGlyph(Glyph &glyph, uint32 chr) const;
+	bool cacheGlyph(Glyph &glyph, uint32 key, uint32 chr) const;
+	bool rasterizeGlyph(Glyph &glyph, uint32 key) const;
+	bool getGlyphImage(uint32 key, const Glyph &glyph, GlyphAtlas::Bitmap &image) const;
 	typedef Common::HashMap<uint32, Glyph> GlyphCache;
 	mutable GlyphCache _glyphs;
 	bool _allowLateCaching;
 	void assureCached(uint32 chr) const;
+	const Glyph *findGlyph(uint32 chr) const;
+	uint32 _atlasFont;
 
 	Common::SeekableReadStream *readTTFTable(FT_ULong tag) const;
 
@@ -211,6 +221,8 @@ private:
 	int computePointSizeFromHeaders(int height) const;
 	void drawChar(Surface *dst, uint32 chr, int x, int y, uint32 color,
 		const uint32 *transparentColor) const;
+	void drawGlyph(Surface *dst, uint32 key, const Glyph &glyph, int x, int y, uint32 color,
+		const uint32 *transparentColor) const;
 
 	FT_Int32 _loadFlags;
 	FT_Render_Mode _renderMode;
@@ -224,7 +236,7 @@ TTFFont::TTFFont()
 	: _initialized(false), _stream(), _face(), _ttfFile(0), _width(0), _height(0), _ascent(0),
 	  _descent(0), _glyphs(), _loadFlags(FT_LOAD_TARGET_NORMAL), _renderMode(FT_RENDER_MODE_NORMAL),
 	  _hasKerning(false), _allowLateCaching(false), _fakeBold(false), _fakeItalic(false),
-	  _disposeAfterUse(DisposeAfterUse::NO) {
+	  _disposeAfterUse(DisposeAfterUse::NO), _atlasFont(GlyphAtlas::instance().registerFont()) {
 }
 
 TTFFont::~TTFFont() {
@@ -235,11 +247,11 @@ TTFFont::~TTFFont() {
 			delete _ttfFile;
 		_ttfFile = 0;
 
-		for (GlyphCache::iterator i = _glyphs.begin(), end = _glyphs.end(); i != end; ++i)
-			i->_value.image.free();
-
 		_initialized = false;
 	}
+
+	if (GlyphAtlas::hasInstance())
+		GlyphAtlas::instance().unregisterFont(_atlasFont);
 }
 
 
@@ -366,7 +378,7 @@ bool TTFFont::load(Common::SeekableReadStream *ttfFile, DisposeAfterUse::Flag di
 
 		// Load all ISO-8859-1 characters.
 		for (uint i = 0; i < 256; ++i) {
-			if (!cacheGlyph(_glyphs[i], i)) {
+			if (!cacheGlyph(_glyphs[i], i, i)) {
 				_glyphs.erase(i);
 			}
 		}
@@ -379,7 +391,7 @@ bool TTFFont::load(Common::SeekableReadStream *ttfFile, DisposeAfterUse::Flag di
 			const bool isRequired = (mapping[i] & 0x80000000) != 0;
 			// Check whether loading an important glyph fails and error out if
 			// that is the case.
-			if (!cacheGlyph(_glyphs[i], unicode)) {
+			if (!cacheGlyph(_glyphs[i], i, unicode)) {
 				_glyphs.erase(i);
 				if (isRequired) {
 					g_ttf.closeFont(_face);
@@ -592,10 +604,8 @@ Common::Rect TTFFont::getBoundingBox(uint32 chr) const {
 	if (glyphEntry == _glyphs.end()) {
 		return Common::Rect();
 	} else {
-		const int xOffset = glyphEntry->_value.xOffset;
-		const int yOffset = glyphEntry->_value.yOffset;
-		const Graphics::Surface &image = glyphEntry->_value.image;
-		return Common::Rect(xOffset, yOffset, xOffset + image.w, yOffset + image.h);
+		const Glyph &glyph = glyphEntry->_value;
+		return Common::Rect(glyph.xOffset, glyph.yOffset, glyph.xOffset + glyph.width, glyph.yOffset + glyph.height);
 	}
 }
 
@@ -665,15 +675,57 @@ void TTFFont::drawChar(ManagedSurface *dst, uint32 chr, int x, int y, uint32 col
 	dst->addDirtyRect(charBox);
 }
 
-void TTFFont::drawChar(Surface * dst, uint32 chr, int x, int y, uint32 color,
+void TTFFont::drawChar(Surface *dst, uint32 chr, int x, int y, uint32 color,
 		const uint32 *transparentColor) const {
-	assureCached(chr);
-	GlyphCache::const_iterator glyphEntry = _glyphs.find(chr);
-	if (glyphEntry == _glyphs.end())
-		return;
+	const Glyph *glyph = findGlyph(chr);
+	if (glyph)
+		drawGlyph(dst, chr, *glyph, x, y, color, transparentColor);
+}
 
-	const Glyph &glyph = glyphEntry->_value;
+bool TTFFont::drawRun(Surface *dst, const uint32 *str, uint len, int x, int y, int leftX, int rightX,
+		uint32 color, const uint32 *transparentColor, Common::Rect &dirty) const {
+	// This follows drawStringImpl, but looks up each character only once
+	const Glyph *lastGlyph = findGlyph(0);
+	FT_UInt lastSlot = lastGlyph ? lastGlyph->slot : 0;
 
+	for (uint i = 0; i < len; ++i) {
+		const uint32 cur = str[i];
+		const Glyph *glyph = findGlyph(cur);
+
+		if (_hasKerning && lastSlot && glyph && glyph->slot) {
+			FT_Vector kerningVector;
+			FT_Get_Kerning(_face, lastSlot, glyph->slot, FT_KERNING_DEFAULT, &kerningVector);
+			x += (kerningVector.x / 64);
+		}
+		lastSlot = glyph ? glyph->slot : 0;
+
+		if (!glyph) {
+			if (x > rightX)
+				break;
+			continue;
+		}
+
+		Common::Rect charBox(glyph->xOffset, glyph->yOffset, glyph->xOffset + glyph->width, glyph->yOffset + glyph->height);
+		if (x + charBox.right > rightX)
+			break;
+		if (x + charBox.right >= leftX) {
+			drawGlyph(dst, cur, *glyph, x, y, color, transparentColor);
+
+			charBox.translate(x, y);
+			if (dirty.isEmpty())
+				dirty = charBox;
+			else if (!charBox.isEmpty())
+				dirty.extend(charBox);
+		}
+
+		x += glyph->advance;
+	}
+
+	return true;
+}
+
+void TTFFont::drawGlyph(Surface *dst, uint32 key, const Glyph &glyph, int x, int y, uint32 color,
+		const uint32 *transparentColor) const {
 	x += glyph.xOffset;
 	y += glyph.yOffset;
 
@@ -682,14 +734,13 @@ void TTFFont::drawChar(Surface * dst, uint32 chr, int x, int y, uint32 color,
 	if (y > dst->h)
 		return;
 
-	int w = glyph.image.w;
-	int h = glyph.image.h;
-
-	const uint8 *srcPos = (const uint8 *)glyph.image.getPixels();
+	int w = glyph.width;
+	int h = glyph.height;
+	int srcX = 0, srcY = 0;
 
 	// Make sure we are not drawing outside the screen bounds
 	if (x < 0) {
-		srcPos -= x;
+		srcX = -x;
 		w += x;
 		x = 0;
 	}
@@ -701,7 +752,7 @@ void TTFFont::drawChar(Surface * dst, uint32 chr, int x, int y, uint32 color,
 		return;
 
 	if (y < 0) {
-		srcPos -= y * glyph.image.pitch;
+		srcY = -y;
 		h += y;
 		y = 0;
 	}
@@ -712,6 +763,11 @@ void TTFFont::drawChar(Surface * dst, uint32 chr, int x, int y, uint32 color,
 	if (h <= 0)
 		return;
 
+	GlyphAtlas::Bitmap image;
+	if (!getGlyphImage(key, glyph, image))
+		return;
+
+	const uint8 *srcPos = image.pixels + srcY * image.pitch + srcX;
 	uint8 *dstPos = (uint8 *)dst->getBasePtr(x, y);
 
 	if (dst->format.isCLUT8()) {
@@ -730,23 +786,38 @@ void TTFFont::drawChar(Surface * dst, uint32 chr, int x, int y, uint32 color,
 			}
 
 			dstPos += dst->pitch;
-			srcPos += glyph.image.pitch;
+			srcPos += image.pitch;
 		}
 	} else if (dst->format.bytesPerPixel == 1) {
-		renderGlyph<uint8>(dstPos, dst->pitch, srcPos, glyph.image.pitch, w, h, color, dst->format, transparentColor);
+		renderGlyph<uint8>(dstPos, dst->pitch, srcPos, image.pitch, w, h, color, dst->format, transparentColor);
 	} else if (dst->format.bytesPerPixel == 2) {
-		renderGlyph<uint16>(dstPos, dst->pitch, srcPos, glyph.image.pitch, w, h, color, dst->format, transparentColor);
+		renderGlyph<uint16>(dstPos, dst->pitch, srcPos, image.pitch, w, h, color, dst->format, transparentColor);
 	} else if (dst->format.bytesPerPixel == 4) {
-		renderGlyph<uint32>(dstPos, dst->pitch, srcPos, glyph.image.pitch, w, h, color, dst->format, transparentColor);
+		renderGlyph<uint32>(dstPos, dst->pitch, srcPos, image.pitch, w, h, color, dst->format, transparentColor);
 	}
 }
 
-bool TTFFont::cacheGlyph(Glyph &glyph, uint32 chr) const {
+bool TTFFont::getGlyphImage(uint32 key, const Glyph &glyph, GlyphAtlas::Bitmap &image) const {
+	GlyphAtlas &atlas = GlyphAtlas::instance();
+	if (atlas.getGlyph(_atlasFont, key, image))
+		return true;
+
+	// The atlas dropped the image to make room for other glyphs
+	Glyph rendered = glyph;
+	return rasterizeGlyph(rendered, key) && atlas.getGlyph(_atlasFont, key, image);
+}
+
+bool TTFFont::cacheGlyph(Glyph &glyph, uint32 key, uint32 chr) const {
 	FT_UInt slot = FT_Get_Char_Index(_face, chr);
 	if (!slot)
 		return false;
 
 	glyph.slot = slot;
+	return rasterizeGlyph(glyph, key);
+}
+
+bool TTFFont::rasterizeGlyph(Glyph &glyph, uint32 key) const {
+	FT_UInt slot = glyph.slot;
 
 	// We use the light target and render mode to improve the looks of the
 	// glyphs. It is most noticeable in FreeSansBold.ttf, where otherwise the
@@ -806,50 +877,49 @@ bool TTFFont::cacheGlyph(Glyph &glyph, uint32 chr) const {
 	}
 
 
-	glyph.image.create(bitmap->width, bitmap->rows, PixelFormat::createFormatCLUT8());
+	glyph.width = bitmap->width;
+	glyph.height = bitmap->rows;
 
-	const uint8 *src = bitmap->buffer;
-	int srcPitch = bitmap->pitch;
-	if (srcPitch < 0) {
-		src += (bitmap->rows - 1) * srcPitch;
-		srcPitch = -srcPitch;
-	}
+	const bool supported = (bitmap->pixel_mode == FT_PIXEL_MODE_MONO || bitmap->pixel_mode == FT_PIXEL_MODE_GRAY);
+	if (!supported)
+		warning("TTFFont::rasterizeGlyph: Unsupported pixel mode %d", bitmap->pixel_mode);
 
-	uint8 *dst = (uint8 *)glyph.image.getPixels();
+	// Glyphs without pixels, like spaces, don't need an image
+	if (supported && glyph.width > 0 && glyph.height > 0) {
+		GlyphAtlas::Bitmap image = GlyphAtlas::instance().addGlyph(_atlasFont, key, glyph.width, glyph.height);
 
-	switch (bitmap->pixel_mode) {
-	case FT_PIXEL_MODE_MONO:
-		for (int y = 0; y < (int)bitmap->rows; ++y) {
-			const uint8 *curSrc = src;
-			uint8 mask = 0;
+		const uint8 *src = bitmap->buffer;
+		int srcPitch = bitmap->pitch;
+		if (srcPitch < 0) {
+			src += (bitmap->rows - 1) * srcPitch;
+			srcPitch = -srcPitch;
+		}
 
-			for (int x = 0; x < (int)bitmap->width; ++x) {
-				if ((x % 8) == 0)
-					mask = *curSrc++;
+		uint8 *dst = image.pixels;
 
-				if (mask & 0x80)
-					*dst = 255;
+		if (bitmap->pixel_mode == FT_PIXEL_MODE_MONO) {
+			for (int y = 0; y < glyph.height; ++y) {
+				const uint8 *curSrc = src;
+				uint8 mask = 0;
 
-				mask <<= 1;
-				++dst;
-			}
+				for (int x = 0; x < glyph.width; ++x) {
+					if ((x % 8) == 0)
+						mask = *curSrc++;
 
-			src += srcPitch;
-		}
-		break;
+					dst[x] = (mask & 0x80) ? 255 : 0;
+					mask <<= 1;
+				}
 
-	case FT_PIXEL_MODE_GRAY:
-		for (int y = 0; y < (int)bitmap->rows; ++y) {
-			memcpy(dst, src, bitmap->width);
-			dst += glyph.image.pitch;
-			src += srcPitch;
+				dst += image.pitch;
+				src += srcPitch;
+			}
+		} else {
+			for (int y = 0; y < glyph.height; ++y) {
+				memcpy(dst, src, glyph.width);
+				dst += image.pitch;
+				src += srcPitch;
+			}
 		}
-		break;
-
-	default:
-		warning("TTFFont::cacheGlyph: Unsupported pixel mode %d", bitmap->pixel_mode);
-		glyph.image.free();
-		return false;
 	}
 
 #if FAKE_BOLD == 1
@@ -858,7 +928,15 @@ bool TTFFont::cacheGlyph(Glyph &glyph, uint32 chr) const {
 	}
 #endif
 
-	return true;
+	return supported;
+}
+
+const TTFFont::Glyph *TTFFont::findGlyph(uint32 chr) const {
+	assureCached(chr);
+	GlyphCache::const_iterator glyphEntry = _glyphs.find(chr);
+	if (glyphEntry == _glyphs.end())
+		return nullptr;
+	return &glyphEntry->_value;
 }
 
 void TTFFont::assureCached(uint32 chr) const {
@@ -867,7 +945,7 @@ void TTFFont::assureCached(uint32 chr) const {
 	}
 
 	Glyph newGlyph;
-	if (cacheGlyph(newGlyph, chr)) {
+	if (cacheGlyph(newGlyph, chr, chr)) {
 		_glyphs[chr] = newGlyph;
 	}
 }
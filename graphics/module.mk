@@ -4,10 +4,12 @@ MODULE_OBJS := \
 	big5.o \
 	blit/blit.o \
 	blit/blit-alpha.o \
+	blit/blit-fast.o \
 	blit/blit-generic.o \
 	blit/blit-scale.o \
 	color_quantizer.o \
 	cursorman.o \
+	dirtyregion.o \
 	font.o \
 	fontman.o \
 	fonts/amigafont.o \
@@ -15,6 +17,7 @@ MODULE_OBJS := \
 	fonts/consolefont.o \
 	fonts/dosfont.o \
 	fonts/freetype.o \
+	fonts/glyphatlas.o \
 	fonts/macfont.o \
 	fonts/newfont_big.o \
 	fonts/newfont.o \
@@ -97,6 +100,15 @@ MODULE_OBJS += \
 	tinygl/ztriangle.o \
 	tinygl/zblit.o \
 	tinygl/zdirtyrect.o
+
+ifdef SCUMMVM_SSE2
+MODULE_OBJS += \
+	tinygl/zspan_sse2.o
+endif
+ifdef SCUMMVM_AVX2
+MODULE_OBJS += \
+	tinygl/zspan_avx2.o
+endif
 endif
 
 ifdef USE_ASPECT
@@ -146,15 +158,21 @@ endif
 
 ifdef SCUMMVM_NEON
 MODULE_OBJS += \
-	blit/blit-neon.o
+	blit/blit-neon.o \
+	blit/blit-fast-neon.o \
+	yuv_to_rgb_neon.o
 endif
 ifdef SCUMMVM_SSE2
 MODULE_OBJS += \
-	blit/blit-sse2.o
+	blit/blit-sse2.o \
+	blit/blit-fast-sse2.o \
+	yuv_to_rgb_sse2.o
 endif
 ifdef SCUMMVM_AVX2
 MODULE_OBJS += \
-	blit/blit-avx2.o
+	blit/blit-avx2.o \
+	blit/blit-fast-avx2.o \
+	yuv_to_rgb_avx2.o
 endif
 
 # Include common rules
@@ -22,6 +22,7 @@
 #ifndef GRAPHICS_SCREEN_H
 #define GRAPHICS_SCREEN_H
 
+#include "graphics/dirtyregion.h"
 #include "graphics/managed_surface.h"
 #include "graphics/palette.h"
 #include "graphics/pixelformat.h"
@@ -48,19 +49,9 @@ namespace Graphics {
 class Screen : public ManagedSurface {
 protected:
 	/**
-	 * List of affected areas of the screen
+	 * Affected areas of the screen
 	 */
-	Common::List<Common::Rect> _dirtyRects;
-protected:
-	/**
-	 * Merges together overlapping dirty areas of the screen
-	 */
-	void mergeDirtyRects();
-
-	/**
-	 * Returns the union of two dirty area rectangles
-	 */
-	bool unionRectangle(Common::Rect &destRect, const Common::Rect &src1, const Common::Rect &src2);
+	DirtyRegion _dirtyRects;
 public:
 	Screen();
 	Screen(int width, int height);
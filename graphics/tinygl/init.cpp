@@ -357,6 +357,7 @@ void GLContext::init(int screenW, int screenH, Graphics::PixelFormat pixelFormat
 	_drawCallAllocator[1].initialize(drawCallMemorySize);
 	_debugRectsEnabled = false;
 	_profilingEnabled = false;
+	_tileRasterizer = new TileRasterizer();
 
 	TinyGL::Internal::tglBlitResetScissorRect();
 }
@@ -371,6 +372,7 @@ void GLContext::deinit() {
 	free_texture(default_texture);
 	endSharedState();
 	gl_free(vertex);
+	delete _tileRasterizer;
 	delete fb;
 }
 
@@ -172,6 +172,7 @@ void GLContext::glopRotate(GLParam *p) {
 
 		// fill in the values
 		m._m[3][0] = 0.0f;
+		m._m[3][1] = 0.0f;
 		m._m[3][2] = 0.0f;
 		m._m[0][3] = 0.0f;
 		m._m[1][3] = 0.0f;
@@ -30,6 +30,7 @@
 #include "common/scummsys.h"
 #include "common/endian.h"
 #include "common/memory.h"
+#include "common/system.h"
 
 #include "graphics/tinygl/zbuffer.h"
 #include "graphics/tinygl/zgl.h"
@@ -52,6 +53,20 @@ FrameBuffer::FrameBuffer(int width, int height, const Graphics::PixelFormat &for
 
 	_offscreenBuffer.pbuf = _pbuf;
 	_offscreenBuffer.zbuf = _zbuf;
+	_ownsBuffers = true;
+
+	_currentTexture = nullptr;
+	_spanFunc = selectSpanFunc(_pbufFormat);
+
+	_enableScissor = false;
+}
+
+FrameBuffer::FrameBuffer(const FrameBuffer *parent) {
+	_ownsBuffers = false;
+	shareBuffers(parent);
+
+	_offscreenBuffer.pbuf = nullptr;
+	_offscreenBuffer.zbuf = nullptr;
 
 	_currentTexture = nullptr;
 
@@ -59,12 +74,70 @@ FrameBuffer::FrameBuffer(int width, int height, const Graphics::PixelFormat &for
 }
 
 FrameBuffer::~FrameBuffer() {
+	if (!_ownsBuffers)
+		return;
+
 	gl_free(_pbuf);
 	gl_free(_zbuf);
 	if (_sbuf)
 		gl_free(_sbuf);
 }
 
+void FrameBuffer::shareBuffers(const FrameBuffer *parent) {
+	assert(!_ownsBuffers);
+
+	_pbufWidth = parent->_pbufWidth;
+	_pbufHeight = parent->_pbufHeight;
+	_pbufFormat = parent->_pbufFormat;
+	_pbufBpp = parent->_pbufBpp;
+	_pbufPitch = parent->_pbufPitch;
+
+	_pbuf = parent->_pbuf;
+	_zbuf = parent->_zbuf;
+	_sbuf = parent->_sbuf;
+
+	_textureSize = parent->_textureSize;
+	_textureSizeMask = parent->_textureSizeMask;
+
+	_spanFunc = parent->_spanFunc;
+}
+
+namespace {
+
+bool cpuSpanFuncSelected = false;
+SpanFunc cpuSpanFunc = nullptr;
+
+} // End of anonymous namespace
+
+SpanFunc selectSpanFunc(const Graphics::PixelFormat &format) {
+	// The span kernels work on 32bpp pixels with 8 bit components
+	if (format.bytesPerPixel != 4 || format.rLoss != 0 || format.gLoss != 0 || format.bLoss != 0 ||
+	    (format.aLoss != 0 && format.aLoss != 8))
+		return nullptr;
+
+	if (!cpuSpanFuncSelected) {
+		// Contexts may be created before the backend exists
+		if (!g_system)
+			return nullptr;
+
+		cpuSpanFuncSelected = true;
+#ifdef SCUMMVM_SSE2
+		if (g_system->hasFeature(OSystem::kFeatureCpuSSE2))
+			cpuSpanFunc = fillSpanSSE2;
+#endif
+#ifdef SCUMMVM_AVX2
+		if (g_system->hasFeature(OSystem::kFeatureCpuAVX2))
+			cpuSpanFunc = fillSpanAVX2;
+#endif
+	}
+	return cpuSpanFunc;
+}
+
+void setCPUSpanFunc(SpanFunc func) {
+	cpuSpanFuncSelected = true;
+	cpuSpanFunc = func;
+}
+
 Buffer *FrameBuffer::genOffscreenBuffer() {
 	Buffer *buf = (Buffer *)gl_malloc(sizeof(Buffer));
 	buf->pbuf = (byte *)gl_zalloc(_pbufHeight * _pbufPitch);
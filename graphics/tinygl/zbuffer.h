@@ -31,6 +31,7 @@
 #include "graphics/surface.h"
 #include "graphics/tinygl/texelbuffer.h"
 #include "graphics/tinygl/gl.h"
+#include "graphics/tinygl/zspan.h"
 
 #include "common/rect.h"
 #include "common/textconsole.h"
@@ -105,8 +106,20 @@ struct ZBufferPoint {
 
 struct FrameBuffer {
 	FrameBuffer(int width, int height, const Graphics::PixelFormat &format, bool enableStencilBuffer);
+	/**
+	 * Create a frame buffer which renders into the buffers of @p parent,
+	 * with its own rendering state. Used to rasterize disjoint parts of
+	 * the parent from several threads.
+	 */
+	explicit FrameBuffer(const FrameBuffer *parent);
 	~FrameBuffer();
 
+	/**
+	 * Make a frame buffer created from a parent follow the parent's
+	 * current buffers and texture size.
+	 */
+	void shareBuffers(const FrameBuffer *parent);
+
 	Graphics::PixelFormat getPixelFormat() {
 		return _pbufFormat;
 	}
@@ -373,6 +386,12 @@ private:
 	template <bool kDepthWrite, bool kEnableScissor, bool kStencilEnabled, bool StippleEnabled, bool kDepthTestEnabled>
 	void putPixelDepth(uint *pz, byte *ps, int _a, int x, int y, uint &z, int &dzdx);
 
+	template <bool kDepthWrite, bool kSmoothMode, bool kEnableBlending, bool kDepthTestEnabled>
+	void putSpanTexture(int fbOffset, const TexelBuffer *texture,
+	                    uint wrap_s, uint wrap_t, uint *pz,
+	                    uint &z, int &t, int &s, uint &r, uint &g, uint &b, uint &a,
+	                    int dzdx, int dsdx, int dtdx, int drdx, int dgdx, int dbdx, uint dadx);
+
 
 	template <bool kEnableAlphaTest>
 	FORCEINLINE void writePixel(int pixel, int value) {
@@ -669,6 +688,18 @@ public:
 		_fogColorB = colorB;
 	}
 
+	/**
+	 * Set the kernel that fills runs of textured pixels, or nullptr to
+	 * draw them one pixel at a time.
+	 */
+	void setSpanFunc(SpanFunc func) {
+		_spanFunc = func;
+	}
+
+	SpanFunc getSpanFunc() const {
+		return _spanFunc;
+	}
+
 private:
 
 	/**
@@ -755,6 +786,7 @@ private:
 	void drawLine(const ZBufferPoint *p1, const ZBufferPoint *p2);
 
 	Buffer _offscreenBuffer;
+	bool _ownsBuffers;
 	byte *_pbuf;
 	int _pbufWidth;
 	int _pbufHeight;
@@ -774,6 +806,7 @@ private:
 
 	const TexelBuffer *_currentTexture;
 	uint _wrapS, _wrapT;
+	SpanFunc _spanFunc;
 	bool _blendingEnabled;
 	int _sourceBlendingFactor;
 	int _destinationBlendingFactor;
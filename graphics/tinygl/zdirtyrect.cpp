@@ -19,11 +19,13 @@
  *
  */
 
+#include "graphics/dirtyregion.h"
 #include "graphics/tinygl/zdirtyrect.h"
 #include "graphics/tinygl/zgl.h"
 #include "graphics/tinygl/gl.h"
 
 #include "common/debug.h"
+#include "common/jobs.h"
 
 namespace TinyGL {
 
@@ -143,70 +145,41 @@ void GLContext::presentBufferDirtyRects(Common::List<Common::Rect> &dirtyAreas)
 		_appendDirtyRectangle(**itFrame, rectangles, 255, 0, 0);
 	}
 
-	// This loop increases outer rectangle coordinates to favor merging of adjacent rectangles.
+	// Outer rectangle coordinates are increased to favor merging of adjacent rectangles.
+	Graphics::DirtyRegion region;
 	for (RectangleIterator it = rectangles.begin(); it != rectangles.end(); ++it) {
-		(*it).rectangle.right++;
-		(*it).rectangle.bottom++;
+		Common::Rect rect = (*it).rectangle;
+		rect.right++;
+		rect.bottom++;
+		rect.clip(renderRect);
+		region.addRect(rect);
 	}
 
-	// Merge coalesce dirty rects.
-	bool restartMerge;
-	do {
-		restartMerge = false;
-		for (RectangleIterator it1 = rectangles.begin(); it1 != rectangles.end(); ++it1) {
-			for (RectangleIterator it2 = rectangles.begin(); it2 != rectangles.end();) {
-				if (it1 != it2) {
-					if ((*it1).rectangle.intersects((*it2).rectangle)) {
-						(*it1).rectangle.extend((*it2).rectangle);
-						it2 = rectangles.erase(it2);
-						restartMerge = true;
-					} else {
-						++it2;
-					}
-				} else {
-					++it2;
-				}
-			}
-		}
-	} while(restartMerge);
-
-	for (RectangleIterator it1 = rectangles.begin(); it1 != rectangles.end(); ++it1) {
-		RectangleIterator it2 = it1;
-		it2++;
-		while (it2 != rectangles.end()) {
-			if ((*it1).rectangle.contains((*it2).rectangle)) {
-				it2 = rectangles.erase(it2);
-			} else {
-				++it2;
-			}
-		}
-	}
-
-	for (RectangleIterator it1 = rectangles.begin(); it1 != rectangles.end(); ++it1) {
-		(*it1).rectangle.clip(renderRect);
-	}
-
-	if (!rectangles.empty()) {
-		for (RectangleIterator itRect = rectangles.begin(); itRect != rectangles.end(); ++itRect) {
-			dirtyAreas.push_back((*itRect).rectangle);
+	if (!region.empty()) {
+		for (Graphics::DirtyRegion::const_iterator itRect = region.begin(); itRect != region.end(); ++itRect) {
+			dirtyAreas.push_back(*itRect);
 		}
 
 		// Execute draw calls.
-		for (DrawCallIterator it = _drawCallsQueue.begin(); it != _drawCallsQueue.end(); ++it) {
-			Common::Rect drawCallRegion = (*it)->getDirtyRegion();
-			for (RectangleIterator itRect = rectangles.begin(); itRect != rectangles.end(); ++itRect) {
-				Common::Rect dirtyRegion = (*itRect).rectangle;
-				if (dirtyRegion.intersects(drawCallRegion)) {
-					(*it)->execute(dirtyRegion, true);
+		if (_tileRasterizer->isAvailable(this)) {
+			_tileRasterizer->execute(this, _drawCallsQueue, region.getRects());
+		} else {
+			for (DrawCallIterator it = _drawCallsQueue.begin(); it != _drawCallsQueue.end(); ++it) {
+				Common::Rect drawCallRegion = (*it)->getDirtyRegion();
+				for (Graphics::DirtyRegion::const_iterator itRect = region.begin(); itRect != region.end(); ++itRect) {
+					const Common::Rect &dirtyRegion = *itRect;
+					if (dirtyRegion.intersects(drawCallRegion)) {
+						(*it)->execute(dirtyRegion, true);
+					}
 				}
 			}
 		}
 
 		if (_debugRectsEnabled) {
 			// Draw debug rectangles.
-			// Note: white rectangles are rectangle that contained other rectangles
-			// blue rectangles are rectangle merged from other rectangles
-			// red rectangles are original dirty rects
+			// Note: white rectangles are dirty rects of the previous frame
+			// red rectangles are dirty rects of the current frame
+			// blue rectangles are the merged areas which were redrawn
 
 			fb->enableBlending(false);
 			fb->enableAlphaTest(false);
@@ -214,6 +187,9 @@ void GLContext::presentBufferDirtyRects(Common::List<Common::Rect> &dirtyAreas)
 			for (RectangleIterator it = rectangles.begin(); it != rectangles.end(); ++it) {
 				debugDrawRectangle((*it).rectangle, (*it).r, (*it).g, (*it).b);
 			}
+			for (Graphics::DirtyRegion::const_iterator itRect = region.begin(); itRect != region.end(); ++itRect) {
+				debugDrawRectangle(*itRect, 0, 0, 255);
+			}
 
 			fb->enableBlending(blending_enabled);
 			fb->enableAlphaTest(alpha_test_enabled);
@@ -239,8 +215,17 @@ void GLContext::presentBufferSimple(Common::List<Common::Rect> &dirtyAreas) {
 
 	dirtyAreas.push_back(Common::Rect(fb->getPixelBufferWidth(), fb->getPixelBufferHeight()));
 
+	if (_tileRasterizer->isAvailable(this)) {
+		Common::Array<Common::Rect> regions;
+		regions.push_back(dirtyAreas.back());
+		_tileRasterizer->execute(this, _drawCallsQueue, regions);
+	} else {
+		for (DrawCallIterator it = _drawCallsQueue.begin(); it != _drawCallsQueue.end(); ++it) {
+			(*it)->execute(true);
+		}
+	}
+
 	for (DrawCallIterator it = _drawCallsQueue.begin(); it != _drawCallsQueue.end(); ++it) {
-		(*it)->execute(true);
 		delete *it;
 	}
 
@@ -293,7 +278,7 @@ RasterizationDrawCall::RasterizationDrawCall() : DrawCall(DrawCall_Rasterization
 	_drawTriangleFront = c->draw_triangle_front;
 	_drawTriangleBack = c->draw_triangle_back;
 	memcpy(_vertex, c->vertex, sizeof(GLVertex) * _vertexCount);
-	_state = captureState();
+	_state = captureState(c);
 	if (c->_enableDirtyRectangles) {
 		computeDirtyRegion();
 	}
@@ -333,18 +318,20 @@ void RasterizationDrawCall::computeDirtyRegion() {
 }
 
 void RasterizationDrawCall::execute(bool restoreState) const {
-	GLContext *c = gl_get_context();
+	execute(gl_get_context(), _vertex, restoreState);
+}
 
+void RasterizationDrawCall::execute(GLContext *c, GLVertex *vertex, bool restoreState) const {
 	RasterizationDrawCall::RasterizationState backupState;
 	if (restoreState) {
-		backupState = captureState();
+		backupState = captureState(c);
 	}
-	applyState(_state);
+	applyState(c, _state);
 
 	GLVertex *prevVertex = c->vertex;
 	int prevVertexCount = c->vertex_cnt;
 
-	c->vertex = _vertex;
+	c->vertex = vertex;
 	c->vertex_cnt = _vertexCount;
 	c->draw_triangle_front = (gl_draw_triangle_func)_drawTriangleFront;
 	c->draw_triangle_back = (gl_draw_triangle_func)_drawTriangleBack;
@@ -428,13 +415,12 @@ void RasterizationDrawCall::execute(bool restoreState) const {
 	c->vertex_cnt = prevVertexCount;
 
 	if (restoreState) {
-		applyState(backupState);
+		applyState(c, backupState);
 	}
 }
 
-RasterizationDrawCall::RasterizationState RasterizationDrawCall::captureState() const {
+RasterizationDrawCall::RasterizationState RasterizationDrawCall::captureState(const GLContext *c) const {
 	RasterizationState state;
-	GLContext *c = gl_get_context();
 	state.enableBlending = c->blending_enabled;
 	state.sfactor = c->source_blending_factor;
 	state.dfactor = c->destination_blending_factor;
@@ -485,8 +471,7 @@ RasterizationDrawCall::RasterizationState RasterizationDrawCall::captureState()
 	return state;
 }
 
-void RasterizationDrawCall::applyState(const RasterizationDrawCall::RasterizationState &state) const {
-	GLContext *c = gl_get_context();
+void RasterizationDrawCall::applyState(GLContext *c, const RasterizationDrawCall::RasterizationState &state) const {
 	c->fb->enableBlending(state.enableBlending);
 	c->fb->setBlendingFactors(state.sfactor, state.dfactor);
 	c->fb->enableAlphaTest(state.alphaTestEnabled);
@@ -556,6 +541,13 @@ void RasterizationDrawCall::execute(const Common::Rect &clippingRectangle, bool
 	c->fb->resetScissorRectangle();
 }
 
+void RasterizationDrawCall::executeTile(GLContext *c, GLVertex *vertexScratch, const Common::Rect &tileRectangle) const {
+	memcpy(vertexScratch, _vertex, sizeof(GLVertex) * _vertexCount);
+	c->fb->setScissorRectangle(tileRectangle);
+	execute(c, vertexScratch, false);
+	c->fb->resetScissorRectangle();
+}
+
 bool RasterizationDrawCall::operator==(const RasterizationDrawCall &other) const {
 	if (_vertexCount == other._vertexCount &&
 		_drawTriangleFront == other._drawTriangleFront &&
@@ -711,6 +703,13 @@ void ClearBufferDrawCall::execute(const Common::Rect &clippingRectangle, bool re
 	                   _clearStencilBuffer, _stencilValue);
 }
 
+void ClearBufferDrawCall::executeTile(GLContext *c, const Common::Rect &tileRectangle) const {
+	Common::Rect clearRect = c->_enableDirtyRectangles ? tileRectangle.findIntersectingRect(getDirtyRegion()) : tileRectangle;
+	c->fb->clearRegion(clearRect.left, clearRect.top, clearRect.width(), clearRect.height(),
+	                   _clearZBuffer, _zValue, _clearColorBuffer, _rValue, _gValue, _bValue,
+	                   _clearStencilBuffer, _stencilValue);
+}
+
 bool ClearBufferDrawCall::operator==(const ClearBufferDrawCall &other) const {
 	return
 		_clearZBuffer == other._clearZBuffer &&
@@ -777,4 +776,159 @@ void *Internal::allocateFrame(int size) {
 	return c->_drawCallAllocator[c->_currentAllocatorIndex].allocate(size);
 }
 
+TileRasterizer::TileRasterizer() : _laneCount(0) {
+}
+
+TileRasterizer::~TileRasterizer() {
+	for (uint i = 0; i < _lanes.size(); i++) {
+		delete _lanes[i].context;
+		delete _lanes[i].fb;
+		gl_free(_lanes[i].vertices);
+	}
+}
+
+bool TileRasterizer::isAvailable(const GLContext *c) const {
+	// Selection and profiling update state shared by the whole context
+	return JobSys.getWorkerCount() > 0 && c->render_mode == TGL_RENDER && !c->_profilingEnabled;
+}
+
+void TileRasterizer::prepareLanes(GLContext *c, uint laneCount) {
+	while (_lanes.size() < laneCount) {
+		Lane lane;
+		lane.context = new GLContext();
+		lane.fb = new FrameBuffer(c->fb);
+		lane.vertices = nullptr;
+		lane.vertexMax = 0;
+		_lanes.push_back(lane);
+	}
+
+	// Rasterization draw calls apply their own state, except for these
+	for (uint i = 0; i < laneCount; i++) {
+		GLContext *laneContext = _lanes[i].context;
+		_lanes[i].fb->shareBuffers(c->fb);
+		laneContext->fb = _lanes[i].fb;
+		laneContext->renderRect = c->renderRect;
+		laneContext->render_mode = c->render_mode;
+		laneContext->current_cull_face = c->current_cull_face;
+		laneContext->vertex_n = c->vertex_n;
+		// Scales the texture coordinates of the vertices added by clipping
+		laneContext->_textureSize = c->_textureSize;
+		laneContext->_enableDirtyRectangles = c->_enableDirtyRectangles;
+		laneContext->_profilingEnabled = false;
+	}
+	_laneCount = laneCount;
+}
+
+void TileRasterizer::execute(GLContext *c, const Common::List<DrawCall *> &drawCalls, const Common::Array<Common::Rect> &regions) {
+	typedef Common::List<DrawCall *>::const_iterator DrawCallIterator;
+
+	const Common::Rect frame(c->fb->getPixelBufferWidth(), c->fb->getPixelBufferHeight());
+
+	_regions = regions;
+	_tiles.clear();
+	for (int y = 0; y < frame.bottom; y += kTileHeight) {
+		_tiles.push_back(Common::Rect(0, y, frame.right, MIN<int>(y + kTileHeight, frame.bottom)));
+	}
+	_bins.resize(_tiles.size());
+
+	prepareLanes(c, MIN<uint>(JobSys.getConcurrency(), _tiles.size()));
+
+	int vertexCount = 0;
+	for (DrawCallIterator it = drawCalls.begin(); it != drawCalls.end(); ++it) {
+		if ((*it)->getType() == DrawCall::DrawCall_Rasterization) {
+			vertexCount = MAX(vertexCount, ((const RasterizationDrawCall *)*it)->getVertexCount());
+		}
+	}
+	for (uint i = 0; i < _laneCount; i++) {
+		if (_lanes[i].vertexMax < vertexCount) {
+			_lanes[i].vertices = (GLVertex *)gl_realloc(_lanes[i].vertices, vertexCount * sizeof(GLVertex));
+			_lanes[i].vertexMax = vertexCount;
+		}
+	}
+
+	DrawCallIterator it = drawCalls.begin();
+	for (;;) {
+		// Bin the draw calls up to the next blit by the tiles they cover
+		for (uint i = 0; i < _bins.size(); i++) {
+			_bins[i].clear();
+		}
+		bool binned = false;
+		for (; it != drawCalls.end() && (*it)->getType() != DrawCall::DrawCall_Blitting; ++it) {
+			Common::Rect region = c->_enableDirtyRectangles ? (*it)->getDirtyRegion() : frame;
+			region.clip(frame);
+			if (region.isEmpty())
+				continue;
+
+			for (int tile = region.top / kTileHeight; tile <= (region.bottom - 1) / kTileHeight; tile++) {
+				_bins[tile].push_back(*it);
+			}
+			binned = true;
+		}
+
+		if (binned) {
+			executeRun();
+		}
+
+		if (it == drawCalls.end())
+			break;
+
+		// Blits render through the current context
+		Common::Rect blitRegion = (*it)->getDirtyRegion();
+		for (uint i = 0; i < _regions.size(); i++) {
+			if (!c->_enableDirtyRectangles || _regions[i].intersects(blitRegion)) {
+				(*it)->execute(_regions[i], true);
+			}
+		}
+		++it;
+	}
+}
+
+void TileRasterizer::executeRun() {
+	Run runs[Common::JobSystem::kMaxWorkers + 1];
+	Common::JobGroup group;
+
+	for (uint i = 0; i < _laneCount; i++) {
+		runs[i].rasterizer = this;
+		runs[i].lane = i;
+		JobSys.addJob(group, runLane, &runs[i]);
+	}
+	JobSys.wait(group);
+}
+
+void TileRasterizer::runLane(void *param) {
+	Run *run = (Run *)param;
+	TileRasterizer *rasterizer = run->rasterizer;
+
+	// Interleave the tiles, so the lanes share the busy parts of the screen
+	for (uint tile = run->lane; tile < rasterizer->_tiles.size(); tile += rasterizer->_laneCount) {
+		rasterizer->executeTile(rasterizer->_lanes[run->lane], tile);
+	}
+}
+
+void TileRasterizer::executeTile(Lane &lane, uint tile) {
+	const Common::Array<const DrawCall *> &bin = _bins[tile];
+
+	for (uint i = 0; i < bin.size(); i++) {
+		const DrawCall *drawCall = bin[i];
+		for (uint j = 0; j < _regions.size(); j++) {
+			Common::Rect tileRegion = _regions[j].findIntersectingRect(_tiles[tile]);
+			if (tileRegion.isEmpty())
+				continue;
+			if (lane.context->_enableDirtyRectangles && !tileRegion.intersects(drawCall->getDirtyRegion()))
+				continue;
+
+			switch (drawCall->getType()) {
+			case DrawCall::DrawCall_Rasterization:
+				((const RasterizationDrawCall *)drawCall)->executeTile(lane.context, lane.vertices, tileRegion);
+				break;
+			case DrawCall::DrawCall_Clear:
+				((const ClearBufferDrawCall *)drawCall)->executeTile(lane.context, tileRegion);
+				break;
+			default:
+				break;
+			}
+		}
+	}
+}
+
 } // end of namespace TinyGL
@@ -25,6 +25,7 @@
 #include "common/types.h"
 #include "common/rect.h"
 #include "common/array.h"
+#include "common/list.h"
 
 #include "graphics/tinygl/zblit.h"
 
@@ -37,6 +38,7 @@ void *allocateFrame(int size);
 struct GLContext;
 struct GLVertex;
 struct GLTexture;
+struct FrameBuffer;
 
 class DrawCall {
 public:
@@ -70,6 +72,8 @@ public:
 	bool operator==(const ClearBufferDrawCall &other) const;
 	virtual void execute(bool restoreState) const;
 	virtual void execute(const Common::Rect &clippingRectangle, bool restoreState) const;
+	// Clear exactly the given rectangle of the frame buffer of context c.
+	void executeTile(GLContext *c, const Common::Rect &tileRectangle) const;
 
 	void *operator new(size_t size) {
 		return Internal::allocateFrame(size);
@@ -89,6 +93,11 @@ public:
 	bool operator==(const RasterizationDrawCall &other) const;
 	virtual void execute(bool restoreState) const;
 	virtual void execute(const Common::Rect &clippingRectangle, bool restoreState) const;
+	// Rasterize into the given rectangle with context c, which does not need
+	// to be the current context. The vertices are copied to vertexScratch
+	// first, as rasterizing modifies them.
+	void executeTile(GLContext *c, GLVertex *vertexScratch, const Common::Rect &tileRectangle) const;
+	int getVertexCount() const { return _vertexCount; }
 
 	void *operator new(size_t size) {
 		return Internal::allocateFrame(size);
@@ -96,6 +105,7 @@ public:
 
 	void operator delete(void *p) { }
 private:
+	void execute(GLContext *c, GLVertex *vertex, bool restoreState) const;
 	void computeDirtyRegion();
 	typedef void (*gl_draw_triangle_func_ptr)(GLContext *c, TinyGL::GLVertex *p0, TinyGL::GLVertex *p1, TinyGL::GLVertex *p2);
 	int _vertexCount;
@@ -152,8 +162,8 @@ private:
 
 	RasterizationState _state;
 
-	RasterizationState captureState() const;
-	void applyState(const RasterizationState &state) const;
+	RasterizationState captureState(const GLContext *c) const;
+	void applyState(GLContext *c, const RasterizationState &state) const;
 };
 
 // Encapsulate a blit call: it might execute either a color buffer or z buffer blit.
@@ -210,6 +220,51 @@ private:
 	BlittingState _blitState;
 };
 
+// Executes a frame's draw calls in parallel over horizontal tiles of the
+// frame buffer. Each lane has its own context and frame buffer state, and
+// only writes to the rows of its tiles. Blits use the current context, so
+// they are executed serially between the parallel runs of other draw calls.
+class TileRasterizer {
+public:
+	TileRasterizer();
+	~TileRasterizer();
+
+	// Whether the draw calls of c can be rasterized in parallel.
+	bool isAvailable(const GLContext *c) const;
+
+	// Execute drawCalls clipped to each of regions, like executing each
+	// draw call on each region it intersects in order.
+	void execute(GLContext *c, const Common::List<DrawCall *> &drawCalls, const Common::Array<Common::Rect> &regions);
+
+private:
+	enum {
+		kTileHeight = 32
+	};
+
+	struct Lane {
+		GLContext *context;
+		FrameBuffer *fb;
+		GLVertex *vertices;
+		int vertexMax;
+	};
+
+	struct Run {
+		TileRasterizer *rasterizer;
+		uint lane;
+	};
+
+	static void runLane(void *param);
+	void prepareLanes(GLContext *c, uint laneCount);
+	void executeRun();
+	void executeTile(Lane &lane, uint tile);
+
+	Common::Array<Lane> _lanes;
+	Common::Array<Common::Array<const DrawCall *> > _bins;
+	Common::Array<Common::Rect> _regions;
+	Common::Array<Common::Rect> _tiles;
+	uint _laneCount;
+};
+
 } // end of namespace TinyGL
 
 #endif
@@ -466,6 +466,7 @@ struct GLContext {
 	LinearAllocator _drawCallAllocator[2];
 	bool _debugRectsEnabled;
 	bool _profilingEnabled;
+	TileRasterizer *_tileRasterizer;
 
 	void gl_vertex_transform(GLVertex *v);
 	void gl_calc_fog_factor(GLVertex *v);
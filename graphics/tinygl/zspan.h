@@ -0,0 +1,79 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef GRAPHICS_TINYGL_ZSPAN_H
+#define GRAPHICS_TINYGL_ZSPAN_H
+
+#include "common/scummsys.h"
+
+namespace Graphics {
+struct PixelFormat;
+}
+
+namespace TinyGL {
+
+/**
+ * A run of kLength shaded pixels in a 32bpp frame buffer with 8 bit
+ * components. The span kernels depth test the pixels, blend them and write
+ * colour and depth with the same results as FrameBuffer::writePixel().
+ */
+struct SpanArgs {
+	enum {
+		kLength = 8
+	};
+
+	uint32 *pbuf;         ///< Colour of the first pixel
+	uint *zbuf;           ///< Depth of the first pixel
+	const uint32 *colors; ///< Source colours as ARGB8888
+	uint z;               ///< Depth of the first pixel, below 2^30 for the whole span
+	int dzdx;
+
+	int depthFunc;        ///< TGL_ALWAYS when the depth test is disabled
+	bool depthWrite;
+	bool blending;        ///< Blend with TGL_SRC_ALPHA, TGL_ONE_MINUS_SRC_ALPHA
+	byte aShift, rShift, gShift, bShift;
+	uint32 aMask;         ///< Alpha bits of the pixel format, 0 if it has none
+};
+
+typedef void (*SpanFunc)(const SpanArgs &args);
+
+#ifdef SCUMMVM_SSE2
+void fillSpanSSE2(const SpanArgs &args);
+#endif
+#ifdef SCUMMVM_AVX2
+void fillSpanAVX2(const SpanArgs &args);
+#endif
+
+/**
+ * Pick the fastest span kernel supported by the CPU for a frame buffer
+ * format. Returns nullptr if the format has no kernel.
+ */
+SpanFunc selectSpanFunc(const Graphics::PixelFormat &format);
+
+/**
+ * Use this kernel for new frame buffers instead of asking the backend which
+ * instruction sets the CPU supports. Meant for tests.
+ */
+void setCPUSpanFunc(SpanFunc func);
+
+} // end of namespace TinyGL
+
+#endif
@@ -0,0 +1,126 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#include "graphics/tinygl/gl.h"
+#include "graphics/tinygl/zspan.h"
+
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+namespace TinyGL {
+
+namespace {
+
+static inline __m256i component(__m256i px, __m128i shift) {
+	return _mm256_and_si256(_mm256_srl_epi32(px, shift), _mm256_set1_epi32(0xFF));
+}
+
+// (x * y) >> 8 for 32 bit lanes holding bytes
+static inline __m256i mul8(__m256i x, __m256i y) {
+	return _mm256_srli_epi32(_mm256_mullo_epi16(x, y), 8);
+}
+
+// The same as FrameBuffer::compareDepth(), comparing unsigned depths
+static inline __m256i depthTest(__m256i z, __m256i zDst, int func) {
+	const __m256i bias = _mm256_set1_epi32((int)0x80000000);
+	const __m256i zb = _mm256_xor_si256(z, bias);
+	const __m256i zDstb = _mm256_xor_si256(zDst, bias);
+	const __m256i ones = _mm256_set1_epi32(-1);
+
+	switch (func) {
+	case TGL_NEVER:
+		return _mm256_setzero_si256();
+	case TGL_LESS:
+		return _mm256_cmpgt_epi32(zb, zDstb);
+	case TGL_EQUAL:
+		return _mm256_cmpeq_epi32(zDst, z);
+	case TGL_LEQUAL:
+		return _mm256_xor_si256(_mm256_cmpgt_epi32(zDstb, zb), ones);
+	case TGL_GREATER:
+		return _mm256_cmpgt_epi32(zDstb, zb);
+	case TGL_NOTEQUAL:
+		return _mm256_xor_si256(_mm256_cmpeq_epi32(zDst, z), ones);
+	case TGL_GEQUAL:
+		return _mm256_xor_si256(_mm256_cmpgt_epi32(zb, zDstb), ones);
+	default:
+		return ones;
+	}
+}
+
+} // End of anonymous namespace
+
+void fillSpanAVX2(const SpanArgs &args) {
+	const __m128i aShift = _mm_cvtsi32_si128(args.aShift);
+	const __m128i rShift = _mm_cvtsi32_si128(args.rShift);
+	const __m128i gShift = _mm_cvtsi32_si128(args.gShift);
+	const __m128i bShift = _mm_cvtsi32_si128(args.bShift);
+	const __m256i aMask = _mm256_set1_epi32(args.aMask);
+
+	const __m256i z = _mm256_add_epi32(_mm256_set1_epi32(args.z),
+	                                   _mm256_mullo_epi32(_mm256_set1_epi32(args.dzdx), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+	const __m256i zDst = _mm256_loadu_si256((const __m256i *)args.zbuf);
+	const __m256i pass = depthTest(z, zDst, args.depthFunc);
+
+	const __m256i src = _mm256_loadu_si256((const __m256i *)args.colors);
+	const __m256i dst = _mm256_loadu_si256((const __m256i *)args.pbuf);
+	__m256i sA = _mm256_srli_epi32(src, 24);
+	__m256i sR = _mm256_and_si256(_mm256_srli_epi32(src, 16), _mm256_set1_epi32(0xFF));
+	__m256i sG = _mm256_and_si256(_mm256_srli_epi32(src, 8), _mm256_set1_epi32(0xFF));
+	__m256i sB = _mm256_and_si256(src, _mm256_set1_epi32(0xFF));
+
+	__m256i out;
+	if (args.blending) {
+		const __m256i invA = _mm256_sub_epi32(_mm256_set1_epi32(255), sA);
+		const __m256i max = _mm256_set1_epi32(255);
+		sR = _mm256_min_epi32(_mm256_add_epi32(mul8(sR, sA), mul8(component(dst, rShift), invA)), max);
+		sG = _mm256_min_epi32(_mm256_add_epi32(mul8(sG, sA), mul8(component(dst, gShift), invA)), max);
+		sB = _mm256_min_epi32(_mm256_add_epi32(mul8(sB, sA), mul8(component(dst, bShift), invA)), max);
+		out = aMask;
+	} else {
+		out = _mm256_and_si256(_mm256_sll_epi32(sA, aShift), aMask);
+	}
+	out = _mm256_or_si256(out, _mm256_sll_epi32(sR, rShift));
+	out = _mm256_or_si256(out, _mm256_sll_epi32(sG, gShift));
+	out = _mm256_or_si256(out, _mm256_sll_epi32(sB, bShift));
+	_mm256_storeu_si256((__m256i *)args.pbuf, _mm256_blendv_epi8(dst, out, pass));
+
+	if (args.depthWrite) {
+		// writePixel() stores the depth through a float
+		const __m256i zOut = _mm256_cvttps_epi32(_mm256_cvtepi32_ps(z));
+		_mm256_storeu_si256((__m256i *)args.zbuf, _mm256_blendv_epi8(zDst, zOut, pass));
+	}
+}
+
+} // end of namespace TinyGL
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
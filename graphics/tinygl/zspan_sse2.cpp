@@ -0,0 +1,143 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#include "graphics/tinygl/gl.h"
+#include "graphics/tinygl/zspan.h"
+
+#include <emmintrin.h>
+
+#if !defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("sse2"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#endif
+
+#endif // !defined(__x86_64__)
+
+namespace TinyGL {
+
+namespace {
+
+static inline __m128i component(__m128i px, __m128i shift) {
+	return _mm_and_si128(_mm_srl_epi32(px, shift), _mm_set1_epi32(0xFF));
+}
+
+// (x * y) >> 8 for 32 bit lanes holding bytes
+static inline __m128i mul8(__m128i x, __m128i y) {
+	return _mm_srli_epi32(_mm_mullo_epi16(x, y), 8);
+}
+
+// The same as FrameBuffer::compareDepth(), comparing unsigned depths
+static inline __m128i depthTest(__m128i z, __m128i zDst, int func) {
+	const __m128i bias = _mm_set1_epi32((int)0x80000000);
+	const __m128i zb = _mm_xor_si128(z, bias);
+	const __m128i zDstb = _mm_xor_si128(zDst, bias);
+	const __m128i ones = _mm_set1_epi32(-1);
+
+	switch (func) {
+	case TGL_NEVER:
+		return _mm_setzero_si128();
+	case TGL_LESS:
+		return _mm_cmplt_epi32(zDstb, zb);
+	case TGL_EQUAL:
+		return _mm_cmpeq_epi32(zDst, z);
+	case TGL_LEQUAL:
+		return _mm_xor_si128(_mm_cmpgt_epi32(zDstb, zb), ones);
+	case TGL_GREATER:
+		return _mm_cmpgt_epi32(zDstb, zb);
+	case TGL_NOTEQUAL:
+		return _mm_xor_si128(_mm_cmpeq_epi32(zDst, z), ones);
+	case TGL_GEQUAL:
+		return _mm_xor_si128(_mm_cmplt_epi32(zDstb, zb), ones);
+	default:
+		return ones;
+	}
+}
+
+static inline __m128i select(__m128i mask, __m128i a, __m128i b) {
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+static void fillSpan4(const SpanArgs &args, int offset) {
+	const __m128i aShift = _mm_cvtsi32_si128(args.aShift);
+	const __m128i rShift = _mm_cvtsi32_si128(args.rShift);
+	const __m128i gShift = _mm_cvtsi32_si128(args.gShift);
+	const __m128i bShift = _mm_cvtsi32_si128(args.bShift);
+	const __m128i aMask = _mm_set1_epi32(args.aMask);
+
+	const uint z0 = args.z + offset * args.dzdx;
+	const __m128i z = _mm_setr_epi32(z0, z0 + args.dzdx, z0 + 2 * args.dzdx, z0 + 3 * args.dzdx);
+	const __m128i zDst = _mm_loadu_si128((const __m128i *)(args.zbuf + offset));
+	const __m128i pass = depthTest(z, zDst, args.depthFunc);
+
+	const __m128i src = _mm_loadu_si128((const __m128i *)(args.colors + offset));
+	const __m128i dst = _mm_loadu_si128((const __m128i *)(args.pbuf + offset));
+	__m128i sA = _mm_srli_epi32(src, 24);
+	__m128i sR = _mm_and_si128(_mm_srli_epi32(src, 16), _mm_set1_epi32(0xFF));
+	__m128i sG = _mm_and_si128(_mm_srli_epi32(src, 8), _mm_set1_epi32(0xFF));
+	__m128i sB = _mm_and_si128(src, _mm_set1_epi32(0xFF));
+
+	__m128i out;
+	if (args.blending) {
+		const __m128i invA = _mm_sub_epi32(_mm_set1_epi32(255), sA);
+		const __m128i max = _mm_set1_epi32(255);
+		sR = _mm_min_epi16(_mm_add_epi32(mul8(sR, sA), mul8(component(dst, rShift), invA)), max);
+		sG = _mm_min_epi16(_mm_add_epi32(mul8(sG, sA), mul8(component(dst, gShift), invA)), max);
+		sB = _mm_min_epi16(_mm_add_epi32(mul8(sB, sA), mul8(component(dst, bShift), invA)), max);
+		out = aMask;
+	} else {
+		out = _mm_and_si128(_mm_sll_epi32(sA, aShift), aMask);
+	}
+	out = _mm_or_si128(out, _mm_sll_epi32(sR, rShift));
+	out = _mm_or_si128(out, _mm_sll_epi32(sG, gShift));
+	out = _mm_or_si128(out, _mm_sll_epi32(sB, bShift));
+	_mm_storeu_si128((__m128i *)(args.pbuf + offset), select(pass, out, dst));
+
+	if (args.depthWrite) {
+		// writePixel() stores the depth through a float
+		const __m128i zOut = _mm_cvttps_epi32(_mm_cvtepi32_ps(z));
+		_mm_storeu_si128((__m128i *)(args.zbuf + offset), select(pass, zOut, zDst));
+	}
+}
+
+} // End of anonymous namespace
+
+void fillSpanSSE2(const SpanArgs &args) {
+	fillSpan4(args, 0);
+	fillSpan4(args, 4);
+}
+
+} // end of namespace TinyGL
+
+#if !defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // !defined(__x86_64__)
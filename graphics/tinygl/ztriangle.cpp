@@ -147,6 +147,53 @@ void FrameBuffer::putPixelTexture(int fbOffset, const TexelBuffer *texture,
 	}
 }
 
+template <bool kDepthWrite, bool kSmoothMode, bool kEnableBlending, bool kDepthTestEnabled>
+void FrameBuffer::putSpanTexture(int fbOffset, const TexelBuffer *texture,
+                                 uint wrap_s, uint wrap_t, uint *pz,
+                                 uint &z, int &t, int &s, uint &r, uint &g, uint &b, uint &a,
+                                 int dzdx, int dsdx, int dtdx, int drdx, int dgdx, int dbdx, uint dadx) {
+	uint32 colors[SpanArgs::kLength];
+	for (int _a = 0; _a < SpanArgs::kLength; _a++) {
+		uint8 c_a, c_r, c_g, c_b;
+		texture->getARGBAt(wrap_s, wrap_t, s, t, c_a, c_r, c_g, c_b);
+		uint l_a = (a >> (ZB_POINT_ALPHA_BITS - 8));
+		uint l_r = (r >> (ZB_POINT_RED_BITS - 8));
+		uint l_g = (g >> (ZB_POINT_GREEN_BITS - 8));
+		uint l_b = (b >> (ZB_POINT_BLUE_BITS - 8));
+		c_a = (c_a * l_a) >> (ZB_POINT_ALPHA_BITS - 8);
+		c_r = (c_r * l_r) >> (ZB_POINT_RED_BITS - 8);
+		c_g = (c_g * l_g) >> (ZB_POINT_GREEN_BITS - 8);
+		c_b = (c_b * l_b) >> (ZB_POINT_BLUE_BITS - 8);
+		colors[_a] = (c_a << 24) | (c_r << 16) | (c_g << 8) | c_b;
+		s += dsdx;
+		t += dtdx;
+		if (kSmoothMode) {
+			a += dadx;
+			r += drdx;
+			g += dgdx;
+			b += dbdx;
+		}
+	}
+
+	SpanArgs args;
+	args.pbuf = (uint32 *)_pbuf + fbOffset;
+	args.zbuf = pz;
+	args.colors = colors;
+	args.z = z;
+	args.dzdx = dzdx;
+	args.depthFunc = kDepthTestEnabled ? _depthFunc : TGL_ALWAYS;
+	args.depthWrite = kDepthWrite;
+	args.blending = kEnableBlending;
+	args.aShift = _pbufFormat.aShift;
+	args.rShift = _pbufFormat.rShift;
+	args.gShift = _pbufFormat.gShift;
+	args.bShift = _pbufFormat.bShift;
+	args.aMask = _pbufFormat.aLoss == 8 ? 0 : 0xFFu << _pbufFormat.aShift;
+	_spanFunc(args);
+
+	z += SpanArgs::kLength * dzdx;
+}
+
 template <bool kDepthWrite, bool kEnableScissor, bool kStencilEnabled, bool kStippleEnabled, bool kDepthTestEnabled>
 void FrameBuffer::putPixelDepth(uint *pz, byte *ps, int _a, int x, int y, uint &z, int &dzdx) {
 	if (kEnableScissor && scissorPixel(x + _a, y)) {
@@ -339,12 +386,18 @@ void FrameBuffer::fillTriangle(ZBufferPoint *p0, ZBufferPoint *p1, ZBufferPoint
 		a1 = p2->a;
 	}
 
+	// The span kernels cover the usual state of textured triangles
+	bool useSpanFunc = false;
 	if (kInterpRGB && (kInterpST || kInterpSTZ)) {
 		texture = _currentTexture;
 		fdzdx = (float)dzdx;
 		fndzdx = NB_INTERP * fdzdx;
 		ndszdx = NB_INTERP * dszdx;
 		ndtzdx = NB_INTERP * dtzdx;
+
+		useSpanFunc = _spanFunc && NB_INTERP == SpanArgs::kLength && kInterpZ &&
+		              !kFogMode && !kAlphaTestEnabled && !kStencilEnabled &&
+		              (!kBlendingEnabled || (_sourceBlendingFactor == TGL_SRC_ALPHA && _destinationBlendingFactor == TGL_ONE_MINUS_SRC_ALPHA));
 	}
 
 	if (fz0 > 0) {
@@ -445,8 +498,14 @@ void FrameBuffer::fillTriangle(ZBufferPoint *p0, ZBufferPoint *p1, ZBufferPoint
 
 		// we draw all the scan line of the part
 		while (nb_lines > 0) {
+			// the rest of the triangle is below the scissor rectangle
+			if (kEnableScissor && y >= _clipRectangle.bottom)
+				return;
+
 			int x = x1;
-			if (!kInterpRGB) {
+			if (kEnableScissor && y < _clipRectangle.top) {
+				// the scan line is above the scissor rectangle, only step the edges
+			} else if (!kInterpRGB) {
 				int n;
 				uint *pz;
 				byte *ps = nullptr;
@@ -579,9 +638,17 @@ void FrameBuffer::fillTriangle(ZBufferPoint *p0, ZBufferPoint *p1, ZBufferPoint
 						fz += fndzdx;
 						zinv = (float)(1.0 / fz);
 					}
-					for (int _a = 0; _a < NB_INTERP; _a++) {
-						putPixelTexture<kDepthWrite, kInterpRGB, kSmoothMode, kFogMode, kAlphaTestEnabled, kEnableScissor, kBlendingEnabled, kStencilEnabled, kDepthTestEnabled>
-						               (pp, texture, _wrapS, _wrapT, pz, ps, _a, x, y, z, t, s, r, g, b, a, dzdx, dsdx, dtdx, drdx, dgdx, dbdx, dadx, fog, fog_r, fog_g, fog_b, dfdx);
+					// The kernels take whole spans inside the scissor rectangle, with depths below 2^30
+					const uint zEnd = z + (NB_INTERP - 1) * dzdx;
+					if (useSpanFunc && (z | zEnd) < (1u << 30) &&
+					    (!kEnableScissor || (x >= _clipRectangle.left && x + NB_INTERP <= _clipRectangle.right))) {
+						putSpanTexture<kDepthWrite, kSmoothMode, kBlendingEnabled, kDepthTestEnabled>
+						              (pp, texture, _wrapS, _wrapT, pz, z, t, s, r, g, b, a, dzdx, dsdx, dtdx, drdx, dgdx, dbdx, dadx);
+					} else {
+						for (int _a = 0; _a < NB_INTERP; _a++) {
+							putPixelTexture<kDepthWrite, kInterpRGB, kSmoothMode, kFogMode, kAlphaTestEnabled, kEnableScissor, kBlendingEnabled, kStencilEnabled, kDepthTestEnabled>
+							               (pp, texture, _wrapS, _wrapT, pz, ps, _a, x, y, z, t, s, r, g, b, a, dzdx, dsdx, dtdx, drdx, dgdx, dbdx, dadx, fog, fog_r, fog_g, fog_b, dfdx);
+						}
 					}
 					pp += NB_INTERP;
 					if (kInterpZ) {
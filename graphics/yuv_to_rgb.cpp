@@ -82,8 +82,11 @@
 // BASIS, AND BROWN UNIVERSITY HAS NO OBLIGATION TO PROVIDE MAINTENANCE,
 // SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
 
+#include "common/jobs.h"
+#include "common/system.h"
 #include "graphics/surface.h"
 #include "graphics/yuv_to_rgb.h"
+#include "graphics/yuv_to_rgb_intern.h"
 
 namespace Common {
 DECLARE_SINGLETON(Graphics::YUVToRGBManager);
@@ -99,18 +102,32 @@ public:
 	YUVToRGBManager::LuminanceScale getScale() const { return _scale; }
 	const int16 *getColorTable() const { return _colorTab; }
 	const byte *getClipTable() const { return _clipTable; }
+	const YUVToRGBRowParams &getRowParams() const { return _rowParams; }
 
 private:
 	Graphics::PixelFormat _format;
 	YUVToRGBManager::LuminanceScale _scale;
 	int16 _colorTab[4 * 256]; // 2048 bytes
 	byte _clipTable[3 * 768];
+	YUVToRGBRowParams _rowParams;
 };
 
 YUVToRGBLookup::YUVToRGBLookup(Graphics::PixelFormat format, YUVToRGBManager::LuminanceScale scale) {
 	_format = format;
 	_scale = scale;
 
+	_rowParams.bytesPerPixel = format.bytesPerPixel;
+	_rowParams.itu = (scale == YUVToRGBManager::kScaleITU);
+	_rowParams.rLoss = format.rLoss;
+	_rowParams.gLoss = format.gLoss;
+	_rowParams.bLoss = format.bLoss;
+	_rowParams.aLoss = format.aLoss;
+	_rowParams.rShift = format.rShift;
+	_rowParams.gShift = format.gShift;
+	_rowParams.bShift = format.bShift;
+	_rowParams.aShift = format.aShift;
+	_rowParams.aMask = (0xFF >> format.aLoss) << format.aShift;
+
 	// Generate the tables for the display surface
 
 	uint r_offset = 0;
@@ -182,20 +199,49 @@ YUVToRGBLookup::YUVToRGBLookup(Graphics::PixelFormat format, YUVToRGBManager::Lu
 }
 
 YUVToRGBManager::YUVToRGBManager() {
-	_lookup = 0;
+	_rowFuncs = nullptr;
+	_rowFuncsSelected = false;
+	_multiThreaded = true;
 }
 
 YUVToRGBManager::~YUVToRGBManager() {
-	delete _lookup;
+	for (uint i = 0; i < _lookups.size(); i++)
+		delete _lookups[i];
+}
+
+void YUVToRGBManager::selectRowFuncs() {
+	_rowFuncsSelected = true;
+	_rowFuncs = nullptr;
+
+	// The manager may be used by tools without a backend
+	if (!g_system)
+		return;
+
+#ifdef SCUMMVM_NEON
+	if (g_system->hasFeature(OSystem::kFeatureCpuNEON))
+		_rowFuncs = &yuvToRGBRowFuncsNEON;
+#endif
+#ifdef SCUMMVM_SSE2
+	if (g_system->hasFeature(OSystem::kFeatureCpuSSE2))
+		_rowFuncs = &yuvToRGBRowFuncsSSE2;
+#endif
+#ifdef SCUMMVM_AVX2
+	if (g_system->hasFeature(OSystem::kFeatureCpuAVX2))
+		_rowFuncs = &yuvToRGBRowFuncsAVX2;
+#endif
 }
 
 const YUVToRGBLookup *YUVToRGBManager::getLookup(Graphics::PixelFormat format, YUVToRGBManager::LuminanceScale scale) {
-	if (_lookup && _lookup->getFormat() == format && _lookup->getScale() == scale)
-		return _lookup;
+	Common::StackLock lock(_mutex);
+
+	for (uint i = 0; i < _lookups.size(); i++) {
+		if (_lookups[i]->getFormat() == format && _lookups[i]->getScale() == scale)
+			return _lookups[i];
+	}
 
-	delete _lookup;
-	_lookup = new YUVToRGBLookup(format, scale);
-	return _lookup;
+	YUVToRGBLookup *lookup = new YUVToRGBLookup(format, scale);
+	_lookups.push_back(lookup);
+	return lookup;
 }
 
 #define PUT_PIXEL(s, d) \
@@ -203,7 +249,7 @@ const YUVToRGBLookup *YUVToRGBManager::getLookup(Graphics::PixelFormat format, Y
 	*((PixelInt *)(d)) = ((L[cr_r] << r_shift) | (L[crb_g] << g_shift) | (L[cb_b] << b_shift) | a_mask)
 
 template<typename PixelInt>
-void convertYUV444ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
+void convertYUV444ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup, const YUVToRGBRowFuncs *rowFuncs, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
 	// Keep the tables in pointers here to avoid a dereference on each pixel
 	const int16 *Cr_r_tab = lookup->getColorTable();
 	const int16 *Cr_g_tab = Cr_r_tab + 256;
@@ -217,7 +263,16 @@ void convertYUV444ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup
 	const PixelInt a_mask = (0xFF >> lookup->getFormat().aLoss) << lookup->getFormat().aShift;
 
 	for (int h = 0; h < yHeight; h++) {
-		for (int w = 0; w < yWidth; w++) {
+		int w = 0;
+		if (rowFuncs) {
+			w = rowFuncs->row444(dstPtr, ySrc, uSrc, vSrc, yWidth, lookup->getRowParams());
+			dstPtr += w * sizeof(PixelInt);
+			ySrc += w;
+			uSrc += w;
+			vSrc += w;
+		}
+
+		for (; w < yWidth; w++) {
 			const byte *L;
 
 			int16 cr_r  = Cr_r_tab[*vSrc];
@@ -244,17 +299,11 @@ void YUVToRGBManager::convert444(Graphics::Surface *dst, YUVToRGBManager::Lumina
 	assert(dst->format.bytesPerPixel == 2 || dst->format.bytesPerPixel == 4);
 	assert(ySrc && uSrc && vSrc);
 
-	const YUVToRGBLookup *lookup = getLookup(dst->format, scale);
-
-	// Use a templated function to avoid an if check on every pixel
-	if (dst->format.bytesPerPixel == 2)
-		convertYUV444ToRGB<uint16>((byte *)dst->getPixels(), dst->pitch, lookup, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
-	else
-		convertYUV444ToRGB<uint32>((byte *)dst->getPixels(), dst->pitch, lookup, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
+	convert(kConvert444, dst, scale, ySrc, uSrc, vSrc, nullptr, yWidth, yHeight, yPitch, uvPitch);
 }
 
 template<typename PixelInt>
-void convertYUV422ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
+void convertYUV422ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup, const YUVToRGBRowFuncs *rowFuncs, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
 	int halfWidth = yWidth >> 1;
 
 	// Keep the tables in pointers here to avoid a dereference on each pixel
@@ -270,7 +319,17 @@ void convertYUV422ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup
 	const PixelInt a_mask = (0xFF >> lookup->getFormat().aLoss) << lookup->getFormat().aShift;
 
 	for (int h = 0; h < yHeight; h++) {
-		for (int w = 0; w < halfWidth; w++) {
+		int w = 0;
+		if (rowFuncs) {
+			int done = rowFuncs->row422(dstPtr, nullptr, ySrc, nullptr, nullptr, nullptr, uSrc, vSrc, yWidth, lookup->getRowParams());
+			dstPtr += done * sizeof(PixelInt);
+			ySrc += done;
+			w = done >> 1;
+			uSrc += w;
+			vSrc += w;
+		}
+
+		for (; w < halfWidth; w++) {
 			const byte *L;
 
 			int16 cr_r  = Cr_r_tab[*vSrc];
@@ -301,17 +360,11 @@ void YUVToRGBManager::convert422(Graphics::Surface *dst, YUVToRGBManager::Lumina
 	assert(ySrc && uSrc && vSrc);
 	assert((yWidth & 1) == 0);
 
-	const YUVToRGBLookup *lookup = getLookup(dst->format, scale);
-
-	// Use a templated function to avoid an if check on every pixel
-	if (dst->format.bytesPerPixel == 2)
-		convertYUV422ToRGB<uint16>((byte *)dst->getPixels(), dst->pitch, lookup, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
-	else
-		convertYUV422ToRGB<uint32>((byte *)dst->getPixels(), dst->pitch, lookup, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
+	convert(kConvert422, dst, scale, ySrc, uSrc, vSrc, nullptr, yWidth, yHeight, yPitch, uvPitch);
 }
 
 template<typename PixelInt>
-void convertYUV420ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
+void convertYUV420ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup, const YUVToRGBRowFuncs *rowFuncs, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
 	int halfHeight = yHeight >> 1;
 	int halfWidth = yWidth >> 1;
 
@@ -328,7 +381,17 @@ void convertYUV420ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup
 	const PixelInt a_mask = (0xFF >> lookup->getFormat().aLoss) << lookup->getFormat().aShift;
 
 	for (int h = 0; h < halfHeight; h++) {
-		for (int w = 0; w < halfWidth; w++) {
+		int w = 0;
+		if (rowFuncs) {
+			int done = rowFuncs->row422(dstPtr, dstPtr + dstPitch, ySrc, ySrc + yPitch, nullptr, nullptr, uSrc, vSrc, yWidth, lookup->getRowParams());
+			dstPtr += done * sizeof(PixelInt);
+			ySrc += done;
+			w = done >> 1;
+			uSrc += w;
+			vSrc += w;
+		}
+
+		for (; w < halfWidth; w++) {
 			const byte *L;
 
 			int16 cr_r  = Cr_r_tab[*vSrc];
@@ -362,13 +425,7 @@ void YUVToRGBManager::convert420(Graphics::Surface *dst, YUVToRGBManager::Lumina
 	assert((yWidth & 1) == 0);
 	assert((yHeight & 1) == 0);
 
-	const YUVToRGBLookup *lookup = getLookup(dst->format, scale);
-
-	// Use a templated function to avoid an if check on every pixel
-	if (dst->format.bytesPerPixel == 2)
-		convertYUV420ToRGB<uint16>((byte *)dst->getPixels(), dst->pitch, lookup, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
-	else
-		convertYUV420ToRGB<uint32>((byte *)dst->getPixels(), dst->pitch, lookup, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
+	convert(kConvert420, dst, scale, ySrc, uSrc, vSrc, nullptr, yWidth, yHeight, yPitch, uvPitch);
 }
 
 #define PUT_PIXELA(s, a, d) \
@@ -376,7 +433,7 @@ void YUVToRGBManager::convert420(Graphics::Surface *dst, YUVToRGBManager::Lumina
 	*((PixelInt *)(d)) = ((L[cr_r] << r_shift) | (L[crb_g] << g_shift) | (L[cb_b] << b_shift) | ((a >> a_loss) << a_shift))
 
 template<typename PixelInt>
-void convertYUVA420ToRGBA(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup, const byte *ySrc, const byte *uSrc, const byte *vSrc, const byte *aSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
+void convertYUVA420ToRGBA(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup, const YUVToRGBRowFuncs *rowFuncs, const byte *ySrc, const byte *uSrc, const byte *vSrc, const byte *aSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
 	int halfHeight = yHeight >> 1;
 	int halfWidth = yWidth >> 1;
 
@@ -394,7 +451,18 @@ void convertYUVA420ToRGBA(byte *dstPtr, int dstPitch, const YUVToRGBLookup *look
 	const byte a_loss = lookup->getFormat().aLoss;
 
 	for (int h = 0; h < halfHeight; h++) {
-		for (int w = 0; w < halfWidth; w++) {
+		int w = 0;
+		if (rowFuncs) {
+			int done = rowFuncs->row422(dstPtr, dstPtr + dstPitch, ySrc, ySrc + yPitch, aSrc, aSrc + yPitch, uSrc, vSrc, yWidth, lookup->getRowParams());
+			dstPtr += done * sizeof(PixelInt);
+			ySrc += done;
+			aSrc += done;
+			w = done >> 1;
+			uSrc += w;
+			vSrc += w;
+		}
+
+		for (; w < halfWidth; w++) {
 			const byte *L;
 
 			int16 cr_r  = Cr_r_tab[*vSrc];
@@ -431,13 +499,7 @@ void YUVToRGBManager::convert420Alpha(Graphics::Surface *dst, YUVToRGBManager::L
 	assert((yWidth & 1) == 0);
 	assert((yHeight & 1) == 0);
 
-	const YUVToRGBLookup *lookup = getLookup(dst->format, scale);
-
-	// Use a templated function to avoid an if check on every pixel
-	if (dst->format.bytesPerPixel == 2)
-		convertYUVA420ToRGBA<uint16>((byte *)dst->getPixels(), dst->pitch, lookup, ySrc, uSrc, vSrc, aSrc, yWidth, yHeight, yPitch, uvPitch);
-	else
-		convertYUVA420ToRGBA<uint32>((byte *)dst->getPixels(), dst->pitch, lookup, ySrc, uSrc, vSrc, aSrc, yWidth, yHeight, yPitch, uvPitch);
+	convert(kConvert420Alpha, dst, scale, ySrc, uSrc, vSrc, aSrc, yWidth, yHeight, yPitch, uvPitch);
 }
 
 #define READ_QUAD(ptr, prefix) \
@@ -465,7 +527,7 @@ void YUVToRGBManager::convert420Alpha(Graphics::Surface *dst, YUVToRGBManager::L
 	xDiff++
 
 template<typename PixelInt>
-void convertYUV410ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
+void convertYUV410ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup, const YUVToRGBRowFuncs *rowFuncs, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
 	// Keep the tables in pointers here to avoid a dereference on each pixel
 	const int16 *Cr_r_tab = lookup->getColorTable();
 	const int16 *Cr_g_tab = Cr_r_tab + 256;
@@ -481,7 +543,15 @@ void convertYUV410ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup
 	int quarterWidth = yWidth >> 2;
 
 	for (int y = 0; y < yHeight; y++) {
-		for (int x = 0; x < quarterWidth; x++) {
+		int x = 0;
+		if (rowFuncs) {
+			int done = rowFuncs->row410(dstPtr, ySrc, uSrc + (y >> 2) * uvPitch, vSrc + (y >> 2) * uvPitch, uvPitch, y & 3, yWidth, lookup->getRowParams());
+			dstPtr += done * sizeof(PixelInt);
+			ySrc += done;
+			x = done >> 2;
+		}
+
+		for (; x < quarterWidth; x++) {
 			// Perform bilinear interpolation on the chroma values
 			// Based on the algorithm found here: http://tech-algorithm.com/articles/bilinear-image-scaling/
 			// Feel free to optimize further
@@ -521,13 +591,107 @@ void YUVToRGBManager::convert410(Graphics::Surface *dst, YUVToRGBManager::Lumina
 	assert((yWidth & 3) == 0);
 	assert((yHeight & 3) == 0);
 
-	const YUVToRGBLookup *lookup = getLookup(dst->format, scale);
+	convert(kConvert410, dst, scale, ySrc, uSrc, vSrc, nullptr, yWidth, yHeight, yPitch, uvPitch);
+}
+
+// Minimum number of pixels per band, smaller conversions are not split
+static const int kMinBandPixels = 32 * 1024;
+
+struct YUVToRGBManager::ConvertBand {
+	ConvertType type;
+	byte *dstPtr;
+	int dstPitch;
+	uint bytesPerPixel;
+	const YUVToRGBLookup *lookup;
+	const YUVToRGBRowFuncs *rowFuncs;
+	const byte *ySrc, *uSrc, *vSrc, *aSrc;
+	int yWidth, yPitch, uvPitch;
+	int lumaRowsPerUnit; // luminance rows sharing a single chroma row
+
+	template<typename PixelInt>
+	void convert(uint begin, uint end) const {
+		byte *dst = dstPtr + begin * lumaRowsPerUnit * dstPitch;
+		const byte *y = ySrc + begin * lumaRowsPerUnit * yPitch;
+		const byte *u = uSrc + begin * uvPitch;
+		const byte *v = vSrc + begin * uvPitch;
+		const int height = (end - begin) * lumaRowsPerUnit;
+
+		switch (type) {
+		case kConvert444:
+			convertYUV444ToRGB<PixelInt>(dst, dstPitch, lookup, rowFuncs, y, u, v, yWidth, height, yPitch, uvPitch);
+			break;
+		case kConvert422:
+			convertYUV422ToRGB<PixelInt>(dst, dstPitch, lookup, rowFuncs, y, u, v, yWidth, height, yPitch, uvPitch);
+			break;
+		case kConvert420:
+			convertYUV420ToRGB<PixelInt>(dst, dstPitch, lookup, rowFuncs, y, u, v, yWidth, height, yPitch, uvPitch);
+			break;
+		case kConvert420Alpha:
+			convertYUVA420ToRGBA<PixelInt>(dst, dstPitch, lookup, rowFuncs, y, u, v, aSrc + begin * lumaRowsPerUnit * yPitch, yWidth, height, yPitch, uvPitch);
+			break;
+		case kConvert410:
+			convertYUV410ToRGB<PixelInt>(dst, dstPitch, lookup, rowFuncs, y, u, v, yWidth, height, yPitch, uvPitch);
+			break;
+		}
+	}
+
+	static void run(void *param, uint begin, uint end) {
+		const ConvertBand *band = (const ConvertBand *)param;
+
+		// Use a templated function to avoid an if check on every pixel
+		if (band->bytesPerPixel == 2)
+			band->convert<uint16>(begin, end);
+		else
+			band->convert<uint32>(begin, end);
+	}
+};
+
+void YUVToRGBManager::convert(ConvertType type, Graphics::Surface *dst, LuminanceScale scale, const byte *ySrc, const byte *uSrc, const byte *vSrc, const byte *aSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
+	ConvertBand band;
+
+	// If no row converters have been selected yet, detect and select
+	_mutex.lock();
+	if (!_rowFuncsSelected)
+		selectRowFuncs();
+	band.rowFuncs = _rowFuncs;
+	_mutex.unlock();
+
+	band.type = type;
+	band.dstPtr = (byte *)dst->getPixels();
+	band.dstPitch = dst->pitch;
+	band.bytesPerPixel = dst->format.bytesPerPixel;
+	band.lookup = getLookup(dst->format, scale);
+	band.ySrc = ySrc;
+	band.uSrc = uSrc;
+	band.vSrc = vSrc;
+	band.aSrc = aSrc;
+	band.yWidth = yWidth;
+	band.yPitch = yPitch;
+	band.uvPitch = uvPitch;
+
+	switch (type) {
+	case kConvert420:
+	case kConvert420Alpha:
+		band.lumaRowsPerUnit = 2;
+		break;
+	case kConvert410:
+		band.lumaRowsPerUnit = 4;
+		break;
+	default:
+		band.lumaRowsPerUnit = 1;
+		break;
+	}
+
+	// Every band starts on a chroma row, so the bands can be converted
+	// independently of each other. The job system needs a backend.
+	const uint unitCount = yHeight / band.lumaRowsPerUnit;
+	if (!_multiThreaded || !g_system || yWidth <= 0) {
+		ConvertBand::run(&band, 0, unitCount);
+		return;
+	}
 
-	// Use a templated function to avoid an if check on every pixel
-	if (dst->format.bytesPerPixel == 2)
-		convertYUV410ToRGB<uint16>((byte *)dst->getPixels(), dst->pitch, lookup, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
-	else
-		convertYUV410ToRGB<uint32>((byte *)dst->getPixels(), dst->pitch, lookup, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
+	const uint minSlice = MAX(1, kMinBandPixels / (yWidth * band.lumaRowsPerUnit));
+	JobSys.parallelFor(unitCount, ConvertBand::run, &band, minSlice);
 }
 
 } // End of namespace Graphics
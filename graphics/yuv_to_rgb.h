@@ -38,12 +38,17 @@
 #define GRAPHICS_YUV_TO_RGB_H
 
 #include "common/scummsys.h"
+#include "common/array.h"
+#include "common/mutex.h"
 #include "common/singleton.h"
 #include "graphics/surface.h"
 
+class YUVToRGBTestSuite;
+
 namespace Graphics {
 
 class YUVToRGBLookup;
+struct YUVToRGBRowFuncs;
 
 class YUVToRGBManager : public Common::Singleton<YUVToRGBManager> {
 public:
@@ -135,14 +140,41 @@ public:
 	 */
 	void convert410(Graphics::Surface *dst, LuminanceScale scale, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch);
 
+	/**
+	 * Set whether large images are split into horizontal bands which are
+	 * converted in parallel on the job system. This is enabled by default.
+	 */
+	void setMultiThreaded(bool enable) { _multiThreaded = enable; }
+
 private:
 	friend class Common::Singleton<SingletonBaseType>;
+	friend class ::YUVToRGBTestSuite;
 	YUVToRGBManager();
 	~YUVToRGBManager();
 
-	const YUVToRGBLookup *getLookup(Graphics::PixelFormat format, LuminanceScale scale);
+	enum ConvertType {
+		kConvert444,
+		kConvert422,
+		kConvert420,
+		kConvert420Alpha,
+		kConvert410
+	};
 
-	YUVToRGBLookup *_lookup;
+	struct ConvertBand;
+
+	const YUVToRGBLookup *getLookup(Graphics::PixelFormat format, LuminanceScale scale);
+	void selectRowFuncs();
+	void convert(ConvertType type, Graphics::Surface *dst, LuminanceScale scale, const byte *ySrc, const byte *uSrc, const byte *vSrc, const byte *aSrc, int yWidth, int yHeight, int yPitch, int uvPitch);
+
+	// Videos may be converted on decode-ahead threads while others are
+	// converted on the main thread, so the lookup tables are never replaced:
+	// there is one per format and scale, kept until the manager is destroyed.
+	// _mutex protects them and the row converter selection.
+	Common::Mutex _mutex;
+	Common::Array<YUVToRGBLookup *> _lookups;
+	const YUVToRGBRowFuncs *_rowFuncs;
+	bool _rowFuncsSelected;
+	bool _multiThreaded;
 };
  /** @} */
 } // End of namespace Graphics
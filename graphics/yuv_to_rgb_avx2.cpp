@@ -0,0 +1,234 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#include "graphics/yuv_to_rgb_intern.h"
+
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+namespace Graphics {
+
+namespace {
+
+// sign(n) * (whole * |n| + ((|n| * frac) >> 16)), see yuv_to_rgb_intern.h
+template<bool whole>
+static inline __m256i mulTrunc(__m256i n, int frac) {
+	const __m256i absN = _mm256_abs_epi16(n);
+	__m256i res = _mm256_mulhi_epu16(absN, _mm256_set1_epi16((short)frac));
+	if (whole)
+		res = _mm256_add_epi16(res, absN);
+	return _mm256_sign_epi16(res, n);
+}
+
+// Equivalent of the Cr_r_tab, Cr_g_tab + Cb_g_tab and Cb_b_tab lookups
+static inline void chroma(__m256i u, __m256i v, __m256i &crR, __m256i &crbG, __m256i &cbB) {
+	const __m256i cr = _mm256_sub_epi16(v, _mm256_set1_epi16(128));
+	const __m256i cb = _mm256_sub_epi16(u, _mm256_set1_epi16(128));
+	crR = mulTrunc<true>(cr, kYUVCrRFrac);
+	crbG = _mm256_sub_epi16(_mm256_setzero_si256(), _mm256_add_epi16(mulTrunc<false>(cr, kYUVCrGFrac), mulTrunc<false>(cb, kYUVCbGFrac)));
+	cbB = mulTrunc<true>(cb, kYUVCbBFrac);
+}
+
+static inline __m256i load16(const byte *src) {
+	return _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)src));
+}
+
+class PixelWriter {
+public:
+	PixelWriter(const YUVToRGBRowParams &params) : _bytesPerPixel(params.bytesPerPixel), _itu(params.itu) {
+		_rLoss = _mm_cvtsi32_si128(params.rLoss);
+		_gLoss = _mm_cvtsi32_si128(params.gLoss);
+		_bLoss = _mm_cvtsi32_si128(params.bLoss);
+		_aLoss = _mm_cvtsi32_si128(params.aLoss);
+		_rShift = _mm_cvtsi32_si128(params.rShift);
+		_gShift = _mm_cvtsi32_si128(params.gShift);
+		_bShift = _mm_cvtsi32_si128(params.bShift);
+		_aShift = _mm_cvtsi32_si128(params.aShift);
+		_aMask16 = _mm256_set1_epi16((short)params.aMask);
+		_aMask32 = _mm256_set1_epi32(params.aMask);
+		_min = _mm256_set1_epi16(_itu ? 16 : 0);
+		_max = _mm256_set1_epi16(_itu ? 235 : 255);
+	}
+
+	/** Write 16 pixels. If aSrc is nullptr, the alpha bits are fixed. */
+	inline void write(byte *dst, __m256i y, const byte *aSrc, __m256i crR, __m256i crbG, __m256i cbB) const {
+		const __m256i r = component(y, crR, _rLoss);
+		const __m256i g = component(y, crbG, _gLoss);
+		const __m256i b = component(y, cbB, _bLoss);
+
+		if (_bytesPerPixel == 2) {
+			__m256i px = _mm256_or_si256(_mm256_or_si256(_mm256_sll_epi16(r, _rShift), _mm256_sll_epi16(g, _gShift)), _mm256_sll_epi16(b, _bShift));
+			if (aSrc)
+				px = _mm256_or_si256(px, _mm256_sll_epi16(_mm256_srl_epi16(load16(aSrc), _aLoss), _aShift));
+			else
+				px = _mm256_or_si256(px, _aMask16);
+			_mm256_storeu_si256((__m256i *)dst, px);
+		} else {
+			__m256i lo = _mm256_or_si256(_mm256_or_si256(_mm256_sll_epi32(widenLo(r), _rShift), _mm256_sll_epi32(widenLo(g), _gShift)), _mm256_sll_epi32(widenLo(b), _bShift));
+			__m256i hi = _mm256_or_si256(_mm256_or_si256(_mm256_sll_epi32(widenHi(r), _rShift), _mm256_sll_epi32(widenHi(g), _gShift)), _mm256_sll_epi32(widenHi(b), _bShift));
+			if (aSrc) {
+				const __m256i a = _mm256_srl_epi16(load16(aSrc), _aLoss);
+				lo = _mm256_or_si256(lo, _mm256_sll_epi32(widenLo(a), _aShift));
+				hi = _mm256_or_si256(hi, _mm256_sll_epi32(widenHi(a), _aShift));
+			} else {
+				lo = _mm256_or_si256(lo, _aMask32);
+				hi = _mm256_or_si256(hi, _aMask32);
+			}
+			_mm256_storeu_si256((__m256i *)dst, lo);
+			_mm256_storeu_si256((__m256i *)(dst + 32), hi);
+		}
+	}
+
+private:
+	static inline __m256i widenLo(__m256i x) {
+		return _mm256_cvtepu16_epi32(_mm256_castsi256_si128(x));
+	}
+
+	static inline __m256i widenHi(__m256i x) {
+		return _mm256_cvtepu16_epi32(_mm256_extracti128_si256(x, 1));
+	}
+
+	// Equivalent of the clip table lookup
+	inline __m256i component(__m256i y, __m256i c, __m128i loss) const {
+		__m256i x = _mm256_min_epi16(_mm256_max_epi16(_mm256_add_epi16(y, c), _min), _max);
+		if (_itu) {
+			x = _mm256_sub_epi16(x, _min);
+			x = _mm256_add_epi16(x, _mm256_mulhi_epu16(x, _mm256_set1_epi16((short)kYUVITUFrac)));
+		}
+		return _mm256_srl_epi16(x, loss);
+	}
+
+	uint _bytesPerPixel;
+	bool _itu;
+	__m128i _rLoss, _gLoss, _bLoss, _aLoss;
+	__m128i _rShift, _gShift, _bShift, _aShift;
+	__m256i _aMask16, _aMask32;
+	__m256i _min, _max;
+};
+
+static int convertRow444(byte *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, int width, const YUVToRGBRowParams &params) {
+	const PixelWriter writer(params);
+	const int dstStep = 16 * params.bytesPerPixel;
+
+	int x = 0;
+	for (; x + 16 <= width; x += 16) {
+		__m256i crR, crbG, cbB;
+		chroma(load16(uSrc + x), load16(vSrc + x), crR, crbG, cbB);
+		writer.write(dst, load16(ySrc + x), nullptr, crR, crbG, cbB);
+		dst += dstStep;
+	}
+	return x;
+}
+
+static int convertRow422(byte *dst0, byte *dst1, const byte *y0, const byte *y1, const byte *a0, const byte *a1,
+                         const byte *uSrc, const byte *vSrc, int width, const YUVToRGBRowParams &params) {
+	const PixelWriter writer(params);
+	const int dstStep = 16 * params.bytesPerPixel;
+
+	int x = 0;
+	for (; x + 32 <= width; x += 32) {
+		__m256i crR, crbG, cbB;
+		chroma(load16(uSrc + x / 2), load16(vSrc + x / 2), crR, crbG, cbB);
+
+		// Every chroma sample covers two pixels. The unpacks work within
+		// 128-bit lanes, so the halves need to be put back in order.
+		__m256i lo = _mm256_unpacklo_epi16(crR, crR), hi = _mm256_unpackhi_epi16(crR, crR);
+		const __m256i crRLo = _mm256_permute2x128_si256(lo, hi, 0x20), crRHi = _mm256_permute2x128_si256(lo, hi, 0x31);
+		lo = _mm256_unpacklo_epi16(crbG, crbG);
+		hi = _mm256_unpackhi_epi16(crbG, crbG);
+		const __m256i crbGLo = _mm256_permute2x128_si256(lo, hi, 0x20), crbGHi = _mm256_permute2x128_si256(lo, hi, 0x31);
+		lo = _mm256_unpacklo_epi16(cbB, cbB);
+		hi = _mm256_unpackhi_epi16(cbB, cbB);
+		const __m256i cbBLo = _mm256_permute2x128_si256(lo, hi, 0x20), cbBHi = _mm256_permute2x128_si256(lo, hi, 0x31);
+
+		writer.write(dst0, load16(y0 + x), a0 ? a0 + x : nullptr, crRLo, crbGLo, cbBLo);
+		writer.write(dst0 + dstStep, load16(y0 + x + 16), a0 ? a0 + x + 16 : nullptr, crRHi, crbGHi, cbBHi);
+		dst0 += 2 * dstStep;
+
+		if (dst1) {
+			writer.write(dst1, load16(y1 + x), a1 ? a1 + x : nullptr, crRLo, crbGLo, cbBLo);
+			writer.write(dst1 + dstStep, load16(y1 + x + 16), a1 ? a1 + x + 16 : nullptr, crRHi, crbGHi, cbBHi);
+			dst1 += 2 * dstStep;
+		}
+	}
+	return x;
+}
+
+// Repeat each of four samples four times
+static inline __m256i repeat4(const byte *src) {
+	return _mm256_setr_epi16(src[0], src[0], src[0], src[0], src[1], src[1], src[1], src[1],
+	                         src[2], src[2], src[2], src[2], src[3], src[3], src[3], src[3]);
+}
+
+// Bilinear interpolation of the chroma for four 4 pixel wide quads
+static inline __m256i interpolate410(const byte *src, int uvPitch, __m256i xDiff, __m256i xInv, int yDiff) {
+	const __m256i a = repeat4(src);
+	const __m256i b = repeat4(src + 1);
+	const __m256i c = repeat4(src + uvPitch);
+	const __m256i d = repeat4(src + uvPitch + 1);
+
+	const __m256i top = _mm256_add_epi16(_mm256_mullo_epi16(a, xInv), _mm256_mullo_epi16(b, xDiff));
+	const __m256i bottom = _mm256_add_epi16(_mm256_mullo_epi16(c, xInv), _mm256_mullo_epi16(d, xDiff));
+	const __m256i sum = _mm256_add_epi16(_mm256_mullo_epi16(top, _mm256_set1_epi16(4 - yDiff)), _mm256_mullo_epi16(bottom, _mm256_set1_epi16(yDiff)));
+	return _mm256_srli_epi16(sum, 4);
+}
+
+static int convertRow410(byte *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, int uvPitch, int yDiff,
+                         int width, const YUVToRGBRowParams &params) {
+	const PixelWriter writer(params);
+	const int dstStep = 16 * params.bytesPerPixel;
+	const __m256i xDiff = _mm256_setr_epi16(0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3);
+	const __m256i xInv = _mm256_sub_epi16(_mm256_set1_epi16(4), xDiff);
+
+	int x = 0;
+	for (; x + 16 <= width; x += 16) {
+		__m256i crR, crbG, cbB;
+		chroma(interpolate410(uSrc + x / 4, uvPitch, xDiff, xInv, yDiff),
+		       interpolate410(vSrc + x / 4, uvPitch, xDiff, xInv, yDiff), crR, crbG, cbB);
+		writer.write(dst, load16(ySrc + x), nullptr, crR, crbG, cbB);
+		dst += dstStep;
+	}
+	return x;
+}
+
+} // End of anonymous namespace
+
+const YUVToRGBRowFuncs yuvToRGBRowFuncsAVX2 = {
+	convertRow444,
+	convertRow422,
+	convertRow410
+};
+
+} // End of namespace Graphics
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
@@ -0,0 +1,89 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef GRAPHICS_YUV_TO_RGB_INTERN_H
+#define GRAPHICS_YUV_TO_RGB_INTERN_H
+
+#include "common/scummsys.h"
+
+namespace Graphics {
+
+/**
+ * Destination format description used by the SIMD row converters.
+ */
+struct YUVToRGBRowParams {
+	uint bytesPerPixel;
+	bool itu;       ///< Luminance values range from [16, 235]
+	byte rLoss, gLoss, bLoss, aLoss;
+	byte rShift, gShift, bShift, aShift;
+	uint32 aMask;   ///< Alpha bits of every pixel when there is no alpha plane
+};
+
+/**
+ * The row converters handle as many leading pixels of a row as their vector
+ * width allows and return that number. The caller converts the remaining
+ * pixels with the scalar code. The results are identical to the scalar code.
+ */
+struct YUVToRGBRowFuncs {
+	/** Convert a row with full resolution chroma. */
+	int (*row444)(byte *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, int width, const YUVToRGBRowParams &params);
+
+	/**
+	 * Convert a row with horizontally halved chroma. For 4:2:0 the next row,
+	 * which shares the same chroma, is converted as well when dst1 and y1 are
+	 * given. The alpha planes a0 and a1 are optional.
+	 */
+	int (*row422)(byte *dst0, byte *dst1, const byte *y0, const byte *y1, const byte *a0, const byte *a1,
+	              const byte *uSrc, const byte *vSrc, int width, const YUVToRGBRowParams &params);
+
+	/**
+	 * Convert a 4:1:0 row, interpolating between the chroma row at uSrc/vSrc
+	 * and the one below it.
+	 */
+	int (*row410)(byte *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, int uvPitch, int yDiff,
+	              int width, const YUVToRGBRowParams &params);
+};
+
+#ifdef SCUMMVM_NEON
+extern const YUVToRGBRowFuncs yuvToRGBRowFuncsNEON;
+#endif
+#ifdef SCUMMVM_SSE2
+extern const YUVToRGBRowFuncs yuvToRGBRowFuncsSSE2;
+#endif
+#ifdef SCUMMVM_AVX2
+extern const YUVToRGBRowFuncs yuvToRGBRowFuncsAVX2;
+#endif
+
+/**
+ * Fixed point factors reproducing the truncated chroma tables of
+ * YUVToRGBLookup exactly: t(c, n) = sign(n) * (whole * |n| + ((|n| * frac) >> 16)).
+ */
+enum {
+	kYUVCrRFrac = 26303, // 0.419 / 0.299, whole part 1
+	kYUVCrGFrac = 46767, // 0.299 / 0.419
+	kYUVCbGFrac = 22572, // 0.114 / 0.331
+	kYUVCbBFrac = 50687, // 0.587 / 0.331, whole part 1
+	kYUVITUFrac = 10774  // x * 255 / 219 == x + ((x * kYUVITUFrac) >> 16) for x in [0, 219]
+};
+
+} // End of namespace Graphics
+
+#endif
@@ -0,0 +1,240 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#ifdef SCUMMVM_NEON
+
+#include "graphics/yuv_to_rgb_intern.h"
+
+#include <arm_neon.h>
+
+#if !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("neon"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("fpu=neon")
+#endif
+
+#endif // !defined(__aarch64__) && !defined(__ARM_NEON)
+
+namespace Graphics {
+
+namespace {
+
+static inline uint16x8_t mulhi(uint16x8_t a, uint16x8_t b) {
+	return vcombine_u16(vshrn_n_u32(vmull_u16(vget_low_u16(a), vget_low_u16(b)), 16),
+	                    vshrn_n_u32(vmull_u16(vget_high_u16(a), vget_high_u16(b)), 16));
+}
+
+// sign(n) * (whole * |n| + ((|n| * frac) >> 16)), see yuv_to_rgb_intern.h
+template<bool whole>
+static inline int16x8_t mulTrunc(int16x8_t n, int frac) {
+	const uint16x8_t absN = vreinterpretq_u16_s16(vabsq_s16(n));
+	uint16x8_t res = mulhi(absN, vdupq_n_u16(frac));
+	if (whole)
+		res = vaddq_u16(res, absN);
+	const int16x8_t sres = vreinterpretq_s16_u16(res);
+	return vbslq_s16(vcltq_s16(n, vdupq_n_s16(0)), vnegq_s16(sres), sres);
+}
+
+// Equivalent of the Cr_r_tab, Cr_g_tab + Cb_g_tab and Cb_b_tab lookups
+static inline void chroma(int16x8_t u, int16x8_t v, int16x8_t &crR, int16x8_t &crbG, int16x8_t &cbB) {
+	const int16x8_t cr = vsubq_s16(v, vdupq_n_s16(128));
+	const int16x8_t cb = vsubq_s16(u, vdupq_n_s16(128));
+	crR = mulTrunc<true>(cr, kYUVCrRFrac);
+	crbG = vnegq_s16(vaddq_s16(mulTrunc<false>(cr, kYUVCrGFrac), mulTrunc<false>(cb, kYUVCbGFrac)));
+	cbB = mulTrunc<true>(cb, kYUVCbBFrac);
+}
+
+static inline int16x8_t load8(const byte *src) {
+	return vreinterpretq_s16_u16(vmovl_u8(vld1_u8(src)));
+}
+
+class PixelWriter {
+public:
+	PixelWriter(const YUVToRGBRowParams &params) : _bytesPerPixel(params.bytesPerPixel), _itu(params.itu) {
+		// Negative shift counts shift to the right
+		_rLoss = vdupq_n_s16(-params.rLoss);
+		_gLoss = vdupq_n_s16(-params.gLoss);
+		_bLoss = vdupq_n_s16(-params.bLoss);
+		_aLoss = vdupq_n_s16(-params.aLoss);
+		_rShift16 = vdupq_n_s16(params.rShift);
+		_gShift16 = vdupq_n_s16(params.gShift);
+		_bShift16 = vdupq_n_s16(params.bShift);
+		_aShift16 = vdupq_n_s16(params.aShift);
+		_rShift32 = vdupq_n_s32(params.rShift);
+		_gShift32 = vdupq_n_s32(params.gShift);
+		_bShift32 = vdupq_n_s32(params.bShift);
+		_aShift32 = vdupq_n_s32(params.aShift);
+		_aMask16 = vdupq_n_u16((uint16)params.aMask);
+		_aMask32 = vdupq_n_u32(params.aMask);
+		_min = vdupq_n_s16(_itu ? 16 : 0);
+		_max = vdupq_n_s16(_itu ? 235 : 255);
+	}
+
+	/** Write 8 pixels. If aSrc is nullptr, the alpha bits are fixed. */
+	inline void write(byte *dst, int16x8_t y, const byte *aSrc, int16x8_t crR, int16x8_t crbG, int16x8_t cbB) const {
+		const uint16x8_t r = component(y, crR, _rLoss);
+		const uint16x8_t g = component(y, crbG, _gLoss);
+		const uint16x8_t b = component(y, cbB, _bLoss);
+
+		if (_bytesPerPixel == 2) {
+			uint16x8_t px = vorrq_u16(vorrq_u16(vshlq_u16(r, _rShift16), vshlq_u16(g, _gShift16)), vshlq_u16(b, _bShift16));
+			if (aSrc)
+				px = vorrq_u16(px, vshlq_u16(vshlq_u16(vmovl_u8(vld1_u8(aSrc)), _aLoss), _aShift16));
+			else
+				px = vorrq_u16(px, _aMask16);
+			vst1q_u16((uint16 *)dst, px);
+		} else {
+			uint32x4_t lo = vorrq_u32(vorrq_u32(vshlq_u32(vmovl_u16(vget_low_u16(r)), _rShift32), vshlq_u32(vmovl_u16(vget_low_u16(g)), _gShift32)), vshlq_u32(vmovl_u16(vget_low_u16(b)), _bShift32));
+			uint32x4_t hi = vorrq_u32(vorrq_u32(vshlq_u32(vmovl_u16(vget_high_u16(r)), _rShift32), vshlq_u32(vmovl_u16(vget_high_u16(g)), _gShift32)), vshlq_u32(vmovl_u16(vget_high_u16(b)), _bShift32));
+			if (aSrc) {
+				const uint16x8_t a = vshlq_u16(vmovl_u8(vld1_u8(aSrc)), _aLoss);
+				lo = vorrq_u32(lo, vshlq_u32(vmovl_u16(vget_low_u16(a)), _aShift32));
+				hi = vorrq_u32(hi, vshlq_u32(vmovl_u16(vget_high_u16(a)), _aShift32));
+			} else {
+				lo = vorrq_u32(lo, _aMask32);
+				hi = vorrq_u32(hi, _aMask32);
+			}
+			vst1q_u32((uint32 *)dst, lo);
+			vst1q_u32((uint32 *)(dst + 16), hi);
+		}
+	}
+
+private:
+	// Equivalent of the clip table lookup
+	inline uint16x8_t component(int16x8_t y, int16x8_t c, int16x8_t loss) const {
+		uint16x8_t x = vreinterpretq_u16_s16(vminq_s16(vmaxq_s16(vaddq_s16(y, c), _min), _max));
+		if (_itu) {
+			x = vsubq_u16(x, vreinterpretq_u16_s16(_min));
+			x = vaddq_u16(x, mulhi(x, vdupq_n_u16(kYUVITUFrac)));
+		}
+		return vshlq_u16(x, loss);
+	}
+
+	uint _bytesPerPixel;
+	bool _itu;
+	int16x8_t _rLoss, _gLoss, _bLoss, _aLoss;
+	int16x8_t _rShift16, _gShift16, _bShift16, _aShift16;
+	int32x4_t _rShift32, _gShift32, _bShift32, _aShift32;
+	uint16x8_t _aMask16;
+	uint32x4_t _aMask32;
+	int16x8_t _min, _max;
+};
+
+static int convertRow444(byte *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, int width, const YUVToRGBRowParams &params) {
+	const PixelWriter writer(params);
+	const int dstStep = 8 * params.bytesPerPixel;
+
+	int x = 0;
+	for (; x + 8 <= width; x += 8) {
+		int16x8_t crR, crbG, cbB;
+		chroma(load8(uSrc + x), load8(vSrc + x), crR, crbG, cbB);
+		writer.write(dst, load8(ySrc + x), nullptr, crR, crbG, cbB);
+		dst += dstStep;
+	}
+	return x;
+}
+
+static int convertRow422(byte *dst0, byte *dst1, const byte *y0, const byte *y1, const byte *a0, const byte *a1,
+                         const byte *uSrc, const byte *vSrc, int width, const YUVToRGBRowParams &params) {
+	const PixelWriter writer(params);
+	const int dstStep = 8 * params.bytesPerPixel;
+
+	int x = 0;
+	for (; x + 16 <= width; x += 16) {
+		int16x8_t crR, crbG, cbB;
+		chroma(load8(uSrc + x / 2), load8(vSrc + x / 2), crR, crbG, cbB);
+
+		// Every chroma sample covers two pixels
+		const int16x8x2_t crR2 = vzipq_s16(crR, crR);
+		const int16x8x2_t crbG2 = vzipq_s16(crbG, crbG);
+		const int16x8x2_t cbB2 = vzipq_s16(cbB, cbB);
+
+		writer.write(dst0, load8(y0 + x), a0 ? a0 + x : nullptr, crR2.val[0], crbG2.val[0], cbB2.val[0]);
+		writer.write(dst0 + dstStep, load8(y0 + x + 8), a0 ? a0 + x + 8 : nullptr, crR2.val[1], crbG2.val[1], cbB2.val[1]);
+		dst0 += 2 * dstStep;
+
+		if (dst1) {
+			writer.write(dst1, load8(y1 + x), a1 ? a1 + x : nullptr, crR2.val[0], crbG2.val[0], cbB2.val[0]);
+			writer.write(dst1 + dstStep, load8(y1 + x + 8), a1 ? a1 + x + 8 : nullptr, crR2.val[1], crbG2.val[1], cbB2.val[1]);
+			dst1 += 2 * dstStep;
+		}
+	}
+	return x;
+}
+
+// Bilinear interpolation of the chroma for two 4 pixel wide quads
+static inline int16x8_t interpolate410(const byte *src, int uvPitch, int16x8_t xDiff, int16x8_t xInv, int yDiff) {
+	const int16x8_t a = vcombine_s16(vdup_n_s16(src[0]), vdup_n_s16(src[1]));
+	const int16x8_t b = vcombine_s16(vdup_n_s16(src[1]), vdup_n_s16(src[2]));
+	const int16x8_t c = vcombine_s16(vdup_n_s16(src[uvPitch]), vdup_n_s16(src[uvPitch + 1]));
+	const int16x8_t d = vcombine_s16(vdup_n_s16(src[uvPitch + 1]), vdup_n_s16(src[uvPitch + 2]));
+
+	const int16x8_t top = vmlaq_s16(vmulq_s16(a, xInv), b, xDiff);
+	const int16x8_t bottom = vmlaq_s16(vmulq_s16(c, xInv), d, xDiff);
+	const int16x8_t sum = vmlaq_n_s16(vmulq_n_s16(top, 4 - yDiff), bottom, yDiff);
+	return vshrq_n_s16(sum, 4);
+}
+
+static int convertRow410(byte *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, int uvPitch, int yDiff,
+                         int width, const YUVToRGBRowParams &params) {
+	const PixelWriter writer(params);
+	const int dstStep = 8 * params.bytesPerPixel;
+	static const int16 xDiffs[8] = { 0, 1, 2, 3, 0, 1, 2, 3 };
+	const int16x8_t xDiff = vld1q_s16(xDiffs);
+	const int16x8_t xInv = vsubq_s16(vdupq_n_s16(4), xDiff);
+
+	int x = 0;
+	for (; x + 8 <= width; x += 8) {
+		int16x8_t crR, crbG, cbB;
+		chroma(interpolate410(uSrc + x / 4, uvPitch, xDiff, xInv, yDiff),
+		       interpolate410(vSrc + x / 4, uvPitch, xDiff, xInv, yDiff), crR, crbG, cbB);
+		writer.write(dst, load8(ySrc + x), nullptr, crR, crbG, cbB);
+		dst += dstStep;
+	}
+	return x;
+}
+
+} // End of anonymous namespace
+
+const YUVToRGBRowFuncs yuvToRGBRowFuncsNEON = {
+	convertRow444,
+	convertRow422,
+	convertRow410
+};
+
+} // End of namespace Graphics
+
+#if !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#endif // SCUMMVM_NEON
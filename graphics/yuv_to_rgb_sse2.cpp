@@ -0,0 +1,224 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#include "graphics/yuv_to_rgb_intern.h"
+
+#include <emmintrin.h>
+
+#if !defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("sse2"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#endif
+
+#endif // !defined(__x86_64__)
+
+namespace Graphics {
+
+namespace {
+
+// sign(n) * (whole * |n| + ((|n| * frac) >> 16)), see yuv_to_rgb_intern.h
+template<bool whole>
+static inline __m128i mulTrunc(__m128i n, int frac) {
+	const __m128i sign = _mm_srai_epi16(n, 15);
+	const __m128i absN = _mm_sub_epi16(_mm_xor_si128(n, sign), sign);
+	__m128i res = _mm_mulhi_epu16(absN, _mm_set1_epi16((short)frac));
+	if (whole)
+		res = _mm_add_epi16(res, absN);
+	return _mm_sub_epi16(_mm_xor_si128(res, sign), sign);
+}
+
+// Equivalent of the Cr_r_tab, Cr_g_tab + Cb_g_tab and Cb_b_tab lookups
+static inline void chroma(__m128i u, __m128i v, __m128i &crR, __m128i &crbG, __m128i &cbB) {
+	const __m128i cr = _mm_sub_epi16(v, _mm_set1_epi16(128));
+	const __m128i cb = _mm_sub_epi16(u, _mm_set1_epi16(128));
+	crR = mulTrunc<true>(cr, kYUVCrRFrac);
+	crbG = _mm_sub_epi16(_mm_setzero_si128(), _mm_add_epi16(mulTrunc<false>(cr, kYUVCrGFrac), mulTrunc<false>(cb, kYUVCbGFrac)));
+	cbB = mulTrunc<true>(cb, kYUVCbBFrac);
+}
+
+static inline __m128i load8(const byte *src) {
+	return _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)src), _mm_setzero_si128());
+}
+
+class PixelWriter {
+public:
+	PixelWriter(const YUVToRGBRowParams &params) : _bytesPerPixel(params.bytesPerPixel), _itu(params.itu) {
+		_rLoss = _mm_cvtsi32_si128(params.rLoss);
+		_gLoss = _mm_cvtsi32_si128(params.gLoss);
+		_bLoss = _mm_cvtsi32_si128(params.bLoss);
+		_aLoss = _mm_cvtsi32_si128(params.aLoss);
+		_rShift = _mm_cvtsi32_si128(params.rShift);
+		_gShift = _mm_cvtsi32_si128(params.gShift);
+		_bShift = _mm_cvtsi32_si128(params.bShift);
+		_aShift = _mm_cvtsi32_si128(params.aShift);
+		_aMask16 = _mm_set1_epi16((short)params.aMask);
+		_aMask32 = _mm_set1_epi32(params.aMask);
+		_min = _mm_set1_epi16(_itu ? 16 : 0);
+		_max = _mm_set1_epi16(_itu ? 235 : 255);
+	}
+
+	/** Write 8 pixels. If aSrc is nullptr, the alpha bits are fixed. */
+	inline void write(byte *dst, __m128i y, const byte *aSrc, __m128i crR, __m128i crbG, __m128i cbB) const {
+		const __m128i r = component(y, crR, _rLoss);
+		const __m128i g = component(y, crbG, _gLoss);
+		const __m128i b = component(y, cbB, _bLoss);
+
+		if (_bytesPerPixel == 2) {
+			__m128i px = _mm_or_si128(_mm_or_si128(_mm_sll_epi16(r, _rShift), _mm_sll_epi16(g, _gShift)), _mm_sll_epi16(b, _bShift));
+			if (aSrc)
+				px = _mm_or_si128(px, _mm_sll_epi16(_mm_srl_epi16(load8(aSrc), _aLoss), _aShift));
+			else
+				px = _mm_or_si128(px, _aMask16);
+			_mm_storeu_si128((__m128i *)dst, px);
+		} else {
+			const __m128i zero = _mm_setzero_si128();
+			__m128i lo = _mm_or_si128(_mm_or_si128(_mm_sll_epi32(_mm_unpacklo_epi16(r, zero), _rShift), _mm_sll_epi32(_mm_unpacklo_epi16(g, zero), _gShift)), _mm_sll_epi32(_mm_unpacklo_epi16(b, zero), _bShift));
+			__m128i hi = _mm_or_si128(_mm_or_si128(_mm_sll_epi32(_mm_unpackhi_epi16(r, zero), _rShift), _mm_sll_epi32(_mm_unpackhi_epi16(g, zero), _gShift)), _mm_sll_epi32(_mm_unpackhi_epi16(b, zero), _bShift));
+			if (aSrc) {
+				const __m128i a = _mm_srl_epi16(load8(aSrc), _aLoss);
+				lo = _mm_or_si128(lo, _mm_sll_epi32(_mm_unpacklo_epi16(a, zero), _aShift));
+				hi = _mm_or_si128(hi, _mm_sll_epi32(_mm_unpackhi_epi16(a, zero), _aShift));
+			} else {
+				lo = _mm_or_si128(lo, _aMask32);
+				hi = _mm_or_si128(hi, _aMask32);
+			}
+			_mm_storeu_si128((__m128i *)dst, lo);
+			_mm_storeu_si128((__m128i *)(dst + 16), hi);
+		}
+	}
+
+private:
+	// Equivalent of the clip table lookup
+	inline __m128i component(__m128i y, __m128i c, __m128i loss) const {
+		__m128i x = _mm_min_epi16(_mm_max_epi16(_mm_add_epi16(y, c), _min), _max);
+		if (_itu) {
+			x = _mm_sub_epi16(x, _min);
+			x = _mm_add_epi16(x, _mm_mulhi_epu16(x, _mm_set1_epi16((short)kYUVITUFrac)));
+		}
+		return _mm_srl_epi16(x, loss);
+	}
+
+	uint _bytesPerPixel;
+	bool _itu;
+	__m128i _rLoss, _gLoss, _bLoss, _aLoss;
+	__m128i _rShift, _gShift, _bShift, _aShift;
+	__m128i _aMask16, _aMask32;
+	__m128i _min, _max;
+};
+
+static int convertRow444(byte *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, int width, const YUVToRGBRowParams &params) {
+	const PixelWriter writer(params);
+	const int dstStep = 8 * params.bytesPerPixel;
+
+	int x = 0;
+	for (; x + 8 <= width; x += 8) {
+		__m128i crR, crbG, cbB;
+		chroma(load8(uSrc + x), load8(vSrc + x), crR, crbG, cbB);
+		writer.write(dst, load8(ySrc + x), nullptr, crR, crbG, cbB);
+		dst += dstStep;
+	}
+	return x;
+}
+
+static int convertRow422(byte *dst0, byte *dst1, const byte *y0, const byte *y1, const byte *a0, const byte *a1,
+                         const byte *uSrc, const byte *vSrc, int width, const YUVToRGBRowParams &params) {
+	const PixelWriter writer(params);
+	const int dstStep = 8 * params.bytesPerPixel;
+
+	int x = 0;
+	for (; x + 16 <= width; x += 16) {
+		__m128i crR, crbG, cbB;
+		chroma(load8(uSrc + x / 2), load8(vSrc + x / 2), crR, crbG, cbB);
+
+		// Every chroma sample covers two pixels
+		const __m128i crRLo = _mm_unpacklo_epi16(crR, crR), crRHi = _mm_unpackhi_epi16(crR, crR);
+		const __m128i crbGLo = _mm_unpacklo_epi16(crbG, crbG), crbGHi = _mm_unpackhi_epi16(crbG, crbG);
+		const __m128i cbBLo = _mm_unpacklo_epi16(cbB, cbB), cbBHi = _mm_unpackhi_epi16(cbB, cbB);
+
+		writer.write(dst0, load8(y0 + x), a0 ? a0 + x : nullptr, crRLo, crbGLo, cbBLo);
+		writer.write(dst0 + dstStep, load8(y0 + x + 8), a0 ? a0 + x + 8 : nullptr, crRHi, crbGHi, cbBHi);
+		dst0 += 2 * dstStep;
+
+		if (dst1) {
+			writer.write(dst1, load8(y1 + x), a1 ? a1 + x : nullptr, crRLo, crbGLo, cbBLo);
+			writer.write(dst1 + dstStep, load8(y1 + x + 8), a1 ? a1 + x + 8 : nullptr, crRHi, crbGHi, cbBHi);
+			dst1 += 2 * dstStep;
+		}
+	}
+	return x;
+}
+
+// Bilinear interpolation of the chroma for two 4 pixel wide quads
+static inline __m128i interpolate410(const byte *src, int uvPitch, __m128i xDiff, __m128i xInv, int yDiff) {
+	const __m128i a = _mm_unpacklo_epi64(_mm_set1_epi16(src[0]), _mm_set1_epi16(src[1]));
+	const __m128i b = _mm_unpacklo_epi64(_mm_set1_epi16(src[1]), _mm_set1_epi16(src[2]));
+	const __m128i c = _mm_unpacklo_epi64(_mm_set1_epi16(src[uvPitch]), _mm_set1_epi16(src[uvPitch + 1]));
+	const __m128i d = _mm_unpacklo_epi64(_mm_set1_epi16(src[uvPitch + 1]), _mm_set1_epi16(src[uvPitch + 2]));
+
+	const __m128i top = _mm_add_epi16(_mm_mullo_epi16(a, xInv), _mm_mullo_epi16(b, xDiff));
+	const __m128i bottom = _mm_add_epi16(_mm_mullo_epi16(c, xInv), _mm_mullo_epi16(d, xDiff));
+	const __m128i sum = _mm_add_epi16(_mm_mullo_epi16(top, _mm_set1_epi16(4 - yDiff)), _mm_mullo_epi16(bottom, _mm_set1_epi16(yDiff)));
+	return _mm_srli_epi16(sum, 4);
+}
+
+static int convertRow410(byte *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, int uvPitch, int yDiff,
+                         int width, const YUVToRGBRowParams &params) {
+	const PixelWriter writer(params);
+	const int dstStep = 8 * params.bytesPerPixel;
+	const __m128i xDiff = _mm_setr_epi16(0, 1, 2, 3, 0, 1, 2, 3);
+	const __m128i xInv = _mm_sub_epi16(_mm_set1_epi16(4), xDiff);
+
+	int x = 0;
+	for (; x + 8 <= width; x += 8) {
+		__m128i crR, crbG, cbB;
+		chroma(interpolate410(uSrc + x / 4, uvPitch, xDiff, xInv, yDiff),
+		       interpolate410(vSrc + x / 4, uvPitch, xDiff, xInv, yDiff), crR, crbG, cbB);
+		writer.write(dst, load8(ySrc + x), nullptr, crR, crbG, cbB);
+		dst += dstStep;
+	}
+	return x;
+}
+
+} // End of anonymous namespace
+
+const YUVToRGBRowFuncs yuvToRGBRowFuncsSSE2 = {
+	convertRow444,
+	convertRow422,
+	convertRow410
+};
+
+} // End of namespace Graphics
+
+#if !defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // !defined(__x86_64__)
@@ -20,6 +20,7 @@
  */
 
 #include "common/events.h"
+#include "common/profiler.h"
 #include "common/translation.h"
 #include "common/zip-set.h"
 #include "gui/EventRecorder.h"
@@ -114,7 +115,6 @@ void GuiManager::initIconsSet() {
 	_iconsSet.clear();
 #ifdef EMSCRIPTEN
 	Common::Path iconsPath = ConfMan.getPath("iconspath");
-	_iconsSet = Common::SearchSet();
 	_iconsSet.addDirectory("gui-icons/", iconsPath, 0, 3, false);
 	_iconsSetChanged = true;
 #else
@@ -477,6 +477,8 @@ void GuiManager::redraw() {
 	if (_dialogStack.empty())
 		return;
 
+	PROFILE_ZONE("GuiManager::redraw");
+
 	// Reset any custom RTL paddings set by stacked dialogs when we go back to the top
 	if (useRTL() && _dialogStack.size() == 1) {
 		setDialogPaddings(0, 0);
@@ -672,6 +672,7 @@ bool LauncherDialog::doGameDetection(const Common::Path &path) {
 	// ...so let's determine a list of candidates, games that
 	// could be contained in the specified directory.
 	DetectionResults detectionResults = EngineMan.detectGames(files);
+	ADCacheMan.flushPersistentMD5s();
 
 	if (detectionResults.foundUnknownGames()) {
 		Common::U32String report = detectionResults.generateUnknownGameReport(false, 80);
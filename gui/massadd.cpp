@@ -277,6 +277,9 @@ void MassAddDialog::handleTickle() {
 	Common::U32String buf;
 
 	if (_scanStack.empty()) {
+		// Keep the MD5s computed during the scan for the next one
+		ADCacheMan.flushPersistentMD5s();
+
 		// Enable the OK button
 		_okButton->setEnabled(true);
 
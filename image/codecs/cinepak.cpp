@@ -282,7 +282,6 @@ CinepakDecoder::CinepakDecoder(int bitsPerPixel) : Codec(), _bitsPerPixel(bitsPe
 	_curFrame.surface = 0;
 	_curFrame.strips = 0;
 	_y = 0;
-	_colorMap = 0;
 	_ditherPalette = 0;
 	_ditherType = kDitherTypeUnknown;
 
@@ -321,7 +320,6 @@ CinepakDecoder::~CinepakDecoder() {
 	delete[] _curFrame.strips;
 	delete[] _clipTableBuf;
 
-	delete[] _colorMap;
 	delete[] _ditherPalette;
 }
 
@@ -496,25 +494,25 @@ void CinepakDecoder::ditherCodebookQT(uint16 strip, byte codebookType, uint16 co
 		const CinepakCodebook &codebook = _curFrame.strips[strip].v1_codebook[codebookIndex];
 		byte *output = (byte *)(_curFrame.strips[strip].v1_dither + codebookIndex);
 
-		byte *ditherEntry = _colorMap + createDitherTableIndex(_clipTable, codebook.y[0], codebook.u, codebook.v);
+		byte *ditherEntry = _colorMap.get() + createDitherTableIndex(_clipTable, codebook.y[0], codebook.u, codebook.v);
 		output[0x000] = ditherEntry[0x0000];
 		output[0x001] = ditherEntry[0x4000];
 		output[0x400] = ditherEntry[0xC000];
 		output[0x401] = ditherEntry[0x0000];
 
-		ditherEntry = _colorMap + createDitherTableIndex(_clipTable, codebook.y[1], codebook.u, codebook.v);
+		ditherEntry = _colorMap.get() + createDitherTableIndex(_clipTable, codebook.y[1], codebook.u, codebook.v);
 		output[0x002] = ditherEntry[0x8000];
 		output[0x003] = ditherEntry[0xC000];
 		output[0x402] = ditherEntry[0x4000];
 		output[0x403] = ditherEntry[0x8000];
 
-		ditherEntry = _colorMap + createDitherTableIndex(_clipTable, codebook.y[2], codebook.u, codebook.v);
+		ditherEntry = _colorMap.get() + createDitherTableIndex(_clipTable, codebook.y[2], codebook.u, codebook.v);
 		output[0x800] = ditherEntry[0x4000];
 		output[0x801] = ditherEntry[0x8000];
 		output[0xC00] = ditherEntry[0x8000];
 		output[0xC01] = ditherEntry[0xC000];
 
-		ditherEntry = _colorMap + createDitherTableIndex(_clipTable, codebook.y[3], codebook.u, codebook.v);
+		ditherEntry = _colorMap.get() + createDitherTableIndex(_clipTable, codebook.y[3], codebook.u, codebook.v);
 		output[0x802] = ditherEntry[0xC000];
 		output[0x803] = ditherEntry[0x0000];
 		output[0xC02] = ditherEntry[0x0000];
@@ -523,25 +521,25 @@ void CinepakDecoder::ditherCodebookQT(uint16 strip, byte codebookType, uint16 co
 		const CinepakCodebook &codebook = _curFrame.strips[strip].v4_codebook[codebookIndex];
 		byte *output = (byte *)(_curFrame.strips[strip].v4_dither + codebookIndex);
 
-		byte *ditherEntry = _colorMap + createDitherTableIndex(_clipTable, codebook.y[0], codebook.u, codebook.v);
+		byte *ditherEntry = _colorMap.get() + createDitherTableIndex(_clipTable, codebook.y[0], codebook.u, codebook.v);
 		output[0x000] = ditherEntry[0x0000];
 		output[0x400] = ditherEntry[0x8000];
 		output[0x800] = ditherEntry[0x4000];
 		output[0xC00] = ditherEntry[0xC000];
 
-		ditherEntry = _colorMap + createDitherTableIndex(_clipTable, codebook.y[1], codebook.u, codebook.v);
+		ditherEntry = _colorMap.get() + createDitherTableIndex(_clipTable, codebook.y[1], codebook.u, codebook.v);
 		output[0x001] = ditherEntry[0x4000];
 		output[0x401] = ditherEntry[0xC000];
 		output[0x801] = ditherEntry[0x8000];
 		output[0xC01] = ditherEntry[0x0000];
 
-		ditherEntry = _colorMap + createDitherTableIndex(_clipTable, codebook.y[2], codebook.u, codebook.v);
+		ditherEntry = _colorMap.get() + createDitherTableIndex(_clipTable, codebook.y[2], codebook.u, codebook.v);
 		output[0x002] = ditherEntry[0xC000];
 		output[0x402] = ditherEntry[0x4000];
 		output[0x802] = ditherEntry[0x8000];
 		output[0xC02] = ditherEntry[0x0000];
 
-		ditherEntry = _colorMap + createDitherTableIndex(_clipTable, codebook.y[3], codebook.u, codebook.v);
+		ditherEntry = _colorMap.get() + createDitherTableIndex(_clipTable, codebook.y[3], codebook.u, codebook.v);
 		output[0x003] = ditherEntry[0x0000];
 		output[0x403] = ditherEntry[0x8000];
 		output[0x803] = ditherEntry[0xC000];
@@ -577,22 +575,22 @@ void CinepakDecoder::ditherCodebookVFW(uint16 strip, byte codebookType, uint16 c
 		uint32 pixelGroup7 = uv1 | s_yLookup[yLookup4];
 		uint32 pixelGroup8 = uv2 | s_yLookup[yLookup4 + 1];
 
-		output[0x000] = getRGBLookupEntry(_colorMap, pixelGroup1 & 0xFFFF);
-		output[0x001] = getRGBLookupEntry(_colorMap, pixelGroup1 >> 16);
-		output[0x002] = getRGBLookupEntry(_colorMap, pixelGroup2 & 0xFFFF);
-		output[0x003] = getRGBLookupEntry(_colorMap, pixelGroup2 >> 16);
-		output[0x400] = getRGBLookupEntry(_colorMap, pixelGroup3 & 0xFFFF);
-		output[0x401] = getRGBLookupEntry(_colorMap, pixelGroup3 >> 16);
-		output[0x402] = getRGBLookupEntry(_colorMap, pixelGroup4 & 0xFFFF);
-		output[0x403] = getRGBLookupEntry(_colorMap, pixelGroup4 >> 16);
-		output[0x800] = getRGBLookupEntry(_colorMap, pixelGroup5 >> 16);
-		output[0x801] = getRGBLookupEntry(_colorMap, pixelGroup6 & 0xFFFF);
-		output[0x802] = getRGBLookupEntry(_colorMap, pixelGroup7 >> 16);
-		output[0x803] = getRGBLookupEntry(_colorMap, pixelGroup8 & 0xFFFF);
-		output[0xC00] = getRGBLookupEntry(_colorMap, pixelGroup6 >> 16);
-		output[0xC01] = getRGBLookupEntry(_colorMap, pixelGroup5 & 0xFFFF);
-		output[0xC02] = getRGBLookupEntry(_colorMap, pixelGroup8 >> 16);
-		output[0xC03] = getRGBLookupEntry(_colorMap, pixelGroup7 & 0xFFFF);
+		output[0x000] = getRGBLookupEntry(_colorMap.get(), pixelGroup1 & 0xFFFF);
+		output[0x001] = getRGBLookupEntry(_colorMap.get(), pixelGroup1 >> 16);
+		output[0x002] = getRGBLookupEntry(_colorMap.get(), pixelGroup2 & 0xFFFF);
+		output[0x003] = getRGBLookupEntry(_colorMap.get(), pixelGroup2 >> 16);
+		output[0x400] = getRGBLookupEntry(_colorMap.get(), pixelGroup3 & 0xFFFF);
+		output[0x401] = getRGBLookupEntry(_colorMap.get(), pixelGroup3 >> 16);
+		output[0x402] = getRGBLookupEntry(_colorMap.get(), pixelGroup4 & 0xFFFF);
+		output[0x403] = getRGBLookupEntry(_colorMap.get(), pixelGroup4 >> 16);
+		output[0x800] = getRGBLookupEntry(_colorMap.get(), pixelGroup5 >> 16);
+		output[0x801] = getRGBLookupEntry(_colorMap.get(), pixelGroup6 & 0xFFFF);
+		output[0x802] = getRGBLookupEntry(_colorMap.get(), pixelGroup7 >> 16);
+		output[0x803] = getRGBLookupEntry(_colorMap.get(), pixelGroup8 & 0xFFFF);
+		output[0xC00] = getRGBLookupEntry(_colorMap.get(), pixelGroup6 >> 16);
+		output[0xC01] = getRGBLookupEntry(_colorMap.get(), pixelGroup5 & 0xFFFF);
+		output[0xC02] = getRGBLookupEntry(_colorMap.get(), pixelGroup8 >> 16);
+		output[0xC03] = getRGBLookupEntry(_colorMap.get(), pixelGroup7 & 0xFFFF);
 	} else {
 		const CinepakCodebook &codebook = _curFrame.strips[strip].v4_codebook[codebookIndex];
 		byte *output = (byte *)(_curFrame.strips[strip].v4_dither + codebookIndex);
@@ -616,22 +614,22 @@ void CinepakDecoder::ditherCodebookVFW(uint16 strip, byte codebookType, uint16 c
 		uint32 pixelGroup7 = uv2 | s_yLookup[yLookup3 + 1];
 		uint32 pixelGroup8 = uv2 | s_yLookup[yLookup4 + 1];
 
-		output[0x000] = getRGBLookupEntry(_colorMap, pixelGroup1 & 0xFFFF);
-		output[0x001] = getRGBLookupEntry(_colorMap, pixelGroup2 >> 16);
-		output[0x400] = getRGBLookupEntry(_colorMap, pixelGroup5 & 0xFFFF);
-		output[0x401] = getRGBLookupEntry(_colorMap, pixelGroup6 >> 16);
-		output[0x002] = getRGBLookupEntry(_colorMap, pixelGroup3 & 0xFFFF);
-		output[0x003] = getRGBLookupEntry(_colorMap, pixelGroup4 >> 16);
-		output[0x402] = getRGBLookupEntry(_colorMap, pixelGroup7 & 0xFFFF);
-		output[0x403] = getRGBLookupEntry(_colorMap, pixelGroup8 >> 16);
-		output[0x800] = getRGBLookupEntry(_colorMap, pixelGroup1 >> 16);
-		output[0x801] = getRGBLookupEntry(_colorMap, pixelGroup6 & 0xFFFF);
-		output[0xC00] = getRGBLookupEntry(_colorMap, pixelGroup5 >> 16);
-		output[0xC01] = getRGBLookupEntry(_colorMap, pixelGroup2 & 0xFFFF);
-		output[0x802] = getRGBLookupEntry(_colorMap, pixelGroup3 >> 16);
-		output[0x803] = getRGBLookupEntry(_colorMap, pixelGroup8 & 0xFFFF);
-		output[0xC02] = getRGBLookupEntry(_colorMap, pixelGroup7 >> 16);
-		output[0xC03] = getRGBLookupEntry(_colorMap, pixelGroup4 & 0xFFFF);
+		output[0x000] = getRGBLookupEntry(_colorMap.get(), pixelGroup1 & 0xFFFF);
+		output[0x001] = getRGBLookupEntry(_colorMap.get(), pixelGroup2 >> 16);
+		output[0x400] = getRGBLookupEntry(_colorMap.get(), pixelGroup5 & 0xFFFF);
+		output[0x401] = getRGBLookupEntry(_colorMap.get(), pixelGroup6 >> 16);
+		output[0x002] = getRGBLookupEntry(_colorMap.get(), pixelGroup3 & 0xFFFF);
+		output[0x003] = getRGBLookupEntry(_colorMap.get(), pixelGroup4 >> 16);
+		output[0x402] = getRGBLookupEntry(_colorMap.get(), pixelGroup7 & 0xFFFF);
+		output[0x403] = getRGBLookupEntry(_colorMap.get(), pixelGroup8 >> 16);
+		output[0x800] = getRGBLookupEntry(_colorMap.get(), pixelGroup1 >> 16);
+		output[0x801] = getRGBLookupEntry(_colorMap.get(), pixelGroup6 & 0xFFFF);
+		output[0xC00] = getRGBLookupEntry(_colorMap.get(), pixelGroup5 >> 16);
+		output[0xC01] = getRGBLookupEntry(_colorMap.get(), pixelGroup2 & 0xFFFF);
+		output[0x802] = getRGBLookupEntry(_colorMap.get(), pixelGroup3 >> 16);
+		output[0x803] = getRGBLookupEntry(_colorMap.get(), pixelGroup8 & 0xFFFF);
+		output[0xC02] = getRGBLookupEntry(_colorMap.get(), pixelGroup7 >> 16);
+		output[0xC03] = getRGBLookupEntry(_colorMap.get(), pixelGroup4 & 0xFFFF);
 	}
 }
 
@@ -662,7 +660,6 @@ bool CinepakDecoder::canDither(DitherType type) const {
 void CinepakDecoder::setDither(DitherType type, const byte *palette) {
 	assert(canDither(type));
 
-	delete[] _colorMap;
 	delete[] _ditherPalette;
 
 	_ditherPalette = new byte[256 * 3];
@@ -673,14 +670,16 @@ void CinepakDecoder::setDither(DitherType type, const byte *palette) {
 	_ditherType = type;
 
 	if (type == kDitherTypeVFW) {
-		_colorMap = new byte[1024];
+		byte *colorMap = new byte[1024];
 
 		for (int i = 0; i < 1024; i++)
-			_colorMap[i] = findNearestRGB(s_defaultPaletteLookup[i]);
+			colorMap[i] = findNearestRGB(s_defaultPaletteLookup[i]);
+
+		_colorMap = Common::SharedPtr<byte>(colorMap, Common::ArrayDeleter<byte>());
 	} else {
-		// Generate QuickTime dither table
+		// Get the QuickTime dither table
 		// 4 blocks of 0x4000 bytes (RGB554 lookup)
-		_colorMap = createQuickTimeDitherTable(palette, 256);
+		_colorMap = DitherTables.getQuickTimeTable(palette, 256);
 	}
 }
 
@@ -91,7 +91,7 @@ private:
 
 	byte *_ditherPalette;
 	bool _dirtyPalette;
-	byte *_colorMap;
+	Common::SharedPtr<byte> _colorMap;
 	DitherType _ditherType;
 
 	void initializeCodebook(uint16 strip, byte codebookType);
@@ -19,7 +19,6 @@
  *
  */
 
-#include "common/list.h"
 #include "common/scummsys.h"
 
 #include "image/codecs/codec.h"
@@ -53,6 +52,10 @@
 #include "common/endian.h"
 #include "common/textconsole.h"
 
+namespace Common {
+DECLARE_SINGLETON(Image::DitherTableCache);
+}
+
 namespace Image {
 
 namespace {
@@ -60,11 +63,11 @@ namespace {
 /**
  * Add a color to the QuickTime dither table check queue if it hasn't already been found.
  */
-inline void addColorToQueue(uint16 color, uint16 index, byte *checkBuffer, Common::List<uint16> &checkQueue) {
+inline void addColorToQueue(uint16 color, uint16 index, byte *checkBuffer, uint16 *checkQueue, uint &queueEnd) {
 	if ((READ_UINT16(checkBuffer + color * 2) & 0xFF) == 0) {
 		// Previously unfound color
 		WRITE_UINT16(checkBuffer + color * 2, index);
-		checkQueue.push_back(color);
+		checkQueue[queueEnd++] = color;
 	}
 }
 
@@ -77,12 +80,26 @@ inline uint16 makeQuickTimeDitherColor(byte r, byte g, byte b) {
 	return ((r & 0xF8) << 6) | ((g & 0xF8) << 1) | (b >> 4);
 }
 
+// 4 blocks of 0x4000 bytes (RGB554 lookup)
+const uint32 kQuickTimeTableSize = 0x10000;
+
+uint32 hashPalette(const byte *palette, uint colorCount) {
+	// FNV-1a
+	uint32 hash = 2166136261u;
+	for (uint i = 0; i < colorCount * 3; i++)
+		hash = (hash ^ palette[i]) * 16777619u;
+	return hash;
+}
+
 } // End of anonymous namespace
 
 byte *Codec::createQuickTimeDitherTable(const byte *palette, uint colorCount) {
-	byte *buf = new byte[0x10000]();
+	byte *buf = new byte[kQuickTimeTableSize]();
 
-	Common::List<uint16> checkQueue;
+	// Every color is only queued once, after room for black and white which
+	// are put in front of the queue
+	uint16 *checkQueue = new uint16[0x4000 + 2];
+	uint queueStart = 2, queueEnd = 2;
 
 	bool foundBlack = false;
 	bool foundWhite = false;
@@ -111,44 +128,45 @@ byte *Codec::createQuickTimeDitherTable(const byte *palette, uint colorCount) {
 			foundWhite = true;
 		} else {
 			// Previously unfound color
-			addColorToQueue(col, n, buf, checkQueue);
+			addColorToQueue(col, n, buf, checkQueue, queueEnd);
 		}
 	}
 
 	// More special handling for white
 	if (foundWhite)
-		checkQueue.push_front(0x3FFF);
+		checkQueue[--queueStart] = 0x3FFF;
 
 	// More special handling for black
 	if (foundBlack)
-		checkQueue.push_front(0);
+		checkQueue[--queueStart] = 0;
 
 	// Go through the list of colors we have and match up similar colors
 	// to fill in the table as best as we can.
-	while (!checkQueue.empty()) {
-		uint16 col = checkQueue.front();
-		checkQueue.pop_front();
+	while (queueStart != queueEnd) {
+		uint16 col = checkQueue[queueStart++];
 		uint16 index = READ_UINT16(buf + col * 2);
 
 		uint32 x = col << 4;
 		if ((x & 0xFF) < 0xF0)
-			addColorToQueue((x + 0x10) >> 4, index, buf, checkQueue);
+			addColorToQueue((x + 0x10) >> 4, index, buf, checkQueue, queueEnd);
 		if ((x & 0xFF) >= 0x10)
-			addColorToQueue((x - 0x10) >> 4, index, buf, checkQueue);
+			addColorToQueue((x - 0x10) >> 4, index, buf, checkQueue, queueEnd);
 
 		uint32 y = col << 7;
 		if ((y & 0xFF00) < 0xF800)
-			addColorToQueue((y + 0x800) >> 7, index, buf, checkQueue);
+			addColorToQueue((y + 0x800) >> 7, index, buf, checkQueue, queueEnd);
 		if ((y & 0xFF00) >= 0x800)
-			addColorToQueue((y - 0x800) >> 7, index, buf, checkQueue);
+			addColorToQueue((y - 0x800) >> 7, index, buf, checkQueue, queueEnd);
 
 		uint32 z = col << 2;
 		if ((z & 0xFF00) < 0xF800)
-			addColorToQueue((z + 0x800) >> 2, index, buf, checkQueue);
+			addColorToQueue((z + 0x800) >> 2, index, buf, checkQueue, queueEnd);
 		if ((z & 0xFF00) >= 0x800)
-			addColorToQueue((z - 0x800) >> 2, index, buf, checkQueue);
+			addColorToQueue((z - 0x800) >> 2, index, buf, checkQueue, queueEnd);
 	}
 
+	delete[] checkQueue;
+
 	// Contract the table back to just palette entries
 	for (int i = 0; i < 0x4000; i++)
 		buf[i] = READ_UINT16(buf + i * 2) >> 8;
@@ -201,6 +219,70 @@ byte *Codec::createQuickTimeDitherTable(const byte *palette, uint colorCount) {
 	return buf;
 }
 
+DitherTableCache::DitherTableCache() : _maxUnusedSize(1024 * 1024) {
+}
+
+Common::SharedPtr<byte> DitherTableCache::getQuickTimeTable(const byte *palette, uint colorCount) {
+	assert(colorCount <= 256);
+	const uint32 hash = hashPalette(palette, colorCount);
+
+	Common::StackLock lock(_mutex);
+
+	for (Common::List<Entry>::iterator it = _entries.begin(); it != _entries.end(); ++it) {
+		if (it->hash == hash && it->colorCount == colorCount && !memcmp(it->palette, palette, colorCount * 3)) {
+			// Move the table to the front, it's the last one to be dropped
+			if (it != _entries.begin()) {
+				_entries.push_front(*it);
+				_entries.erase(it);
+			}
+			return _entries.front().table;
+		}
+	}
+
+	// Make room for the new table, which also becomes unused once the codec
+	// is done with it
+	trim(_maxUnusedSize > kQuickTimeTableSize ? _maxUnusedSize - kQuickTimeTableSize : 0);
+
+	Entry entry;
+	entry.hash = hash;
+	entry.colorCount = colorCount;
+	memcpy(entry.palette, palette, colorCount * 3);
+	entry.table = Common::SharedPtr<byte>(Codec::createQuickTimeDitherTable(palette, colorCount), Common::ArrayDeleter<byte>());
+	_entries.push_front(entry);
+	return entry.table;
+}
+
+void DitherTableCache::setMaxUnusedSize(uint32 size) {
+	Common::StackLock lock(_mutex);
+	_maxUnusedSize = size;
+	trim(size);
+}
+
+uint32 DitherTableCache::getMemoryUsage() const {
+	Common::StackLock lock(_mutex);
+	return _entries.size() * kQuickTimeTableSize;
+}
+
+void DitherTableCache::clear() {
+	Common::StackLock lock(_mutex);
+	trim(0);
+}
+
+void DitherTableCache::trim(uint32 maxUnusedSize) {
+	uint32 unusedSize = 0;
+	for (Common::List<Entry>::iterator it = _entries.begin(); it != _entries.end(); ) {
+		// The cache holds the only reference of the tables which are unused
+		if (it->table.unique()) {
+			if (unusedSize + kQuickTimeTableSize > maxUnusedSize) {
+				it = _entries.erase(it);
+				continue;
+			}
+			unusedSize += kQuickTimeTableSize;
+		}
+		++it;
+	}
+}
+
 Codec *createBitmapCodec(uint32 tag, uint32 streamTag, int width, int height, int bitsPerPixel) {
 	// Crusader videos are special cased here because the frame type is not in the "compression"
 	// tag but in the "stream handler" tag for these files
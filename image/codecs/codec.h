@@ -22,6 +22,10 @@
 #ifndef IMAGE_CODECS_CODEC_H
 #define IMAGE_CODECS_CODEC_H
 
+#include "common/list.h"
+#include "common/mutex.h"
+#include "common/ptr.h"
+#include "common/singleton.h"
 #include "graphics/surface.h"
 #include "graphics/pixelformat.h"
 
@@ -129,6 +133,58 @@ public:
 	static byte *createQuickTimeDitherTable(const byte *palette, uint colorCount);
 };
 
+/**
+ * Cache of the dither tables used by the codecs.
+ *
+ * Codecs dithering to the same palette share their table, and the tables no
+ * longer used by any codec are kept up to a memory limit, so that the videos
+ * played one after the other with the palette of a game only create it once.
+ *
+ * The cache itself may be used from any thread. The reference counts of the
+ * tables it hands out are not atomic though, so the codecs which share them
+ * must stay on one thread; VideoDecoder does not decode dithered videos
+ * ahead for that reason.
+ */
+class DitherTableCache : public Common::Singleton<DitherTableCache> {
+public:
+	/**
+	 * Get the QuickTime dither table of a palette, creating it if it isn't
+	 * in the cache.
+	 */
+	Common::SharedPtr<byte> getQuickTimeTable(const byte *palette, uint colorCount);
+
+	/**
+	 * Set the total size of the tables kept while no codec uses them, 1 MB
+	 * by default.
+	 */
+	void setMaxUnusedSize(uint32 size);
+
+	/** Get the total size of the tables in the cache. */
+	uint32 getMemoryUsage() const;
+
+	/** Remove the tables which no codec uses. */
+	void clear();
+
+private:
+	friend class Common::Singleton<SingletonBaseType>;
+	DitherTableCache();
+
+	struct Entry {
+		uint32 hash;
+		uint colorCount;
+		byte palette[256 * 3];
+		Common::SharedPtr<byte> table;
+	};
+
+	/** The tables, the most recently requested first. */
+	Common::List<Entry> _entries;
+	uint32 _maxUnusedSize;
+	mutable Common::Mutex _mutex;
+
+	/** Remove the least recently requested unused tables over the limit. */
+	void trim(uint32 maxUnusedSize);
+};
+
 /**
  * Create a codec given a bitmap/AVI compression tag and stream handler tag (can be 0)
  */
@@ -141,4 +197,6 @@ Codec *createQuickTimeCodec(uint32 tag, int width, int height, int bitsPerPixel)
 
 } // End of namespace Image
 
+#define DitherTables (::Image::DitherTableCache::instance())
+
 #endif
@@ -45,15 +45,13 @@ MJPEGDecoder::MJPEGDecoder() : Codec() {
 	if (_pixelFormat.bytesPerPixel == 1)
 		_pixelFormat = Graphics::PixelFormat(4, 8, 8, 8, 8, 8, 16, 24, 0);
 
-	_surface = 0;
 	_accuracy = CodecAccuracy::Default;
+	_jpeg = new JPEGDecoder();
+	_headerSize = 0;
 }
 
 MJPEGDecoder::~MJPEGDecoder() {
-	if (_surface) {
-		_surface->free();
-		delete _surface;
-	}
+	delete _jpeg;
 }
 
 // Header to be inserted
@@ -167,63 +165,56 @@ const Graphics::Surface *MJPEGDecoder::decodeFrame(Common::SeekableReadStream &s
 		return 0;
 	}
 
-	uint32 outputSize = stream.size() - inputSkip + sizeof(s_jpegHeader) + DHT_SEGMENT_SIZE;
-	byte *data = (byte *)malloc(outputSize);
-
-	if (!data) {
-		warning("Failed to allocate data for MJPEG conversion");
-		return 0;
+	// The header and the Huffman tables are the same for every frame
+	if (!_headerSize) {
+		_data.resize(sizeof(s_jpegHeader) + DHT_SEGMENT_SIZE);
+		byte *data = _data.begin();
+
+		// Copy the header
+		memcpy(data, s_jpegHeader, sizeof(s_jpegHeader));
+		uint32 dataOffset = sizeof(s_jpegHeader);
+
+		// Write the fake DHT segment
+		memcpy(data + dataOffset, s_dhtSegmentHead, sizeof(s_dhtSegmentHead));
+		dataOffset += sizeof(s_dhtSegmentHead);
+		memcpy(data + dataOffset, s_mjpegBitsDCLuminance + 1, 16);
+		dataOffset += 16;
+		memcpy(data + dataOffset, s_dhtSegmentFrag, sizeof(s_dhtSegmentFrag));
+		dataOffset += sizeof(s_dhtSegmentFrag);
+		memcpy(data + dataOffset, s_mjpegValDC, 12);
+		dataOffset += 12;
+		data[dataOffset++] = 0x10;
+		memcpy(data + dataOffset, s_mjpegBitsACLuminance + 1, 16);
+		dataOffset += 16;
+		memcpy(data + dataOffset, s_mjpegValACLuminance, 162);
+		dataOffset += 162;
+		data[dataOffset++] = 0x11;
+		memcpy(data + dataOffset, s_mjpegBitsACChrominance + 1, 16);
+		dataOffset += 16;
+		memcpy(data + dataOffset, s_mjpegValACChrominance, 162);
+		dataOffset += 162;
+
+		_headerSize = dataOffset;
 	}
 
-	// Copy the header
-	memcpy(data, s_jpegHeader, sizeof(s_jpegHeader));
-	uint32 dataOffset = sizeof(s_jpegHeader);
-
-	// Write the fake DHT segment
-	memcpy(data + dataOffset, s_dhtSegmentHead, sizeof(s_dhtSegmentHead));
-	dataOffset += sizeof(s_dhtSegmentHead);
-	memcpy(data + dataOffset, s_mjpegBitsDCLuminance + 1, 16);
-	dataOffset += 16;
-	memcpy(data + dataOffset, s_dhtSegmentFrag, sizeof(s_dhtSegmentFrag));
-	dataOffset += sizeof(s_dhtSegmentFrag);
-	memcpy(data + dataOffset, s_mjpegValDC, 12);
-	dataOffset += 12;
-	data[dataOffset++] = 0x10;
-	memcpy(data + dataOffset, s_mjpegBitsACLuminance + 1, 16);
-	dataOffset += 16;
-	memcpy(data + dataOffset, s_mjpegValACLuminance, 162);
-	dataOffset += 162;
-	data[dataOffset++] = 0x11;
-	memcpy(data + dataOffset, s_mjpegBitsACChrominance + 1, 16);
-	dataOffset += 16;
-	memcpy(data + dataOffset, s_mjpegValACChrominance, 162);
-	dataOffset += 162;
-
-	// Write the actual data
+	// Write the actual data after the header, reusing the buffer of the previous frame
+	_data.resize(_headerSize + stream.size() - inputSkip);
 	stream.seek(inputSkip);
-	stream.read(data + dataOffset, stream.size() - inputSkip);
+	stream.read(_data.begin() + _headerSize, _data.size() - _headerSize);
 
-	Common::MemoryReadStream convertedStream(data, outputSize, DisposeAfterUse::YES);
-	JPEGDecoder jpeg;
-	jpeg.setCodecAccuracy(_accuracy);
-	jpeg.setOutputPixelFormat(_pixelFormat);
+	Common::MemoryReadStream convertedStream(_data.begin(), _data.size());
+	_jpeg->setCodecAccuracy(_accuracy);
+	_jpeg->setOutputPixelFormat(_pixelFormat);
 
-	if (!jpeg.loadStream(convertedStream)) {
+	const Graphics::Surface *surface = _jpeg->decodeFrame(convertedStream);
+	if (!surface) {
 		warning("Failed to decode MJPEG frame");
 		return 0;
 	}
 
-	if (_surface) {
-		_surface->free();
-		delete _surface;
-	}
-
-	_surface = new Graphics::Surface();
-	_surface->copyFrom(*jpeg.getSurface());
-
-	assert(_surface->format == _pixelFormat);
+	assert(surface->format == _pixelFormat);
 
-	return _surface;
+	return surface;
 }
 
 void MJPEGDecoder::setCodecAccuracy(CodecAccuracy accuracy) {
@@ -22,6 +22,7 @@
 #ifndef IMAGE_CODECS_MJPEG_H
 #define IMAGE_CODECS_MJPEG_H
 
+#include "common/array.h"
 #include "image/codecs/codec.h"
 #include "graphics/pixelformat.h"
 
@@ -35,6 +36,8 @@ struct Surface;
 
 namespace Image {
 
+class JPEGDecoder;
+
 /**
  * Motion JPEG decoder.
  *
@@ -52,8 +55,14 @@ public:
 
 private:
 	Graphics::PixelFormat _pixelFormat;
-	Graphics::Surface *_surface;
 	CodecAccuracy _accuracy;
+
+	/** The decoder of the converted frames, which keeps its surface between them. */
+	JPEGDecoder *_jpeg;
+
+	/** The converted frame, starting with the JFIF header and Huffman tables. */
+	Common::Array<byte> _data;
+	uint32 _headerSize;
 };
 
 } // End of namespace Image
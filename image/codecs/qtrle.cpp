@@ -40,7 +40,6 @@ QTRLEDecoder::QTRLEDecoder(uint16 width, uint16 height, byte bitsPerPixel) : Cod
 	_height = height;
 	_surface = 0;
 	_dirtyPalette = false;
-	_colorMap = 0;
 
 	// We need to ensure the width is a multiple of 4
 	_paddedWidth = width;
@@ -55,7 +54,6 @@ QTRLEDecoder::~QTRLEDecoder() {
 		delete _surface;
 	}
 
-	delete[] _colorMap;
 	delete[] _ditherPalette;
 }
 
@@ -322,6 +320,7 @@ inline uint16 readDitherColor24(Common::ReadStream &stream) {
 void QTRLEDecoder::dither24(Common::SeekableReadStream &stream, uint32 rowPtr, uint32 linesToChange) {
 	uint32 pixelPtr = 0;
 	byte *output = (byte *)_surface->getPixels();
+	const byte *colorMap = _colorMap.get();
 
 	static const uint16 colorTableOffsets[] = { 0x0000, 0xC000, 0x4000, 0x8000 };
 
@@ -352,7 +351,7 @@ void QTRLEDecoder::dither24(Common::SeekableReadStream &stream, uint32 rowPtr, u
 				uint16 color = readDitherColor24(stream);
 
 				while (rleCode--) {
-					output[pixelPtr++] = _colorMap[colorTableOffset + color];
+					output[pixelPtr++] = colorMap[colorTableOffset + color];
 					colorTableOffset += 0x4000;
 				}
 			} else {
@@ -362,7 +361,7 @@ void QTRLEDecoder::dither24(Common::SeekableReadStream &stream, uint32 rowPtr, u
 				// copy pixels directly to output
 				while (rleCode--) {
 					uint16 color = readDitherColor24(stream);
-					output[pixelPtr++] = _colorMap[colorTableOffset + color];
+					output[pixelPtr++] = colorMap[colorTableOffset + color];
 					colorTableOffset += 0x4000;
 				}
 			}
@@ -525,8 +524,7 @@ void QTRLEDecoder::setDither(DitherType type, const byte *palette) {
 	memcpy(_ditherPalette, palette, 256 * 3);
 	_dirtyPalette = true;
 
-	delete[] _colorMap;
-	_colorMap = createQuickTimeDitherTable(palette, 256);
+	_colorMap = DitherTables.getQuickTimeTable(palette, 256);
 }
 
 void QTRLEDecoder::createSurface() {
@@ -53,7 +53,7 @@ private:
 	uint32 _paddedWidth;
 	byte *_ditherPalette;
 	bool _dirtyPalette;
-	byte *_colorMap;
+	Common::SharedPtr<byte> _colorMap;
 
 	void createSurface();
 
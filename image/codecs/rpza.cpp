@@ -34,7 +34,6 @@ RPZADecoder::RPZADecoder(uint16 width, uint16 height) : Codec() {
 	_format = Graphics::PixelFormat(2, 5, 5, 5, 0, 10, 5, 0, 0);
 	_ditherPalette = 0;
 	_dirtyPalette = false;
-	_colorMap = 0;
 	_width = width;
 	_height = height;
 	_blockWidth = (width + 3) / 4;
@@ -49,7 +48,6 @@ RPZADecoder::~RPZADecoder() {
 	}
 
 	delete[] _ditherPalette;
-	delete[] _colorMap;
 }
 
 #define ADVANCE_BLOCK() \
@@ -339,9 +337,9 @@ const Graphics::Surface *RPZADecoder::decodeFrame(Common::SeekableReadStream &st
 	}
 
 	if (_colorMap)
-		decodeFrameTmpl<byte, BlockDecoderDither>(stream, (byte *)_surface->getPixels(), _surface->pitch, _blockWidth, _blockHeight, _colorMap);
+		decodeFrameTmpl<byte, BlockDecoderDither>(stream, (byte *)_surface->getPixels(), _surface->pitch, _blockWidth, _blockHeight, _colorMap.get());
 	else
-		decodeFrameTmpl<uint16, BlockDecoderRaw>(stream, (uint16 *)_surface->getPixels(), _surface->pitch / 2, _blockWidth, _blockHeight, _colorMap);
+		decodeFrameTmpl<uint16, BlockDecoderRaw>(stream, (uint16 *)_surface->getPixels(), _surface->pitch / 2, _blockWidth, _blockHeight, _colorMap.get());
 
 	return _surface;
 }
@@ -359,8 +357,7 @@ void RPZADecoder::setDither(DitherType type, const byte *palette) {
 	_dirtyPalette = true;
 	_format = Graphics::PixelFormat::createFormatCLUT8();
 
-	delete[] _colorMap;
-	_colorMap = createQuickTimeDitherTable(palette, 256);
+	_colorMap = DitherTables.getQuickTimeTable(palette, 256);
 }
 
 } // End of namespace Image
@@ -25,14 +25,20 @@
 
 #include "image/jpeg.h"
 
+#include "common/array.h"
 #include "common/debug.h"
 #include "common/endian.h"
+#include "common/jobs.h"
+#include "common/memstream.h"
 #include "common/stream.h"
+#include "common/system.h"
 #include "common/textconsole.h"
 #include "common/util.h"
 #include "graphics/pixelformat.h"
 
 #ifdef USE_JPEG
+#include <setjmp.h>
+
 // The original release of libjpeg v6b did not contain any extern "C" in case
 // its header files are included in a C++ environment. To avoid any linking
 // issues we need to add it on our own.
@@ -48,7 +54,8 @@ JPEGDecoder::JPEGDecoder() :
 		_surface(),
 		_colorSpace(kColorSpaceRGB),
 		_accuracy(CodecAccuracy::Default),
-		_requestedPixelFormat(getByteOrderRgbPixelFormat()) {
+		_requestedPixelFormat(getByteOrderRgbPixelFormat()),
+		_bandCount(0) {
 }
 
 JPEGDecoder::~JPEGDecoder() {
@@ -71,8 +78,18 @@ void JPEGDecoder::destroy() {
 	_surface.free();
 }
 
+void JPEGDecoder::createSurface(uint16 width, uint16 height, const Graphics::PixelFormat &format) {
+	// Video codecs decode many frames of the same size
+	if (_surface.getPixels() && _surface.w == width && _surface.h == height && _surface.format == format)
+		return;
+
+	_surface.free();
+	_surface.create(width, height, format);
+}
+
 const Graphics::Surface *JPEGDecoder::decodeFrame(Common::SeekableReadStream &stream) {
-	if (!loadStream(stream))
+	// Keep the surface of the previous frame, which likely has the same size
+	if (!decodeImage(stream))
 		return 0;
 
 	return getSurface();
@@ -179,6 +196,20 @@ void errorExit(j_common_ptr cinfo) {
 	error("libjpeg: %s", buffer);
 }
 
+/** Error handling which returns to the band decoder instead of quitting. */
+struct BandErrorManager : public jpeg_error_mgr {
+	jmp_buf setjmpBuffer;
+};
+
+void bandErrorExit(j_common_ptr cinfo) {
+	char buffer[JMSG_LENGTH_MAX];
+	(*cinfo->err->format_message)(cinfo, buffer);
+	// Band decoders run on the job system workers, so the image is decoded
+	// again on the calling thread, which reports the error if there is one
+	debug(3, "libjpeg: band decoding failed: %s", buffer);
+	longjmp(((BandErrorManager *)cinfo->err)->setjmpBuffer, 1);
+}
+
 void outputMessage(j_common_ptr cinfo) {
 	char buffer[JMSG_LENGTH_MAX];
 	(*cinfo->err->format_message)(cinfo, buffer);
@@ -229,14 +260,302 @@ J_COLOR_SPACE fromScummvmPixelFormat(const Graphics::PixelFormat &format) {
 	return JCS_UNKNOWN;
 }
 
+// Only split images with at least this many pixels into bands
+const uint kMinBandPixels = 320 * 240;
+
+// Size of the blocks in which the entropy coded data is read
+const uint32 kScanReadSize = 64 * 1024;
+
+/**
+ * A baseline JPEG file, with the offsets of the restart intervals in its
+ * entropy coded data. The DC predictions are reset at every restart marker,
+ * so the intervals can be decoded independently of each other.
+ */
+struct RestartIntervals {
+	Common::Array<byte> data;     ///< The JPEG file, up to its EOI marker.
+	uint32 sofHeightPos;          ///< Offset of the image height in the frame header.
+	uint32 scanStart;             ///< Offset of the entropy coded data.
+	Common::Array<uint32> starts; ///< Start offsets of the restart intervals.
+	Common::Array<uint32> ends;   ///< End offsets of the restart intervals.
+};
+
+/**
+ * Read a JPEG file from the stream, up to the EOI marker following its scan,
+ * and find its restart intervals.
+ */
+bool readRestartIntervals(Common::SeekableReadStream &stream, RestartIntervals &intervals) {
+	Common::Array<byte> &data = intervals.data;
+
+	// Copy the marker segments up to the start of the scan
+	intervals.sofHeightPos = 0;
+	while (true) {
+		if (stream.readByte() != 0xFF)
+			return false;
+
+		byte marker;
+		do {
+			// Skip the fill bytes
+			marker = stream.readByte();
+		} while (marker == 0xFF && !stream.eos());
+
+		if (stream.eos() || stream.err())
+			return false;
+
+		const uint32 pos = data.size();
+		if (marker == 0xD8) {
+			// Start of image
+			data.push_back(0xFF);
+			data.push_back(marker);
+			continue;
+		}
+
+		const uint32 length = stream.readUint16BE();
+		if (length < 2 || stream.eos())
+			return false;
+
+		data.resize(pos + 2 + length);
+		data[pos] = 0xFF;
+		data[pos + 1] = marker;
+		WRITE_BE_UINT16(&data[pos + 2], length);
+		if (stream.read(&data[pos + 4], length - 2) != length - 2)
+			return false;
+
+		if (marker == 0xC0 || marker == 0xC1) {
+			intervals.sofHeightPos = pos + 5;
+		} else if (marker >= 0xC2 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+			// Progressive, lossless or arithmetic coded frame
+			return false;
+		}
+
+		if (marker == 0xDA)
+			break;
+	}
+
+	if (!intervals.sofHeightPos)
+		return false;
+
+	uint32 pos = data.size();
+	intervals.scanStart = pos;
+	intervals.starts.push_back(pos);
+
+	// Read the entropy coded data in blocks until the marker which ends it
+	uint32 capacity = pos;
+	while (true) {
+		if (pos + 1 >= data.size()) {
+			const uint32 size = data.size();
+			if (size + kScanReadSize > capacity) {
+				capacity = MAX(capacity * 2, size + kScanReadSize);
+				data.reserve(capacity);
+			}
+
+			data.resize(size + kScanReadSize);
+			data.resize(size + stream.read(&data[size], kScanReadSize));
+			if (pos + 1 >= data.size())
+				return false;
+		}
+
+		if (data[pos] != 0xFF) {
+			pos++;
+			continue;
+		}
+
+		const byte marker = data[pos + 1];
+		if (marker == 0x00) {
+			// Stuffed zero byte
+			pos += 2;
+		} else if (marker >= 0xD0 && marker <= 0xD7) {
+			intervals.ends.push_back(pos);
+			intervals.starts.push_back(pos + 2);
+			pos += 2;
+		} else if (marker == 0xFF) {
+			// Fill byte
+			pos++;
+		} else {
+			// The end of the scan, which has to be the only one
+			intervals.ends.push_back(pos);
+			data.resize(pos + 2);
+			return marker == JPEG_EOI;
+		}
+	}
+}
+
+/**
+ * Decodes a horizontal band of an image with restart markers, using a JPEG
+ * file made of the headers and the restart intervals covering the band.
+ */
+struct BandDecoder {
+	const RestartIntervals *intervals;
+	Graphics::Surface *surface;
+	J_COLOR_SPACE colorSpace;
+	J_DCT_METHOD dctMethod;
+
+	uint height;           ///< Height of the image.
+	uint stepHeight;       ///< Pixel rows between the restart intervals which start an MCU row.
+	uint intervalsPerStep; ///< Restart intervals between the ones which start an MCU row.
+	uint stepCount;        ///< Number of steps covering the image.
+	uint bandCount;        ///< Number of bands, each covering whole steps.
+	bool *failed;          ///< For each band, whether it could not be decoded.
+
+	bool decode(uint band) const;
+	bool decodeStream(Common::SeekableReadStream &stream, uint top, uint keepTop, uint keepBottom) const;
+
+	static void run(void *param, uint begin, uint end) {
+		const BandDecoder *decoder = (const BandDecoder *)param;
+		for (uint i = begin; i < end; i++)
+			decoder->failed[i] = !decoder->decode(i);
+	}
+};
+
+bool BandDecoder::decode(uint band) const {
+	const uint firstStep = band * stepCount / bandCount;
+	const uint lastStep = (band + 1) * stepCount / bandCount;
+
+	// Chroma upsampling uses the neighbouring rows, so decode one more step
+	// on both sides for the band to match the whole image exactly
+	const uint decodeFirstStep = firstStep > 0 ? firstStep - 1 : 0;
+	const uint decodeLastStep = MIN(lastStep + 1, stepCount);
+	const uint top = decodeFirstStep * stepHeight;
+	const uint bottom = MIN(decodeLastStep * stepHeight, height);
+	const uint keepTop = firstStep * stepHeight;
+	const uint keepBottom = MIN(lastStep * stepHeight, height);
+
+	const uint firstInterval = decodeFirstStep * intervalsPerStep;
+	const uint lastInterval = MIN<uint>(decodeLastStep * intervalsPerStep, intervals->starts.size());
+
+	// Put the restart intervals after the headers, numbering the markers from 0
+	uint32 size = intervals->scanStart;
+	for (uint i = firstInterval; i < lastInterval; i++)
+		size += intervals->ends[i] - intervals->starts[i] + 2;
+
+	byte *data = (byte *)malloc(size);
+	if (!data)
+		return false;
+
+	memcpy(data, intervals->data.begin(), intervals->scanStart);
+	WRITE_BE_UINT16(data + intervals->sofHeightPos, bottom - top);
+
+	uint32 pos = intervals->scanStart;
+	for (uint i = firstInterval; i < lastInterval; i++) {
+		const uint32 length = intervals->ends[i] - intervals->starts[i];
+		memcpy(data + pos, intervals->data.begin() + intervals->starts[i], length);
+		pos += length;
+
+		data[pos++] = 0xFF;
+		data[pos++] = (i + 1 < lastInterval) ? JPEG_RST0 + ((i - firstInterval) & 7) : JPEG_EOI;
+	}
+
+	Common::MemoryReadStream stream(data, size, DisposeAfterUse::YES);
+	return decodeStream(stream, top, keepTop, keepBottom);
+}
+
+bool BandDecoder::decodeStream(Common::SeekableReadStream &stream, uint top, uint keepTop, uint keepBottom) const {
+	// Errors jump back here, so nothing in this function may need to be
+	// destroyed but the decompression structure
+	jpeg_decompress_struct cinfo;
+	BandErrorManager jerr;
+	cinfo.err = jpeg_std_error(&jerr);
+	jerr.error_exit = &bandErrorExit;
+	jerr.output_message = &outputMessage;
+	jpeg_create_decompress(&cinfo);
+	if (setjmp(jerr.setjmpBuffer)) {
+		jpeg_destroy_decompress(&cinfo);
+		return false;
+	}
+
+	jpeg_scummvm_src(&cinfo, &stream);
+	jpeg_read_header(&cinfo, TRUE);
+
+	cinfo.out_color_space = colorSpace;
+	cinfo.dct_method = dctMethod;
+	jpeg_start_decompress(&cinfo);
+
+	JSAMPARRAY scratch = (*cinfo.mem->alloc_sarray)((j_common_ptr)&cinfo, JPOOL_IMAGE, cinfo.output_width * cinfo.output_components, 1);
+	while (cinfo.output_scanline < cinfo.output_height) {
+		const uint y = top + cinfo.output_scanline;
+		JSAMPROW row = (y >= keepTop && y < keepBottom) ? (JSAMPROW)surface->getBasePtr(0, y) : scratch[0];
+		jpeg_read_scanlines(&cinfo, &row, 1);
+	}
+
+	jpeg_finish_decompress(&cinfo);
+	jpeg_destroy_decompress(&cinfo);
+	return true;
+}
+
+uint greatestCommonDivisor(uint a, uint b) {
+	while (b) {
+		const uint t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+/**
+ * Decode the image in bands on the job system if it has restart markers at
+ * the start of MCU rows. Returns false if the image can't be split, or one
+ * of the bands could not be decoded.
+ */
+bool decodeBands(j_decompress_ptr cinfo, Common::SeekableReadStream &stream, int64 startPos, Graphics::Surface &surface, uint bandCount) {
+	if (bandCount < 2 || !cinfo->restart_interval || cinfo->progressive_mode || cinfo->arith_code)
+		return false;
+	if ((cinfo->num_components != 1 && cinfo->num_components != 3) || cinfo->comps_in_scan != cinfo->num_components)
+		return false;
+
+	// Find the restart intervals which start an MCU row
+	const uint mcusPerRow = cinfo->MCUs_per_row;
+	const uint mcuCount = mcusPerRow * cinfo->MCU_rows_in_scan;
+	const uint mcuHeight = (cinfo->num_components == 1) ? DCTSIZE : cinfo->max_v_samp_factor * DCTSIZE;
+	const uint stepMCUs = mcusPerRow / greatestCommonDivisor(mcusPerRow, cinfo->restart_interval) * cinfo->restart_interval;
+	const uint intervalCount = (mcuCount + cinfo->restart_interval - 1) / cinfo->restart_interval;
+
+	BandDecoder decoder;
+	decoder.surface = &surface;
+	decoder.colorSpace = cinfo->out_color_space;
+	decoder.dctMethod = cinfo->dct_method;
+	decoder.height = cinfo->output_height;
+	decoder.stepHeight = stepMCUs / mcusPerRow * mcuHeight;
+	decoder.intervalsPerStep = stepMCUs / cinfo->restart_interval;
+	decoder.stepCount = (intervalCount + decoder.intervalsPerStep - 1) / decoder.intervalsPerStep;
+	decoder.bandCount = MIN(bandCount, decoder.stepCount / 2);
+	if (decoder.bandCount < 2)
+		return false;
+
+	// Read the file, keeping the position of libjpeg for decoding the image
+	// serially if it can't be done in bands
+	const int64 pos = stream.pos();
+	RestartIntervals intervals;
+	stream.seek(startPos);
+	const bool valid = readRestartIntervals(stream, intervals) && intervals.starts.size() == intervalCount;
+	stream.clearErr();
+	stream.seek(pos);
+	if (!valid)
+		return false;
+
+	Common::Array<bool> failed;
+	failed.resize(decoder.bandCount, false);
+	decoder.intervals = &intervals;
+	decoder.failed = failed.begin();
+	JobSys.parallelFor(decoder.bandCount, BandDecoder::run, &decoder);
+
+	for (uint i = 0; i < decoder.bandCount; i++) {
+		if (failed[i])
+			return false;
+	}
+	return true;
+}
+
 } // End of anonymous namespace
 #endif
 
 bool JPEGDecoder::loadStream(Common::SeekableReadStream &stream) {
-#ifdef USE_JPEG
 	// Reset member variables from previous decodings
 	destroy();
 
+	return decodeImage(stream);
+}
+
+bool JPEGDecoder::decodeImage(Common::SeekableReadStream &stream) {
+#ifdef USE_JPEG
 	jpeg_decompress_struct cinfo;
 	jpeg_error_mgr jerr;
 
@@ -254,6 +573,7 @@ bool JPEGDecoder::loadStream(Common::SeekableReadStream &stream) {
 		cinfo.dct_method = JDCT_ISLOW;
 
 	// Initialize our buffer handling
+	const int64 startPos = stream.pos();
 	jpeg_scummvm_src(&cinfo, &stream);
 
 	// Read the file header
@@ -301,13 +621,13 @@ bool JPEGDecoder::loadStream(Common::SeekableReadStream &stream) {
 		} else {
 			outputPixelFormat = _requestedPixelFormat;
 		}
-		_surface.create(cinfo.output_width, cinfo.output_height, outputPixelFormat);
+		createSurface(cinfo.output_width, cinfo.output_height, outputPixelFormat);
 		break;
 	}
 	case kColorSpaceYUV:
 		// We use YUV with 3 bytes per pixel otherwise.
 		// This is pretty ugly since our PixelFormat cannot express YUV...
-		_surface.create(cinfo.output_width, cinfo.output_height, Graphics::PixelFormat(3, 0, 0, 0, 0, 0, 0, 0, 0));
+		createSurface(cinfo.output_width, cinfo.output_height, Graphics::PixelFormat(3, 0, 0, 0, 0, 0, 0, 0, 0));
 		break;
 	default:
 		break;
@@ -317,23 +637,29 @@ bool JPEGDecoder::loadStream(Common::SeekableReadStream &stream) {
 		assert(_surface.format.bytesPerPixel == 4);
 	}
 
-	// Allocate buffer for one scanline
-	JDIMENSION pitch = cinfo.output_width * _surface.format.bytesPerPixel;
-	assert(_surface.pitch >= (int)pitch);
-	JSAMPARRAY buffer = (*cinfo.mem->alloc_sarray)((j_common_ptr)&cinfo, JPOOL_IMAGE, pitch, 1);
+	assert(_surface.pitch >= (int)(cinfo.output_width * cinfo.output_components));
 
-	// Go through the image data scanline by scanline
-	while (cinfo.output_scanline < cinfo.output_height) {
-		byte *dst = (byte *)_surface.getBasePtr(0, cinfo.output_scanline);
+	uint bandCount = _bandCount;
+	if (!bandCount && g_system && cinfo.output_width * cinfo.output_height >= kMinBandPixels)
+		bandCount = JobSys.getConcurrency();
 
-		jpeg_read_scanlines(&cinfo, buffer, 1);
+	if (decodeBands(&cinfo, stream, startPos, _surface, bandCount)) {
+		jpeg_destroy_decompress(&cinfo);
+	} else {
+		// Go through the image data, decoding straight into the surface
+		JSAMPROW rows[16];
+		while (cinfo.output_scanline < cinfo.output_height) {
+			const uint rowCount = MIN<uint>(cinfo.output_height - cinfo.output_scanline, ARRAYSIZE(rows));
+			for (uint i = 0; i < rowCount; i++)
+				rows[i] = (JSAMPROW)_surface.getBasePtr(0, cinfo.output_scanline + i);
 
-		memcpy(dst, buffer[0], pitch);
-	}
+			jpeg_read_scanlines(&cinfo, rows, rowCount);
+		}
 
-	// We are done with decompressing, thus free all the data
-	jpeg_finish_decompress(&cinfo);
-	jpeg_destroy_decompress(&cinfo);
+		// We are done with decompressing, thus free all the data
+		jpeg_finish_decompress(&cinfo);
+		jpeg_destroy_decompress(&cinfo);
+	}
 
 	if (_colorSpace == kColorSpaceRGB && _surface.format != _requestedPixelFormat) {
 		_surface.convertToInPlace(_requestedPixelFormat); // Slow path
@@ -26,6 +26,8 @@
 #include "image/image_decoder.h"
 #include "image/codecs/codec.h"
 
+class JPEGTestSuite;
+
 namespace Common {
 class SeekableReadStream;
 }
@@ -98,12 +100,24 @@ public:
 	void setOutputColorSpace(ColorSpace outSpace) { _colorSpace = outSpace; }
 
 private:
+	friend class ::JPEGTestSuite;
+
 	Graphics::Surface _surface;
 	ColorSpace _colorSpace;
 	Graphics::PixelFormat _requestedPixelFormat;
 	CodecAccuracy _accuracy;
 
+	/**
+	 * Number of horizontal bands decoded in parallel for images with restart
+	 * markers, 0 to use one band per job system thread.
+	 */
+	uint _bandCount;
+
 	Graphics::PixelFormat getByteOrderRgbPixelFormat() const;
+	/** Decode an image into the surface, which is kept if it has the right size. */
+	bool decodeImage(Common::SeekableReadStream &stream);
+	/** Create the surface, unless the one of the previous image can be reused. */
+	void createSurface(uint16 width, uint16 height, const Graphics::PixelFormat &format);
 };
 /** @} */
 } // End of namespace Image
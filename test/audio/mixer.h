@@ -0,0 +1,251 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cxxtest/TestSuite.h>
+
+#include "audio/mixer_intern.h"
+#include "audio/rate.h"
+
+#include "common/debug.h"
+#include "common/random.h"
+#include "common/system.h"
+
+#include "helper.h"
+#include "../null_osystem.h"
+
+class MixerTestSuite : public CxxTest::TestSuite {
+	enum {
+		kOutputRate = 48000,
+		kBufferFrames = 1024
+	};
+
+	static Audio::SeekableAudioStream *createStream(int rate, bool stereo) {
+		return createSineStream<int16>(rate, 1, nullptr, false, stereo);
+	}
+
+public:
+	void test_clamped_add_buffer() {
+		Common::RandomSource rnd("mixer");
+		const int16 edges[] = { -32768, -32767, -16384, -1, 0, 1, 16384, 32766, 32767 };
+
+		for (uint len = 0; len < 40; len++) {
+			int16 dst[40], src[40], ref[40];
+			for (uint i = 0; i < len; i++) {
+				dst[i] = (i & 1) ? edges[rnd.getRandomNumber(ARRAYSIZE(edges) - 1)] : (int16)rnd.getRandomNumber(0xffff);
+				src[i] = (i & 2) ? edges[rnd.getRandomNumber(ARRAYSIZE(edges) - 1)] : (int16)rnd.getRandomNumber(0xffff);
+				ref[i] = dst[i];
+				Audio::clampedAdd(ref[i], src[i]);
+			}
+
+			Audio::clampedAddBuffer(dst, src, len);
+			TS_ASSERT_EQUALS(memcmp(dst, ref, len * sizeof(int16)), 0);
+		}
+	}
+
+#if NULL_OSYSTEM_IS_AVAILABLE
+	void test_channel_control() {
+		Common::install_null_g_system();
+
+		Audio::MixerImpl mixer(kOutputRate);
+		Audio::Mixer &engineMixer = mixer;
+		mixer.setReady(true);
+
+		int16 buffer[kBufferFrames * 2];
+		Audio::SoundHandle handle;
+		engineMixer.playStream(Audio::Mixer::kSFXSoundType, &handle, createStream(22050, false), 42, 200, -20);
+
+		// The request has only been queued, but has to be visible right away
+		TS_ASSERT(mixer.isSoundHandleActive(handle));
+		TS_ASSERT(mixer.isSoundIDActive(42));
+		TS_ASSERT(mixer.hasActiveChannelOfType(Audio::Mixer::kSFXSoundType));
+		TS_ASSERT_EQUALS(mixer.getSoundID(handle), 42);
+		TS_ASSERT_EQUALS(mixer.getChannelVolume(handle), 200);
+		TS_ASSERT_EQUALS(mixer.getChannelBalance(handle), -20);
+		TS_ASSERT_EQUALS(mixer.getChannelRate(handle), 22050u);
+
+		mixer.setChannelVolume(handle, 100);
+		mixer.setChannelBalance(handle, 30);
+		mixer.setChannelRate(handle, 11025);
+		TS_ASSERT_EQUALS(mixer.getChannelVolume(handle), 100);
+		TS_ASSERT_EQUALS(mixer.getChannelBalance(handle), 30);
+		TS_ASSERT_EQUALS(mixer.getChannelRate(handle), 11025u);
+		mixer.resetChannelRate(handle);
+		TS_ASSERT_EQUALS(mixer.getChannelRate(handle), 22050u);
+
+		TS_ASSERT_EQUALS(mixer.mixCallback((byte *)buffer, sizeof(buffer)), kBufferFrames);
+
+		// Flood the queue without running the callback, which makes the
+		// control side drain it, then silence the channel: the last request
+		// must still win
+		for (int i = 0; i < 3 * Audio::MixerImpl::COMMAND_QUEUE_SIZE; i++)
+			mixer.setChannelVolume(handle, i & 0xff);
+		mixer.setChannelVolume(handle, 0);
+
+		mixer.mixCallback((byte *)buffer, sizeof(buffer));
+		TS_ASSERT_EQUALS(mixer._commandsHead.load(), mixer._commandsTail.load());
+		for (int i = 0; i < kBufferFrames * 2; i++)
+			TS_ASSERT_EQUALS(buffer[i], 0);
+
+		// Stopped channels are not touched any more, even by a callback which
+		// did not see the stop request yet
+		int index = 0;
+		while (!mixer._channels[index])
+			index++;
+		mixer._channelFlags[index].fetchAdd(Audio::MixerImpl::kChannelStopped);
+		TS_ASSERT_EQUALS(mixer.mixCallback((byte *)buffer, sizeof(buffer)), 0);
+		mixer._channelFlags[index].store(0);
+		TS_ASSERT_EQUALS(mixer.mixCallback((byte *)buffer, sizeof(buffer)), kBufferFrames);
+
+		// Paused channels are not mixed
+		mixer.setChannelVolume(handle, 255);
+		mixer.pauseHandle(handle, true);
+		mixer.mixCallback((byte *)buffer, sizeof(buffer));
+		for (int i = 0; i < kBufferFrames * 2; i++)
+			TS_ASSERT_EQUALS(buffer[i], 0);
+		mixer.pauseHandle(handle, false);
+
+		// Stopping is visible right away, but the channel is removed by the
+		// callback and then deleted by the control side
+		mixer.stopHandle(handle);
+		TS_ASSERT(!mixer.isSoundHandleActive(handle));
+		TS_ASSERT(mixer._channels[index]);
+		TS_ASSERT(mixer._channelStates[index].retiring);
+
+		const uint stopCommand = (mixer._commandsTail.load() + Audio::MixerImpl::COMMAND_QUEUE_SIZE - 1) % Audio::MixerImpl::COMMAND_QUEUE_SIZE;
+		mixer.mixCallback((byte *)buffer, sizeof(buffer));
+		TS_ASSERT(!mixer._channels[index]);
+		TS_ASSERT(mixer._commands[stopCommand].channel);
+
+		Audio::SoundHandle pending;
+		engineMixer.playStream(Audio::Mixer::kMusicSoundType, &pending, createStream(11025, true));
+		TS_ASSERT(!mixer._commands[stopCommand].channel);
+		TS_ASSERT(!mixer._channelStates[index].retiring);
+		TS_ASSERT(mixer.isSoundHandleActive(pending));
+		mixer.stopAll();
+		TS_ASSERT(!mixer.isSoundHandleActive(pending));
+		TS_ASSERT(!mixer.hasActiveChannelOfType(Audio::Mixer::kMusicSoundType));
+
+		// Finished sounds are reported by the callback
+		Audio::SoundHandle finished;
+		engineMixer.playStream(Audio::Mixer::kSpeechSoundType, &finished, createStream(kOutputRate, false));
+		for (int i = 0; i < 2 * kOutputRate / kBufferFrames + 2; i++)
+			mixer.mixCallback((byte *)buffer, sizeof(buffer));
+		TS_ASSERT(!mixer.isSoundHandleActive(finished));
+		TS_ASSERT(!mixer.isSoundIDActive(42));
+	}
+
+	void test_stop_without_callback() {
+		Common::install_null_g_system();
+
+		Audio::MixerImpl mixer(kOutputRate);
+		Audio::Mixer &engineMixer = mixer;
+		mixer.setReady(true);
+
+		// Stopped channels keep their slots until they were removed, which
+		// the control side does itself once it runs out of slots
+		Audio::SoundHandle handles[Audio::MixerImpl::NUM_CHANNELS];
+		for (int round = 0; round < 3; round++) {
+			for (int i = 0; i < Audio::MixerImpl::NUM_CHANNELS; i++) {
+				engineMixer.playStream(Audio::Mixer::kSFXSoundType, &handles[i], createStream(22050, false));
+				TS_ASSERT(mixer.isSoundHandleActive(handles[i]));
+			}
+
+			mixer.stopAll();
+			for (int i = 0; i < Audio::MixerImpl::NUM_CHANNELS; i++)
+				TS_ASSERT(!mixer.isSoundHandleActive(handles[i]));
+		}
+	}
+
+	void test_sinc_rate_change() {
+		Common::install_null_g_system();
+
+		Audio::MixerImpl mixer(kOutputRate);
+		Audio::Mixer &engineMixer = mixer;
+		mixer.setReady(true);
+		mixer.setRateConverterQuality(Audio::kRateConverterBest);
+
+		int16 buffer[kBufferFrames * 2];
+		Audio::SoundHandle handle;
+		engineMixer.playStream(Audio::Mixer::kSFXSoundType, &handle, createStream(22050, true));
+		mixer.loopChannel(handle);
+		mixer.mixCallback((byte *)buffer, sizeof(buffer));
+
+		// Downsampling switches to a filter bank built by the control side,
+		// which gets the one the callback replaced back
+		const uint first = mixer._commandsTail.load();
+		mixer.setChannelRate(handle, 96000);
+		Audio::RateFilter *filter = mixer._commands[first].filter;
+		TS_ASSERT(filter);
+
+		mixer.mixCallback((byte *)buffer, sizeof(buffer));
+		TS_ASSERT(mixer.isSoundHandleActive(handle));
+		TS_ASSERT(mixer._commands[first].filter);
+		TS_ASSERT_DIFFERS(mixer._commands[first].filter, filter);
+
+		mixer.resetChannelRate(handle);
+		TS_ASSERT(!mixer._commands[first].filter);
+		TS_ASSERT(mixer._commands[first + 1].filter);
+		mixer.mixCallback((byte *)buffer, sizeof(buffer));
+		TS_ASSERT_EQUALS(mixer.getChannelRate(handle), 22050u);
+
+		// Requests for a channel which is gone return the filter as well
+		mixer.setChannelRate(handle, 96000);
+		mixer.stopHandle(handle);
+		mixer.mixCallback((byte *)buffer, sizeof(buffer));
+		engineMixer.playStream(Audio::Mixer::kSFXSoundType, &handle, createStream(22050, true));
+		for (int i = 0; i < Audio::MixerImpl::COMMAND_QUEUE_SIZE; i++)
+			TS_ASSERT(!mixer._commands[i].filter);
+	}
+
+	void test_mix_speed() {
+		Common::install_null_g_system();
+
+		Audio::MixerImpl mixer(kOutputRate);
+		Audio::Mixer &engineMixer = mixer;
+		mixer.setReady(true);
+
+		// A mix of all conversion paths: plain copy, integer ratio and
+		// interpolation, mono and stereo
+		const int rates[] = { 48000, 96000, 22050, 11025 };
+		for (int i = 0; i < Audio::MixerImpl::NUM_CHANNELS; i++) {
+			Audio::SoundHandle handle;
+			engineMixer.playStream(Audio::Mixer::kSFXSoundType, &handle, createStream(rates[i % ARRAYSIZE(rates)], (i & 4) != 0));
+			mixer.loopChannel(handle);
+		}
+
+#ifdef SLOW_TESTS
+		const int seconds = 60;
+#else
+		const int seconds = 1;
+#endif
+
+		int16 buffer[kBufferFrames * 2];
+		const int callbacks = seconds * kOutputRate / kBufferFrames;
+		uint32 start = g_system->getMillis();
+		for (int i = 0; i < callbacks; i++)
+			mixer.mixCallback((byte *)buffer, sizeof(buffer));
+		debug("Mixing %d channels at %d Hz: %d ms for %d s of audio", (int)Audio::MixerImpl::NUM_CHANNELS, (int)kOutputRate, g_system->getMillis() - start, seconds);
+
+		for (int i = 0; i < Audio::MixerImpl::NUM_CHANNELS; i++)
+			TS_ASSERT(mixer._channels[i]);
+	}
+#endif
+};
@@ -0,0 +1,194 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cxxtest/TestSuite.h>
+
+#include "audio/audiostream.h"
+#include "audio/decoders/raw.h"
+#include "audio/mixer.h"
+#include "audio/rate.h"
+
+#include "common/debug.h"
+#include "common/memstream.h"
+#include "common/system.h"
+
+#include "../null_osystem.h"
+
+#include <math.h>
+
+class RateConverterTestSuite : public CxxTest::TestSuite {
+	enum {
+		kAmplitude = 16000
+	};
+
+	static Audio::AudioStream *createTone(int rate, double freq, int frames, bool stereo) {
+		const int channels = stereo ? 2 : 1;
+		int16 *data = (int16 *)malloc(frames * channels * sizeof(int16));
+		for (int i = 0; i < frames; i++) {
+			for (int c = 0; c < channels; c++)
+				data[i * channels + c] = (int16)(kAmplitude * sin(2 * M_PI * freq * i / rate) * (c ? -1 : 1));
+		}
+
+		return Audio::makeRawStream((const byte *)data, frames * channels * sizeof(int16), rate,
+		                            Audio::FLAG_16BITS | (stereo ? Audio::FLAG_STEREO : 0)
+#ifdef SCUMM_LITTLE_ENDIAN
+		                            | Audio::FLAG_LITTLE_ENDIAN
+#endif
+		                            );
+	}
+
+	/** Convert a whole tone and return the largest deviation from the ideal output. */
+	static int toneError(Audio::RateConverterQuality quality, int inRate, int outRate, double freq, int *outFrames = nullptr) {
+		const int inFrames = inRate / 4;
+		Audio::AudioStream *stream = createTone(inRate, freq, inFrames, true);
+		Audio::RateConverter *converter = Audio::makeRateConverter(inRate, outRate, true, true, false, quality);
+
+		const int maxFrames = (int)((int64)inFrames * outRate / inRate) + 64;
+		int16 *out = new int16[maxFrames * 2];
+		memset(out, 0, maxFrames * 2 * sizeof(int16));
+
+		int total = 0;
+		while (!stream->endOfData() || converter->needsDraining()) {
+			const int converted = converter->convert(*stream, out + total * 2, MIN(maxFrames - total, 1000), Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume);
+			if (!converted)
+				break;
+			total += converted;
+		}
+
+		// Skip the edges, where the filter sees the silence around the tone
+		int error = 0;
+		for (int i = 64; i < total - 64; i++) {
+			const int expected = (int)(kAmplitude * sin(2 * M_PI * freq * i / outRate));
+			error = MAX(error, ABS(out[i * 2] - expected));
+			error = MAX(error, ABS(out[i * 2 + 1] + expected));
+		}
+
+		if (outFrames)
+			*outFrames = total;
+
+		delete[] out;
+		delete converter;
+		delete stream;
+		return error;
+	}
+
+public:
+	void test_sinc_same_rate_is_exact() {
+		for (int q = Audio::kRateConverterFast; q <= Audio::kRateConverterBest; q++)
+			TS_ASSERT_LESS_THAN_EQUALS(toneError((Audio::RateConverterQuality)q, 44100, 44100, 1000.0), 1);
+	}
+
+	void test_sinc_upsampling_accuracy() {
+		const int fast = toneError(Audio::kRateConverterFast, 22050, 48000, 3000.0);
+		const int medium = toneError(Audio::kRateConverterMedium, 22050, 48000, 3000.0);
+		const int best = toneError(Audio::kRateConverterBest, 22050, 48000, 3000.0);
+
+		TS_ASSERT_LESS_THAN(fast, kAmplitude / 50);
+		TS_ASSERT_LESS_THAN_EQUALS(medium, fast);
+		TS_ASSERT_LESS_THAN_EQUALS(best, medium);
+		TS_ASSERT_LESS_THAN(best, kAmplitude / 200);
+	}
+
+	void test_sinc_downsampling_accuracy() {
+		TS_ASSERT_LESS_THAN(toneError(Audio::kRateConverterBest, 96000, 44100, 5000.0), kAmplitude / 100);
+		TS_ASSERT_LESS_THAN(toneError(Audio::kRateConverterMedium, 48000, 11025, 1000.0), kAmplitude / 50);
+	}
+
+	void test_sinc_drains_stream() {
+		const int rates[][2] = { { 11025, 48000 }, { 22050, 44100 }, { 44100, 44100 }, { 96000, 48000 }, { 48000, 11025 } };
+		for (int i = 0; i < ARRAYSIZE(rates); i++) {
+			int frames;
+			toneError(Audio::kRateConverterMedium, rates[i][0], rates[i][1], 440.0, &frames);
+
+			const int expected = (int)((int64)(rates[i][0] / 4) * rates[i][1] / rates[i][0]);
+			TS_ASSERT_LESS_THAN_EQUALS(ABS(frames - expected), 1);
+		}
+	}
+
+	void test_sinc_rate_change() {
+		// Pitch changes of upsampled sounds keep the filter bank
+		TS_ASSERT(!Audio::makeRateFilter(22050, 11025, 48000, Audio::kRateConverterMedium));
+		TS_ASSERT(!Audio::makeRateFilter(22050, 96000, 48000, Audio::kRateConverterLinear));
+
+		Audio::AudioStream *stream = createTone(22050, 440.0, 22050, true);
+		Audio::RateConverter *converter = Audio::makeRateConverter(22050, 48000, true, true, false, Audio::kRateConverterMedium);
+		int16 buffer[256 * 2];
+
+		memset(buffer, 0, sizeof(buffer));
+		TS_ASSERT_EQUALS(converter->convert(*stream, buffer, 256, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume), 256);
+
+		// Downsampling needs a wider filter, which is built in advance
+		Audio::RateFilter *filter = Audio::makeRateFilter(22050, 96000, 48000, Audio::kRateConverterMedium);
+		TS_ASSERT(filter);
+		Audio::RateFilter *oldFilter = converter->setInputRateWithFilter(96000, filter);
+		TS_ASSERT(oldFilter);
+		TS_ASSERT_DIFFERS(oldFilter, filter);
+		delete oldFilter;
+		TS_ASSERT_EQUALS(converter->getInputRate(), 96000u);
+		TS_ASSERT_EQUALS(converter->convert(*stream, buffer, 256, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume), 256);
+
+		// Switching back builds the narrow filter right away
+		converter->setInputRate(22050);
+		TS_ASSERT_EQUALS(converter->getInputRate(), 22050u);
+
+		int total = 0;
+		while (!stream->endOfData() || converter->needsDraining()) {
+			memset(buffer, 0, sizeof(buffer));
+			const int converted = converter->convert(*stream, buffer, 256, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume);
+			if (!converted)
+				break;
+			total += converted;
+		}
+		TS_ASSERT(!converter->needsDraining());
+		TS_ASSERT_LESS_THAN(0, total);
+
+		delete converter;
+		delete stream;
+	}
+
+	void test_convert_speed() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+
+#ifdef SLOW_TESTS
+		const int seconds = 60;
+#else
+		const int seconds = 1;
+#endif
+
+		const char *const names[] = { "linear", "fast", "medium", "best" };
+		int16 buffer[1024 * 2];
+
+		for (int q = Audio::kRateConverterLinear; q <= Audio::kRateConverterBest; q++) {
+			Audio::AudioStream *stream = createTone(22050, 440.0, 22050 * seconds, true);
+			Audio::RateConverter *converter = Audio::makeRateConverter(22050, 48000, true, true, false, (Audio::RateConverterQuality)q);
+
+			uint32 start = g_system->getMillis();
+			while (converter->convert(*stream, buffer, 1024, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume) == 1024)
+				;
+			debug("Resampling %d s of 22050 Hz stereo to 48000 Hz (%s): %d ms", seconds, names[q], g_system->getMillis() - start);
+
+			delete converter;
+			delete stream;
+		}
+#endif
+	}
+};
@@ -0,0 +1,121 @@
+#include <cxxtest/TestSuite.h>
+
+#include "backends/fs/posix/posix-iostream.h"
+#include "backends/fs/posix/posix-mmapstream.h"
+#include "common/fs.h"
+#include "common/ptr.h"
+
+#include "../../null_osystem.h"
+
+class PosixMmapStreamTestSuite : public CxxTest::TestSuite {
+	// Copied into the build directory by the test target
+	static const char *dataPath() { return "test/engine-data/encoding.dat"; }
+
+public:
+	void test_matches_stdio() {
+		Common::ScopedPtr<Common::SeekableReadStream> file(PosixIoStream::makeFromPath(dataPath(), StdioStream::WriteMode_Read));
+		TS_ASSERT(file);
+		if (!file)
+			return;
+
+		// Files on network shares or removable media are not mapped
+		Common::ScopedPtr<PosixMmapStream> mapped(PosixMmapStream::makeFromPath(dataPath()));
+		if (!mapped)
+			return;
+
+		const int64 size = file->size();
+		TS_ASSERT_EQUALS(mapped->size(), size);
+		TS_ASSERT_LESS_THAN(4096, size);
+
+		byte *expected = new byte[size];
+		TS_ASSERT_EQUALS(file->read(expected, size), (uint32)size);
+
+		// Sequential reads
+		byte buffer[1000];
+		int64 pos = 0;
+		while (!mapped->eos()) {
+			const uint32 read = mapped->read(buffer, sizeof(buffer));
+			TS_ASSERT_EQUALS(memcmp(buffer, expected + pos, read), 0);
+			pos += read;
+			TS_ASSERT_EQUALS(mapped->pos(), pos);
+		}
+		TS_ASSERT_EQUALS(pos, size);
+		TS_ASSERT(!mapped->err());
+
+		// Random access in all seek modes
+		TS_ASSERT(mapped->seek(100));
+		TS_ASSERT_EQUALS(mapped->readUint32BE(), READ_BE_UINT32(expected + 100));
+		TS_ASSERT(mapped->seek(-8, SEEK_END));
+		TS_ASSERT_EQUALS(mapped->pos(), size - 8);
+		TS_ASSERT_EQUALS(mapped->readUint32LE(), READ_LE_UINT32(expected + size - 8));
+		TS_ASSERT(mapped->seek(-4 - 1000, SEEK_CUR));
+		TS_ASSERT_EQUALS(mapped->read(buffer, 3), 3u);
+		TS_ASSERT_EQUALS(memcmp(buffer, expected + size - 1008, 3), 0);
+		TS_ASSERT(!mapped->seek(-1));
+		TS_ASSERT_EQUALS(mapped->pos(), size - 1005);
+
+		// Reading past the end sets eos, seeking clears it
+		TS_ASSERT(mapped->seek(size + 10));
+		TS_ASSERT_EQUALS(mapped->read(buffer, 1), 0u);
+		TS_ASSERT(mapped->eos());
+		TS_ASSERT(mapped->seek(0));
+		TS_ASSERT(!mapped->eos());
+
+		// Direct access to the mapping
+		const byte *range = mapped->getRangePointer(16, 64);
+		TS_ASSERT(range);
+		if (range)
+			TS_ASSERT_EQUALS(memcmp(range, expected + 16, 64), 0);
+		TS_ASSERT(mapped->getRangePointer(size - 1, 1));
+		TS_ASSERT(mapped->getRangePointer(size, 0));
+		TS_ASSERT(!mapped->getRangePointer(size - 1, 2));
+		TS_ASSERT(!mapped->getRangePointer(-1, 1));
+		TS_ASSERT(!mapped->getRangePointer(size + 1, 0));
+
+		delete[] expected;
+	}
+
+	void test_mapping_is_opt_in() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+		const Common::Path path(dataPath());
+		Common::FSNode node(path);
+
+		Common::ScopedPtr<Common::SeekableReadStream> regular(node.createReadStream());
+		TS_ASSERT(regular);
+		if (regular)
+			TS_ASSERT(!regular->getRangePointer(0, 1));
+
+		Common::ScopedPtr<Common::SeekableReadStream> mapped(node.createMappedReadStream());
+		TS_ASSERT(mapped);
+		if (mapped) {
+			Common::ScopedPtr<PosixMmapStream> direct(PosixMmapStream::makeFromPath(dataPath()));
+			TS_ASSERT_EQUALS(mapped->getRangePointer(0, 1) != nullptr, direct != nullptr);
+		}
+#endif
+	}
+
+	void test_directory_members_are_mapped() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+		Common::FSDirectory dir(Common::Path("test/engine-data"));
+
+		// Game data opened through SearchMan ends up here
+		Common::ScopedPtr<Common::SeekableReadStream> member(dir.createReadStreamForMember(Common::Path("encoding.dat")));
+		TS_ASSERT(member);
+		if (member) {
+			Common::ScopedPtr<PosixMmapStream> direct(PosixMmapStream::makeFromPath(dataPath()));
+			TS_ASSERT_EQUALS(member->getRangePointer(0, 1) != nullptr, direct != nullptr);
+			TS_ASSERT_EQUALS(member->size(), (int64)179670);
+		}
+#endif
+	}
+
+	void test_refuses_unmappable() {
+		TS_ASSERT(!PosixMmapStream::makeFromPath("test/engine-data/does-not-exist"));
+		// Directories can not be mapped
+		TS_ASSERT(!PosixMmapStream::makeFromPath("test/engine-data"));
+		// Neither can files below the requested size
+		TS_ASSERT(!PosixMmapStream::makeFromPath(dataPath(), 1 << 20));
+	}
+};
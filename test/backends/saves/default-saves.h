@@ -0,0 +1,159 @@
+#include <cxxtest/TestSuite.h>
+
+#include "backends/saves/default/default-saves.h"
+#include "common/memstream.h"
+#include "common/ptr.h"
+#include "common/system.h"
+
+#include "../../null_osystem.h"
+
+class DefaultSaveFileManagerTestSuite : public CxxTest::TestSuite {
+	/** Keeps the save files in the build directory. */
+	class TestSaveFileManager : public DefaultSaveFileManager {
+	protected:
+		Common::Path getSavePath() const override { return Common::Path("test/savefiles"); }
+	};
+
+	/** Takes a while to be written, so that the saves queued after it wait. */
+	class SlowWriteStream : public Common::MemoryWriteStreamDynamic {
+	public:
+		SlowWriteStream() : Common::MemoryWriteStreamDynamic(DisposeAfterUse::YES) {}
+
+		uint32 write(const void *dataPtr, uint32 dataSize) override {
+			g_system->delayMillis(200);
+			return Common::MemoryWriteStreamDynamic::write(dataPtr, dataSize);
+		}
+	};
+
+	static const uint32 kSaveSize = 200000;
+
+	static byte saveByte(uint32 pos, uint seed) {
+		return (byte)(pos * 31 + (pos >> 9) + seed * 77);
+	}
+
+	static bool writeSave(DefaultSaveFileManager &manager, const char *filename, uint seed, bool compress = true) {
+		Common::OutSaveFile *file = manager.openForSaving(filename, compress);
+		if (!file)
+			return false;
+
+		byte *data = new byte[kSaveSize];
+		for (uint32 i = 0; i < kSaveSize; i++)
+			data[i] = saveByte(i, seed);
+		file->write(data, kSaveSize);
+		delete[] data;
+
+		file->finalize();
+		const bool success = !file->err();
+		delete file;
+		return success;
+	}
+
+	static bool checkSave(DefaultSaveFileManager &manager, const char *filename, uint seed) {
+		Common::ScopedPtr<Common::InSaveFile> file(manager.openForLoading(filename));
+		if (!file || file->size() != kSaveSize)
+			return false;
+
+		byte *data = new byte[kSaveSize];
+		bool same = file->read(data, kSaveSize) == kSaveSize;
+		for (uint32 i = 0; same && i < kSaveSize; i++)
+			same = data[i] == saveByte(i, seed);
+		delete[] data;
+		return same;
+	}
+
+	/** Queue a save which keeps the writer busy for a while. */
+	static void queueSlowSave(DefaultSaveFileManager &manager) {
+		DefaultSaveFileManager::PendingSave *save = new DefaultSaveFileManager::PendingSave();
+		save->filename = "slow";
+		save->file = new SlowWriteStream();
+		save->size = 16;
+		save->data = (byte *)calloc(save->size, 1);
+		save->compress = false;
+		save->error = Common::kNoError;
+		TS_ASSERT(manager.queueSave(save));
+	}
+
+	static bool isPending(DefaultSaveFileManager &manager, const char *filename) {
+		Common::StackLock lock(manager._savesMutex);
+		for (Common::List<DefaultSaveFileManager::PendingSave *>::const_iterator i = manager._pendingSaves.begin(); i != manager._pendingSaves.end(); ++i) {
+			if ((*i)->filename == filename)
+				return true;
+		}
+		return false;
+	}
+
+	static void createSaveDirectory() {
+		Common::FSNode dir(Common::Path("test/savefiles"));
+		if (!dir.exists())
+			dir.createDirectory();
+	}
+
+public:
+	void test_write_and_read_back() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+		createSaveDirectory();
+		TestSaveFileManager manager;
+
+		TS_ASSERT(writeSave(manager, "plain", 1, false));
+		TS_ASSERT(writeSave(manager, "compressed", 2));
+		manager.waitForSave("plain");
+		manager.waitForSave("compressed");
+		TS_ASSERT(!isPending(manager, "plain"));
+		TS_ASSERT(!isPending(manager, "compressed"));
+
+		TS_ASSERT(checkSave(manager, "plain", 1));
+		TS_ASSERT(checkSave(manager, "compressed", 2));
+		Common::ScopedPtr<Common::InSaveFile> raw(manager.openRawFile("plain"));
+		TS_ASSERT(raw && raw->size() == kSaveSize);
+		raw.reset();
+
+		manager.processPendingSaves(true);
+		TS_ASSERT(manager.removeSavefile("plain"));
+		TS_ASSERT(manager.removeSavefile("compressed"));
+#endif
+	}
+
+	void test_open_while_queued() {
+#if NULL_OSYSTEM_IS_AVAILABLE && NULL_OSYSTEM_HAS_THREADS
+		Common::install_null_g_system();
+		createSaveDirectory();
+		TestSaveFileManager manager;
+
+		TS_ASSERT(writeSave(manager, "queued", 1));
+		manager.waitForSave("queued");
+
+		// The file on disk is truncated until the queued save is written
+		queueSlowSave(manager);
+		TS_ASSERT(writeSave(manager, "queued", 2));
+		TS_ASSERT(isPending(manager, "queued"));
+		TS_ASSERT(checkSave(manager, "queued", 2));
+		TS_ASSERT(!isPending(manager, "queued"));
+
+		manager.processPendingSaves(true);
+		TS_ASSERT(manager.removeSavefile("queued"));
+#endif
+	}
+
+	void test_destroy_with_queued_saves() {
+#if NULL_OSYSTEM_IS_AVAILABLE && NULL_OSYSTEM_HAS_THREADS
+		Common::install_null_g_system();
+		createSaveDirectory();
+		const char *const filenames[] = { "first", "second", "third" };
+
+		TestSaveFileManager *manager = new TestSaveFileManager();
+		queueSlowSave(*manager);
+		for (int i = 0; i < ARRAYSIZE(filenames); i++)
+			TS_ASSERT(writeSave(*manager, filenames[i], i, i != 1));
+		TS_ASSERT(isPending(*manager, filenames[ARRAYSIZE(filenames) - 1]));
+		delete manager;
+
+		// The destructor writes all of them
+		TestSaveFileManager reader;
+		for (int i = 0; i < ARRAYSIZE(filenames); i++) {
+			TS_ASSERT(checkSave(reader, filenames[i], i));
+			TS_ASSERT(reader.removeSavefile(filenames[i]));
+		}
+#endif
+	}
+};
@@ -0,0 +1,113 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/arena.h"
+
+class ArenaTestSuite : public CxxTest::TestSuite
+{
+	public:
+	void test_allocate() {
+		Common::Arena arena(256);
+		byte *a = (byte *)arena.allocate(10);
+		byte *b = (byte *)arena.allocate(10);
+		TS_ASSERT_DIFFERS(a, b);
+		TS_ASSERT_EQUALS((uintptr)a % Common::Arena::kDefaultAlignment, 0u);
+		TS_ASSERT_EQUALS((uintptr)b % Common::Arena::kDefaultAlignment, 0u);
+		memset(a, 1, 10);
+		memset(b, 2, 10);
+		TS_ASSERT_EQUALS(a[9], 1);
+
+		// Allocations larger than a block get their own block
+		byte *big = (byte *)arena.allocate(1000, 64);
+		TS_ASSERT_EQUALS((uintptr)big % 64, 0u);
+		memset(big, 3, 1000);
+		TS_ASSERT_EQUALS(b[0], 2);
+		TS_ASSERT_EQUALS(arena.getAllocationCount(), 3u);
+		TS_ASSERT_EQUALS(arena.getHeapAllocationCount(), 2u);
+
+		char *str = arena.copyString("hello");
+		TS_ASSERT_EQUALS(strcmp(str, "hello"), 0);
+	}
+
+	void test_rewind() {
+		Common::Arena arena(256);
+		void *first = arena.allocate(100);
+		Common::Arena::Marker marker = arena.mark();
+		void *second = arena.allocate(100);
+		for (int i = 0; i < 10; i++)
+			arena.allocate(100);
+		arena.rewind(marker);
+		TS_ASSERT_EQUALS(arena.allocate(100), second);
+
+		// The blocks are kept, so further frames don't use the heap
+		arena.reset();
+		arena.resetStatistics();
+		TS_ASSERT_EQUALS(arena.allocate(100), first);
+		for (int i = 0; i < 10; i++)
+			arena.allocate(100);
+		TS_ASSERT_EQUALS(arena.getAllocationCount(), 11u);
+		TS_ASSERT_EQUALS(arena.getHeapAllocationCount(), 0u);
+
+		marker = arena.mark();
+		{
+			Common::ArenaScope scope(arena);
+			arena.allocate(1000);
+		}
+		TS_ASSERT_EQUALS(arena.mark().block, marker.block);
+		TS_ASSERT_EQUALS(arena.mark().offset, marker.offset);
+
+		arena.reset();
+		arena.freeUnusedBlocks();
+		TS_ASSERT_EQUALS(arena.getMemoryUsage(), 0u);
+	}
+
+	void test_array() {
+		Common::Arena arena(128);
+		Common::ArenaArray<Common::String> array(arena);
+		TS_ASSERT(array.empty());
+		for (int i = 0; i < 100; i++)
+			array.push_back(Common::String::format("string number %d, long enough for the heap", i));
+		TS_ASSERT_EQUALS(array.size(), 100u);
+		TS_ASSERT_EQUALS(array[42], "string number 42, long enough for the heap");
+		array.push_back(array[0]);
+		TS_ASSERT_EQUALS(array.back(), array.front());
+		array.emplace_back("emplaced");
+		TS_ASSERT_EQUALS(array.back(), "emplaced");
+		array.pop_back();
+		array.resize(3);
+		TS_ASSERT_EQUALS(array.size(), 3u);
+
+		Common::Array<Common::String> copy = array.toArray();
+		TS_ASSERT_EQUALS(copy.size(), 3u);
+		TS_ASSERT_EQUALS(copy[2], "string number 2, long enough for the heap");
+	}
+
+	void test_string() {
+		Common::Arena arena(64);
+		Common::ArenaString str(arena, "foo");
+		TS_ASSERT_EQUALS(str.size(), 3u);
+		str += "bar";
+		str += Common::String("baz");
+		str += '!';
+		TS_ASSERT(str == "foobarbaz!");
+		TS_ASSERT(str.equalsIgnoreCase("FOOBARBAZ!"));
+
+		Common::ArenaString copy(str);
+		copy += "?";
+		str += "x";
+		TS_ASSERT(copy == "foobarbaz!?");
+		TS_ASSERT(str == "foobarbaz!x");
+
+		for (int i = 0; i < 10; i++)
+			str += str;
+		TS_ASSERT_EQUALS(str.size(), 11u * 1024);
+		TS_ASSERT_EQUALS(str[11 * 1023], 'f');
+
+		Common::ArenaString formatted = Common::ArenaString::format(arena, "%s %d", "value", 42);
+		TS_ASSERT(formatted == "value 42");
+		TS_ASSERT_EQUALS(formatted.toString(), "value 42");
+
+		formatted.clear();
+		TS_ASSERT(formatted.empty());
+		TS_ASSERT(formatted == "");
+	}
+};
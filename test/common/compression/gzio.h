@@ -0,0 +1,257 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/array.h"
+#include "common/compression/deflate.h"
+#include "common/memstream.h"
+#include "common/ptr.h"
+
+/**
+ * Tests seeking in the gzio inflater. The Clickteam variant of deflate is
+ * the only one which always goes through gzio, even when zlib is available,
+ * so the data is generated in that format. It differs from plain deflate
+ * only in its block headers.
+ */
+class GzioTestSuite : public CxxTest::TestSuite {
+	// Must match CHECKPOINT_INTERVAL in gzio.cpp
+	static const int64 kCheckpointInterval = 0x100000;
+	static const uint32 kDataSize = 5 * 0x100000 + 12345;
+
+	class BitWriter {
+	public:
+		BitWriter() : _bits(0), _count(0) {}
+
+		void putBits(uint32 value, uint count) {
+			_bits |= value << _count;
+			_count += count;
+			while (_count >= 8) {
+				_data.push_back(_bits & 0xff);
+				_bits >>= 8;
+				_count -= 8;
+			}
+		}
+
+		/** Huffman codes are stored starting with their most significant bit */
+		void putCode(uint32 code, uint count) {
+			uint32 reversed = 0;
+			for (uint i = 0; i < count; i++)
+				reversed |= ((code >> i) & 1) << (count - 1 - i);
+			putBits(reversed, count);
+		}
+
+		void align() {
+			if (_count)
+				putBits(0, 8 - _count);
+		}
+
+		const Common::Array<byte> &data() { align(); return _data; }
+
+	private:
+		Common::Array<byte> _data;
+		uint32 _bits;
+		uint _count;
+	};
+
+	static void putLiteralLength(BitWriter &out, uint symbol) {
+		if (symbol < 144)
+			out.putCode(0x30 + symbol, 8);
+		else if (symbol < 256)
+			out.putCode(0x190 + symbol - 144, 9);
+		else if (symbol < 280)
+			out.putCode(symbol - 256, 7);
+		else
+			out.putCode(0xc0 + symbol - 280, 8);
+	}
+
+	static void putMatch(BitWriter &out, uint length, uint distance) {
+		static const uint16 lengthBase[] = {
+			3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+			35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+		};
+		static const byte lengthExtra[] = {
+			0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+			3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+		};
+		static const uint16 distanceBase[] = {
+			1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+			257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+		};
+
+		uint i = ARRAYSIZE(lengthBase) - 1;
+		while (lengthBase[i] > length)
+			i--;
+		putLiteralLength(out, 257 + i);
+		out.putBits(length - lengthBase[i], lengthExtra[i]);
+
+		i = ARRAYSIZE(distanceBase) - 1;
+		while (distanceBase[i] > distance)
+			i--;
+		out.putCode(i, 5);
+		out.putBits(distance - distanceBase[i], i < 4 ? 0 : i / 2 - 1);
+	}
+
+	static uint32 nextRandom(uint32 &seed) {
+		seed = seed * 1103515245 + 12345;
+		return seed >> 8;
+	}
+
+	/**
+	 * Generates kDataSize bytes of data together with their compressed form,
+	 * alternating between stored and fixed Huffman blocks. Back references
+	 * reach up to the full window size, often into earlier blocks. Returns
+	 * the offsets at which blocks start.
+	 */
+	static Common::Array<int64> generate(Common::Array<byte> &plain, Common::Array<byte> &compressed) {
+		Common::Array<int64> blockStarts;
+		BitWriter out;
+		uint32 seed = 1;
+
+		plain.reserve(kDataSize);
+		while (plain.size() < kDataSize) {
+			blockStarts.push_back(plain.size());
+
+			const bool stored = blockStarts.size() % 3 == 0;
+			uint32 blockSize = 20000 + nextRandom(seed) % 40000;
+			if (blockSize > kDataSize - plain.size())
+				blockSize = kDataSize - plain.size();
+			const bool last = plain.size() + blockSize == kDataSize;
+
+			out.putBits(stored ? 7 : 5, 3);
+			out.putBits(last ? 1 : 0, 1);
+
+			if (stored) {
+				out.align();
+				out.putBits(blockSize, 16);
+				for (uint32 i = 0; i < blockSize; i++) {
+					const byte b = nextRandom(seed) & 0xff;
+					plain.push_back(b);
+					out.putBits(b, 8);
+				}
+				continue;
+			}
+
+			const uint32 end = plain.size() + blockSize;
+			while (plain.size() < end) {
+				const uint32 left = end - plain.size();
+				if (left >= 3 && plain.size() >= 32768 && nextRandom(seed) % 4 == 0) {
+					uint length = 3 + nextRandom(seed) % 256;
+					if (length > left)
+						length = left;
+					const uint distance = 1 + nextRandom(seed) % 32768;
+					putMatch(out, length, distance);
+					for (uint i = 0; i < length; i++)
+						plain.push_back(plain[plain.size() - distance]);
+				} else {
+					const byte b = nextRandom(seed) & 0xff;
+					putLiteralLength(out, b);
+					plain.push_back(b);
+				}
+			}
+			putLiteralLength(out, 256);
+		}
+
+		compressed = out.data();
+		return blockStarts;
+	}
+
+	/** Where gzio places its checkpoints, i.e. the first block start after every interval */
+	static Common::Array<int64> checkpoints(const Common::Array<int64> &blockStarts) {
+		Common::Array<int64> result;
+		for (uint i = 0; i < blockStarts.size(); i++) {
+			if (blockStarts[i] >= (result.empty() ? 0 : result.back()) + kCheckpointInterval)
+				result.push_back(blockStarts[i]);
+		}
+		return result;
+	}
+
+	static Common::SeekableReadStream *wrap(const Common::Array<byte> &compressed) {
+		return Common::wrapClickteamReadStream(
+			new Common::MemoryReadStream(compressed.data(), compressed.size()), DisposeAfterUse::YES, kDataSize);
+	}
+
+	static bool readMatches(Common::SeekableReadStream &stream, const Common::Array<byte> &plain, int64 offset, uint32 length) {
+		byte buffer[4096];
+		assert(length <= sizeof(buffer));
+		if (offset + length > plain.size())
+			length = plain.size() - offset;
+
+		if (!stream.seek(offset) || stream.pos() != offset)
+			return false;
+		if (stream.read(buffer, length) != length || stream.pos() != offset + length)
+			return false;
+		return memcmp(buffer, plain.data() + offset, length) == 0;
+	}
+
+public:
+	void test_sequential_read() {
+		Common::Array<byte> plain, compressed;
+		generate(plain, compressed);
+
+		Common::ScopedPtr<Common::SeekableReadStream> stream(wrap(compressed));
+		TS_ASSERT_EQUALS(stream->size(), (int64)kDataSize);
+
+		byte buffer[10000];
+		uint32 pos = 0;
+		while (!stream->eos()) {
+			const uint32 read = stream->read(buffer, sizeof(buffer));
+			TS_ASSERT_EQUALS(memcmp(buffer, plain.data() + pos, read), 0);
+			pos += read;
+		}
+		TS_ASSERT_EQUALS(pos, kDataSize);
+		TS_ASSERT(!stream->err());
+	}
+
+	void test_seek_to_checkpoints() {
+		Common::Array<byte> plain, compressed;
+		const Common::Array<int64> points = checkpoints(generate(plain, compressed));
+		TS_ASSERT_LESS_THAN_EQUALS(4u, points.size());
+
+		Common::ScopedPtr<Common::SeekableReadStream> stream(wrap(compressed));
+
+		// Skip ahead first, so the checkpoints are created on the way
+		TS_ASSERT(readMatches(*stream, plain, kDataSize - 100, 100));
+
+		// Backward, right at, just before and just after every checkpoint
+		for (int i = points.size() - 1; i >= 0; i--) {
+			TS_ASSERT(readMatches(*stream, plain, points[i], 1000));
+			TS_ASSERT(readMatches(*stream, plain, points[i] - 1, 2));
+			TS_ASSERT(readMatches(*stream, plain, points[i] - 500, 1000));
+			TS_ASSERT(readMatches(*stream, plain, points[i] + 1, 1000));
+		}
+
+		// Forward across the checkpoints again
+		for (uint i = 0; i < points.size(); i++) {
+			TS_ASSERT(readMatches(*stream, plain, points[i] - 4096, 4096));
+			TS_ASSERT(readMatches(*stream, plain, points[i], 1));
+			TS_ASSERT(readMatches(*stream, plain, points[i] + 40000, 4096));
+		}
+
+		TS_ASSERT(!stream->err());
+	}
+
+	void test_random_seeks() {
+		Common::Array<byte> plain, compressed;
+		generate(plain, compressed);
+
+		Common::ScopedPtr<Common::SeekableReadStream> stream(wrap(compressed));
+		uint32 seed = 42;
+
+		for (int i = 0; i < 100; i++) {
+			const int64 offset = nextRandom(seed) % kDataSize;
+			const uint32 length = 1 + nextRandom(seed) % 4096;
+			TS_ASSERT(readMatches(*stream, plain, offset, length));
+		}
+
+		// Relative seeks, which mostly end up in the same window
+		TS_ASSERT(stream->seek(3 * kCheckpointInterval));
+		for (int i = 0; i < 100; i++) {
+			const int64 pos = stream->pos();
+			const int64 delta = (int64)(nextRandom(seed) % 200000) - 100000;
+			if (pos + delta < 0 || pos + delta + 4 > kDataSize)
+				continue;
+			TS_ASSERT(stream->seek(delta, SEEK_CUR));
+			TS_ASSERT_EQUALS(stream->readUint32LE(), READ_LE_UINT32(plain.data() + pos + delta));
+		}
+
+		TS_ASSERT(!stream->err());
+	}
+};
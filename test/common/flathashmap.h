@@ -0,0 +1,207 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/flathashmap.h"
+#include "common/hash-str.h"
+#include "common/path.h"
+
+class FlatHashMapTestSuite : public CxxTest::TestSuite
+{
+	public:
+	void test_empty_clear() {
+		Common::FlatHashMap<int, int> container;
+		TS_ASSERT(container.empty());
+		container[0] = 17;
+		container[1] = 33;
+		TS_ASSERT(!container.empty());
+		container.clear();
+		TS_ASSERT(container.empty());
+		TS_ASSERT(!container.contains(0));
+		container[1] = 42;
+		container.clear(true);
+		TS_ASSERT(container.empty());
+		TS_ASSERT(!container.contains(1));
+
+		Common::FlatHashMap<Common::String, Common::String, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> container2;
+		TS_ASSERT(container2.empty());
+		container2["foo"] = "bar";
+		container2["quux"] = "blub";
+		TS_ASSERT(!container2.empty());
+		container2.clear();
+		TS_ASSERT(container2.empty());
+	}
+
+	void test_add_remove() {
+		Common::FlatHashMap<int, int> container;
+		container[0] = 17;
+		container[1] = 33;
+		container[2] = 45;
+		container[3] = 12;
+		container[4] = 96;
+		TS_ASSERT(container.contains(1));
+		container.erase(1);
+		TS_ASSERT(!container.contains(1));
+		container[1] = 42;
+		TS_ASSERT(container.contains(1));
+		TS_ASSERT_EQUALS(container[1], 42);
+		container.erase(container.find(0));
+		container.erase(1);
+		container.erase(2);
+		container.erase(container.find(3));
+		TS_ASSERT_EQUALS(container.size(), 1u);
+		container.erase(4);
+		TS_ASSERT(container.empty());
+		container.erase(4);
+		TS_ASSERT(container.empty());
+	}
+
+	void test_lookup_with_default() {
+		Common::FlatHashMap<int, int> container;
+		container[0] = 17;
+		container[1] = -1;
+
+		const Common::FlatHashMap<int, int> &containerRef = container;
+
+		TS_ASSERT_EQUALS(containerRef.getValOrDefault(0), 17);
+		TS_ASSERT_EQUALS(containerRef.getValOrDefault(17), 0);
+		TS_ASSERT_EQUALS(containerRef.getValOrDefault(1, -10), -1);
+		TS_ASSERT_EQUALS(containerRef.getValOrDefault(17, -10), -10);
+		TS_ASSERT_EQUALS(containerRef.size(), 2u);
+
+		int val = 0;
+		TS_ASSERT(containerRef.tryGetVal(0, val));
+		TS_ASSERT_EQUALS(val, 17);
+		TS_ASSERT(!containerRef.tryGetVal(2, val));
+		TS_ASSERT_EQUALS(val, 17);
+	}
+
+	void test_heterogeneous_lookup() {
+		Common::FlatHashMap<Common::String, int, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> strings;
+		strings["Foo"] = 1;
+		strings[Common::String("bar")] = 2;
+		const char *bar = "BAR";
+		TS_ASSERT(strings.contains("fOO"));
+		TS_ASSERT(strings.contains(bar));
+		TS_ASSERT_EQUALS(strings.find(bar)->_value, 2);
+		TS_ASSERT(!strings.contains("baz"));
+		strings.erase("foo");
+		TS_ASSERT(!strings.contains("Foo"));
+
+		Common::FlatHashMap<Common::Path, int, Common::Path::IgnoreCase_Hash, Common::Path::IgnoreCase_EqualTo> paths;
+		paths[Common::Path("Data/Music.dat")] = 1;
+		paths[Common::Path("|escaped")] = 2;
+		TS_ASSERT(paths.contains("data/MUSIC.DAT"));
+		TS_ASSERT(!paths.contains("data"));
+		TS_ASSERT(!paths.contains("data\\music.dat"));
+		TS_ASSERT_EQUALS(paths.getValOrDefault("DATA/music.dat"), 1);
+		TS_ASSERT_EQUALS(paths.getValOrDefault("|Escaped"), 2);
+
+		Common::FlatHashSet<Common::Path, Common::Path::Hash, Common::Path::EqualTo> caseSensitive;
+		caseSensitive.insert(Common::Path("Data/Music.dat"));
+		TS_ASSERT(caseSensitive.contains("Data/Music.dat"));
+		TS_ASSERT(!caseSensitive.contains("data/music.dat"));
+	}
+
+	void test_iterator() {
+		Common::FlatHashMap<int, int> container;
+		for (int i = 0; i < 5; i++)
+			container[i] = i * 10;
+		container.erase(1);
+		container.erase(0);
+
+		int found = 0;
+		for (Common::FlatHashMap<int, int>::iterator i = container.begin(); i != container.end(); ++i) {
+			int key = i->_key;
+			TS_ASSERT(key >= 0 && key <= 4);
+			TS_ASSERT(!(found & (1 << key)));
+			TS_ASSERT_EQUALS(i->_value, key * 10);
+			found |= 1 << key;
+		}
+		TS_ASSERT(found == 16+8+4);
+
+		found = 0;
+		const Common::FlatHashMap<int, int> &containerRef = container;
+		for (Common::FlatHashMap<int, int>::const_iterator j = containerRef.begin(); j != containerRef.end(); ++j)
+			found |= 1 << j->_key;
+		TS_ASSERT(found == 16+8+4);
+
+		// Erasing the current entry keeps the iterator valid
+		for (Common::FlatHashMap<int, int>::iterator i = container.begin(); i != container.end(); ++i) {
+			if (i->_key != 3)
+				container.erase(i);
+		}
+		TS_ASSERT_EQUALS(container.size(), 1u);
+		TS_ASSERT(container.contains(3));
+
+		container.clear();
+		TS_ASSERT_EQUALS(container.begin(), container.end());
+	}
+
+	void test_copy() {
+		Common::FlatHashMap<int, Common::String> map1, map2;
+		map1[323] = "a value long enough to be allocated on the heap";
+		map1[17] = "short";
+		map2 = map1;
+		map1.clear();
+		TS_ASSERT_EQUALS(map2.size(), 2u);
+		TS_ASSERT_EQUALS(map2[323], "a value long enough to be allocated on the heap");
+		TS_ASSERT_EQUALS(map2[17], "short");
+
+		Common::FlatHashMap<int, Common::String> map3(map2);
+		TS_ASSERT_EQUALS(map3[17], "short");
+	}
+
+	void test_growth() {
+		// Compare against HashMap while keys are added and removed, so the
+		// table grows and has to reuse deleted slots
+		Common::FlatHashMap<Common::String, Common::String> flat;
+		Common::HashMap<Common::String, Common::String> reference;
+		uint32 seed = 1;
+
+		for (int i = 0; i < 20000; i++) {
+			seed = seed * 1103515245 + 12345;
+			const Common::String key = Common::String::format("dir%u/file%u.dat", (seed >> 16) % 8, (seed >> 8) % 1000);
+			if (seed & 0x80000000) {
+				flat.erase(key);
+				reference.erase(key);
+			} else {
+				flat[key] = key + "!";
+				reference[key] = key + "!";
+			}
+		}
+
+		TS_ASSERT_EQUALS(flat.size(), reference.size());
+		for (Common::HashMap<Common::String, Common::String>::const_iterator i = reference.begin(); i != reference.end(); ++i)
+			TS_ASSERT_EQUALS(flat.getValOrDefault(i->_key), i->_value);
+
+		uint count = 0;
+		for (Common::FlatHashMap<Common::String, Common::String>::const_iterator i = flat.begin(); i != flat.end(); ++i, ++count)
+			TS_ASSERT(reference.contains(i->_key));
+		TS_ASSERT_EQUALS(count, reference.size());
+	}
+
+	void test_set() {
+		Common::FlatHashSet<int> set;
+		TS_ASSERT(set.empty());
+		TS_ASSERT(set.insert(5));
+		TS_ASSERT(!set.insert(5));
+		for (int i = 0; i < 100; i++)
+			set.insert(i * 32);
+		TS_ASSERT_EQUALS(set.size(), 101u);
+		TS_ASSERT(set.contains(5));
+		TS_ASSERT(set.contains(99 * 32));
+		TS_ASSERT(!set.contains(6));
+
+		TS_ASSERT(set.erase(5));
+		TS_ASSERT(!set.erase(5));
+		set.erase(set.find(0));
+		TS_ASSERT_EQUALS(set.size(), 99u);
+
+		int sum = 0;
+		for (Common::FlatHashSet<int>::iterator i = set.begin(); i != set.end(); ++i)
+			sum += *i;
+		TS_ASSERT_EQUALS(sum, 32 * (99 * 100 / 2));
+
+		set.clear();
+		TS_ASSERT(set.empty());
+	}
+};
@@ -1,6 +1,7 @@
 #include <cxxtest/TestSuite.h>
 #include "common/util.h"
 #include "common/formats/quicktime.h"
+#include "common/memstream.h"
 
 static const byte VALID_MOOV_DATA[] = { // a minimally 'correct' quicktime file.
 	// size				'moov'					size				'mdat'
@@ -24,6 +25,60 @@ static const byte VALID_MHDR_DATA[] = { // a 'correct' quicktime file with a hea
 	0x0, 0x0, 0x0, 0x8, 0x6d, 0x64, 0x61, 0x74
 };
 
+static void writeAtom(Common::MemoryWriteStreamDynamic &out, uint32 tag, Common::MemoryWriteStreamDynamic &payload) {
+	out.writeUint32BE(payload.size() + 8);
+	out.writeUint32BE(tag);
+	out.write(payload.getData(), payload.size());
+}
+
+// A video track with 2000 chunks: 100 chunks of 2 samples, then chunks of 3
+// samples. Sample i is i + 1 bytes large, chunk i is at 1000 + 16 * i and
+// every tenth sample is a keyframe.
+static void writeSampleTableMovie(Common::MemoryWriteStreamDynamic &out) {
+	Common::MemoryWriteStreamDynamic hdlr(DisposeAfterUse::YES);
+	hdlr.writeUint32BE(0); // version + flags
+	hdlr.writeUint32BE(MKTAG('m', 'h', 'l', 'r'));
+	hdlr.writeUint32BE(MKTAG('v', 'i', 'd', 'e'));
+	hdlr.writeUint32BE(0);
+	hdlr.writeUint32BE(0);
+	hdlr.writeUint32BE(0);
+
+	Common::MemoryWriteStreamDynamic stsc(DisposeAfterUse::YES);
+	stsc.writeUint32BE(0);
+	stsc.writeUint32BE(2);
+	stsc.writeUint32BE(1);   stsc.writeUint32BE(2); stsc.writeUint32BE(1);
+	stsc.writeUint32BE(101); stsc.writeUint32BE(3); stsc.writeUint32BE(2);
+
+	Common::MemoryWriteStreamDynamic stsz(DisposeAfterUse::YES);
+	stsz.writeUint32BE(0);
+	stsz.writeUint32BE(0);
+	stsz.writeUint32BE(5900);
+	for (uint32 i = 0; i < 5900; i++)
+		stsz.writeUint32BE(i + 1);
+
+	Common::MemoryWriteStreamDynamic stco(DisposeAfterUse::YES);
+	stco.writeUint32BE(0);
+	stco.writeUint32BE(2000);
+	for (uint32 i = 0; i < 2000; i++)
+		stco.writeUint32BE(1000 + 16 * i);
+
+	Common::MemoryWriteStreamDynamic stss(DisposeAfterUse::YES);
+	stss.writeUint32BE(0);
+	stss.writeUint32BE(590);
+	for (uint32 i = 0; i < 590; i++)
+		stss.writeUint32BE(i * 10 + 1);
+
+	Common::MemoryWriteStreamDynamic trak(DisposeAfterUse::YES);
+	writeAtom(trak, MKTAG('h', 'd', 'l', 'r'), hdlr);
+	writeAtom(trak, MKTAG('s', 't', 's', 'c'), stsc);
+	writeAtom(trak, MKTAG('s', 't', 's', 'z'), stsz);
+	writeAtom(trak, MKTAG('s', 't', 'c', 'o'), stco);
+	writeAtom(trak, MKTAG('s', 't', 's', 's'), stss);
+
+	Common::MemoryWriteStreamDynamic moov(DisposeAfterUse::YES);
+	writeAtom(moov, MKTAG('t', 'r', 'a', 'k'), trak);
+	writeAtom(out, MKTAG('m', 'o', 'o', 'v'), moov);
+}
 
 class QuickTimeTestParser : public Common::QuickTimeParser {
 public:
@@ -80,4 +135,76 @@ public:
 		TS_ASSERT(!result);
 	}
 
+	void test_sampleTables() {
+		Common::MemoryWriteStreamDynamic data(DisposeAfterUse::YES);
+		writeSampleTableMovie(data);
+		Common::MemoryReadStream stream(data.getData(), data.size());
+
+		QuickTimeTestParser parser;
+		TS_ASSERT(parser.parseStream(&stream, DisposeAfterUse::NO));
+		TS_ASSERT_EQUALS(parser.getTracks().size(), 1u);
+		const auto *track = parser.getTracks()[0];
+
+		// Nothing is read from the tables until it is needed
+		TS_ASSERT_EQUALS(track->sampleCount, 5900u);
+		TS_ASSERT_EQUALS(track->sampleSizes.size(), 5900u);
+		TS_ASSERT_EQUALS(track->chunkOffsets.size(), 2000u);
+		TS_ASSERT_EQUALS(track->keyframes.size(), 590u);
+		TS_ASSERT_EQUALS(track->sampleSizes.getLoadedCount(), 0u);
+		TS_ASSERT_EQUALS(track->chunkOffsets.getLoadedCount(), 0u);
+
+		// Reading an entry loads its page, and leaves the stream where it was
+		stream.seek(7);
+		TS_ASSERT_EQUALS(track->chunkOffsets[1500], 1000u + 16 * 1500);
+		TS_ASSERT_EQUALS(track->chunkOffsets.getLoadedCount(), 2000u - 1024);
+		TS_ASSERT_EQUALS(track->sampleSizes[4000], 4001u);
+		TS_ASSERT_EQUALS(track->sampleSizes.getLoadedCount(), 1024u);
+		TS_ASSERT_EQUALS(stream.pos(), 7);
+
+		uint32 chunk, firstSample, descId;
+		TS_ASSERT(track->findSampleChunk(0, chunk, firstSample, descId));
+		TS_ASSERT_EQUALS(chunk, 0u);
+		TS_ASSERT_EQUALS(firstSample, 0u);
+		TS_ASSERT_EQUALS(descId, 1u);
+		TS_ASSERT(track->findSampleChunk(199, chunk, firstSample, descId));
+		TS_ASSERT_EQUALS(chunk, 99u);
+		TS_ASSERT_EQUALS(firstSample, 198u);
+		TS_ASSERT(track->findSampleChunk(205, chunk, firstSample, descId));
+		TS_ASSERT_EQUALS(chunk, 101u);
+		TS_ASSERT_EQUALS(firstSample, 203u);
+		TS_ASSERT_EQUALS(descId, 2u);
+		TS_ASSERT(track->findSampleChunk(5899, chunk, firstSample, descId));
+		TS_ASSERT_EQUALS(chunk, 1999u);
+		TS_ASSERT(!track->findSampleChunk(5900, chunk, firstSample, descId));
+
+		TS_ASSERT_EQUALS(track->getChunkSampleCount(50, firstSample), 2u);
+		TS_ASSERT_EQUALS(firstSample, 100u);
+		TS_ASSERT_EQUALS(track->getChunkSampleCount(100, firstSample), 3u);
+		TS_ASSERT_EQUALS(firstSample, 200u);
+
+		TS_ASSERT_EQUALS(track->findKeyframe(0), 0u);
+		TS_ASSERT_EQUALS(track->findKeyframe(15), 10u);
+		TS_ASSERT_EQUALS(track->findKeyframe(5899), 5890u);
+	}
+
+	void test_sampleTablesBeginOffset() {
+		Common::MemoryWriteStreamDynamic data(DisposeAfterUse::YES);
+		writeSampleTableMovie(data);
+		Common::MemoryReadStream stream(data.getData(), data.size());
+
+		QuickTimeTestParser parser;
+		parser.setChunkBeginOffset(1000);
+		TS_ASSERT(parser.parseStream(&stream, DisposeAfterUse::NO));
+		TS_ASSERT_EQUALS(parser.getTracks()[0]->chunkOffsets[0], 0u);
+		TS_ASSERT_EQUALS(parser.getTracks()[0]->chunkOffsets[1999], 16u * 1999);
+	}
+
+	void test_sampleTablesTruncated() {
+		Common::MemoryWriteStreamDynamic data(DisposeAfterUse::YES);
+		writeSampleTableMovie(data);
+		Common::MemoryReadStream stream(data.getData(), data.size() - 100);
+
+		QuickTimeTestParser parser;
+		TS_ASSERT(!parser.parseStream(&stream, DisposeAfterUse::NO));
+	}
 };
@@ -0,0 +1,132 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/jobs.h"
+#include "../null_osystem.h"
+
+static void incrementJob(void *param) {
+	(*(int *)param)++;
+}
+
+static void fillRange(void *param, uint begin, uint end) {
+	byte *data = (byte *)param;
+	for (uint i = begin; i < end; i++)
+		data[i]++;
+}
+
+static void sumRange(void *param, uint begin, uint end) {
+	uint32 *data = (uint32 *)param;
+	for (uint i = begin; i < end; i++) {
+		// Enough work per item for the slices to overlap on the workers
+		uint32 sum = 0;
+		for (uint j = 0; j <= i; j++)
+			sum += j;
+		data[i] = sum;
+	}
+}
+
+// Waits on a group of its own from inside a job
+static void nestedJob(void *param) {
+	int *counters = (int *)param;
+	Common::JobGroup group;
+	for (int i = 0; i < 8; i++)
+		JobSys.addJob(group, incrementJob, &counters[i]);
+	JobSys.wait(group);
+}
+
+class JobSystemTestSuite : public CxxTest::TestSuite
+{
+public:
+	void test_jobs() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+
+		int counters[16] = { 0 };
+		Common::JobGroup group;
+		for (int i = 0; i < 16; i++)
+			JobSys.addJob(group, incrementJob, &counters[i]);
+		JobSys.wait(group);
+
+		for (int i = 0; i < 16; i++)
+			TS_ASSERT_EQUALS(counters[i], 1);
+
+		// Waiting on an empty group returns immediately
+		JobSys.wait(group);
+
+		Common::JobSystem::destroy();
+#endif
+	}
+
+	void test_parallel_for() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+
+		byte data[1000] = { 0 };
+		JobSys.parallelFor(ARRAYSIZE(data), fillRange, data, 7);
+		JobSys.parallelFor(0, fillRange, data);
+
+		for (uint i = 0; i < ARRAYSIZE(data); i++)
+			TS_ASSERT_EQUALS(data[i], 1);
+
+		Common::JobSystem::destroy();
+#endif
+	}
+
+	void test_workers() {
+#if NULL_OSYSTEM_IS_AVAILABLE && NULL_OSYSTEM_HAS_THREADS
+		Common::install_null_g_system(4);
+		TS_ASSERT_EQUALS(JobSys.getWorkerCount(), 3u);
+
+		// Several rounds, so that jobs are also added while workers are
+		// still busy with the previous ones
+		int counters[64] = { 0 };
+		for (int round = 0; round < 10; round++) {
+			Common::JobGroup group;
+			for (int i = 0; i < 64; i++)
+				JobSys.addJob(group, incrementJob, &counters[i]);
+			JobSys.wait(group);
+		}
+
+		for (int i = 0; i < 64; i++)
+			TS_ASSERT_EQUALS(counters[i], 10);
+
+		Common::JobSystem::destroy();
+		Common::install_null_g_system();
+#endif
+	}
+
+	void test_workers_parallel_for() {
+#if NULL_OSYSTEM_IS_AVAILABLE && NULL_OSYSTEM_HAS_THREADS
+		Common::install_null_g_system(4);
+
+		uint32 data[2000];
+		JobSys.parallelFor(ARRAYSIZE(data), sumRange, data, 16);
+
+		for (uint i = 0; i < ARRAYSIZE(data); i++)
+			TS_ASSERT_EQUALS(data[i], i * (i + 1) / 2);
+
+		Common::JobSystem::destroy();
+		Common::install_null_g_system();
+#endif
+	}
+
+	void test_workers_nested_wait() {
+#if NULL_OSYSTEM_IS_AVAILABLE && NULL_OSYSTEM_HAS_THREADS
+		Common::install_null_g_system(3);
+
+		// More waiting jobs than workers: each must run the jobs of its own
+		// group rather than block a worker forever
+		int counters[6][8] = { { 0 } };
+		Common::JobGroup group;
+		for (int i = 0; i < 6; i++)
+			JobSys.addJob(group, nestedJob, counters[i]);
+		JobSys.wait(group);
+
+		for (int i = 0; i < 6; i++)
+			for (int j = 0; j < 8; j++)
+				TS_ASSERT_EQUALS(counters[i][j], 1);
+
+		Common::JobSystem::destroy();
+		Common::install_null_g_system();
+#endif
+	}
+};
@@ -104,4 +104,40 @@ class MemoryReadStreamTestSuite : public CxxTest::TestSuite {
 		ms.seek(0, SEEK_SET);
 		TS_ASSERT(!ms.eos());
 	}
+
+	void test_range_pointer() {
+		byte contents[] = { 1, 2, 3, 4, 5, 6, 7 };
+		Common::MemoryReadStream ms(contents, sizeof(contents));
+
+		TS_ASSERT_EQUALS(ms.getRangePointer(0, 7), contents);
+		TS_ASSERT_EQUALS(ms.getRangePointer(2, 3), contents + 2);
+		TS_ASSERT_EQUALS(ms.getRangePointer(7, 0), contents + 7);
+
+		// Ranges outside of the stream are rejected
+		TS_ASSERT(!ms.getRangePointer(5, 3));
+		TS_ASSERT(!ms.getRangePointer(-1, 1));
+		TS_ASSERT(!ms.getRangePointer(8, 0));
+
+		// The position is left untouched, and does not affect the result
+		TS_ASSERT_EQUALS(ms.pos(), 0);
+		ms.seek(4);
+		TS_ASSERT_EQUALS(ms.getRangePointer(1, 1), contents + 1);
+	}
+
+	void test_shared_range_pointer() {
+		byte contents[] = { 1, 2, 3, 4, 5, 6, 7 };
+		Common::SharedPtr<Common::SeekableReadStream> ms(new Common::MemoryReadStream(contents, sizeof(contents)));
+
+		Common::SharedPtr<byte> view = Common::getSharedRangePointer(ms, 2, 3);
+		TS_ASSERT_EQUALS(view.get(), contents + 2);
+		TS_ASSERT_EQUALS(ms.refCount(), 2);
+
+		// A stream over the view reads the original memory
+		Common::MemoryReadStream viewStream(view, 3);
+		TS_ASSERT_EQUALS(viewStream.readByte(), 3);
+		TS_ASSERT_EQUALS(viewStream.getRangePointer(0, 3), contents + 2);
+
+		TS_ASSERT(!Common::getSharedRangePointer(ms, 5, 3));
+		TS_ASSERT(!Common::getSharedRangePointer(Common::SharedPtr<Common::SeekableReadStream>(), 0, 0));
+	}
 };
@@ -0,0 +1,207 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/memstream.h"
+#include "common/profiler.h"
+#include "../null_osystem.h"
+
+class ProfilerTestSuite : public CxxTest::TestSuite
+{
+	enum {
+		kAudioZones = 20000
+	};
+
+	static void audioThread(void *param) {
+		for (int i = 0; i < kAudioZones; i++)
+			PROFILE_ZONE_TRACK("audio", Common::Profiler::kTrackAudio);
+	}
+
+	static void workerThread(void *param) {
+		for (int i = 0; i < kAudioZones; i++)
+			PROFILE_ZONE("worker");
+	}
+
+public:
+	void test_disabled() {
+		// Zones and counters are no-ops which do not need g_system
+		TS_ASSERT(!Common::Profiler::isEnabled());
+		PROFILE_ZONE("disabled");
+		PROFILE_COUNT("disabled", 1);
+	}
+
+	void test_zones_and_counters() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+		ProfilerMan.setEnabled(true);
+
+		{
+			PROFILE_ZONE("outer");
+			PROFILE_COUNT("items", 2);
+			{
+				PROFILE_ZONE("inner");
+				PROFILE_COUNT("items", 3);
+			}
+			PROFILE_ZONE_TRACK("audio", Common::Profiler::kTrackAudio);
+		}
+		ProfilerMan.frameMark();
+		ProfilerMan.frameMark();
+
+		Common::Array<Common::Profiler::Frame> frames;
+		ProfilerMan.getFrames(frames);
+		TS_ASSERT_EQUALS(frames.size(), 2u);
+		TS_ASSERT_EQUALS(frames[0].number, 0u);
+		TS_ASSERT_EQUALS(frames[1].number, 1u);
+		TS_ASSERT_LESS_THAN_EQUALS(frames[0].start, frames[0].end);
+		TS_ASSERT_EQUALS(frames[0].end, frames[1].start);
+
+		Common::Array<const char *> counterNames;
+		ProfilerMan.getCounterNames(counterNames);
+		TS_ASSERT_EQUALS(counterNames.size(), 1u);
+		TS_ASSERT_EQUALS(frames[0].counters[0], 5);
+		TS_ASSERT_EQUALS(frames[1].counters[0], 0);
+
+		// Zones are listed in the order they were closed
+		Common::Array<Common::Profiler::Zone> zones;
+		ProfilerMan.getZones(frames[0], zones);
+		TS_ASSERT_EQUALS(zones.size(), 3u);
+		TS_ASSERT_EQUALS(Common::String(zones[0].name), "inner");
+		TS_ASSERT_EQUALS(zones[0].depth, 1);
+		TS_ASSERT_EQUALS(Common::String(zones[1].name), "audio");
+		TS_ASSERT_EQUALS(zones[1].track, Common::Profiler::kTrackAudio);
+		TS_ASSERT_EQUALS(zones[1].depth, 0);
+		TS_ASSERT_EQUALS(Common::String(zones[2].name), "outer");
+		TS_ASSERT_EQUALS(zones[2].depth, 0);
+		TS_ASSERT_LESS_THAN_EQUALS(zones[2].start, zones[0].start);
+		TS_ASSERT_LESS_THAN_EQUALS(zones[0].end, zones[2].end);
+
+		ProfilerMan.getZones(frames[1], zones);
+		TS_ASSERT(zones.empty());
+
+		Common::MemoryWriteStreamDynamic trace(DisposeAfterUse::YES);
+		ProfilerMan.exportChromeTrace(trace);
+		Common::String json((const char *)trace.getData(), trace.size());
+		TS_ASSERT(json.hasPrefix("{\"traceEvents\":["));
+		TS_ASSERT(json.contains("\"name\":\"inner\",\"ph\":\"X\",\"pid\":1,\"tid\":1"));
+		TS_ASSERT(json.contains("\"name\":\"audio\",\"ph\":\"X\",\"pid\":1,\"tid\":2"));
+		TS_ASSERT(json.contains("\"name\":\"items\",\"ph\":\"C\""));
+		TS_ASSERT(json.contains("\"value\":5"));
+		TS_ASSERT(json.hasSuffix("]}\n"));
+
+		Common::Profiler::destroy();
+#endif
+	}
+
+	void test_frame_history() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+		ProfilerMan.setEnabled(true);
+
+		for (uint i = 0; i < Common::Profiler::kFrameHistory + 10; i++) {
+			PROFILE_ZONE("frame");
+			ProfilerMan.frameMark();
+		}
+
+		// Only the most recent frames are kept
+		Common::Array<Common::Profiler::Frame> frames;
+		ProfilerMan.getFrames(frames);
+		TS_ASSERT_EQUALS(frames.size(), (uint)Common::Profiler::kFrameHistory);
+		TS_ASSERT_EQUALS(frames[0].number, 10u);
+		TS_ASSERT_EQUALS(frames.back().number, Common::Profiler::kFrameHistory + 9u);
+
+		// Each zone closes after its frame mark, so it lands in the next frame
+		Common::Array<Common::Profiler::Zone> zones;
+		ProfilerMan.getZones(frames[0], zones);
+		TS_ASSERT_EQUALS(zones.size(), 1u);
+
+		// Disabling keeps the data, enabling again starts over
+		ProfilerMan.setEnabled(false);
+		ProfilerMan.frameMark();
+		ProfilerMan.getFrames(frames);
+		TS_ASSERT_EQUALS(frames.size(), (uint)Common::Profiler::kFrameHistory);
+		ProfilerMan.setEnabled(true);
+		ProfilerMan.getFrames(frames);
+		TS_ASSERT(frames.empty());
+
+		Common::Profiler::destroy();
+#endif
+	}
+
+	void test_audio_thread() {
+#if NULL_OSYSTEM_IS_AVAILABLE && NULL_OSYSTEM_HAS_THREADS
+		Common::install_null_g_system();
+		ProfilerMan.setEnabled(true);
+
+		// The audio track is written without a lock while the main thread
+		// closes zones and ends frames
+		Common::ThreadInternal *thread = g_system->createThread(audioThread, nullptr);
+		TS_ASSERT(thread);
+		for (int i = 0; i < 200; i++) {
+			{
+				PROFILE_ZONE("main");
+			}
+			ProfilerMan.frameMark();
+		}
+		thread->join();
+		delete thread;
+		ProfilerMan.frameMark();
+
+		Common::Array<Common::Profiler::Frame> frames;
+		Common::Array<Common::Profiler::Zone> zones;
+		ProfilerMan.getFrames(frames);
+		TS_ASSERT_EQUALS(frames.size(), 201u);
+
+		uint mainZones = 0, audioZones = 0;
+		for (uint i = 0; i < frames.size(); i++) {
+			ProfilerMan.getZones(frames[i], zones);
+			for (uint z = 0; z < zones.size(); z++) {
+				if (zones[z].track == Common::Profiler::kTrackAudio) {
+					TS_ASSERT_EQUALS(Common::String(zones[z].name), "audio");
+					audioZones++;
+				} else {
+					TS_ASSERT_EQUALS(Common::String(zones[z].name), "main");
+					mainZones++;
+				}
+				if (z > 0)
+					TS_ASSERT_LESS_THAN(zones[z - 1].order, zones[z].order);
+			}
+		}
+		TS_ASSERT_EQUALS(mainZones, 200u);
+		TS_ASSERT_EQUALS(audioZones, (uint)kAudioZones);
+
+		Common::Profiler::destroy();
+		Common::install_null_g_system();
+#endif
+	}
+
+	void test_other_threads() {
+#if NULL_OSYSTEM_IS_AVAILABLE && NULL_OSYSTEM_HAS_THREADS && !defined(NO_CXX11_THREAD_LOCAL)
+		Common::install_null_g_system();
+		ProfilerMan.setEnabled(true);
+		TS_ASSERT(Common::Profiler::isMainThread());
+
+		// Zones on the main track are dropped on other threads, rather than
+		// racing with the main thread
+		Common::ThreadInternal *thread = g_system->createThread(workerThread, nullptr);
+		TS_ASSERT(thread);
+		for (int i = 0; i < 200; i++) {
+			PROFILE_ZONE("main");
+		}
+		thread->join();
+		delete thread;
+		ProfilerMan.frameMark();
+
+		Common::Array<Common::Profiler::Frame> frames;
+		Common::Array<Common::Profiler::Zone> zones;
+		ProfilerMan.getFrames(frames);
+		TS_ASSERT_EQUALS(frames.size(), 1u);
+		ProfilerMan.getZones(frames[0], zones);
+		TS_ASSERT_EQUALS(zones.size(), 200u);
+		for (uint z = 0; z < zones.size(); z++) {
+			TS_ASSERT_EQUALS(Common::String(zones[z].name), "main");
+			TS_ASSERT_EQUALS(zones[z].depth, 0);
+		}
+
+		Common::Profiler::destroy();
+		Common::install_null_g_system();
+#endif
+	}
+};
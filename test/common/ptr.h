@@ -166,6 +166,25 @@ class PtrTestSuite : public CxxTest::TestSuite {
 		TS_ASSERT(a.expired());
 		TS_ASSERT(!a.lock());
 	}
+
+	void test_aliasing() {
+		TS_ASSERT_EQUALS(InstanceCountingClass::count, 0);
+		{
+			int value = 0;
+			Common::SharedPtr<int> alias;
+			{
+				Common::SharedPtr<InstanceCountingClass> owner(new InstanceCountingClass());
+				alias = Common::SharedPtr<int>(owner, &value);
+				TS_ASSERT_EQUALS(alias.get(), &value);
+				TS_ASSERT_EQUALS(owner.refCount(), 2);
+			}
+
+			// The alias keeps the owned object alive
+			TS_ASSERT_EQUALS(InstanceCountingClass::count, 1);
+			TS_ASSERT_EQUALS(alias.refCount(), 1);
+		}
+		TS_ASSERT_EQUALS(InstanceCountingClass::count, 0);
+	}
 };
 
 int PtrTestSuite::InstanceCountingClass::count = 0;
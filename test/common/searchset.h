@@ -0,0 +1,135 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/archive.h"
+#include "common/memstream.h"
+
+class SearchSetTestArchive : public Common::Archive {
+public:
+	SearchSetTestArchive(bool fixed) : _self(this), _fixed(fixed), _lookups(0) {}
+
+	void addMember(const char *path) { _members[Common::Path(path)] = true; }
+	void removeMember(const char *path) { _members.erase(Common::Path(path)); }
+
+	bool hasFile(const Common::Path &path) const override {
+		_lookups++;
+		return _members.contains(path);
+	}
+
+	int listMembers(Common::ArchiveMemberList &list) const override {
+		return 0;
+	}
+
+	const Common::ArchiveMemberPtr getMember(const Common::Path &path) const override {
+		return Common::ArchiveMemberPtr(new Common::GenericArchiveMember(path, *this));
+	}
+
+	Common::SeekableReadStream *createReadStreamForMember(const Common::Path &path) const override {
+		if (!_members.contains(path))
+			return nullptr;
+		// The stream contents tell which archive opened it
+		return new Common::MemoryReadStream((const byte *)&_self, sizeof(_self));
+	}
+
+	bool hasFixedMembers() const override { return _fixed; }
+
+	const SearchSetTestArchive *_self;
+	bool _fixed;
+	mutable int _lookups;
+	Common::HashMap<Common::Path, bool, Common::Path::IgnoreCase_Hash, Common::Path::IgnoreCase_EqualTo> _members;
+};
+
+class SearchSetTestSuite : public CxxTest::TestSuite
+{
+	const void *openedBy(Common::SearchSet &set, const char *path) {
+		Common::SeekableReadStream *stream = set.createReadStreamForMember(Common::Path(path));
+		if (!stream)
+			return nullptr;
+		const void *archive;
+		stream->read(&archive, sizeof(archive));
+		delete stream;
+		return archive;
+	}
+
+	public:
+	void test_priority() {
+		Common::SearchSet set;
+		SearchSetTestArchive *low = new SearchSetTestArchive(true);
+		SearchSetTestArchive *high = new SearchSetTestArchive(true);
+		SearchSetTestArchive *dynamic = new SearchSetTestArchive(false);
+		low->addMember("a.dat");
+		low->addMember("b.dat");
+		high->addMember("b.dat");
+		set.add("low", low, 0);
+		set.add("high", high, 10);
+		set.add("dynamic", dynamic, 5);
+
+		TS_ASSERT(set.hasFile("a.dat"));
+		TS_ASSERT(set.hasFile("B.DAT"));
+		TS_ASSERT(!set.hasFile("c.dat"));
+		TS_ASSERT_EQUALS(openedBy(set, "a.dat"), low);
+		TS_ASSERT_EQUALS(openedBy(set, "b.dat"), high);
+
+		// Members added to archives which may change are found
+		dynamic->addMember("a.dat");
+		dynamic->addMember("c.dat");
+		TS_ASSERT(set.hasFile("c.dat"));
+		TS_ASSERT_EQUALS(openedBy(set, "a.dat"), dynamic);
+		TS_ASSERT_EQUALS(openedBy(set, "b.dat"), high);
+
+		Common::Archive *container = nullptr;
+		TS_ASSERT(set.getMember(Common::Path("a.dat"), &container));
+		TS_ASSERT_EQUALS(container, dynamic);
+
+		// Changing the order is noticed
+		set.setPriority("low", 20);
+		TS_ASSERT_EQUALS(openedBy(set, "b.dat"), low);
+		set.remove("low");
+		TS_ASSERT_EQUALS(openedBy(set, "b.dat"), high);
+		TS_ASSERT_EQUALS(openedBy(set, "a.dat"), dynamic);
+	}
+
+	void test_index() {
+		Common::SearchSet set;
+		SearchSetTestArchive *fixed1 = new SearchSetTestArchive(true);
+		SearchSetTestArchive *fixed2 = new SearchSetTestArchive(true);
+		fixed2->addMember("file.dat");
+		set.add("fixed1", fixed1);
+		set.add("fixed2", fixed2);
+
+		for (int i = 0; i < 10; i++) {
+			TS_ASSERT(set.hasFile("file.dat"));
+			TS_ASSERT(!set.hasFile("missing.dat"));
+			TS_ASSERT_EQUALS(openedBy(set, "file.dat"), fixed2);
+		}
+
+		// Each path is only looked up once in the archives before the one
+		// holding it, which is asked again to confirm it still does
+		TS_ASSERT_EQUALS(fixed1->_lookups, 2);
+		TS_ASSERT_EQUALS(fixed2->_lookups, 2 + 19);
+
+		set.clear();
+		TS_ASSERT(!set.hasFile("file.dat"));
+	}
+
+	void test_removed_member() {
+		Common::SearchSet set;
+		SearchSetTestArchive *high = new SearchSetTestArchive(true);
+		SearchSetTestArchive *low = new SearchSetTestArchive(true);
+		high->addMember("file.dat");
+		low->addMember("file.dat");
+		high->addMember("gone.dat");
+		set.add("high", high, 10);
+		set.add("low", low, 0);
+
+		TS_ASSERT_EQUALS(openedBy(set, "file.dat"), high);
+		TS_ASSERT(set.hasFile("gone.dat"));
+
+		// Like a file deleted from an FSDirectory
+		high->removeMember("file.dat");
+		high->removeMember("gone.dat");
+		TS_ASSERT_EQUALS(openedBy(set, "file.dat"), low);
+		TS_ASSERT(set.hasFile("file.dat"));
+		TS_ASSERT(!set.hasFile("gone.dat"));
+		TS_ASSERT(!set.getMember(Common::Path("gone.dat")));
+	}
+};
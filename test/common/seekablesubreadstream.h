@@ -70,4 +70,16 @@ class SeekableSubReadStreamTestSuite : public CxxTest::TestSuite {
 		b = ssrs.readByte();
 		TS_ASSERT_EQUALS(b, 1);
 	}
+
+	void test_range_pointer() {
+		byte contents[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+		Common::MemoryReadStream ms(contents, 10);
+
+		Common::SeekableSubReadStream ssrs(&ms, 2, 8);
+
+		TS_ASSERT_EQUALS(ssrs.getRangePointer(0, 6), contents + 2);
+		TS_ASSERT_EQUALS(ssrs.getRangePointer(3, 2), contents + 5);
+		TS_ASSERT(!ssrs.getRangePointer(4, 3));
+		TS_ASSERT(!ssrs.getRangePointer(-1, 2));
+	}
 };
@@ -0,0 +1,77 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/smallarray.h"
+#include "common/str.h"
+
+class SmallArrayTestSuite : public CxxTest::TestSuite
+{
+	public:
+	void test_inline() {
+		Common::SmallArray<int, 4> array;
+		TS_ASSERT(array.empty());
+		TS_ASSERT(array.isInline());
+		for (int i = 0; i < 4; i++)
+			array.push_back(i);
+		TS_ASSERT(array.isInline());
+		TS_ASSERT_EQUALS(array.size(), 4u);
+
+		array.push_back(4);
+		TS_ASSERT(!array.isInline());
+		for (int i = 0; i < 5; i++)
+			TS_ASSERT_EQUALS(array[i], i);
+
+		array.clear();
+		TS_ASSERT(array.empty());
+		TS_ASSERT(array.isInline());
+	}
+
+	void test_insert_remove() {
+		Common::SmallArray<int, 4> array = {1, 2, 4};
+		array.insert_at(2, 3);
+		array.insert_at(0, 0);
+		array.insert_at(5, 5);
+		TS_ASSERT_EQUALS(array.size(), 6u);
+		for (int i = 0; i < 6; i++)
+			TS_ASSERT_EQUALS(array[i], i);
+
+		// Inserting an element of the array itself
+		array.insert_at(0, array[5]);
+		TS_ASSERT_EQUALS(array[0], 5);
+		TS_ASSERT_EQUALS(array.remove_at(0), 5);
+		array.erase(array.begin() + 1);
+		TS_ASSERT_EQUALS(array[1], 2);
+		array.pop_back();
+		TS_ASSERT_EQUALS(array.back(), 4);
+		TS_ASSERT_EQUALS(array.size(), 4u);
+	}
+
+	void test_copy_move() {
+		Common::SmallArray<Common::String, 2> small, large;
+		small.push_back("a string which is long enough to be allocated on the heap");
+		for (int i = 0; i < 10; i++)
+			large.emplace_back(Common::String::format("element %d", i));
+		large.push_back(large[0]);
+		TS_ASSERT_EQUALS(large.back(), "element 0");
+
+		Common::SmallArray<Common::String, 2> copy(small);
+		TS_ASSERT(copy == small);
+		copy = large;
+		TS_ASSERT(copy == large);
+		TS_ASSERT(copy != small);
+
+		Common::SmallArray<Common::String, 2> moved(Common::move(small));
+		TS_ASSERT(small.empty());
+		TS_ASSERT(moved.isInline());
+		TS_ASSERT_EQUALS(moved[0], "a string which is long enough to be allocated on the heap");
+
+		const Common::String *storage = large.data();
+		moved = Common::move(large);
+		TS_ASSERT(large.empty());
+		TS_ASSERT_EQUALS(moved.data(), storage);
+		TS_ASSERT_EQUALS(moved.size(), 11u);
+
+		moved.resize(1);
+		TS_ASSERT_EQUALS(moved.size(), 1u);
+		TS_ASSERT_EQUALS(moved.toArray()[0], "element 0");
+	}
+};
@@ -0,0 +1,317 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cxxtest/TestSuite.h>
+#include "test/instrset_detect.h"
+
+#include "common/random.h"
+#include "common/system.h"
+#include "common/textconsole.h"
+
+#include "graphics/blit.h"
+#include "graphics/blit/blit-fast.h"
+#include "graphics/pixelformat.h"
+
+#include "../null_osystem.h"
+
+#if NULL_OSYSTEM_IS_AVAILABLE
+#define BENCHMARK_TIME 1
+#else
+#define BENCHMARK_TIME 0
+#endif
+
+class CrossBlitTestSuite : public CxxTest::TestSuite {
+	struct Funcs {
+		const char *name;
+		Graphics::FastBlit::ConvertFunc convertFunc;
+		Graphics::FastBlit::MapFunc mapFunc;
+		Graphics::FastBlit::KeyFunc keyFunc;
+	};
+
+	static void useFuncs(const Funcs &funcs) {
+		Graphics::FastBlit::convertFunc = funcs.convertFunc;
+		Graphics::FastBlit::mapFunc = funcs.mapFunc;
+		Graphics::FastBlit::keyFunc = funcs.keyFunc;
+	}
+
+	static void resetFuncs() {
+		Graphics::FastBlit::convertFunc = nullptr;
+		Graphics::FastBlit::mapFunc = nullptr;
+		Graphics::FastBlit::keyFunc = nullptr;
+	}
+
+	static Common::Array<Funcs> getSIMDFuncs() {
+		Common::Array<Funcs> list;
+#ifdef SCUMMVM_NEON
+		Funcs neon = { "NEON", Graphics::FastBlit::convertNEON, nullptr, Graphics::FastBlit::keyNEON };
+		list.push_back(neon);
+#endif
+#ifdef SCUMMVM_SSE2
+		if (instrset_detect() >= 2) {
+			Funcs sse2 = { "SSE2", Graphics::FastBlit::convertSSE2, nullptr, Graphics::FastBlit::keySSE2 };
+			list.push_back(sse2);
+		}
+#endif
+#ifdef SCUMMVM_AVX2
+		if (instrset_detect() >= 8) {
+			Funcs avx2 = { "AVX2", Graphics::FastBlit::convertAVX2, Graphics::FastBlit::mapAVX2, Graphics::FastBlit::keyAVX2 };
+			list.push_back(avx2);
+		}
+#endif
+		return list;
+	}
+
+	static Common::Array<Graphics::PixelFormat> getFormats() {
+		Common::Array<Graphics::PixelFormat> formats;
+		formats.push_back(Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0));
+		formats.push_back(Graphics::PixelFormat(2, 5, 5, 5, 0, 10, 5, 0, 0));
+		formats.push_back(Graphics::PixelFormat(2, 5, 5, 5, 1, 10, 5, 0, 15));
+		formats.push_back(Graphics::PixelFormat(2, 4, 4, 4, 4, 12, 8, 4, 0));
+		formats.push_back(Graphics::PixelFormat(4, 8, 8, 8, 8, 16, 8, 0, 24));
+		formats.push_back(Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0));
+		formats.push_back(Graphics::PixelFormat(4, 8, 8, 8, 8, 0, 8, 16, 24));
+		formats.push_back(Graphics::PixelFormat(4, 8, 8, 8, 0, 16, 8, 0, 0));
+		return formats;
+	}
+
+	static void fillRandom(byte *buf, uint size, Common::RandomSource &rnd) {
+		for (uint i = 0; i < size; i++)
+			buf[i] = rnd.getRandomNumber(255);
+	}
+
+	// Width that is not a multiple of any vector size, and padded pitches
+	static const uint kWidth = 77;
+	static const uint kHeight = 7;
+	static const uint kSrcPitch = kWidth * 4 + 12;
+	static const uint kDstPitch = kWidth * 4 + 20;
+
+public:
+	void test_cross_blit() {
+		Common::RandomSource rnd("crossblit");
+		const Common::Array<Funcs> simdFuncs = getSIMDFuncs();
+		const Common::Array<Graphics::PixelFormat> formats = getFormats();
+
+		byte src[kSrcPitch * kHeight];
+		byte dstInit[kDstPitch * kHeight], dstGeneric[kDstPitch * kHeight], dstSIMD[kDstPitch * kHeight];
+
+		for (uint s = 0; s < formats.size(); s++) {
+			for (uint d = 0; d < formats.size(); d++) {
+				if (s == d)
+					continue;
+				const Graphics::PixelFormat &srcFmt = formats[s];
+				const Graphics::PixelFormat &dstFmt = formats[d];
+
+				fillRandom(src, sizeof(src), rnd);
+				fillRandom(dstInit, sizeof(dstInit), rnd);
+				uint32 key = srcFmt.bytesPerPixel == 2 ? READ_UINT16(src + 8) : READ_UINT32(src + 8);
+				for (uint i = 0; i < kHeight * 5; i++) {
+					byte *px = src + rnd.getRandomNumber(kHeight - 1) * kSrcPitch + rnd.getRandomNumber(kWidth - 1) * srcFmt.bytesPerPixel;
+					if (srcFmt.bytesPerPixel == 2)
+						WRITE_UINT16(px, key);
+					else
+						WRITE_UINT32(px, key);
+				}
+
+				for (int hasKey = 0; hasKey <= 1; hasKey++) {
+					resetFuncs();
+					useFuncs(Funcs());
+					memcpy(dstGeneric, dstInit, sizeof(dstInit));
+					if (hasKey)
+						Graphics::crossKeyBlit(dstGeneric, src, kDstPitch, kSrcPitch, kWidth, kHeight, dstFmt, srcFmt, key);
+					else
+						Graphics::crossBlit(dstGeneric, src, kDstPitch, kSrcPitch, kWidth, kHeight, dstFmt, srcFmt);
+
+					for (uint f = 0; f < simdFuncs.size(); f++) {
+						useFuncs(simdFuncs[f]);
+						memcpy(dstSIMD, dstInit, sizeof(dstInit));
+						if (hasKey)
+							Graphics::crossKeyBlit(dstSIMD, src, kDstPitch, kSrcPitch, kWidth, kHeight, dstFmt, srcFmt, key);
+						else
+							Graphics::crossBlit(dstSIMD, src, kDstPitch, kSrcPitch, kWidth, kHeight, dstFmt, srcFmt);
+						if (memcmp(dstGeneric, dstSIMD, sizeof(dstSIMD)) != 0) {
+							warning("%s crossBlit mismatch: %s -> %s, key %d", simdFuncs[f].name,
+								srcFmt.toString().c_str(), dstFmt.toString().c_str(), hasKey);
+							TS_FAIL("crossBlit mismatch");
+						}
+					}
+				}
+			}
+		}
+		resetFuncs();
+	}
+
+	void test_cross_blit_in_place() {
+		const Common::Array<Funcs> simdFuncs = getSIMDFuncs();
+		const Graphics::PixelFormat srcFmt(4, 8, 8, 8, 8, 16, 8, 0, 24);
+		const Graphics::PixelFormat dstFmt(4, 8, 8, 8, 8, 0, 8, 16, 24);
+
+		uint32 expected[kWidth], buf[kWidth];
+		for (uint i = 0; i < kWidth; i++)
+			expected[i] = buf[i] = 0x01020304 * i;
+
+		resetFuncs();
+		useFuncs(Funcs());
+		Graphics::crossBlit((byte *)expected, (const byte *)expected, kWidth * 4, kWidth * 4, kWidth, 1, dstFmt, srcFmt);
+
+		for (uint f = 0; f < simdFuncs.size(); f++) {
+			for (uint i = 0; i < kWidth; i++)
+				buf[i] = 0x01020304 * i;
+			useFuncs(simdFuncs[f]);
+			Graphics::crossBlit((byte *)buf, (const byte *)buf, kWidth * 4, kWidth * 4, kWidth, 1, dstFmt, srcFmt);
+			TS_ASSERT_SAME_DATA(buf, expected, sizeof(buf));
+		}
+		resetFuncs();
+	}
+
+	void test_cross_blit_map() {
+		Common::RandomSource rnd("crossblitmap");
+		const Common::Array<Funcs> simdFuncs = getSIMDFuncs();
+
+		uint32 map[256];
+		for (uint i = 0; i < 256; i++)
+			map[i] = rnd.getRandomNumber(0xFFFFFFFF);
+
+		byte src[kSrcPitch * kHeight];
+		byte dstInit[kDstPitch * kHeight], dstGeneric[kDstPitch * kHeight], dstSIMD[kDstPitch * kHeight];
+		fillRandom(src, sizeof(src), rnd);
+		fillRandom(dstInit, sizeof(dstInit), rnd);
+		const uint32 key = src[3];
+
+		for (uint bpp = 2; bpp <= 4; bpp += 2) {
+			for (int hasKey = 0; hasKey <= 1; hasKey++) {
+				resetFuncs();
+				useFuncs(Funcs());
+				memcpy(dstGeneric, dstInit, sizeof(dstInit));
+				if (hasKey)
+					Graphics::crossKeyBlitMap(dstGeneric, src, kDstPitch, kSrcPitch, kWidth, kHeight, bpp, map, key);
+				else
+					Graphics::crossBlitMap(dstGeneric, src, kDstPitch, kSrcPitch, kWidth, kHeight, bpp, map);
+
+				for (uint f = 0; f < simdFuncs.size(); f++) {
+					useFuncs(simdFuncs[f]);
+					memcpy(dstSIMD, dstInit, sizeof(dstInit));
+					if (hasKey)
+						Graphics::crossKeyBlitMap(dstSIMD, src, kDstPitch, kSrcPitch, kWidth, kHeight, bpp, map, key);
+					else
+						Graphics::crossBlitMap(dstSIMD, src, kDstPitch, kSrcPitch, kWidth, kHeight, bpp, map);
+					TS_ASSERT_SAME_DATA(dstGeneric, dstSIMD, sizeof(dstSIMD));
+				}
+			}
+		}
+		resetFuncs();
+	}
+
+	void test_key_blit() {
+		Common::RandomSource rnd("keyblit");
+		const Common::Array<Funcs> simdFuncs = getSIMDFuncs();
+
+		byte src[kSrcPitch * kHeight];
+		byte dstInit[kDstPitch * kHeight], dstGeneric[kDstPitch * kHeight], dstSIMD[kDstPitch * kHeight];
+
+		for (uint bpp = 1; bpp <= 4; bpp++) {
+			if (bpp == 3)
+				continue;
+
+			fillRandom(src, sizeof(src), rnd);
+			fillRandom(dstInit, sizeof(dstInit), rnd);
+			// Use a small set of colors so that the key is hit often
+			for (uint i = 0; i < sizeof(src); i++)
+				src[i] &= 0x03;
+			const uint32 key = bpp == 1 ? src[0] : (bpp == 2 ? READ_UINT16(src) : READ_UINT32(src));
+
+			resetFuncs();
+			useFuncs(Funcs());
+			memcpy(dstGeneric, dstInit, sizeof(dstInit));
+			Graphics::keyBlit(dstGeneric, src, kDstPitch, kSrcPitch, kWidth, kHeight, bpp, key);
+
+			for (uint f = 0; f < simdFuncs.size(); f++) {
+				useFuncs(simdFuncs[f]);
+				memcpy(dstSIMD, dstInit, sizeof(dstInit));
+				Graphics::keyBlit(dstSIMD, src, kDstPitch, kSrcPitch, kWidth, kHeight, bpp, key);
+				TS_ASSERT_SAME_DATA(dstGeneric, dstSIMD, sizeof(dstSIMD));
+			}
+		}
+		resetFuncs();
+	}
+
+	void test_cross_blit_speed() {
+#if BENCHMARK_TIME
+		Common::install_null_g_system();
+
+		const Common::Array<Funcs> simdFuncs = getSIMDFuncs();
+		const Graphics::PixelFormat fmt565(2, 5, 6, 5, 0, 11, 5, 0, 0);
+		const Graphics::PixelFormat fmtARGB(4, 8, 8, 8, 8, 16, 8, 0, 24);
+		const Graphics::PixelFormat fmtABGR(4, 8, 8, 8, 8, 0, 8, 16, 24);
+		const uint w = 640, h = 480;
+
+#ifdef SLOW_TESTS
+		const int iters = 200;
+#else
+		const int iters = 1;
+#endif
+
+		byte *src = new byte[w * h * 4];
+		byte *dst = new byte[w * h * 4];
+		uint32 map[256];
+		for (uint i = 0; i < w * h * 4; i++)
+			src[i] = (byte)(i * 7);
+		for (uint i = 0; i < 256; i++)
+			map[i] = i * 0x01010101;
+
+		for (uint f = 0; f <= simdFuncs.size(); f++) {
+			if (f < simdFuncs.size())
+				useFuncs(simdFuncs[f]);
+			else
+				useFuncs(Funcs());
+			const char *name = f < simdFuncs.size() ? simdFuncs[f].name : "generic";
+
+			uint32 start = g_system->getMillis();
+			for (int i = 0; i < iters; i++)
+				Graphics::crossBlit(dst, src, w * 4, w * 2, w, h, fmtARGB, fmt565);
+			debug("crossBlit RGB565 -> ARGB8888 (%s): %d ms for %d iters", name, g_system->getMillis() - start, iters);
+
+			start = g_system->getMillis();
+			for (int i = 0; i < iters; i++)
+				Graphics::crossBlit(dst, src, w * 2, w * 4, w, h, fmt565, fmtARGB);
+			debug("crossBlit ARGB8888 -> RGB565 (%s): %d ms for %d iters", name, g_system->getMillis() - start, iters);
+
+			start = g_system->getMillis();
+			for (int i = 0; i < iters; i++)
+				Graphics::crossBlit(dst, src, w * 4, w * 4, w, h, fmtABGR, fmtARGB);
+			debug("crossBlit ARGB8888 -> ABGR8888 (%s): %d ms for %d iters", name, g_system->getMillis() - start, iters);
+
+			start = g_system->getMillis();
+			for (int i = 0; i < iters; i++)
+				Graphics::crossBlitMap(dst, src, w * 4, w, w, h, 4, map);
+			debug("crossBlitMap CLUT8 -> 32bpp (%s): %d ms for %d iters", name, g_system->getMillis() - start, iters);
+
+			start = g_system->getMillis();
+			for (int i = 0; i < iters; i++)
+				Graphics::keyBlit(dst, src, w * 2, w * 2, w, h, 2, 0x0E07);
+			debug("keyBlit 16bpp (%s): %d ms for %d iters", name, g_system->getMillis() - start, iters);
+		}
+
+		resetFuncs();
+		delete[] src;
+		delete[] dst;
+#endif
+	}
+};
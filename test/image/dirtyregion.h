@@ -0,0 +1,142 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/dirtyregion.h"
+
+class DirtyRegionTestSuite : public CxxTest::TestSuite {
+	static bool isDisjoint(const Graphics::DirtyRegion &region) {
+		const Common::Array<Common::Rect> &rects = region.getRects();
+		for (uint i = 0; i < rects.size(); i++) {
+			for (uint j = i + 1; j < rects.size(); j++) {
+				if (rects[i].intersects(rects[j]))
+					return false;
+			}
+		}
+		return true;
+	}
+
+	static bool covers(const Graphics::DirtyRegion &region, const Common::Rect &r) {
+		for (int y = r.top; y < r.bottom; y++) {
+			for (int x = r.left; x < r.right; x++) {
+				bool found = false;
+				for (Graphics::DirtyRegion::const_iterator i = region.begin(); i != region.end(); ++i) {
+					if (i->contains(x, y)) {
+						found = true;
+						break;
+					}
+				}
+				if (!found)
+					return false;
+			}
+		}
+		return true;
+	}
+
+public:
+	void test_empty() {
+		Graphics::DirtyRegion region;
+		TS_ASSERT(region.empty());
+
+		region.addRect(Common::Rect());
+		region.addRect(Common::Rect(10, 10, 10, 20));
+		TS_ASSERT(region.empty());
+
+		region.addRect(Common::Rect(0, 0, 4, 4));
+		TS_ASSERT(!region.empty());
+		region.clear();
+		TS_ASSERT(region.empty());
+	}
+
+	void test_contained() {
+		Graphics::DirtyRegion region(0);
+		region.addRect(Common::Rect(0, 0, 100, 100));
+		region.addRect(Common::Rect(10, 10, 20, 20));
+		region.addRect(Common::Rect(0, 0, 100, 100));
+		TS_ASSERT_EQUALS(region.size(), 1u);
+		TS_ASSERT_EQUALS(region.getRects()[0], Common::Rect(0, 0, 100, 100));
+
+		region.addRect(Common::Rect(-10, -10, 200, 200));
+		TS_ASSERT_EQUALS(region.size(), 1u);
+		TS_ASSERT_EQUALS(region.getRects()[0], Common::Rect(-10, -10, 200, 200));
+	}
+
+	void test_overlapping() {
+		// Overlapping rectangles are merged even if that wastes a lot
+		Graphics::DirtyRegion region(0);
+		region.addRect(Common::Rect(0, 0, 100, 10));
+		region.addRect(Common::Rect(90, 0, 100, 100));
+		TS_ASSERT_EQUALS(region.size(), 1u);
+		TS_ASSERT_EQUALS(region.getRects()[0], Common::Rect(0, 0, 100, 100));
+
+		// The merged rectangle picks up rectangles it now overlaps
+		region.clear();
+		region.addRect(Common::Rect(0, 0, 10, 10));
+		region.addRect(Common::Rect(50, 50, 60, 60));
+		TS_ASSERT_EQUALS(region.size(), 2u);
+		region.addRect(Common::Rect(5, 5, 55, 55));
+		TS_ASSERT_EQUALS(region.size(), 1u);
+		TS_ASSERT_EQUALS(region.getRects()[0], Common::Rect(0, 0, 60, 60));
+	}
+
+	void test_merge_cost() {
+		// Adjacent rectangles with the same height waste nothing
+		Graphics::DirtyRegion exact(0);
+		exact.addRect(Common::Rect(0, 0, 10, 10));
+		exact.addRect(Common::Rect(10, 0, 20, 10));
+		TS_ASSERT_EQUALS(exact.size(), 1u);
+		TS_ASSERT_EQUALS(exact.getArea(), 200u);
+
+		// A 10 pixel gap between 10x10 rectangles wastes 100 pixels
+		Graphics::DirtyRegion cheap(100);
+		cheap.addRect(Common::Rect(0, 0, 10, 10));
+		cheap.addRect(Common::Rect(20, 0, 30, 10));
+		TS_ASSERT_EQUALS(cheap.size(), 1u);
+		TS_ASSERT_EQUALS(cheap.getRects()[0], Common::Rect(0, 0, 30, 10));
+
+		Graphics::DirtyRegion expensive(99);
+		expensive.addRect(Common::Rect(0, 0, 10, 10));
+		expensive.addRect(Common::Rect(20, 0, 30, 10));
+		TS_ASSERT_EQUALS(expensive.size(), 2u);
+		TS_ASSERT_EQUALS(expensive.getArea(), 200u);
+	}
+
+	void test_many_rects() {
+		Common::Array<Common::Rect> added;
+		Graphics::DirtyRegion region;
+		uint32 seed = 1;
+
+		for (int i = 0; i < 500; i++) {
+			seed = seed * 1103515245 + 12345;
+			int x = (seed >> 8) % 300;
+			int y = (seed >> 20) % 200;
+			Common::Rect r(x, y, x + 1 + (seed >> 4) % 20, y + 1 + (seed >> 12) % 20);
+			region.addRect(r);
+			added.push_back(r);
+		}
+
+		TS_ASSERT(isDisjoint(region));
+		for (uint i = 0; i < added.size(); i++)
+			TS_ASSERT(covers(region, added[i]));
+		TS_ASSERT_LESS_THAN_EQUALS(region.getArea(), 320u * 220u);
+	}
+};
@@ -0,0 +1,90 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cxxtest/TestSuite.h>
+
+#include "image/codecs/codec.h"
+
+#include "../null_osystem.h"
+
+class DitherTableCacheTestSuite : public CxxTest::TestSuite {
+	static void createPalette(byte *palette, uint seed) {
+		for (uint i = 0; i < 256 * 3; i++)
+			palette[i] = (i * 37 + seed * 101 + (i >> 3) * seed) & 0xFF;
+	}
+
+public:
+	void test_shared_tables() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		// The cache has a mutex
+		Common::install_null_g_system();
+
+		byte palette1[256 * 3], palette2[256 * 3];
+		createPalette(palette1, 1);
+		createPalette(palette2, 2);
+
+		Common::SharedPtr<byte> table1 = DitherTables.getQuickTimeTable(palette1, 256);
+		Common::SharedPtr<byte> table2 = DitherTables.getQuickTimeTable(palette2, 256);
+		TS_ASSERT(table1 != table2);
+		TS_ASSERT(DitherTables.getQuickTimeTable(palette1, 256) == table1);
+		TS_ASSERT_EQUALS(DitherTables.getMemoryUsage(), 2u * 0x10000);
+
+		byte *expected = Image::Codec::createQuickTimeDitherTable(palette1, 256);
+		TS_ASSERT_EQUALS(memcmp(table1.get(), expected, 0x10000), 0);
+		delete[] expected;
+
+		// Only the palette entries in use are compared
+		palette2[255 * 3] ^= 0xFF;
+		TS_ASSERT(DitherTables.getQuickTimeTable(palette2, 255) != table2);
+
+		// The tables in use stay in the cache
+		DitherTables.clear();
+		TS_ASSERT_EQUALS(DitherTables.getMemoryUsage(), 2u * 0x10000);
+		table1.reset();
+		table2.reset();
+		DitherTables.clear();
+		TS_ASSERT_EQUALS(DitherTables.getMemoryUsage(), 0u);
+
+		Image::DitherTableCache::destroy();
+#endif
+	}
+
+	void test_memory_limit() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+		DitherTables.setMaxUnusedSize(2 * 0x10000);
+
+		byte palettes[4][256 * 3];
+		for (uint i = 0; i < 4; i++) {
+			createPalette(palettes[i], i + 3);
+			DitherTables.getQuickTimeTable(palettes[i], 256);
+		}
+		TS_ASSERT_EQUALS(DitherTables.getMemoryUsage(), 2u * 0x10000);
+
+		// The least recently requested tables are dropped first
+		const byte *table = DitherTables.getQuickTimeTable(palettes[3], 256).get();
+		DitherTables.getQuickTimeTable(palettes[0], 256);
+		TS_ASSERT_EQUALS(DitherTables.getQuickTimeTable(palettes[3], 256).get(), table);
+
+		Image::DitherTableCache::destroy();
+#endif
+	}
+};
@@ -0,0 +1,132 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/fonts/glyphatlas.h"
+
+class GlyphAtlasTestSuite : public CxxTest::TestSuite {
+	static void fillGlyph(const Graphics::GlyphAtlas::Bitmap &bitmap, byte value) {
+		for (int y = 0; y < bitmap.h; y++)
+			for (int x = 0; x < bitmap.w; x++)
+				bitmap.pixels[y * bitmap.pitch + x] = value + x + y;
+	}
+
+	static bool checkGlyph(const Graphics::GlyphAtlas::Bitmap &bitmap, byte value) {
+		for (int y = 0; y < bitmap.h; y++)
+			for (int x = 0; x < bitmap.w; x++)
+				if (bitmap.pixels[y * bitmap.pitch + x] != (byte)(value + x + y))
+					return false;
+		return true;
+	}
+
+public:
+	void test_glyphs() {
+		Graphics::GlyphAtlas atlas;
+		uint32 font1 = atlas.registerFont();
+		uint32 font2 = atlas.registerFont();
+		TS_ASSERT_DIFFERS(font1, font2);
+
+		Graphics::GlyphAtlas::Bitmap bitmap;
+		TS_ASSERT(!atlas.getGlyph(font1, 'A', bitmap));
+
+		for (uint32 glyph = 0; glyph < 200; glyph++) {
+			fillGlyph(atlas.addGlyph(font1, glyph, 5 + glyph % 7, 8 + glyph % 5), glyph);
+			fillGlyph(atlas.addGlyph(font2, glyph, 10, 12), glyph + 100);
+		}
+
+		// Everything fits into one page
+		TS_ASSERT_EQUALS(atlas.getMemoryUsage(), (uint32)(Graphics::GlyphAtlas::kPageSize * Graphics::GlyphAtlas::kPageSize));
+
+		for (uint32 glyph = 0; glyph < 200; glyph++) {
+			TS_ASSERT(atlas.getGlyph(font1, glyph, bitmap));
+			TS_ASSERT_EQUALS(bitmap.w, (int)(5 + glyph % 7));
+			TS_ASSERT_EQUALS(bitmap.h, (int)(8 + glyph % 5));
+			TS_ASSERT(checkGlyph(bitmap, glyph));
+
+			TS_ASSERT(atlas.getGlyph(font2, glyph, bitmap));
+			TS_ASSERT(checkGlyph(bitmap, glyph + 100));
+		}
+
+		atlas.removeGlyph(font1, 10);
+		TS_ASSERT(!atlas.getGlyph(font1, 10, bitmap));
+		TS_ASSERT(atlas.getGlyph(font2, 10, bitmap));
+
+		atlas.unregisterFont(font2);
+		TS_ASSERT(!atlas.getGlyph(font2, 20, bitmap));
+		TS_ASSERT(atlas.getGlyph(font1, 20, bitmap));
+		TS_ASSERT(checkGlyph(bitmap, 20));
+
+		atlas.clear();
+		TS_ASSERT(!atlas.getGlyph(font1, 20, bitmap));
+		TS_ASSERT_EQUALS(atlas.getMemoryUsage(), 0u);
+	}
+
+	void test_budget() {
+		const uint32 pageBytes = Graphics::GlyphAtlas::kPageSize * Graphics::GlyphAtlas::kPageSize;
+
+		Graphics::GlyphAtlas atlas;
+		atlas.setBudget(2 * pageBytes);
+		uint32 font = atlas.registerFont();
+
+		// Half a page per glyph, so glyphs 0 and 1 share the first page
+		const int w = Graphics::GlyphAtlas::kPageSize;
+		const int h = Graphics::GlyphAtlas::kPageSize / 2;
+		for (uint32 glyph = 0; glyph < 4; glyph++)
+			fillGlyph(atlas.addGlyph(font, glyph, w, h), glyph);
+		TS_ASSERT_EQUALS(atlas.getMemoryUsage(), 2 * pageBytes);
+
+		// Using glyph 0 makes the second page the least recently used one
+		Graphics::GlyphAtlas::Bitmap bitmap;
+		TS_ASSERT(atlas.getGlyph(font, 0, bitmap));
+
+		fillGlyph(atlas.addGlyph(font, 4, w, h), 4);
+		TS_ASSERT_EQUALS(atlas.getMemoryUsage(), 2 * pageBytes);
+
+		TS_ASSERT(atlas.getGlyph(font, 0, bitmap));
+		TS_ASSERT(checkGlyph(bitmap, 0));
+		TS_ASSERT(atlas.getGlyph(font, 1, bitmap));
+		TS_ASSERT(!atlas.getGlyph(font, 2, bitmap));
+		TS_ASSERT(!atlas.getGlyph(font, 3, bitmap));
+		TS_ASSERT(atlas.getGlyph(font, 4, bitmap));
+		TS_ASSERT(checkGlyph(bitmap, 4));
+
+		atlas.setBudget(pageBytes);
+		TS_ASSERT_EQUALS(atlas.getMemoryUsage(), pageBytes);
+		TS_ASSERT(!atlas.getGlyph(font, 0, bitmap));
+		TS_ASSERT(atlas.getGlyph(font, 4, bitmap));
+	}
+
+	void test_large_glyph() {
+		Graphics::GlyphAtlas atlas;
+		uint32 font = atlas.registerFont();
+
+		const int size = Graphics::GlyphAtlas::kPageSize + 44;
+		Graphics::GlyphAtlas::Bitmap bitmap = atlas.addGlyph(font, 1, size, 10);
+		TS_ASSERT_EQUALS(bitmap.w, size);
+		TS_ASSERT_EQUALS(bitmap.h, 10);
+		fillGlyph(bitmap, 1);
+		TS_ASSERT_EQUALS(atlas.getMemoryUsage(), (uint32)(size * Graphics::GlyphAtlas::kPageSize));
+
+		TS_ASSERT(atlas.getGlyph(font, 1, bitmap));
+		TS_ASSERT(checkGlyph(bitmap, 1));
+	}
+};
@@ -0,0 +1,250 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cxxtest/TestSuite.h>
+
+#include "common/memstream.h"
+#include "common/system.h"
+
+#include "graphics/surface.h"
+
+#include "image/jpeg.h"
+#include "image/codecs/mjpeg.h"
+
+#include "../null_osystem.h"
+
+#ifdef USE_JPEG
+// A 40x184 gradient from (0, 0, 128) to (255, 255, 128), with a restart
+// marker every two MCUs. An MCU row has three MCUs, so only every third
+// restart interval starts a row.
+static const byte s_jpegRestarts[] = {
+	0xff, 0xd8, 0xff, 0xe0, 0x00, 0x10, 0x4a, 0x46, 0x49, 0x46, 0x00, 0x01, 0x01, 0x00, 0x00, 0x01,
+	0x00, 0x01, 0x00, 0x00, 0xff, 0xdb, 0x00, 0x43, 0x00, 0x14, 0x0e, 0x0f, 0x12, 0x0f, 0x0d, 0x14,
+	0x12, 0x10, 0x12, 0x17, 0x15, 0x14, 0x18, 0x1e, 0x32, 0x21, 0x1e, 0x1c, 0x1c, 0x1e, 0x3d, 0x2c,
+	0x2e, 0x24, 0x32, 0x49, 0x40, 0x4c, 0x4b, 0x47, 0x40, 0x46, 0x45, 0x50, 0x5a, 0x73, 0x62, 0x50,
+	0x55, 0x6d, 0x56, 0x45, 0x46, 0x64, 0x88, 0x65, 0x6d, 0x77, 0x7b, 0x81, 0x82, 0x81, 0x4e, 0x60,
+	0x8d, 0x97, 0x8c, 0x7d, 0x96, 0x73, 0x7e, 0x81, 0x7c, 0xff, 0xdb, 0x00, 0x43, 0x01, 0x15, 0x17,
+	0x17, 0x1e, 0x1a, 0x1e, 0x3b, 0x21, 0x21, 0x3b, 0x7c, 0x53, 0x46, 0x53, 0x7c, 0x7c, 0x7c, 0x7c,
+	0x7c, 0x7c, 0x7c, 0x7c, 0x7c, 0x7c, 0x7c, 0x7c, 0x7c, 0x7c, 0x7c, 0x7c, 0x7c, 0x7c, 0x7c, 0x7c,
+	0x7c, 0x7c, 0x7c, 0x7c, 0x7c, 0x7c, 0x7c, 0x7c, 0x7c, 0x7c, 0x7c, 0x7c, 0x7c, 0x7c, 0x7c, 0x7c,
+	0x7c, 0x7c, 0x7c, 0x7c, 0x7c, 0x7c, 0x7c, 0x7c, 0x7c, 0x7c, 0x7c, 0x7c, 0x7c, 0x7c, 0xff, 0xc0,
+	0x00, 0x11, 0x08, 0x00, 0xb8, 0x00, 0x28, 0x03, 0x01, 0x22, 0x00, 0x02, 0x11, 0x01, 0x03, 0x11,
+	0x01, 0xff, 0xc4, 0x00, 0x1f, 0x00, 0x00, 0x01, 0x05, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09,
+	0x0a, 0x0b, 0xff, 0xc4, 0x00, 0xb5, 0x10, 0x00, 0x02, 0x01, 0x03, 0x03, 0x02, 0x04, 0x03, 0x05,
+	0x05, 0x04, 0x04, 0x00, 0x00, 0x01, 0x7d, 0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21,
+	0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07, 0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08, 0x23,
+	0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0, 0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16, 0x17,
+	0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a,
+	0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a,
+	0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a,
+	0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99,
+	0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7,
+	0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5,
+	0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1,
+	0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa, 0xff, 0xc4, 0x00, 0x1f, 0x01, 0x00, 0x03,
+	0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01,
+	0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0xff, 0xc4, 0x00, 0xb5, 0x11, 0x00,
+	0x02, 0x01, 0x02, 0x04, 0x04, 0x03, 0x04, 0x07, 0x05, 0x04, 0x04, 0x00, 0x01, 0x02, 0x77, 0x00,
+	0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71, 0x13,
+	0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52, 0xf0, 0x15,
+	0x62, 0x72, 0xd1, 0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26, 0x27,
+	0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+	0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+	0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88,
+	0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6,
+	0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4,
+	0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe2,
+	0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9,
+	0xfa, 0xff, 0xdd, 0x00, 0x04, 0x00, 0x02, 0xff, 0xda, 0x00, 0x0c, 0x03, 0x01, 0x00, 0x02, 0x11,
+	0x03, 0x11, 0x00, 0x3f, 0x00, 0xe5, 0x50, 0x54, 0xe8, 0x2a, 0x34, 0x15, 0x32, 0x0a, 0xf5, 0x24,
+	0xcd, 0x29, 0x32, 0x44, 0x15, 0x32, 0x0a, 0x8d, 0x05, 0x4e, 0x82, 0xb0, 0x93, 0x3d, 0x4a, 0x4c,
+	0xff, 0xd0, 0xce, 0x41, 0x45, 0x3d, 0x05, 0x15, 0xbb, 0x67, 0xd4, 0xc5, 0xe8, 0x64, 0xa0, 0xa9,
+	0x90, 0x54, 0x68, 0x2a, 0x64, 0x15, 0xd5, 0x26, 0x7c, 0xb5, 0x26, 0x7f, 0xff, 0xd1, 0xc7, 0x41,
+	0x53, 0x20, 0xa6, 0x20, 0xa9, 0x90, 0x57, 0x54, 0x99, 0xea, 0x52, 0x64, 0x88, 0x28, 0xa7, 0x20,
+	0xa2, 0xb2, 0x6c, 0xf4, 0x62, 0xf4, 0x3f, 0xff, 0xd2, 0xc0, 0x41, 0x53, 0x20, 0xa8, 0xd0, 0x54,
+	0xe8, 0x2b, 0xba, 0x4c, 0x8a, 0x4c, 0x7a, 0x0a, 0x9d, 0x05, 0x46, 0x82, 0xa6, 0x41, 0x58, 0xc9,
+	0x9e, 0xa5, 0x26, 0x7f, 0xff, 0xd3, 0x85, 0x05, 0x14, 0xe4, 0x14, 0x55, 0x36, 0x7d, 0x14, 0x5e,
+	0x86, 0x4a, 0x0a, 0x99, 0x05, 0x31, 0x05, 0x4c, 0x82, 0xba, 0xa4, 0xcf, 0x96, 0xa4, 0xcf, 0xff,
+	0xd4, 0xa4, 0x82, 0xa6, 0x41, 0x51, 0xa0, 0xa9, 0x90, 0x56, 0xb2, 0x67, 0x6d, 0x26, 0x48, 0x82,
+	0x8a, 0x7a, 0x0a, 0x2b, 0x16, 0xcf, 0x46, 0x2f, 0x43, 0xff, 0xd5, 0xca, 0x41, 0x53, 0xa0, 0xa8,
+	0xd0, 0x54, 0xc8, 0x2b, 0xa6, 0x4c, 0xe4, 0xa4, 0xc9, 0x10, 0x54, 0xc8, 0x2a, 0x34, 0x15, 0x3a,
+	0x0a, 0xc2, 0x4c, 0xf5, 0x29, 0x33, 0xff, 0xd6, 0x91, 0x05, 0x14, 0xf4, 0x14, 0x56, 0x6d, 0x9e,
+	0xdc, 0x5e, 0x86, 0x4a, 0x0a, 0x99, 0x05, 0x46, 0x82, 0xa6, 0x41, 0x5d, 0x52, 0x67, 0xcb, 0x52,
+	0x67, 0xff, 0xd7, 0x62, 0x0a, 0x99, 0x05, 0x31, 0x05, 0x4c, 0x82, 0x94, 0x99, 0xb5, 0x26, 0x48,
+	0x82, 0x8a, 0x72, 0x0a, 0x2b, 0x16, 0xcf, 0x46, 0x2f, 0x43, 0xff, 0xd0, 0xaa, 0xa2, 0xa6, 0x41,
+	0x51, 0xa0, 0xa9, 0xd0, 0x55, 0xc9, 0x9e, 0x6d, 0x26, 0x3d, 0x05, 0x4e, 0x82, 0xa3, 0x41, 0x53,
+	0x20, 0xac, 0x24, 0xcf, 0x52, 0x93, 0x3f, 0xff, 0xd1, 0xbe, 0x82, 0x8a, 0x72, 0x0a, 0x2b, 0x99,
+	0xb3, 0xd3, 0x8b, 0xd0, 0xc9, 0x41, 0x53, 0x20, 0xa6, 0x20, 0xa9, 0x90, 0x57, 0x4c, 0x99, 0xf2,
+	0xf4, 0x99, 0xff, 0xd2, 0x9d, 0x05, 0x4e, 0x82, 0xa3, 0x41, 0x53, 0x20, 0xac, 0x64, 0xc5, 0x49,
+	0x92, 0x20, 0xa2, 0x9e, 0x82, 0x8a, 0xc5, 0xb3, 0xd1, 0x8b, 0xd0, 0xff, 0xd3, 0x10, 0x54, 0xc8,
+	0x29, 0x88, 0x2a, 0x64, 0x15, 0x12, 0x67, 0x8d, 0x49, 0x92, 0x20, 0xa9, 0x90, 0x54, 0x68, 0x2a,
+	0x74, 0x15, 0x8c, 0x99, 0xea, 0x52, 0x67, 0xff, 0xd4, 0xd9, 0x41, 0x45, 0x3d, 0x05, 0x15, 0xc0,
+	0xd9, 0xd9, 0x17, 0xa1, 0x92, 0x82, 0xa6, 0x41, 0x51, 0xa0, 0xa9, 0x90, 0x57, 0x54, 0x99, 0xf2,
+	0xf4, 0x99, 0xff, 0xd5, 0xd2, 0x41, 0x53, 0x20, 0xa6, 0x20, 0xa9, 0x90, 0x57, 0x1c, 0x99, 0xcf,
+	0x49, 0x8f, 0x41, 0x45, 0x3d, 0x05, 0x15, 0x8b, 0x67, 0xa3, 0x17, 0xa1, 0xff, 0xd6, 0xb6, 0x82,
+	0xa6, 0x41, 0x51, 0xa0, 0xa9, 0xd0, 0x57, 0x3c, 0x99, 0xf3, 0xf4, 0x98, 0xf4, 0x15, 0x32, 0x0a,
+	0x62, 0x0a, 0x99, 0x05, 0x61, 0x26, 0x7a, 0x94, 0x99, 0xff, 0xd7, 0xe9, 0x10, 0x51, 0x4e, 0x41,
+	0x45, 0x79, 0x4d, 0x9a, 0xc5, 0xe8, 0x64, 0xa0, 0xa9, 0x90, 0x51, 0x45, 0x75, 0x48, 0xf9, 0x7a,
+	0x47, 0xff, 0xd0, 0xdc, 0x41, 0x53, 0xa0, 0xa2, 0x8a, 0xf3, 0xa4, 0x70, 0x52, 0x26, 0x41, 0x45,
+	0x14, 0x56, 0x2c, 0xf4, 0x63, 0xb1, 0xff, 0xd9
+};
+#endif
+
+class JPEGTestSuite : public CxxTest::TestSuite {
+#ifdef USE_JPEG
+	static bool equalSurfaces(const Graphics::Surface &a, const Graphics::Surface &b) {
+		if (a.w != b.w || a.h != b.h || a.format != b.format)
+			return false;
+		for (int y = 0; y < a.h; y++) {
+			if (memcmp(a.getBasePtr(0, y), b.getBasePtr(0, y), a.w * a.format.bytesPerPixel))
+				return false;
+		}
+		return true;
+	}
+#endif
+
+public:
+	void test_decode() {
+#ifdef USE_JPEG
+		Image::JPEGDecoder decoder;
+		Common::MemoryReadStream stream(s_jpegRestarts, sizeof(s_jpegRestarts));
+		TS_ASSERT(decoder.loadStream(stream));
+
+		const Graphics::Surface *surface = decoder.getSurface();
+		TS_ASSERT_EQUALS(surface->w, 40);
+		TS_ASSERT_EQUALS(surface->h, 184);
+		TS_ASSERT_EQUALS(surface->format.bytesPerPixel, 3);
+
+		const byte *topLeft = (const byte *)surface->getBasePtr(0, 0);
+		const byte *bottomRight = (const byte *)surface->getBasePtr(39, 183);
+		TS_ASSERT_LESS_THAN(topLeft[0], 16);
+		TS_ASSERT_LESS_THAN(topLeft[1], 16);
+		TS_ASSERT_LESS_THAN(ABS(topLeft[2] - 128), 16);
+		TS_ASSERT_LESS_THAN(239, bottomRight[0]);
+		TS_ASSERT_LESS_THAN(239, bottomRight[1]);
+		TS_ASSERT_LESS_THAN(ABS(bottomRight[2] - 128), 16);
+#endif
+	}
+
+	void test_reuse_surface() {
+#ifdef USE_JPEG
+		Image::JPEGDecoder decoder, first;
+		Common::MemoryReadStream stream(s_jpegRestarts, sizeof(s_jpegRestarts));
+		TS_ASSERT(first.loadStream(stream));
+
+		// Frames of a video keep the surface
+		stream.seek(0);
+		const Graphics::Surface *surface = decoder.decodeFrame(stream);
+		TS_ASSERT(surface);
+		const void *pixels = surface->getPixels();
+		stream.seek(0);
+		TS_ASSERT_EQUALS(decoder.decodeFrame(stream), surface);
+		TS_ASSERT_EQUALS(surface->getPixels(), pixels);
+		TS_ASSERT(equalSurfaces(*surface, *first.getSurface()));
+
+		// Loading an image starts from scratch
+		stream.seek(0);
+		TS_ASSERT(decoder.loadStream(stream));
+		TS_ASSERT(equalSurfaces(*decoder.getSurface(), *first.getSurface()));
+#endif
+	}
+
+	void test_bands() {
+		// Bands are decoded on the job system
+#if defined(USE_JPEG) && NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+
+		const Image::JPEGDecoder::ColorSpace colorSpaces[] = {
+			Image::JPEGDecoder::kColorSpaceRGB, Image::JPEGDecoder::kColorSpaceYUV
+		};
+
+		for (uint i = 0; i < ARRAYSIZE(colorSpaces); i++) {
+			Image::JPEGDecoder serial;
+			serial.setOutputColorSpace(colorSpaces[i]);
+			serial._bandCount = 1;
+			Common::MemoryReadStream stream(s_jpegRestarts, sizeof(s_jpegRestarts));
+			TS_ASSERT(serial.loadStream(stream));
+
+			for (uint bandCount = 2; bandCount <= 3; bandCount++) {
+				Image::JPEGDecoder decoder;
+				decoder.setOutputColorSpace(colorSpaces[i]);
+				decoder._bandCount = bandCount;
+				stream.seek(0);
+				TS_ASSERT(decoder.loadStream(stream));
+				TS_ASSERT(equalSurfaces(*decoder.getSurface(), *serial.getSurface()));
+			}
+		}
+#endif
+	}
+
+	void test_bands_stop_at_end_of_image() {
+#if defined(USE_JPEG) && NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+
+		Image::JPEGDecoder serial;
+		serial._bandCount = 1;
+		Common::MemoryReadStream serialStream(s_jpegRestarts, sizeof(s_jpegRestarts));
+		TS_ASSERT(serial.loadStream(serialStream));
+
+		// The image is followed by other data, starting with what looks like
+		// more restart intervals
+		const uint32 trailerSize = 100000;
+		byte *data = (byte *)malloc(sizeof(s_jpegRestarts) + trailerSize);
+		memcpy(data, s_jpegRestarts, sizeof(s_jpegRestarts));
+		for (uint32 i = 0; i < trailerSize; i++)
+			data[sizeof(s_jpegRestarts) + i] = (i & 1) ? 0xD0 + (i / 2) % 8 : 0xFF;
+
+		Image::JPEGDecoder decoder;
+		decoder._bandCount = 3;
+		Common::MemoryReadStream stream(data, sizeof(s_jpegRestarts) + trailerSize, DisposeAfterUse::YES);
+		TS_ASSERT(decoder.loadStream(stream));
+		TS_ASSERT(equalSurfaces(*decoder.getSurface(), *serial.getSurface()));
+#endif
+	}
+
+	void test_mjpeg() {
+#if defined(USE_JPEG) && NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+
+		// Motion JPEG frames have an AVI1 segment instead of the JFIF one
+		byte frame[sizeof(s_jpegRestarts)];
+		memcpy(frame, s_jpegRestarts, sizeof(frame));
+		memcpy(frame + 6, "AVI1", 4);
+
+		const Graphics::PixelFormat format(4, 8, 8, 8, 8, 24, 16, 8, 0);
+		Image::MJPEGDecoder decoder;
+		decoder.setOutputPixelFormat(format);
+		Image::JPEGDecoder reference;
+		reference.setOutputPixelFormat(format);
+		Common::MemoryReadStream referenceStream(s_jpegRestarts, sizeof(s_jpegRestarts));
+		TS_ASSERT(reference.loadStream(referenceStream));
+
+		Common::MemoryReadStream stream(frame, sizeof(frame));
+		const Graphics::Surface *surface = decoder.decodeFrame(stream);
+		TS_ASSERT(surface && equalSurfaces(*surface, *reference.getSurface()));
+
+		stream.seek(0);
+		TS_ASSERT_EQUALS(decoder.decodeFrame(stream), surface);
+		TS_ASSERT(surface && equalSurfaces(*surface, *reference.getSurface()));
+#endif
+	}
+};
@@ -0,0 +1,325 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cxxtest/TestSuite.h>
+#include "test/instrset_detect.h"
+
+#include "common/array.h"
+#include "common/jobs.h"
+#include "common/system.h"
+#include "common/textconsole.h"
+
+#include "../null_osystem.h"
+
+// TinyGL needs g_system for its job system and timing
+#if defined(USE_TINYGL) && NULL_OSYSTEM_IS_AVAILABLE
+#define TINYGL_TESTS 1
+#include "graphics/tinygl/tinygl.h"
+#include "graphics/tinygl/zgl.h"
+#else
+#define TINYGL_TESTS 0
+#endif
+
+class TinyGLTestSuite : public CxxTest::TestSuite {
+#if TINYGL_TESTS
+	struct Funcs {
+		const char *name;
+		TinyGL::SpanFunc spanFunc;
+	};
+
+	static Common::Array<Funcs> getSIMDFuncs() {
+		Common::Array<Funcs> list;
+#ifdef SCUMMVM_SSE2
+		if (instrset_detect() >= 2) {
+			Funcs sse2 = { "SSE2", TinyGL::fillSpanSSE2 };
+			list.push_back(sse2);
+		}
+#endif
+#ifdef SCUMMVM_AVX2
+		if (instrset_detect() >= 8) {
+			Funcs avx2 = { "AVX2", TinyGL::fillSpanAVX2 };
+			list.push_back(avx2);
+		}
+#endif
+		return list;
+	}
+
+	static const int kWidth = 320;
+	static const int kHeight = 240;
+	static const int kTextureSize = 64;
+
+	TGLuint _texture;
+
+	void createScene(const Graphics::PixelFormat &format, bool dirtyRects = false) {
+		// Each draw picks its kernel, the null backend can't report CPU features
+		TinyGL::setCPUSpanFunc(nullptr);
+		TinyGL::createContext(kWidth, kHeight, format, 256, false, dirtyRects);
+
+		byte *texels = new byte[kTextureSize * kTextureSize * 4];
+		for (int i = 0; i < kTextureSize * kTextureSize; i++) {
+			texels[i * 4 + 0] = (byte)(i * 7);
+			texels[i * 4 + 1] = (byte)(i * 13 + 50);
+			texels[i * 4 + 2] = (byte)(i / kTextureSize * 4);
+			texels[i * 4 + 3] = (byte)(64 + (i % kTextureSize) * 3);
+		}
+		tglGenTextures(1, &_texture);
+		tglBindTexture(TGL_TEXTURE_2D, _texture);
+		tglTexParameteri(TGL_TEXTURE_2D, TGL_TEXTURE_MIN_FILTER, TGL_NEAREST);
+		tglTexParameteri(TGL_TEXTURE_2D, TGL_TEXTURE_MAG_FILTER, TGL_NEAREST);
+		tglTexImage2D(TGL_TEXTURE_2D, 0, TGL_RGBA, kTextureSize, kTextureSize, 0, TGL_RGBA, TGL_UNSIGNED_BYTE, texels);
+		delete[] texels;
+	}
+
+	void destroyScene() {
+		tglDeleteTextures(1, &_texture);
+		TinyGL::destroyContext();
+	}
+
+	// Overlapping textured quads at different depths, half of them blended
+	void drawScene(TinyGL::SpanFunc spanFunc) {
+		TinyGL::gl_get_context()->fb->setSpanFunc(spanFunc);
+
+		tglViewport(0, 0, kWidth, kHeight);
+		tglMatrixMode(TGL_PROJECTION);
+		tglLoadIdentity();
+		tglFrustum(-1.0, 1.0, -0.75, 0.75, 1.0, 100.0);
+		tglMatrixMode(TGL_MODELVIEW);
+		tglLoadIdentity();
+
+		tglClearColor(0.1f, 0.2f, 0.3f, 1.0f);
+		tglClearDepth(1.0);
+		tglClear(TGL_COLOR_BUFFER_BIT | TGL_DEPTH_BUFFER_BIT);
+		tglEnable(TGL_DEPTH_TEST);
+		tglDepthFunc(TGL_LEQUAL);
+		tglEnable(TGL_TEXTURE_2D);
+		tglShadeModel(TGL_SMOOTH);
+		tglBlendFunc(TGL_SRC_ALPHA, TGL_ONE_MINUS_SRC_ALPHA);
+
+		for (int i = 0; i < 16; i++) {
+			if (i & 1)
+				tglEnable(TGL_BLEND);
+			else
+				tglDisable(TGL_BLEND);
+
+			tglPushMatrix();
+			tglTranslatef((i % 4) * 0.6f - 0.9f, (i / 4) * 0.45f - 0.7f, -2.0f - (i % 3) * 0.7f);
+			tglRotatef(i * 23.0f, 0.3f, 0.5f, 1.0f);
+			tglBegin(TGL_QUADS);
+			tglColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+			tglTexCoord2f(0.0f, 0.0f);
+			tglVertex3f(-0.6f, -0.6f, 0.0f);
+			tglColor4f(1.0f, 0.5f, 0.2f, 0.8f);
+			tglTexCoord2f(2.0f, 0.0f);
+			tglVertex3f(0.6f, -0.6f, 0.0f);
+			tglColor4f(0.3f, 1.0f, 0.6f, 0.6f);
+			tglTexCoord2f(2.0f, 2.0f);
+			tglVertex3f(0.6f, 0.6f, 0.0f);
+			tglColor4f(0.7f, 0.4f, 1.0f, 1.0f);
+			tglTexCoord2f(0.0f, 2.0f);
+			tglVertex3f(-0.6f, 0.6f, 0.0f);
+			tglEnd();
+			tglPopMatrix();
+		}
+
+		TinyGL::presentBuffer();
+	}
+
+	// Triangles, lines and points around the edges of the 32 row bands the
+	// tile rasterizer splits the screen into
+	void drawBandScene() {
+		tglViewport(0, 0, kWidth, kHeight);
+		tglMatrixMode(TGL_PROJECTION);
+		tglLoadIdentity();
+		tglOrtho(0.0, kWidth, 0.0, kHeight, -1.0, 1.0);
+		tglMatrixMode(TGL_MODELVIEW);
+		tglLoadIdentity();
+
+		tglClearColor(0.3f, 0.1f, 0.2f, 1.0f);
+		tglClearDepth(1.0);
+		tglClear(TGL_COLOR_BUFFER_BIT | TGL_DEPTH_BUFFER_BIT);
+		tglEnable(TGL_DEPTH_TEST);
+		tglDepthFunc(TGL_LESS);
+		tglDisable(TGL_TEXTURE_2D);
+		tglShadeModel(TGL_SMOOTH);
+		tglBlendFunc(TGL_SRC_ALPHA, TGL_ONE_MINUS_SRC_ALPHA);
+
+		for (int i = 0; i < 24; i++) {
+			if (i % 3 == 0)
+				tglEnable(TGL_BLEND);
+			else
+				tglDisable(TGL_BLEND);
+
+			// Vertices up to a pixel off a band edge, and edges crossing it
+			const float edge = (i % 7 + 1) * 32.0f + (i % 5) * 0.25f - 0.5f;
+			const float x = i * 13.0f;
+			tglBegin(TGL_TRIANGLES);
+			tglColor4f(1.0f, (i % 4) * 0.25f, 0.2f, 0.7f);
+			tglVertex3f(x, edge, -0.5f + (i % 6) * 0.15f);
+			tglColor4f(0.2f, 1.0f, (i % 3) * 0.4f, 0.7f);
+			tglVertex3f(x + 60.0f, edge - 1.0f - (i % 4) * 9.0f, 0.3f);
+			tglColor4f(0.4f, 0.3f, 1.0f, 0.7f);
+			tglVertex3f(x + 25.0f, edge + 2.0f + (i % 5) * 17.0f, -0.2f);
+			tglEnd();
+
+			tglBegin(TGL_LINES);
+			tglColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+			tglVertex3f(x + 3.0f, edge - 4.0f, 0.0f);
+			tglVertex3f(x + 9.0f, edge + 36.0f, -0.4f);
+			tglVertex3f(x, edge, 0.1f);
+			tglVertex3f(x + 80.0f, edge + 0.5f, 0.1f);
+			tglEnd();
+
+			tglBegin(TGL_POINTS);
+			tglColor4f(0.0f, 1.0f, 1.0f, 1.0f);
+			tglVertex3f(x + 5.0f, (i % 7 + 1) * 32.0f - 1.0f, -0.9f);
+			tglVertex3f(x + 5.0f, (i % 7 + 1) * 32.0f, -0.9f);
+			tglEnd();
+		}
+
+		// A triangle covering every band
+		tglEnable(TGL_BLEND);
+		tglBegin(TGL_TRIANGLES);
+		tglColor4f(0.5f, 0.5f, 0.0f, 0.5f);
+		tglVertex3f(-10.0f, -10.0f, 0.5f);
+		tglVertex3f(kWidth + 10.0f, kHeight / 2.0f, 0.5f);
+		tglVertex3f(kWidth / 3.0f, kHeight + 10.0f, 0.5f);
+		tglEnd();
+
+		TinyGL::presentBuffer();
+	}
+
+	// Render both scenes, with the job system sized for @p cpuCount
+	void renderScenes(uint cpuCount, bool dirtyRects, byte *color, byte *depth) {
+		Common::install_null_g_system(cpuCount);
+		Common::JobSystem::destroy();
+		TS_ASSERT_EQUALS(JobSys.getWorkerCount(), cpuCount - 1);
+
+		createScene(Graphics::PixelFormat(4, 8, 8, 8, 8, 16, 8, 0, 24), dirtyRects);
+		TinyGL::FrameBuffer *fb = TinyGL::gl_get_context()->fb;
+		const uint pixelSize = kWidth * kHeight * 4;
+
+		drawScene(nullptr);
+		memcpy(color, fb->getPixelBuffer(), pixelSize);
+		memcpy(depth, fb->getZBuffer(), pixelSize);
+		drawBandScene();
+		memcpy(color + pixelSize, fb->getPixelBuffer(), pixelSize);
+		memcpy(depth + pixelSize, fb->getZBuffer(), pixelSize);
+
+		destroyScene();
+		Common::JobSystem::destroy();
+	}
+#endif
+
+public:
+	void test_span_funcs() {
+#if TINYGL_TESTS
+		Common::install_null_g_system();
+
+		const Common::Array<Funcs> simdFuncs = getSIMDFuncs();
+		Common::Array<Graphics::PixelFormat> formats;
+		formats.push_back(Graphics::PixelFormat(4, 8, 8, 8, 8, 16, 8, 0, 24));
+		formats.push_back(Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0));
+		formats.push_back(Graphics::PixelFormat(4, 8, 8, 8, 0, 16, 8, 0, 0));
+
+		const uint pixelSize = kWidth * kHeight * 4;
+		byte *expectedColor = new byte[pixelSize];
+		byte *expectedDepth = new byte[pixelSize];
+
+		for (uint f = 0; f < formats.size(); f++) {
+			createScene(formats[f]);
+			TinyGL::FrameBuffer *fb = TinyGL::gl_get_context()->fb;
+
+			// The first frame after creating the context is the reference
+			drawScene(nullptr);
+			memcpy(expectedColor, fb->getPixelBuffer(), pixelSize);
+			memcpy(expectedDepth, fb->getZBuffer(), pixelSize);
+
+			for (uint i = 0; i < simdFuncs.size(); i++) {
+				drawScene(simdFuncs[i].spanFunc);
+				TSM_ASSERT(simdFuncs[i].name, memcmp(fb->getPixelBuffer(), expectedColor, pixelSize) == 0);
+				TSM_ASSERT(simdFuncs[i].name, memcmp(fb->getZBuffer(), expectedDepth, pixelSize) == 0);
+			}
+
+			// Drawing the scene again gives the same frame
+			drawScene(nullptr);
+			TS_ASSERT(memcmp(fb->getPixelBuffer(), expectedColor, pixelSize) == 0);
+			TS_ASSERT(memcmp(fb->getZBuffer(), expectedDepth, pixelSize) == 0);
+
+			destroyScene();
+		}
+
+		delete[] expectedColor;
+		delete[] expectedDepth;
+#endif
+	}
+
+	void test_tile_rasterizer() {
+#if TINYGL_TESTS && NULL_OSYSTEM_HAS_THREADS
+		const uint size = kWidth * kHeight * 4 * 2;
+		byte *serialColor = new byte[size];
+		byte *serialDepth = new byte[size];
+		byte *tiledColor = new byte[size];
+		byte *tiledDepth = new byte[size];
+
+		for (int dirtyRects = 0; dirtyRects < 2; dirtyRects++) {
+			// Without workers, the draw calls are executed in order on the
+			// whole screen
+			renderScenes(1, dirtyRects, serialColor, serialDepth);
+			renderScenes(4, dirtyRects, tiledColor, tiledDepth);
+
+			TSM_ASSERT(dirtyRects ? "dirty rects" : "full screen", memcmp(tiledColor, serialColor, size) == 0);
+			TSM_ASSERT(dirtyRects ? "dirty rects" : "full screen", memcmp(tiledDepth, serialDepth, size) == 0);
+		}
+
+		delete[] serialColor;
+		delete[] serialDepth;
+		delete[] tiledColor;
+		delete[] tiledDepth;
+		Common::install_null_g_system();
+#endif
+	}
+
+	void test_span_funcs_speed() {
+#if TINYGL_TESTS
+		Common::install_null_g_system();
+
+		const Common::Array<Funcs> simdFuncs = getSIMDFuncs();
+
+#ifdef SLOW_TESTS
+		const int iters = 200;
+#else
+		const int iters = 1;
+#endif
+
+		createScene(Graphics::PixelFormat(4, 8, 8, 8, 8, 16, 8, 0, 24));
+		for (uint f = 0; f <= simdFuncs.size(); f++) {
+			const TinyGL::SpanFunc spanFunc = f < simdFuncs.size() ? simdFuncs[f].spanFunc : nullptr;
+			const char *name = f < simdFuncs.size() ? simdFuncs[f].name : "generic";
+
+			uint32 start = g_system->getMillis();
+			for (int i = 0; i < iters; i++)
+				drawScene(spanFunc);
+			debug("TinyGL textured scene (%s): %d ms for %d iters", name, g_system->getMillis() - start, iters);
+		}
+		destroyScene();
+#endif
+	}
+};
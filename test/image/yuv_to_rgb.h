@@ -0,0 +1,208 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cxxtest/TestSuite.h>
+#include "test/instrset_detect.h"
+
+#include "common/random.h"
+#include "common/system.h"
+#include "common/textconsole.h"
+
+#include "graphics/surface.h"
+#include "graphics/yuv_to_rgb.h"
+#include "graphics/yuv_to_rgb_intern.h"
+
+#include "../null_osystem.h"
+
+#if NULL_OSYSTEM_IS_AVAILABLE
+#define BENCHMARK_TIME 1
+#else
+#define BENCHMARK_TIME 0
+#endif
+
+class YUVToRGBTestSuite : public CxxTest::TestSuite {
+	struct Funcs {
+		const char *name;
+		const Graphics::YUVToRGBRowFuncs *rowFuncs;
+	};
+
+	static Common::Array<Funcs> getSIMDFuncs() {
+		Common::Array<Funcs> list;
+#ifdef SCUMMVM_NEON
+		Funcs neon = { "NEON", &Graphics::yuvToRGBRowFuncsNEON };
+		list.push_back(neon);
+#endif
+#ifdef SCUMMVM_SSE2
+		if (instrset_detect() >= 2) {
+			Funcs sse2 = { "SSE2", &Graphics::yuvToRGBRowFuncsSSE2 };
+			list.push_back(sse2);
+		}
+#endif
+#ifdef SCUMMVM_AVX2
+		if (instrset_detect() >= 8) {
+			Funcs avx2 = { "AVX2", &Graphics::yuvToRGBRowFuncsAVX2 };
+			list.push_back(avx2);
+		}
+#endif
+		return list;
+	}
+
+	enum {
+		kWidth = 100,  // Not a multiple of any vector size, but divisible by 4
+		kHeight = 24,
+		kPitch = 112,
+		kPlaneSize = kPitch * (kHeight + 1)
+	};
+
+	void convert(int type, Graphics::Surface &dst, Graphics::YUVToRGBManager::LuminanceScale scale,
+	             const byte *y, const byte *u, const byte *v, const byte *a) {
+		switch (type) {
+		case 0:
+			YUVToRGBMan.convert444(&dst, scale, y, u, v, kWidth, kHeight, kPitch, kPitch);
+			break;
+		case 1:
+			YUVToRGBMan.convert422(&dst, scale, y, u, v, kWidth, kHeight, kPitch, kPitch);
+			break;
+		case 2:
+			YUVToRGBMan.convert420(&dst, scale, y, u, v, kWidth, kHeight, kPitch, kPitch);
+			break;
+		case 3:
+			YUVToRGBMan.convert420Alpha(&dst, scale, y, u, v, a, kWidth, kHeight, kPitch, kPitch);
+			break;
+		case 4:
+			YUVToRGBMan.convert410(&dst, scale, y, u, v, kWidth, kHeight, kPitch, kPitch);
+			break;
+		}
+	}
+
+	static bool areSurfacesEqual(const Graphics::Surface &a, const Graphics::Surface &b) {
+		return memcmp(a.getPixels(), b.getPixels(), a.h * a.pitch) == 0;
+	}
+
+public:
+	void test_simd_matches_scalar() {
+		static const char *const typeNames[] = { "444", "422", "420", "420Alpha", "410" };
+
+		Common::RandomSource rnd("yuvtorgb");
+		const Common::Array<Funcs> simdFuncs = getSIMDFuncs();
+
+		Common::Array<Graphics::PixelFormat> formats;
+		formats.push_back(Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0));
+		formats.push_back(Graphics::PixelFormat(2, 4, 4, 4, 4, 12, 8, 4, 0));
+		formats.push_back(Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0));
+		formats.push_back(Graphics::PixelFormat(4, 8, 8, 8, 0, 16, 8, 0, 0));
+
+		byte *planes = new byte[kPlaneSize * 4];
+		for (uint i = 0; i < kPlaneSize * 4; i++)
+			planes[i] = rnd.getRandomNumber(255);
+		const byte *y = planes, *u = planes + kPlaneSize, *v = planes + kPlaneSize * 2, *a = planes + kPlaneSize * 3;
+
+		const Graphics::YUVToRGBRowFuncs *oldFuncs = YUVToRGBMan._rowFuncs;
+		const bool oldFuncsSelected = YUVToRGBMan._rowFuncsSelected;
+		const bool oldMultiThreaded = YUVToRGBMan._multiThreaded;
+		YUVToRGBMan._rowFuncsSelected = true;
+
+		for (uint f = 0; f < formats.size(); f++) {
+			Graphics::Surface expected, actual;
+			expected.create(kWidth, kHeight, formats[f]);
+			actual.create(kWidth, kHeight, formats[f]);
+
+			for (int scale = 0; scale < 2; scale++) {
+				for (int type = 0; type < 5; type++) {
+					const Graphics::YUVToRGBManager::LuminanceScale lumScale = (Graphics::YUVToRGBManager::LuminanceScale)scale;
+
+					YUVToRGBMan._rowFuncs = nullptr;
+					YUVToRGBMan._multiThreaded = false;
+					convert(type, expected, lumScale, y, u, v, a);
+
+					for (uint i = 0; i < simdFuncs.size(); i++) {
+						YUVToRGBMan._rowFuncs = simdFuncs[i].rowFuncs;
+						actual.fillRect(Common::Rect(kWidth, kHeight), 0);
+						convert(type, actual, lumScale, y, u, v, a);
+						if (!areSurfacesEqual(expected, actual)) {
+							warning("%s convert%s mismatch: %s, scale %d", simdFuncs[i].name, typeNames[type], formats[f].toString().c_str(), scale);
+							TS_FAIL("SIMD conversion mismatch");
+						}
+					}
+
+					// The result must not depend on how the image is split into bands
+					YUVToRGBMan._rowFuncs = nullptr;
+					YUVToRGBMan._multiThreaded = true;
+					actual.fillRect(Common::Rect(kWidth, kHeight), 0);
+					convert(type, actual, lumScale, y, u, v, a);
+					TS_ASSERT(areSurfacesEqual(expected, actual));
+				}
+			}
+
+			expected.free();
+			actual.free();
+		}
+
+		YUVToRGBMan._rowFuncs = oldFuncs;
+		YUVToRGBMan._rowFuncsSelected = oldFuncsSelected;
+		YUVToRGBMan._multiThreaded = oldMultiThreaded;
+		delete[] planes;
+	}
+
+	void test_convert_speed() {
+#if BENCHMARK_TIME
+		Common::install_null_g_system();
+
+		const int w = 1280, h = 720;
+#ifdef SLOW_TESTS
+		const int iters = 100;
+#else
+		const int iters = 1;
+#endif
+
+		byte *planes = new byte[w * h * 3];
+		for (int i = 0; i < w * h * 3; i++)
+			planes[i] = (byte)(i * 13);
+
+		Graphics::Surface surf;
+		surf.create(w, h, Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0));
+
+		const Graphics::YUVToRGBRowFuncs *oldFuncs = YUVToRGBMan._rowFuncs;
+		const bool oldFuncsSelected = YUVToRGBMan._rowFuncsSelected;
+		const bool oldMultiThreaded = YUVToRGBMan._multiThreaded;
+		YUVToRGBMan._rowFuncsSelected = true;
+		YUVToRGBMan._multiThreaded = false;
+
+		Common::Array<Funcs> funcs = getSIMDFuncs();
+		Funcs generic = { "generic", nullptr };
+		funcs.insert_at(0, generic);
+
+		for (uint i = 0; i < funcs.size(); i++) {
+			YUVToRGBMan._rowFuncs = funcs[i].rowFuncs;
+			uint32 start = g_system->getMillis();
+			for (int j = 0; j < iters; j++)
+				YUVToRGBMan.convert420(&surf, Graphics::YUVToRGBManager::kScaleITU, planes, planes + w * h, planes + w * h * 2, w, h, w, w / 2);
+			debug("convert420 1280x720 (%s): %d ms for %d iters", funcs[i].name, g_system->getMillis() - start, iters);
+		}
+
+		YUVToRGBMan._rowFuncs = oldFuncs;
+		YUVToRGBMan._rowFuncsSelected = oldFuncsSelected;
+		YUVToRGBMan._multiThreaded = oldMultiThreaded;
+		surf.free();
+		delete[] planes;
+#endif
+	}
+};
@@ -7,14 +7,20 @@
 
 //#define DISPLAY_ERROR_MESSAGES
 
-void Common::install_null_g_system() {
+void Common::install_null_g_system(unsigned int cpuCount) {
 #ifdef DISPLAY_ERROR_MESSAGES
 	const bool silenceLogs = false;
 #else
 	const bool silenceLogs = true;
 #endif
 
-	g_system = OSystem_NULL_create(silenceLogs);
+	OSystem_NULL *system = new OSystem_NULL(silenceLogs);
+#ifdef NULL_DRIVER_USE_THREADS
+	system->setCPUCount(cpuCount);
+#else
+	(void)cpuCount;
+#endif
+	g_system = system;
 }
 
 void OSystem_NULL::quit() {
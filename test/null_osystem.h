@@ -2,10 +2,16 @@
 #define TEST_NULL_OSYSTEM 1
 namespace Common {
 #if defined(POSIX) || defined(WIN32)
-void install_null_g_system();
+// cpuCount above 1 gives the job system workers, on POSIX only
+void install_null_g_system(unsigned int cpuCount = 1);
 #define NULL_OSYSTEM_IS_AVAILABLE 1
 #else
 #define NULL_OSYSTEM_IS_AVAILABLE 0
 #endif
+#ifdef POSIX
+#define NULL_OSYSTEM_HAS_THREADS 1
+#else
+#define NULL_OSYSTEM_HAS_THREADS 0
+#endif
 }
 #endif
@@ -0,0 +1,462 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cxxtest/TestSuite.h>
+
+#include "common/array.h"
+#include "common/endian.h"
+#include "common/intrinsics.h"
+#include "common/memstream.h"
+#include "common/random.h"
+#include "common/system.h"
+#include "common/textconsole.h"
+#include "common/util.h"
+
+#include "graphics/surface.h"
+
+#include "../null_osystem.h"
+
+// The decoder gets its default pixel format from g_system
+#if defined(USE_BINK) && NULL_OSYSTEM_IS_AVAILABLE
+#define BINK_TESTS 1
+#include "video/bink_decoder.h"
+#else
+#define BINK_TESTS 0
+#endif
+
+class BinkTestSuite : public CxxTest::TestSuite {
+#if BINK_TESTS
+	/** Writes bits in the order Common::BitStream32LELSB reads them. */
+	class BitWriter {
+	public:
+		BitWriter() : _bits(0) {}
+
+		void put(uint32 value, uint n) {
+			for (uint i = 0; i < n; i++, _bits++) {
+				if (!(_bits & 7))
+					_data.push_back(0);
+				if ((value >> i) & 1)
+					_data.back() |= 1 << (_bits & 7);
+			}
+		}
+
+		void align() {
+			while (_bits & 31)
+				put(0, 1);
+		}
+
+		const Common::Array<byte> &getData() const { return _data; }
+
+	private:
+		Common::Array<byte> _data;
+		uint32 _bits;
+	};
+
+	// Same order as BinkDecoder::BinkVideoTrack::Source
+	enum Source {
+		kSourceBlockTypes, kSourceSubBlockTypes, kSourceColors, kSourcePattern, kSourceXOff,
+		kSourceYOff, kSourceIntraDC, kSourceInterDC, kSourceRun, kSourceMAX
+	};
+
+	enum BlockType {
+		kBlockSkip   = 0,
+		kBlockScaled = 1,
+		kBlockMotion = 2,
+		kBlockIntra  = 5,
+		kBlockInter  = 7
+	};
+
+	/**
+	 * Generates random BIKi frames with all kinds of DCT blocks. Every row
+	 * of a plane has a single block type, so that the bundles can always use
+	 * their fill mode instead of Huffman codes.
+	 */
+	class StreamWriter {
+	public:
+		StreamWriter(uint width, uint height) : _rnd("bink"), _width(width), _height(height) {
+			_rnd.setSeed(1);
+		}
+
+		Common::SeekableReadStream *createStream(uint frameCount) {
+			Common::Array<Common::Array<byte> > frames;
+			uint32 size = 44 + 4 * frameCount;
+			uint32 largestFrameSize = 0;
+			for (uint i = 0; i < frameCount; i++) {
+				frames.push_back(writeFrame((i % 8) == 0));
+				size += frames[i].size();
+				largestFrameSize = MAX<uint32>(largestFrameSize, frames[i].size());
+			}
+
+			byte *data = (byte *)malloc(size);
+			WRITE_BE_UINT32(data, MKTAG('B', 'I', 'K', 'i'));
+			WRITE_LE_UINT32(data + 4, size - 8);
+			WRITE_LE_UINT32(data + 8, frameCount);
+			WRITE_LE_UINT32(data + 12, largestFrameSize);
+			WRITE_LE_UINT32(data + 16, 0);
+			WRITE_LE_UINT32(data + 20, _width);
+			WRITE_LE_UINT32(data + 24, _height);
+			WRITE_LE_UINT32(data + 28, 30);
+			WRITE_LE_UINT32(data + 32, 1);
+			WRITE_LE_UINT32(data + 36, 0x00100000); // Alpha plane
+			WRITE_LE_UINT32(data + 40, 0); // Audio tracks
+
+			uint32 offset = 44 + 4 * frameCount;
+			for (uint i = 0; i < frameCount; i++) {
+				WRITE_LE_UINT32(data + 44 + 4 * i, offset | ((i % 8) == 0 ? 1 : 0));
+				memcpy(data + offset, frames[i].begin(), frames[i].size());
+				offset += frames[i].size();
+			}
+
+			return new Common::MemoryReadStream(data, size, DisposeAfterUse::YES);
+		}
+
+	private:
+		Common::RandomSource _rnd;
+		uint _width, _height;
+
+		Common::Array<byte> writeFrame(bool keyFrame) {
+			const uint yBlockWidth   = (_width  +  7) >> 3;
+			const uint yBlockHeight  = (_height +  7) >> 3;
+			const uint uvBlockWidth  = (_width  + 15) >> 4;
+			const uint uvBlockHeight = (_height + 15) >> 4;
+
+			BitWriter bits;
+			// BIKi has an extra 32-bit word in front of the alpha and luma planes
+			bits.put(0, 32);
+			writePlane(bits, yBlockWidth, yBlockHeight, false, keyFrame);
+			bits.put(0, 32);
+			writePlane(bits, yBlockWidth, yBlockHeight, false, keyFrame);
+			writePlane(bits, uvBlockWidth, uvBlockHeight, true, keyFrame);
+			writePlane(bits, uvBlockWidth, uvBlockHeight, true, keyFrame);
+			return bits.getData();
+		}
+
+		/** How many values of a bundle the decoder uses in a block row. */
+		static uint getRowUsage(int source, byte rowType, uint row, uint blockWidth) {
+			const bool scaledTop = (rowType == kBlockScaled) && !(row & 1);
+
+			switch (source) {
+			case kSourceBlockTypes:
+				return rowType == kBlockScaled ? blockWidth / 2 : blockWidth;
+			case kSourceSubBlockTypes:
+				return scaledTop ? blockWidth / 2 : 0;
+			case kSourceXOff:
+			case kSourceYOff:
+				return (rowType == kBlockMotion || rowType == kBlockInter) ? blockWidth : 0;
+			case kSourceIntraDC:
+				return rowType == kBlockIntra ? blockWidth : (scaledTop ? blockWidth / 2 : 0);
+			case kSourceInterDC:
+				return rowType == kBlockInter ? blockWidth : 0;
+			default:
+				return 0;
+			}
+		}
+
+		void writePlane(BitWriter &bits, uint blockWidth, uint blockHeight, bool isChroma, bool keyFrame) {
+			static const byte interTypes[] = { kBlockSkip, kBlockMotion, kBlockIntra, kBlockInter };
+
+			Common::Array<byte> rows;
+			rows.resize(blockHeight);
+			for (uint y = 0; y < blockHeight; y += 2) {
+				if (y + 1 < blockHeight && _rnd.getRandomBit()) {
+					rows[y] = rows[y + 1] = kBlockScaled;
+					continue;
+				}
+
+				for (uint i = y; i < MIN(y + 2, blockHeight); i++) {
+					byte type = keyFrame ? (byte)kBlockIntra : interTypes[_rnd.getRandomNumber(3)];
+					// Keep motion vectors inside the previous plane
+					if ((type == kBlockMotion || type == kBlockInter) && (i == 0 || i + 1 == blockHeight))
+						type = kBlockIntra;
+					rows[i] = type;
+				}
+			}
+
+			// Huffman tree 0 for every bundle, plus the 16 trees for color high nibbles
+			for (int i = 0; i < kSourceMAX; i++) {
+				if (i == kSourceColors)
+					for (int j = 0; j < 16; j++)
+						bits.put(0, 4);
+				if (i != kSourceIntraDC && i != kSourceInterDC)
+					bits.put(0, 4);
+			}
+
+			// Same as BinkDecoder::BinkVideoTrack::initBundles()
+			const int width = MAX<uint>(isChroma ? _width >> 1 : _width, 8);
+			const int cbw = isChroma ? (_width + 15) >> 4 : (_width + 7) >> 3;
+			int countLengths[kSourceMAX];
+			countLengths[kSourceBlockTypes   ] = Common::intLog2((width >> 3) + 511) + 1;
+			countLengths[kSourceSubBlockTypes] = Common::intLog2(((width + 7) >> 4) + 511) + 1;
+			countLengths[kSourceColors       ] = Common::intLog2(cbw * 64 + 511) + 1;
+			countLengths[kSourceIntraDC      ] = Common::intLog2((width >> 3) + 511) + 1;
+			countLengths[kSourceInterDC      ] = Common::intLog2((width >> 3) + 511) + 1;
+			countLengths[kSourceXOff         ] = Common::intLog2((width >> 3) + 511) + 1;
+			countLengths[kSourceYOff         ] = Common::intLog2((width >> 3) + 511) + 1;
+			countLengths[kSourcePattern      ] = Common::intLog2((cbw << 3) + 511) + 1;
+			countLengths[kSourceRun          ] = Common::intLog2(cbw * 48 + 511) + 1;
+
+			uint pending[kSourceMAX];
+			bool finished[kSourceMAX];
+			for (int i = 0; i < kSourceMAX; i++) {
+				pending[i] = 0;
+				finished[i] = false;
+			}
+
+			for (uint y = 0; y < blockHeight; y++) {
+				for (int s = 0; s < kSourceMAX; s++) {
+					const uint usage = getRowUsage(s, rows[y], y, blockWidth);
+
+					// The decoder only reads new values once it used up the previous ones,
+					// so write exactly what is needed up to the next row using this bundle
+					if (finished[s] || pending[s]) {
+						pending[s] -= usage;
+						continue;
+					}
+
+					uint n = 0;
+					for (uint i = y; i < blockHeight && !n; i++)
+						n = getRowUsage(s, rows[i], i, blockWidth);
+
+					bits.put(n, countLengths[s]);
+					if (!n) {
+						finished[s] = true;
+						continue;
+					}
+
+					writeBundle(bits, s, n, rows[y]);
+					pending[s] = n - usage;
+				}
+
+				for (uint x = 0; x < blockWidth; x++) {
+					if (rows[y] == kBlockScaled) {
+						if (!(y & 1))
+							writeCoeffs(bits);
+						x++;
+					} else if (rows[y] == kBlockIntra || rows[y] == kBlockInter) {
+						writeCoeffs(bits);
+					}
+				}
+			}
+
+			bits.align();
+		}
+
+		void writeBundle(BitWriter &bits, int source, uint n, byte rowType) {
+			switch (source) {
+			case kSourceBlockTypes:
+				bits.put(1, 1);
+				bits.put(rowType, 4);
+				break;
+			case kSourceSubBlockTypes:
+				bits.put(1, 1);
+				bits.put(kBlockIntra, 4);
+				break;
+			case kSourceXOff:
+			case kSourceYOff: {
+				const int v = _rnd.getRandomNumberRngSigned(-7, 7);
+				bits.put(1, 1);
+				bits.put(ABS(v), 4);
+				if (v)
+					bits.put(v < 0, 1);
+				break;
+			}
+			case kSourceIntraDC:
+				writeDCs(bits, n, false);
+				break;
+			case kSourceInterDC:
+				writeDCs(bits, n, true);
+				break;
+			default:
+				error("Unused bundle %d", source);
+			}
+		}
+
+		void writeDCs(BitWriter &bits, uint n, bool hasSign) {
+			const int minValue = hasSign ? -300 : 0;
+			const int maxValue = hasSign ? 300 : 1023;
+
+			int v = _rnd.getRandomNumberRngSigned(minValue, maxValue);
+			if (hasSign) {
+				bits.put(ABS(v), 10);
+				if (v)
+					bits.put(v < 0, 1);
+			} else {
+				bits.put(v, 11);
+			}
+
+			for (uint i = 1; i < n; i += 8) {
+				const uint size = _rnd.getRandomNumber(4);
+				bits.put(size, 4);
+				if (!size)
+					continue;
+
+				for (uint j = i; j < MIN(i + 8, n); j++) {
+					int delta = _rnd.getRandomNumberRngSigned(1 - (1 << size), (1 << size) - 1);
+					if (v + delta < minValue || v + delta > maxValue)
+						delta = -delta;
+					v += delta;
+					bits.put(ABS(delta), size);
+					if (delta)
+						bits.put(delta < 0, 1);
+				}
+			}
+		}
+
+		void writeCoeff(BitWriter &bits, int level) {
+			if (level)
+				bits.put(_rnd.getRandomNumber((1 << level) - 1), level);
+			bits.put(_rnd.getRandomBit(), 1);
+		}
+
+		/** Mirrors BinkDecoder::BinkVideoTrack::readDCTCoeffs(). */
+		void writeCoeffs(BitWriter &bits) {
+			int coefList[128], modeList[128];
+			int listStart = 64, listEnd = 64;
+			coefList[listEnd] = 4;  modeList[listEnd++] = 0;
+			coefList[listEnd] = 24; modeList[listEnd++] = 0;
+			coefList[listEnd] = 44; modeList[listEnd++] = 0;
+			coefList[listEnd] = 1;  modeList[listEnd++] = 3;
+			coefList[listEnd] = 2;  modeList[listEnd++] = 3;
+			coefList[listEnd] = 3;  modeList[listEnd++] = 3;
+
+			// Small coefficients and quantizers keep the IDCT within 32 bits
+			const int levels = _rnd.getRandomNumber(5);
+			bits.put(levels, 4);
+
+			for (int level = levels - 1; level >= 0; level--) {
+				int listPos = listStart;
+				while (listPos < listEnd) {
+					if (!(modeList[listPos] | coefList[listPos])) {
+						listPos++;
+						continue;
+					}
+
+					const uint coded = _rnd.getRandomBit();
+					bits.put(coded, 1);
+					if (!coded) {
+						listPos++;
+						continue;
+					}
+
+					int ccoef = coefList[listPos];
+					const int mode = modeList[listPos];
+					switch (mode) {
+					case 0:
+					case 2:
+						if (mode == 0) {
+							coefList[listPos] = ccoef + 4;
+							modeList[listPos] = 1;
+						} else {
+							coefList[listPos]   = 0;
+							modeList[listPos++] = 0;
+						}
+						for (int i = 0; i < 4; i++, ccoef++) {
+							const uint split = _rnd.getRandomBit();
+							bits.put(split, 1);
+							if (split) {
+								coefList[--listStart] = ccoef;
+								modeList[  listStart] = 3;
+							} else {
+								writeCoeff(bits, level);
+							}
+						}
+						break;
+					case 1:
+						modeList[listPos] = 2;
+						for (int i = 0; i < 3; i++) {
+							ccoef += 4;
+							coefList[listEnd]   = ccoef;
+							modeList[listEnd++] = 2;
+						}
+						break;
+					default:
+						writeCoeff(bits, level);
+						coefList[listPos]   = 0;
+						modeList[listPos++] = 0;
+						break;
+					}
+				}
+			}
+
+			bits.put(_rnd.getRandomNumber(3), 4);
+		}
+	};
+
+	/** Decode all frames, returning a hash of their pixels. */
+	static uint32 decodeFrames(Video::BinkDecoder &decoder, uint &frameCount) {
+		uint32 hash = 2166136261u;
+		frameCount = 0;
+		while (!decoder.endOfVideo()) {
+			const Graphics::Surface *surface = decoder.decodeNextFrame();
+			if (!surface)
+				break;
+
+			for (int y = 0; y < surface->h; y++) {
+				const byte *row = (const byte *)surface->getBasePtr(0, y);
+				for (int x = 0; x < surface->w * surface->format.bytesPerPixel; x++)
+					hash = (hash ^ row[x]) * 16777619u;
+			}
+			frameCount++;
+		}
+		return hash;
+	}
+#endif
+
+public:
+	void test_decode() {
+#if BINK_TESTS
+		Common::install_null_g_system();
+
+		StreamWriter writer(320, 176);
+		Video::BinkDecoder decoder;
+		TS_ASSERT(decoder.loadStream(writer.createStream(12)));
+		decoder.setOutputPixelFormat(Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0));
+
+		uint frameCount;
+		const uint32 hash = decodeFrames(decoder, frameCount);
+		TS_ASSERT_EQUALS(frameCount, 12u);
+		TS_ASSERT_EQUALS(hash, 304013641u);
+#endif
+	}
+
+	void test_decode_speed() {
+#if BINK_TESTS
+		Common::install_null_g_system();
+
+#ifdef SLOW_TESTS
+		const uint frames = 120;
+#else
+		const uint frames = 2;
+#endif
+
+		StreamWriter writer(1280, 720);
+		Video::BinkDecoder decoder;
+		TS_ASSERT(decoder.loadStream(writer.createStream(frames)));
+		decoder.setOutputPixelFormat(Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0));
+
+		uint frameCount;
+		const uint32 start = g_system->getMillis();
+		decodeFrames(decoder, frameCount);
+		TS_ASSERT_EQUALS(frameCount, frames);
+		debug("Bink 1280x720 with alpha: %d ms for %d frames", g_system->getMillis() - start, frames);
+#endif
+	}
+};
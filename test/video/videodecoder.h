@@ -0,0 +1,232 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/atomic.h"
+#include "common/system.h"
+
+#include "graphics/surface.h"
+
+#include "../null_osystem.h"
+
+// The decode-ahead worker needs the threads of the null backend
+#if NULL_OSYSTEM_IS_AVAILABLE && NULL_OSYSTEM_HAS_THREADS
+#define DECODE_AHEAD_TESTS 1
+#include "video/video_decoder.h"
+#else
+#define DECODE_AHEAD_TESTS 0
+#endif
+
+class VideoDecoderTestSuite : public CxxTest::TestSuite {
+#if DECODE_AHEAD_TESTS
+	/** A video whose frames are filled with their frame number. */
+	class TestDecoder : public Video::VideoDecoder {
+	public:
+		bool loadStream(Common::SeekableReadStream *stream) override {
+			return false;
+		}
+
+		void load(int frameCount) {
+			_track = new TestTrack(frameCount);
+			addTrack(_track);
+		}
+
+		/** Number of frames the track has decoded, on whatever thread. */
+		uint32 getDecodedCount() const { return _track->_decoded.load(); }
+
+		/** Number of times the track was paused while it was decoding. */
+		uint32 getOverlapCount() const { return _track->_overlaps.load(); }
+
+		/** Make decoding a frame take a while. */
+		void setDecodeDelay(uint32 msecs) { _track->_decodeDelay = msecs; }
+
+		/**
+		 * Wait until the track has decoded @p count frames, and a little
+		 * longer to see that it does not decode more.
+		 */
+		bool waitForDecodedCount(uint32 count) const {
+			for (int i = 0; i < 5000 && getDecodedCount() < count; i++)
+				g_system->delayMillis(1);
+			g_system->delayMillis(20);
+			return getDecodedCount() == count;
+		}
+
+	private:
+		class TestTrack : public FixedRateVideoTrack {
+		public:
+			TestTrack(int frameCount) : _frameCount(frameCount), _curFrame(-1), _decodeDelay(0) {
+				_surface.create(4, 2, Graphics::PixelFormat::createFormatCLUT8());
+			}
+			~TestTrack() override { _surface.free(); }
+
+			uint16 getWidth() const override { return _surface.w; }
+			uint16 getHeight() const override { return _surface.h; }
+			Graphics::PixelFormat getPixelFormat() const override { return _surface.format; }
+			int getCurFrame() const override { return _curFrame; }
+			int getFrameCount() const override { return _frameCount; }
+
+			const Graphics::Surface *decodeNextFrame() override {
+				_decoding.store(true);
+				if (_decodeDelay)
+					g_system->delayMillis(_decodeDelay);
+				_curFrame++;
+				_surface.fillRect(Common::Rect(_surface.w, _surface.h), _curFrame);
+				_decoded.fetchAdd(1);
+				_decoding.store(false);
+				return &_surface;
+			}
+
+			bool isSeekable() const override { return true; }
+			bool seek(const Audio::Timestamp &time) override {
+				_curFrame = getFrameAtTime(time) - 1;
+				return true;
+			}
+
+			Common::Atomic<uint32> _decoded;
+			Common::Atomic<uint32> _overlaps;
+			Common::Atomic<bool> _decoding;
+			uint32 _decodeDelay;
+
+		protected:
+			Common::Rational getFrameRate() const override { return 30; }
+
+			void pauseIntern(bool shouldPause) override {
+				if (_decoding.load())
+					_overlaps.fetchAdd(1);
+			}
+
+		private:
+			Graphics::Surface _surface;
+			int _frameCount;
+			int _curFrame;
+		};
+
+		TestTrack *_track;
+	};
+
+	static int frameNumber(const Graphics::Surface *frame) {
+		if (!frame)
+			return -1;
+		return *(const byte *)frame->getBasePtr(frame->w - 1, frame->h - 1);
+	}
+#endif
+
+public:
+	void test_queue_fill() {
+#if DECODE_AHEAD_TESTS
+		Common::install_null_g_system();
+		TestDecoder decoder;
+		decoder.load(100);
+		TS_ASSERT(decoder.setDecodeAhead(3));
+		decoder.start();
+
+		// The worker starts with the first frame, and fills the whole queue
+		// besides the displayed frame
+		const Graphics::Surface *frame = decoder.decodeNextFrame();
+		TS_ASSERT_EQUALS(frameNumber(frame), 0);
+		TS_ASSERT_EQUALS(decoder.getCurFrame(), 0);
+		TS_ASSERT(decoder.waitForDecodedCount(1 + 3));
+
+		// The displayed frame is left alone until the next one is requested
+		TS_ASSERT_EQUALS(frameNumber(frame), 0);
+
+		for (int i = 1; i < 10; i++) {
+			frame = decoder.decodeNextFrame();
+			TS_ASSERT_EQUALS(frameNumber(frame), i);
+			TS_ASSERT_EQUALS(decoder.getCurFrame(), i);
+			TS_ASSERT(decoder.waitForDecodedCount(i + 1 + 3));
+		}
+
+		// Too late once frames are decoded
+		TS_ASSERT(!decoder.setDecodeAhead(2));
+		decoder.close();
+#endif
+	}
+
+	void test_seek_and_rewind() {
+#if DECODE_AHEAD_TESTS
+		Common::install_null_g_system();
+		TestDecoder decoder;
+		decoder.load(100);
+		TS_ASSERT(decoder.setDecodeAhead(4));
+		decoder.start();
+
+		TS_ASSERT_EQUALS(frameNumber(decoder.decodeNextFrame()), 0);
+		TS_ASSERT_EQUALS(frameNumber(decoder.decodeNextFrame()), 1);
+		TS_ASSERT(decoder.waitForDecodedCount(2 + 4));
+
+		// The queued frames 2 to 5 are dropped
+		TS_ASSERT(decoder.seekToFrame(50));
+		TS_ASSERT_EQUALS(decoder.getDecodedCount(), 6u);
+		TS_ASSERT_EQUALS(frameNumber(decoder.decodeNextFrame()), 50);
+		TS_ASSERT_EQUALS(decoder.getCurFrame(), 50);
+		TS_ASSERT_EQUALS(frameNumber(decoder.decodeNextFrame()), 51);
+		TS_ASSERT(decoder.waitForDecodedCount(6 + 2 + 4));
+
+		// Seeking backward
+		TS_ASSERT(decoder.seekToFrame(20));
+		TS_ASSERT_EQUALS(frameNumber(decoder.decodeNextFrame()), 20);
+		TS_ASSERT_EQUALS(decoder.getCurFrame(), 20);
+
+		TS_ASSERT(decoder.rewind());
+		TS_ASSERT_EQUALS(frameNumber(decoder.decodeNextFrame()), 0);
+		TS_ASSERT_EQUALS(frameNumber(decoder.decodeNextFrame()), 1);
+		TS_ASSERT_EQUALS(decoder.getCurFrame(), 1);
+		decoder.close();
+#endif
+	}
+
+	void test_rate_and_pause() {
+#if DECODE_AHEAD_TESTS
+		Common::install_null_g_system();
+		TestDecoder decoder;
+		decoder.load(100);
+		decoder.setDecodeDelay(2);
+		TS_ASSERT(decoder.setDecodeAhead(3));
+		decoder.start();
+
+		// Changing the state of the tracks waits for the worker, and keeps
+		// the queued frames
+		for (int i = 0; i < 30; i++) {
+			TS_ASSERT_EQUALS(frameNumber(decoder.decodeNextFrame()), i);
+			TS_ASSERT_EQUALS(decoder.getCurFrame(), i);
+
+			decoder.setRate((i & 1) ? 2 : 1);
+			decoder.pauseVideo(true);
+			TS_ASSERT(decoder.isPaused());
+			decoder.pauseVideo(false);
+			TS_ASSERT(!decoder.isPaused());
+			decoder.setEndFrame(99);
+		}
+
+		TS_ASSERT_EQUALS(decoder.getOverlapCount(), 0u);
+		TS_ASSERT_EQUALS(frameNumber(decoder.decodeNextFrame()), 30);
+		decoder.close();
+#endif
+	}
+
+	void test_end_of_track() {
+#if DECODE_AHEAD_TESTS
+		Common::install_null_g_system();
+		TestDecoder decoder;
+		decoder.load(6);
+		TS_ASSERT(decoder.setDecodeAhead(4));
+		decoder.start();
+
+		for (int i = 0; i < 6; i++) {
+			TS_ASSERT(!decoder.endOfVideo());
+			TS_ASSERT_EQUALS(frameNumber(decoder.decodeNextFrame()), i);
+		}
+
+		// The worker stops at the last frame
+		TS_ASSERT(decoder.endOfVideo());
+		TS_ASSERT_EQUALS(decoder.getCurFrame(), 5);
+		TS_ASSERT(!decoder.decodeNextFrame());
+		TS_ASSERT(decoder.waitForDecodedCount(6));
+
+		// Rewinding at the end restarts it
+		TS_ASSERT(decoder.rewind());
+		TS_ASSERT(!decoder.endOfVideo());
+		TS_ASSERT_EQUALS(frameNumber(decoder.decodeNextFrame()), 0);
+		decoder.close();
+#endif
+	}
+};
@@ -29,6 +29,7 @@
 #include "common/util.h"
 #include "common/textconsole.h"
 #include "common/intrinsics.h"
+#include "common/jobs.h"
 #include "common/stream.h"
 #include "common/substream.h"
 #include "common/file.h"
@@ -59,6 +60,9 @@ static const uint16 kAudioFlagStereo = 0x2000;
 // Number of bits used to store first DC value in bundle
 static const uint32 kDCStartBits = 11;
 
+// Minimum number of DCT blocks transformed by a job
+static const uint kMinDCTSlice = 64;
+
 namespace Video {
 
 BinkDecoder::BinkDecoder() {
@@ -305,6 +309,12 @@ BinkDecoder::BinkVideoTrack::BinkVideoTrack(uint32 width, uint32 height, uint32
 	memset(_curPlanes[3], 255, _yBlockWidth  * 8 * _yBlockHeight  * 8);
 	memset(_oldPlanes[3], 255, _yBlockWidth  * 8 * _yBlockHeight  * 8);
 
+	// The IDCTs are run per plane, and a plane has at most one DCT block per 8x8 block
+	_dctCoeffs     = new int32[_yBlockWidth * _yBlockHeight * 64];
+	_dctBlocks     = new DCTBlock[_yBlockWidth * _yBlockHeight];
+	_dctBlockCount = 0;
+	_dctPitch      = 0;
+
 	initBundles();
 	initHuffman();
 }
@@ -315,6 +325,9 @@ BinkDecoder::BinkVideoTrack::~BinkVideoTrack() {
 		delete[] _oldPlanes[i]; _oldPlanes[i] = 0;
 	}
 
+	delete[] _dctCoeffs;
+	delete[] _dctBlocks;
+
 	deinitBundles();
 
 	for (int i = 0; i < 16; i++) {
@@ -514,6 +527,8 @@ void BinkDecoder::BinkVideoTrack::decodePlane(VideoFrame &video, int planeIdx, b
 	ctx.prevEnd   = _oldPlanes[planeIdx] + width * height;
 	ctx.pitch     = width;
 
+	_dctPitch = ctx.pitch;
+
 	for (int i = 0; i < 64; i++) {
 		ctx.coordMap[i] = (i & 7) + (i >> 3) * ctx.pitch;
 
@@ -593,6 +608,8 @@ void BinkDecoder::BinkVideoTrack::decodePlane(VideoFrame &video, int planeIdx, b
 
 	}
 
+	flushDCTBlocks();
+
 	if (video.bits->pos() & 0x1F) // next plane data starts at 32-bit boundary
 		video.bits->skip(32 - (video.bits->pos() & 0x1F));
 
@@ -808,24 +825,11 @@ void BinkDecoder::BinkVideoTrack::blockScaledRun(DecodeContext &ctx) {
 }
 
 void BinkDecoder::BinkVideoTrack::blockScaledIntra(DecodeContext &ctx) {
-	int32 block[64];
-	memset(block, 0, 64 * sizeof(int32));
+	int32 *block = addDCTBlock(ctx, kDCTScaled);
 
 	block[0] = getBundleValue(kSourceIntraDC);
 
 	readDCTCoeffs(*ctx.video, block, true);
-
-	IDCT(block);
-
-	int32 *src   = block;
-	byte  *dest1 = ctx.dest;
-	byte  *dest2 = ctx.dest + ctx.pitch;
-	for (int j = 0; j < 8; j++, dest1 += (ctx.pitch << 1) - 16, dest2 += (ctx.pitch << 1) - 16, src += 8) {
-
-		for (int i = 0; i < 8; i++, dest1 += 2, dest2 += 2)
-			dest1[0] = dest1[1] = dest2[0] = dest2[1] = src[i];
-
-	}
 }
 
 void BinkDecoder::BinkVideoTrack::blockScaledFill(DecodeContext &ctx) {
@@ -953,14 +957,11 @@ void BinkDecoder::BinkVideoTrack::blockResidue(DecodeContext &ctx) {
 }
 
 void BinkDecoder::BinkVideoTrack::blockIntra(DecodeContext &ctx) {
-	int32 block[64];
-	memset(block, 0, 64 * sizeof(int32));
+	int32 *block = addDCTBlock(ctx, kDCTPut);
 
 	block[0] = getBundleValue(kSourceIntraDC);
 
 	readDCTCoeffs(*ctx.video, block, true);
-
-	IDCTPut(ctx, block);
 }
 
 void BinkDecoder::BinkVideoTrack::blockFill(DecodeContext &ctx) {
@@ -974,14 +975,11 @@ void BinkDecoder::BinkVideoTrack::blockFill(DecodeContext &ctx) {
 void BinkDecoder::BinkVideoTrack::blockInter(DecodeContext &ctx) {
 	blockMotion(ctx);
 
-	int32 block[64];
-	memset(block, 0, 64 * sizeof(int32));
+	int32 *block = addDCTBlock(ctx, kDCTAdd);
 
 	block[0] = getBundleValue(kSourceInterDC);
 
 	readDCTCoeffs(*ctx.video, block, false);
-
-	IDCTAdd(ctx, block);
 }
 
 void BinkDecoder::BinkVideoTrack::blockPattern(DecodeContext &ctx) {
@@ -1415,80 +1413,92 @@ void BinkDecoder::BinkVideoTrack::readResidue(VideoFrame &video, int16 *block, i
 #define A3  3784
 #define A4 -5352
 
-#define IDCT_TRANSFORM(dest,s0,s1,s2,s3,s4,s5,s6,s7,d0,d1,d2,d3,d4,d5,d6,d7,munge,src) {\
-	const int a0 = (src)[s0] + (src)[s4]; \
-	const int a1 = (src)[s0] - (src)[s4]; \
-	const int a2 = (src)[s2] + (src)[s6]; \
-	const int a3 = (A1*((src)[s2] - (src)[s6])) >> 11; \
-	const int a4 = (src)[s5] + (src)[s3]; \
-	const int a5 = (src)[s5] - (src)[s3]; \
-	const int a6 = (src)[s1] + (src)[s7]; \
-	const int a7 = (src)[s1] - (src)[s7]; \
-	const int b0 = a4 + a6; \
-	const int b1 = (A3*(a5 + a7)) >> 11; \
-	const int b2 = ((A4*a5) >> 11) - b0 + b1; \
-	const int b3 = (A1*(a6 - a4) >> 11) - b2; \
-	const int b4 = ((A2*a7) >> 11) + b3 - b1; \
-	(dest)[d0] = munge(a0+a2   +b0); \
-	(dest)[d1] = munge(a1+a3-a2+b2); \
-	(dest)[d2] = munge(a1-a3+a2+b3); \
-	(dest)[d3] = munge(a0-a2   -b4); \
-	(dest)[d4] = munge(a0-a2   +b4); \
-	(dest)[d5] = munge(a1-a3+a2-b3); \
-	(dest)[d6] = munge(a1+a3-a2-b2); \
-	(dest)[d7] = munge(a0+a2   -b0); \
-}
-/* end IDCT_TRANSFORM macro */
-
-#define MUNGE_NONE(x) (x)
-#define IDCT_COL(dest,src) IDCT_TRANSFORM(dest,0,8,16,24,32,40,48,56,0,8,16,24,32,40,48,56,MUNGE_NONE,src)
-
-#define MUNGE_ROW(x) (((x) + 0x7F)>>8)
-#define IDCT_ROW(dest,src) IDCT_TRANSFORM(dest,0,1,2,3,4,5,6,7,0,1,2,3,4,5,6,7,MUNGE_ROW,src)
-
-static inline void IDCTCol(int32 *dest, const int32 *src) {
-	if ((src[8] | src[16] | src[24] | src[32] | src[40] | src[48] | src[56]) == 0) {
-		dest[ 0] =
-		dest[ 8] =
-		dest[16] =
-		dest[24] =
-		dest[32] =
-		dest[40] =
-		dest[48] =
-		dest[56] = src[0];
-	} else {
-		IDCT_COL(dest, src);
+/**
+ * One pass of the IDCT, transforming the 8 columns of src at the same time
+ * so that the compiler can vectorize it. The output is transposed, which
+ * lets the second pass transform the rows of the first pass's output the
+ * same way.
+ */
+template<bool isRowPass>
+static inline void IDCTPass(int32 *dest, const int32 *src) {
+	for (int i = 0; i < 8; i++) {
+		const int32 *s = src + i;
+		int32 *d = dest + 8 * i;
+
+		const int a0 = s[ 0] + s[32];
+		const int a1 = s[ 0] - s[32];
+		const int a2 = s[16] + s[48];
+		const int a3 = (A1 * (s[16] - s[48])) >> 11;
+		const int a4 = s[40] + s[24];
+		const int a5 = s[40] - s[24];
+		const int a6 = s[ 8] + s[56];
+		const int a7 = s[ 8] - s[56];
+		const int b0 = a4 + a6;
+		const int b1 = (A3 * (a5 + a7)) >> 11;
+		const int b2 = ((A4 * a5) >> 11) - b0 + b1;
+		const int b3 = (A1 * (a6 - a4) >> 11) - b2;
+		const int b4 = ((A2 * a7) >> 11) + b3 - b1;
+
+		// The rounding of the row pass
+		const int r = isRowPass ? 0x7F : 0;
+		const int shift = isRowPass ? 8 : 0;
+
+		d[0] = (a0 + a2      + b0 + r) >> shift;
+		d[1] = (a1 + a3 - a2 + b2 + r) >> shift;
+		d[2] = (a1 - a3 + a2 + b3 + r) >> shift;
+		d[3] = (a0 - a2      - b4 + r) >> shift;
+		d[4] = (a0 - a2      + b4 + r) >> shift;
+		d[5] = (a1 - a3 + a2 - b3 + r) >> shift;
+		d[6] = (a1 + a3 - a2 - b2 + r) >> shift;
+		d[7] = (a0 + a2      - b0 + r) >> shift;
 	}
 }
 
-void BinkDecoder::BinkVideoTrack::IDCT(int32 *block) {
-	int i;
-	int32 temp[64];
+int32 *BinkDecoder::BinkVideoTrack::addDCTBlock(DecodeContext &ctx, DCTOutput output) {
+	DCTBlock &block = _dctBlocks[_dctBlockCount];
+	block.dest   = ctx.dest;
+	block.output = output;
 
-	for (i = 0; i < 8; i++)
-		IDCTCol(&temp[i], &block[i]);
-	for (i = 0; i < 8; i++) {
-		IDCT_ROW( (&block[8*i]), (&temp[8*i]) );
-	}
+	int32 *coeffs = _dctCoeffs + 64 * _dctBlockCount++;
+	memset(coeffs, 0, 64 * sizeof(int32));
+	return coeffs;
 }
 
-void BinkDecoder::BinkVideoTrack::IDCTAdd(DecodeContext &ctx, int32 *block) {
-	int i, j;
+void BinkDecoder::BinkVideoTrack::flushDCTBlocks() {
+	// The blocks don't overlap, so they can be transformed in any order
+	JobSys.parallelFor(_dctBlockCount, IDCTBlocks, this, kMinDCTSlice);
+	_dctBlockCount = 0;
+}
 
-	IDCT(block);
-	byte *dest = ctx.dest;
-	for (i = 0; i < 8; i++, dest += ctx.pitch, block += 8)
-		for (j = 0; j < 8; j++)
-			 dest[j] += block[j];
-}
-
-void BinkDecoder::BinkVideoTrack::IDCTPut(DecodeContext &ctx, int32 *block) {
-	int i;
-	int32 temp[64];
-	for (i = 0; i < 8; i++)
-		IDCTCol(&temp[i], &block[i]);
-	for (i = 0; i < 8; i++) {
-		IDCT_ROW( (&ctx.dest[i*ctx.pitch]), (&temp[8*i]) );
+void BinkDecoder::BinkVideoTrack::IDCTBlocks(void *param, uint begin, uint end) {
+	const BinkVideoTrack *track = (const BinkVideoTrack *)param;
+	const uint32 pitch = track->_dctPitch;
+
+	int32 temp[64], block[64];
+	for (uint n = begin; n < end; n++) {
+		IDCTPass<false>(temp, track->_dctCoeffs + 64 * n);
+		IDCTPass<true>(block, temp);
+
+		const int32 *src = block;
+		byte *dest = track->_dctBlocks[n].dest;
+
+		switch (track->_dctBlocks[n].output) {
+		case kDCTPut:
+			for (int j = 0; j < 8; j++, dest += pitch, src += 8)
+				for (int i = 0; i < 8; i++)
+					dest[i] = src[i];
+			break;
+		case kDCTAdd:
+			for (int j = 0; j < 8; j++, dest += pitch, src += 8)
+				for (int i = 0; i < 8; i++)
+					dest[i] += src[i];
+			break;
+		case kDCTScaled:
+			for (int j = 0; j < 8; j++, dest += pitch << 1, src += 8)
+				for (int i = 0; i < 8; i++)
+					dest[2 * i] = dest[2 * i + 1] = dest[pitch + 2 * i] = dest[pitch + 2 * i + 1] = src[i];
+			break;
+		}
 	}
 }
 
@@ -241,6 +241,19 @@ private:
 			byte *curPtr; ///< Pointer to the data that wasn't yet read.
 		};
 
+		/** How the result of an IDCT is written into the plane. */
+		enum DCTOutput {
+			kDCTPut,   ///< Store the 8x8 block.
+			kDCTAdd,   ///< Add the 8x8 block to the motion compensated pixels.
+			kDCTScaled ///< Store the block scaled up to 16x16.
+		};
+
+		/** A DCT block, transformed once the whole plane has been read. */
+		struct DCTBlock {
+			byte *dest;       ///< Top left pixel of the block in the plane.
+			DCTOutput output; ///< How to write the block.
+		};
+
 		int _curFrame;
 		int _frameCount;
 
@@ -275,6 +288,11 @@ private:
 		byte *_curPlanes[4]; ///< The 4 color planes, YUVA, current frame.
 		byte *_oldPlanes[4]; ///< The 4 color planes, YUVA, last frame.
 
+		int32 *_dctCoeffs;      ///< The coefficients of the DCT blocks, 64 per block.
+		DCTBlock *_dctBlocks;   ///< The DCT blocks of the current plane.
+		uint32 _dctBlockCount;  ///< Number of DCT blocks in the current plane.
+		uint32 _dctPitch;       ///< Pitch of the current plane.
+
 		/** Initialize the bundles. */
 		void initBundles();
 		/** Deinitialize the bundles. */
@@ -332,9 +350,11 @@ private:
 		void readResidue     (VideoFrame &video, int16 *block, int masksCount);
 
 		// Bink video IDCT
-		void IDCT(int32 *block);
-		void IDCTPut(DecodeContext &ctx, int32 *block);
-		void IDCTAdd(DecodeContext &ctx, int32 *block);
+		/** Queue a DCT block, returning its zeroed coefficients. */
+		int32 *addDCTBlock(DecodeContext &ctx, DCTOutput output);
+		/** Transform the queued DCT blocks into the plane. */
+		void flushDCTBlocks();
+		static void IDCTBlocks(void *param, uint begin, uint end);
 	};
 
 	class BinkAudioTrack : public AudioTrack {
@@ -346,7 +346,6 @@ QuickTimeDecoder::VideoTrackHandler::VideoTrackHandler(QuickTimeDecoder *decoder
 	_dirtyPalette = false;
 	_reversed = false;
 	_forcedDitherPalette = 0;
-	_ditherTable = 0;
 	_ditherFrame = 0;
 }
 
@@ -394,7 +393,6 @@ QuickTimeDecoder::VideoTrackHandler::~VideoTrackHandler() {
 	}
 
 	delete[] _forcedDitherPalette;
-	delete[] _ditherTable;
 
 	if (_ditherFrame) {
 		_ditherFrame->free();
@@ -727,26 +725,9 @@ Common::Rational QuickTimeDecoder::VideoTrackHandler::getScaledHeight() const {
 
 Common::SeekableReadStream *QuickTimeDecoder::VideoTrackHandler::getNextFramePacket(uint32 &descId) {
 	// First, we have to track down which chunk holds the sample and which sample in the chunk contains the frame we are looking for.
-	int32 totalSampleCount = 0;
-	int32 sampleInChunk = 0;
-	int32 actualChunk = -1;
-	uint32 sampleToChunkIndex = 0;
+	uint32 actualChunk, firstSampleInChunk;
 
-	for (uint32 i = 0; i < _parent->chunkCount; i++) {
-		if (sampleToChunkIndex < _parent->sampleToChunkCount && i >= _parent->sampleToChunk[sampleToChunkIndex].first)
-			sampleToChunkIndex++;
-
-		totalSampleCount += _parent->sampleToChunk[sampleToChunkIndex - 1].count;
-
-		if (totalSampleCount > _curFrame) {
-			actualChunk = i;
-			descId = _parent->sampleToChunk[sampleToChunkIndex - 1].id;
-			sampleInChunk = _parent->sampleToChunk[sampleToChunkIndex - 1].count - totalSampleCount + _curFrame;
-			break;
-		}
-	}
-
-	if (actualChunk < 0)
+	if (!_parent->findSampleChunk(_curFrame, actualChunk, firstSampleInChunk, descId))
 		error("Could not find data for frame %d", _curFrame);
 
 	// Next seek to that frame
@@ -754,7 +735,7 @@ Common::SeekableReadStream *QuickTimeDecoder::VideoTrackHandler::getNextFramePac
 	stream->seek(_parent->chunkOffsets[actualChunk]);
 
 	// Then, if the chunk holds more than one frame, seek to where the frame we want is located
-	for (int32 i = _curFrame - sampleInChunk; i < _curFrame; i++) {
+	for (int32 i = firstSampleInChunk; i < _curFrame; i++) {
 		if (_parent->sampleSize != 0)
 			stream->skip(_parent->sampleSize);
 		else
@@ -786,12 +767,7 @@ uint32 QuickTimeDecoder::VideoTrackHandler::getCurFrameDuration() {
 }
 
 uint32 QuickTimeDecoder::VideoTrackHandler::findKeyFrame(uint32 frame) const {
-	for (int i = _parent->keyframeCount - 1; i >= 0; i--)
-		if (_parent->keyframes[i] <= frame)
-			return _parent->keyframes[i];
-
-	// If none found, we'll assume the requested frame is a key frame
-	return frame;
+	return _parent->findKeyframe(frame);
 }
 
 bool QuickTimeDecoder::VideoTrackHandler::isEmptyEdit() const {
@@ -988,7 +964,7 @@ void QuickTimeDecoder::VideoTrackHandler::setDither(const byte *palette) {
 			// Forced dither
 			_forcedDitherPalette = new byte[256 * 3];
 			memcpy(_forcedDitherPalette, palette, 256 * 3);
-			_ditherTable = Image::Codec::createQuickTimeDitherTable(_forcedDitherPalette, 256);
+			_ditherTable = DitherTables.getQuickTimeTable(_forcedDitherPalette, 256);
 			_dirtyPalette = true;
 		}
 	}
@@ -1001,32 +977,71 @@ uint16 makeDitherColor(byte r, byte g, byte b) {
 	return ((r & 0xF8) << 6) | ((g & 0xF8) << 1) | (b >> 4);
 }
 
-// Default template to convert a dither color
-template<typename PixelInt>
-inline uint16 readDitherColor(PixelInt srcColor, const Graphics::PixelFormat& format, const byte *palette) {
-	byte r, g, b;
-	format.colorToRGB(srcColor, r, g, b);
-	return makeDitherColor(r, g, b);
-}
-
-// Specialized version for 8bpp
-template<>
-inline uint16 readDitherColor(byte srcColor, const Graphics::PixelFormat& format, const byte *palette) {
-	return makeDitherColor(palette[srcColor * 3], palette[srcColor * 3 + 1], palette[srcColor * 3 + 2]);
-}
-
 template<typename PixelInt>
 void ditherFrame(const Graphics::Surface &src, Graphics::Surface &dst, const byte *ditherTable, const byte *palette = 0) {
 	static const uint16 colorTableOffsets[] = { 0x0000, 0xC000, 0x4000, 0x8000 };
 
+	// Look up the dither color of the palette entries, or the bits of the dither
+	// color of each component, instead of converting every pixel to RGB
+	const Graphics::PixelFormat &format = src.format;
+	const uint rMask = (1 << format.rBits()) - 1;
+	const uint gMask = (1 << format.gBits()) - 1;
+	const uint bMask = (1 << format.bBits()) - 1;
+	uint16 lookup[3][256];
+
+	if (palette) {
+		for (uint i = 0; i < 256; i++)
+			lookup[0][i] = makeDitherColor(palette[i * 3], palette[i * 3 + 1], palette[i * 3 + 2]);
+	} else {
+		byte r, g, b;
+		for (uint i = 0; i <= rMask; i++) {
+			format.colorToRGB(i << format.rShift, r, g, b);
+			lookup[0][i] = makeDitherColor(r, 0, 0);
+		}
+		for (uint i = 0; i <= gMask; i++) {
+			format.colorToRGB(i << format.gShift, r, g, b);
+			lookup[1][i] = makeDitherColor(0, g, 0);
+		}
+		for (uint i = 0; i <= bMask; i++) {
+			format.colorToRGB(i << format.bShift, r, g, b);
+			lookup[2][i] = makeDitherColor(0, 0, b);
+		}
+	}
+
+	// With 8 bits per component, the dither colors only need shifts, in a loop
+	// which the compiler can vectorize
+	const bool shiftOnly = !palette && rMask == 0xFF && gMask == 0xFF && bMask == 0xFF;
+	const uint rShift = format.rShift + 3;
+	const uint gShift = format.gShift + 3;
+	const uint bShift = format.bShift + 4;
+
+	Common::Array<uint16> colors;
+	colors.resize(dst.w);
+	uint16 *colorPtr = colors.begin();
+
 	for (int y = 0; y < dst.h; y++) {
 		const PixelInt *srcPtr = (const PixelInt *)src.getBasePtr(0, y);
+
+		if (palette) {
+			for (int x = 0; x < dst.w; x++)
+				colorPtr[x] = lookup[0][srcPtr[x]];
+		} else if (shiftOnly) {
+			for (int x = 0; x < dst.w; x++) {
+				const uint32 color = srcPtr[x];
+				colorPtr[x] = (((color >> rShift) & 0x1F) << 9) | (((color >> gShift) & 0x1F) << 4) | ((color >> bShift) & 0xF);
+			}
+		} else {
+			for (int x = 0; x < dst.w; x++) {
+				const uint32 color = srcPtr[x];
+				colorPtr[x] = lookup[0][(color >> format.rShift) & rMask] | lookup[1][(color >> format.gShift) & gMask] | lookup[2][(color >> format.bShift) & bMask];
+			}
+		}
+
 		byte *dstPtr = (byte *)dst.getBasePtr(0, y);
 		uint16 colorTableOffset = colorTableOffsets[y & 3];
 
 		for (int x = 0; x < dst.w; x++) {
-			uint16 color = readDitherColor(*srcPtr++, src.format, palette);
-			*dstPtr++ = ditherTable[colorTableOffset + color];
+			*dstPtr++ = ditherTable[colorTableOffset + colorPtr[x]];
 			colorTableOffset += 0x4000;
 		}
 	}
@@ -1052,11 +1067,11 @@ const Graphics::Surface *QuickTimeDecoder::VideoTrackHandler::forceDither(const
 	}
 
 	if (frame.format.bytesPerPixel == 1)
-		ditherFrame<byte>(frame, *_ditherFrame, _ditherTable, _curPalette);
+		ditherFrame<byte>(frame, *_ditherFrame, _ditherTable.get(), _curPalette);
 	else if (frame.format.bytesPerPixel == 2)
-		ditherFrame<uint16>(frame, *_ditherFrame, _ditherTable);
+		ditherFrame<uint16>(frame, *_ditherFrame, _ditherTable.get());
 	else if (frame.format.bytesPerPixel == 4)
-		ditherFrame<uint32>(frame, *_ditherFrame, _ditherTable);
+		ditherFrame<uint32>(frame, *_ditherFrame, _ditherTable.get());
 
 	return _ditherFrame;
 }
@@ -32,6 +32,7 @@
 
 #include "audio/decoders/quicktime_intern.h"
 #include "common/keyboard.h"
+#include "common/ptr.h"
 #include "common/scummsys.h"
 
 #include "video/video_decoder.h"
@@ -307,7 +308,7 @@ private:
 
 		// Forced dithering of frames
 		byte *_forcedDitherPalette;
-		byte *_ditherTable;
+		Common::SharedPtr<byte> _ditherTable;
 		Graphics::Surface *_ditherFrame;
 		const Graphics::Surface *forceDither(const Graphics::Surface &frame);
 
@@ -26,10 +26,27 @@
 
 #include "common/rational.h"
 #include "common/file.h"
+#include "common/jobs.h"
 #include "common/system.h"
 
+#include "graphics/surface.h"
+#include "graphics/yuv_to_rgb.h"
+
 namespace Video {
 
+struct VideoDecoder::AheadFrame {
+	Graphics::Surface surface;
+	bool hasSurface;
+	bool endOfTrack;
+	int curFrame;
+	uint32 nextFrameStartTime;
+	bool dirtyPalette;
+	byte palette[256 * 3];
+
+	AheadFrame() : hasSurface(false), endOfTrack(false), curFrame(-1), nextFrameStartTime(0), dirtyPalette(false) {}
+	~AheadFrame() { surface.free(); }
+};
+
 VideoDecoder::VideoDecoder() {
 	_startTime = 0;
 	_dirtyPalette = false;
@@ -47,10 +64,32 @@ VideoDecoder::VideoDecoder() {
 	_mainAudioTrack = 0;
 	_canSetDither = true;
 	_canSetDefaultFormat = true;
+	_dithering = false;
 	_videoCodecAccuracy = Image::CodecAccuracy::Default;
+	_aheadThread = 0;
+	_aheadSlotFree = 0;
+	_aheadFrameReady = 0;
+	_aheadQuit = false;
+	_aheadRead = 0;
+	_aheadWrite = 0;
+	_aheadShowing = false;
+	_aheadFinished = false;
+	_aheadTrack = 0;
+	_aheadCurFrame = -1;
+	_aheadNextFrameStartTime = 0;
+}
+
+VideoDecoder::~VideoDecoder() {
+	// Subclasses are expected to have called close() already, which stopped
+	// the worker while their part of the object still existed
+	stopDecodeAhead();
+	freeDecodeAhead();
 }
 
 void VideoDecoder::close() {
+	stopDecodeAhead();
+	freeDecodeAhead();
+
 	if (isPlaying())
 		stop();
 
@@ -74,6 +113,7 @@ void VideoDecoder::close() {
 	_mainAudioTrack = 0;
 	_canSetDither = true;
 	_canSetDefaultFormat = true;
+	_dithering = false;
 }
 
 bool VideoDecoder::loadFile(const Common::Path &filename) {
@@ -121,6 +161,9 @@ void VideoDecoder::delayMillis(uint msecs) {
 }
 
 void VideoDecoder::pauseVideo(bool pause) {
+	// The decode-ahead worker may be using the tracks
+	Common::StackLock lock(_aheadMutex);
+
 	if (pause) {
 		_pauseLevel++;
 
@@ -152,6 +195,8 @@ void VideoDecoder::resetPauseStartTime() {
 }
 
 void VideoDecoder::setVolume(byte volume) {
+	Common::StackLock lock(_aheadMutex);
+
 	_audioVolume = volume;
 
 	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++)
@@ -160,6 +205,8 @@ void VideoDecoder::setVolume(byte volume) {
 }
 
 void VideoDecoder::setBalance(int8 balance) {
+	Common::StackLock lock(_aheadMutex);
+
 	_audioBalance = balance;
 
 	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++)
@@ -172,6 +219,8 @@ Audio::Mixer::SoundType VideoDecoder::getSoundType() const {
 }
 
 void VideoDecoder::setSoundType(Audio::Mixer::SoundType soundType) {
+	Common::StackLock lock(_aheadMutex);
+
 	_soundType = soundType;
 
 	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++)
@@ -212,6 +261,13 @@ const Graphics::Surface *VideoDecoder::decodeNextFrame() {
 	_canSetDither = false;
 	_canSetDefaultFormat = false;
 
+	if (!_aheadFrames.empty()) {
+		if (!_aheadThread)
+			startDecodeAhead();
+		if (_aheadThread)
+			return decodeAheadFrame();
+	}
+
 	readNextPacket();
 
 	// If we have no next video track at this point, there shouldn't be
@@ -237,6 +293,12 @@ bool VideoDecoder::setReverse(bool reverse) {
 	if (reverse && hasAudio())
 		return false;
 
+	// The worker only decodes forward
+	if (reverse && !_aheadFrames.empty())
+		return false;
+
+	Common::StackLock lock(_aheadMutex);
+
 	// Attempt to make sure all the tracks are in the requested direction
 	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++) {
 		if ((*it)->getTrackType() == Track::kTrackTypeVideo && ((VideoTrack *)*it)->isReversed() != reverse) {
@@ -257,6 +319,9 @@ const byte *VideoDecoder::getPalette() {
 }
 
 int VideoDecoder::getCurFrame() const {
+	if (_aheadThread)
+		return _aheadCurFrame;
+
 	int32 frame = -1;
 
 	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++)
@@ -298,13 +363,13 @@ uint32 VideoDecoder::getTime() const {
 }
 
 uint32 VideoDecoder::getTimeToNextFrame() const {
-	if (endOfVideo() || _needsUpdate || !_nextVideoTrack)
+	if (endOfVideo() || _needsUpdate || (!_aheadThread && !_nextVideoTrack))
 		return 0;
 
 	uint32 currentTime = getTime();
-	uint32 nextFrameStartTime = _nextVideoTrack->getNextFrameStartTime();
+	uint32 nextFrameStartTime = _aheadThread ? _aheadNextFrameStartTime : _nextVideoTrack->getNextFrameStartTime();
 
-	if (_nextVideoTrack->isReversed()) {
+	if (!_aheadThread && _nextVideoTrack->isReversed()) {
 		// For reversed videos, we need to handle the time difference the opposite way.
 		if (nextFrameStartTime >= currentTime)
 			return 0;
@@ -323,8 +388,11 @@ bool VideoDecoder::endOfVideo() const {
 	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++) {
 		const Track *track = *it;
 
-		bool videoEndTimeReached = _endTimeSet && track->getTrackType() == Track::kTrackTypeVideo && ((const VideoTrack *)track)->getNextFrameStartTime() >= (uint)_endTime.msecs();
-		bool endReached = track->endOfTrack() || (isPlaying() && videoEndTimeReached);
+		bool endReached;
+		if (track->getTrackType() == Track::kTrackTypeVideo)
+			endReached = isVideoTrackEndReached((const VideoTrack *)track);
+		else
+			endReached = track->endOfTrack();
 		if (!endReached)
 			return false;
 	}
@@ -347,6 +415,9 @@ bool VideoDecoder::rewind() {
 	if (!isRewindable())
 		return false;
 
+	// Drop the frames decoded ahead, they are restarted with the next frame
+	stopDecodeAhead();
+
 	// Stop all tracks so they can be rewound
 	if (isPlaying())
 		stopAudio();
@@ -381,6 +452,9 @@ bool VideoDecoder::seek(const Audio::Timestamp &time) {
 	if (!isSeekable())
 		return false;
 
+	// Drop the frames decoded ahead, they are restarted with the next frame
+	stopDecodeAhead();
+
 	// Stop all tracks so they can be seek'ed
 	if (isPlaying())
 		stopAudio();
@@ -447,6 +521,8 @@ void VideoDecoder::stop() {
 	if (!isPlaying())
 		return;
 
+	Common::StackLock lock(_aheadMutex);
+
 	// Stop audio here so we don't have it affect getTime()
 	stopAudio();
 
@@ -479,6 +555,8 @@ void VideoDecoder::setRate(const Common::Rational &rate) {
 		return;
 	}
 
+	Common::StackLock lock(_aheadMutex);
+
 	Common::Rational targetRate = rate;
 
 	if (hasAudio()) {
@@ -539,6 +617,10 @@ bool VideoDecoder::setDitheringPalette(const byte *palette) {
 	if (!_canSetDither)
 		return false;
 
+	// The dither tables are shared with the cache, see setDecodeAhead()
+	if (!_aheadFrames.empty())
+		return false;
+
 	bool result = false;
 
 	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++) {
@@ -548,6 +630,7 @@ bool VideoDecoder::setDitheringPalette(const byte *palette) {
 		}
 	}
 
+	_dithering = _dithering || result;
 	return result;
 }
 
@@ -568,7 +651,47 @@ bool VideoDecoder::setOutputPixelFormat(const Graphics::PixelFormat &format) {
 	return result;
 }
 
+bool VideoDecoder::setDecodeAhead(uint frames) {
+	// If a frame was already decoded, we can't set it now.
+	if (!_canSetDefaultFormat)
+		return false;
+
+	freeDecodeAhead();
+	if (!frames)
+		return true;
+
+	// Dithering codecs share their tables with the DitherTableCache, whose
+	// reference counts are not atomic
+	if (_dithering)
+		return false;
+
+	VideoTrack *track = 0;
+
+	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++) {
+		if ((*it)->getTrackType() == Track::kTrackTypeVideo) {
+			// The frame state is only kept for one video track
+			if (track)
+				return false;
+
+			track = (VideoTrack *)*it;
+		}
+	}
+
+	if (!track || track->isReversed())
+		return false;
+
+	// One more frame than requested, for the one being displayed
+	_aheadFrames.resize(frames + 1);
+	for (uint i = 0; i < _aheadFrames.size(); i++)
+		_aheadFrames[i] = new AheadFrame();
+
+	_aheadTrack = track;
+	return true;
+}
+
 void VideoDecoder::setVideoCodecAccuracy(Image::CodecAccuracy accuracy) {
+	Common::StackLock lock(_aheadMutex);
+
 	_videoCodecAccuracy = accuracy;
 
 	for (Track *track : _tracks) {
@@ -876,6 +999,7 @@ bool VideoDecoder::setAudioTrack(int index) {
 	if (_mainAudioTrack == audioTrack)
 		return true;
 
+	Common::StackLock lock(_aheadMutex);
 	_mainAudioTrack->setMute(true);
 	audioTrack->setMute(false);
 	_mainAudioTrack = audioTrack;
@@ -893,6 +1017,9 @@ uint VideoDecoder::getAudioTrackCount() const {
 }
 
 void VideoDecoder::setEndTime(const Audio::Timestamp &endTime) {
+	// The decode-ahead worker may be using the tracks
+	Common::StackLock lock(_aheadMutex);
+
 	Audio::Timestamp startTime = 0;
 
 	if (isPlaying()) {
@@ -941,7 +1068,12 @@ void VideoDecoder::setEndFrame(uint frame) {
 }
 
 void VideoDecoder::resetStartTime() {
-	if (_nextVideoTrack) {
+	if (_aheadThread) {
+		Audio::Timestamp curTime = _aheadTrack->getFrameTime(_aheadCurFrame);
+		if (isPlaying()) {
+			_startTime = g_system->getMillis() - (curTime.msecs() / _playbackRate).toInt();
+		}
+	} else if (_nextVideoTrack) {
 		Audio::Timestamp curTime = _nextVideoTrack->getFrameTime(_nextVideoTrack->getCurFrame());
 		if (isPlaying()) {
 			_startTime = g_system->getMillis() - (curTime.msecs() / _playbackRate).toInt();
@@ -1030,17 +1162,22 @@ bool VideoDecoder::hasFramesLeft() const {
 		if ((*it)->getTrackType() != Track::kTrackTypeVideo)
 			continue;
 
-		const VideoTrack *track = (const VideoTrack *)*it;
-
-		bool videoEndTimeReached = _endTimeSet && track->getNextFrameStartTime() >= (uint)_endTime.msecs();
-		bool endReached = track->endOfTrack() || (isPlaying() && videoEndTimeReached);
-		if (!endReached)
+		if (!isVideoTrackEndReached((const VideoTrack *)*it))
 			return true;
 	}
 
 	return false;
 }
 
+bool VideoDecoder::isVideoTrackEndReached(const VideoTrack *track) const {
+	// While decoding ahead, the track is further than the displayed frame
+	bool endOfTrack = _aheadThread ? _aheadFinished : track->endOfTrack();
+	uint32 nextFrameStartTime = _aheadThread ? _aheadNextFrameStartTime : track->getNextFrameStartTime();
+
+	bool videoEndTimeReached = _endTimeSet && nextFrameStartTime >= (uint)_endTime.msecs();
+	return endOfTrack || (isPlaying() && videoEndTimeReached);
+}
+
 bool VideoDecoder::hasAudio() const {
 	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++)
 		if ((*it)->getTrackType() == Track::kTrackTypeAudio)
@@ -1066,4 +1203,148 @@ void VideoDecoder::eraseTrack(Track *track) {
 	}
 }
 
+void VideoDecoder::startDecodeAhead() {
+	// Nothing left to decode
+	if (!_nextVideoTrack || _aheadTrack->endOfTrack())
+		return;
+
+	_aheadCurFrame = _aheadTrack->getCurFrame();
+	_aheadNextFrameStartTime = _aheadTrack->getNextFrameStartTime();
+	_aheadFinished = false;
+	_aheadShowing = false;
+	_aheadQuit = false;
+	_aheadRead = 0;
+	_aheadWrite = 0;
+
+	// Common::Singleton is not thread-safe. Create the ones which codecs use
+	// while decoding here, the worker may then share them.
+	Graphics::YUVToRGBManager::instance();
+	Common::JobSystem::instance();
+
+	// No frame is displayed yet, so all of them can be filled
+	_aheadSlotFree = g_system->createSemaphore(_aheadFrames.size());
+	if (_aheadSlotFree) {
+		_aheadFrameReady = g_system->createSemaphore(0);
+		if (_aheadFrameReady)
+			_aheadThread = g_system->createThread(decodeAheadProc, this);
+	}
+
+	// Fall back to decoding synchronously
+	if (!_aheadThread) {
+		stopDecodeAhead();
+		freeDecodeAhead();
+	}
+}
+
+void VideoDecoder::stopDecodeAhead() {
+	if (_aheadThread) {
+		_aheadMutex.lock();
+		_aheadQuit = true;
+		_aheadMutex.unlock();
+		_aheadSlotFree->post();
+
+		_aheadThread->join();
+		delete _aheadThread;
+		_aheadThread = 0;
+	}
+
+	delete _aheadSlotFree;
+	_aheadSlotFree = 0;
+	delete _aheadFrameReady;
+	_aheadFrameReady = 0;
+}
+
+void VideoDecoder::freeDecodeAhead() {
+	for (uint i = 0; i < _aheadFrames.size(); i++)
+		delete _aheadFrames[i];
+
+	_aheadFrames.clear();
+	_aheadTrack = 0;
+}
+
+const Graphics::Surface *VideoDecoder::decodeAheadFrame() {
+	if (_aheadFinished)
+		return 0;
+
+	_aheadFrameReady->wait();
+
+	// The previously displayed frame can be reused now
+	if (_aheadShowing)
+		_aheadSlotFree->post();
+
+	AheadFrame *frame = _aheadFrames[_aheadRead];
+	_aheadRead = (_aheadRead + 1) % _aheadFrames.size();
+	_aheadShowing = true;
+
+	_aheadCurFrame = frame->curFrame;
+	_aheadNextFrameStartTime = frame->nextFrameStartTime;
+	_aheadFinished = frame->endOfTrack;
+
+	if (frame->dirtyPalette) {
+		memcpy(_aheadPalette, frame->palette, sizeof(_aheadPalette));
+		_palette = _aheadPalette;
+		_dirtyPalette = true;
+	}
+
+	return frame->hasSurface ? &frame->surface : 0;
+}
+
+void VideoDecoder::decodeAheadProc(void *param) {
+	((VideoDecoder *)param)->decodeAheadLoop();
+}
+
+void VideoDecoder::decodeAheadLoop() {
+	int curFrame = _aheadCurFrame;
+
+	for (;;) {
+		_aheadSlotFree->wait();
+
+		// Held while the tracks are in use, the main thread takes it to
+		// change their state
+		Common::StackLock lock(_aheadMutex);
+		if (_aheadQuit)
+			break;
+
+		AheadFrame *frame = _aheadFrames[_aheadWrite];
+		_aheadWrite = (_aheadWrite + 1) % _aheadFrames.size();
+
+		readNextPacket();
+
+		const Graphics::Surface *surface = 0;
+		frame->dirtyPalette = false;
+		if (_nextVideoTrack) {
+			surface = _nextVideoTrack->decodeNextFrame();
+
+			if (_nextVideoTrack->hasDirtyPalette() && _nextVideoTrack->getPalette()) {
+				memcpy(frame->palette, _nextVideoTrack->getPalette(), sizeof(frame->palette));
+				frame->dirtyPalette = true;
+			}
+
+			curFrame = _nextVideoTrack->getCurFrame();
+			frame->endOfTrack = _nextVideoTrack->endOfTrack();
+			findNextVideoTrack();
+		} else {
+			frame->endOfTrack = true;
+		}
+
+		// The track reuses its surface for the next frame, so it is copied
+		frame->hasSurface = surface != 0;
+		if (surface) {
+			if (frame->surface.w != surface->w || frame->surface.h != surface->h || frame->surface.format != surface->format) {
+				frame->surface.free();
+				frame->surface.create(surface->w, surface->h, surface->format);
+			}
+			frame->surface.copyRectToSurface(*surface, 0, 0, Common::Rect(surface->w, surface->h));
+		}
+
+		frame->curFrame = curFrame;
+		frame->nextFrameStartTime = _nextVideoTrack ? _nextVideoTrack->getNextFrameStartTime() : 0;
+
+		_aheadFrameReady->post();
+
+		if (frame->endOfTrack)
+			break;
+	}
+}
+
 } // End of namespace Video
@@ -25,6 +25,7 @@
 #include "audio/mixer.h"
 #include "audio/timestamp.h"	// TODO: Move this to common/ ?
 #include "common/array.h"
+#include "common/mutex.h"
 #include "common/path.h"
 #include "common/rational.h"
 #include "common/str.h"
@@ -53,7 +54,7 @@ namespace Video {
 class VideoDecoder {
 public:
 	VideoDecoder();
-	virtual ~VideoDecoder() {}
+	virtual ~VideoDecoder();
 
 	/////////////////////////////////////////
 	// Opening/Closing a Video
@@ -407,6 +408,38 @@ public:
 	 */
 	bool setOutputPixelFormat(const Graphics::PixelFormat &format);
 
+	/**
+	 * Decode frames ahead of time on a worker thread.
+	 *
+	 * The worker keeps up to @p frames decoded frames queued, so that a frame
+	 * which takes longer to decode than a frame interval does not delay its
+	 * presentation. decodeNextFrame() then only waits when the queue is empty.
+	 * Seeking and rewinding drop the queued frames.
+	 *
+	 * This only works for videos with a single video track which is played
+	 * forward, and on backends which support threads. While frames are decoded
+	 * ahead, the tracks must only be accessed through the VideoDecoder
+	 * interface, and playing the video in reverse is not possible. The
+	 * methods which change the state of the tracks, such as pauseVideo(),
+	 * setRate() or setEndTime(), wait for the frame the worker is decoding.
+	 *
+	 * The worker only calls the track's decodeNextFrame(), so the codecs must
+	 * not use other state than their own while decoding. The output format is
+	 * set up on the calling thread before the first frame, and
+	 * setOutputPixelFormat() fails after it. Dithering is not supported, since
+	 * the codecs share their dither tables with Image::DitherTableCache, so
+	 * this fails after setDitheringPalette() and the other way around. The
+	 * YUV to RGB manager and the job system, which codecs do use while
+	 * decoding, are thread-safe and created before the worker starts.
+	 *
+	 * This should be called after loadStream(), but before a decodeNextFrame()
+	 * call. This is enforced.
+	 *
+	 * @param frames The number of frames to decode ahead, 0 to disable
+	 * @return true on success, false otherwise
+	 */
+	bool setDecodeAhead(uint frames);
+
 	/**
 	 * Set the accuracy of the video decoder
 	 */
@@ -1001,6 +1034,33 @@ private:
 	// Enforcement of not being able to set dither or set the default format
 	bool _canSetDither;
 	bool _canSetDefaultFormat;
+	bool _dithering;
+
+	// Decode-ahead state. The worker owns the tracks while it holds
+	// _aheadMutex, the other members are only used by the main thread.
+	struct AheadFrame;
+	Common::Array<AheadFrame *> _aheadFrames;
+	Common::ThreadInternal *_aheadThread;
+	Common::SemaphoreInternal *_aheadSlotFree;
+	Common::SemaphoreInternal *_aheadFrameReady;
+	Common::Mutex _aheadMutex;
+	bool _aheadQuit;
+	uint _aheadRead;
+	uint _aheadWrite;
+	bool _aheadShowing;
+	bool _aheadFinished;
+	VideoTrack *_aheadTrack;
+	int _aheadCurFrame;
+	uint32 _aheadNextFrameStartTime;
+	byte _aheadPalette[256 * 3];
+
+	void startDecodeAhead();
+	void stopDecodeAhead();
+	void freeDecodeAhead();
+	const Graphics::Surface *decodeAheadFrame();
+	static void decodeAheadProc(void *param);
+	void decodeAheadLoop();
+	bool isVideoTrackEndReached(const VideoTrack *track) const;
 
 protected:
 	// Internal helper functions